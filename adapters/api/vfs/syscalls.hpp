@@ -32,6 +32,8 @@ namespace vfs::syscalls {
     int            chmod(int& _errno_, const char* path, mode_t mode);
     int            fchmod(int& _errno_, int fd, mode_t mode);
     int            fsync(int& _errno_, int fd);
+    int            fdatasync(int& _errno_, int fd);
+    int            fallocate(int& _errno_, int fd, int mode, off_t offset, off_t len);
     int            mount(int& _errno_, const char* dev, const char* dir, const char* fstype, unsigned long int rwflag, const void* data);
     int            umount(int& _errno_, const char* dev);
     int            statvfs(int& _errno_, const char* path, struct statvfs* buf);
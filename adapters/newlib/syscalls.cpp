@@ -72,6 +72,15 @@ int     _rename(const char* old_name, const char* new_name) { return _rename_r(_
 int     _mkdir(const char* path, mode_t mode) { return _mkdir_r(_REENT, path, mode); }
 int     rmdir(const char* name) { return _rmdir_r(_REENT, name); }
 int     chdir(const char* path) { return _chdir_r(_REENT, path); }
+int     fdatasync(int fd) { return syscalls::fdatasync(_REENT->_errno, fd); }
+int     fallocate(int fd, int mode, off_t offset, off_t len) { return syscalls::fallocate(_REENT->_errno, fd, mode, offset, len); }
+int     posix_fallocate(int fd, off_t offset, off_t len)
+{
+    // NOTE: posix_fallocate returns the error instead of setting errno
+    int err = 0;
+    syscalls::fallocate(err, fd, 0, offset, len);
+    return err;
+}
 
 DIR*           opendir(const char* dirname) { return syscalls::opendir(_REENT->_errno, dirname); }
 int            closedir(DIR* dirp) { return syscalls::closedir(_REENT->_errno, dirp); }
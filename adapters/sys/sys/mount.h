@@ -26,6 +26,8 @@ __BEGIN_DECLS
 #define MS_REC 0x0800         /* Recursive mount */
 #define MS_PRIVATE 0x1000     /* Set mount as private */
 #define MS_UNBINDABLE 0x2000  /* Mark mount as unbindable */
+#define MS_RELATIME 0x200000  /* Update access times relative to modification times */
+#define MS_LAZYTIME 0x2000000 /* Keep timestamp updates in memory */
 
 int mount(const char* source, const char* target, const char* filesystemtype, unsigned long mountflags, const void* data);
 int umount(const char* target);
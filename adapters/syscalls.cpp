@@ -2,6 +2,8 @@
 
 #include <vfs/vfs.hpp>
 
+#include <array>
+#include <cstring>
 #include <filesystem>
 #include <sys/statvfs.h>
 #include <sys/stat.h>
@@ -18,6 +20,11 @@ struct __dirstream {
     std::unique_ptr<vfs::DirectoryHandle> dirh;
     size_t                                position {};
     dirent                                dir_data {};
+    std::array<vfs::DirEntry, 8>          batch {};     ///< Entries read ahead from the directory
+    size_t                                batch_pos {}; ///< Next entry of batch returned to the user
+    size_t                                batch_len {}; ///< Number of valid entries in batch
+    off_t                                 cookie {};    ///< Filesystem position of the next entry returned to the user
+    bool                                  cookies {};   ///< The filesystem supports dirseek, telldir returns cookies rather than entry indices
 };
 
 namespace {
@@ -53,8 +60,42 @@ namespace {
         if (S_ISBLK(mode)) { return DT_BLK; }
         if (S_ISFIFO(mode)) { return DT_FIFO; }
         if (S_ISSOCK(mode)) { return DT_SOCK; }
+        if (S_ISLNK(mode)) { return DT_LNK; }
         return 0;
     }
+
+    /// Returns the next entry of the directory stream, nullptr at the end of directory. Entries are read from the filesystem in batches, so that the mount point is
+    /// locked once per batch rather than once per entry.
+    auto next_entry(DIR* dirp) -> vfs::result<const vfs::DirEntry*>
+    {
+        if (dirp->batch_pos == dirp->batch_len) {
+            const auto ret = vfs::borrow_vfs().dirnext_batch(*dirp->dirh, dirp->batch);
+            if (not ret) { return vfs::error(ret.error()); }
+            dirp->batch_pos = 0;
+            dirp->batch_len = *ret;
+            if (dirp->batch_len == 0) { return nullptr; }
+        }
+        dirp->position += 1;
+        dirp->cookie = dirp->batch[dirp->batch_pos].cookie;
+        return &dirp->batch[dirp->batch_pos++];
+    }
+
+    void fill_dirent(const vfs::DirEntry& entry, dirent& dent)
+    {
+        const auto name = entry.get_name();
+        dent.d_ino      = entry.st.st_ino;
+        dent.d_type     = stmode_to_type(entry.st.st_mode);
+        dent.d_reclen   = name.size();
+        std::memcpy(dent.d_name, name.data(), name.size() + 1);
+    }
+
+    void drop_batch(DIR* dirp, const off_t cookie)
+    {
+        dirp->position  = 0;
+        dirp->cookie    = cookie;
+        dirp->batch_pos = 0;
+        dirp->batch_len = 0;
+    }
 } // namespace
 
 namespace vfs::syscalls {
@@ -134,6 +175,10 @@ namespace vfs::syscalls {
             return nullptr;
         }
         ret->dirh = std::move(*handle);
+        if (const auto cookie = vfs.dirtell(*ret->dirh)) {
+            ret->cookie  = *cookie;
+            ret->cookies = true;
+        }
         return ret;
     }
 
@@ -157,25 +202,14 @@ namespace vfs::syscalls {
             _errno_ = EBADF;
             return nullptr;
         }
-        auto&                 vfs = borrow_vfs();
-        std::filesystem::path fname;
-        struct stat           stdata {};
-        const auto            ret = vfs.dirnext(*dirp->dirh, fname, stdata);
-        if (ret and ret.value() != ENOENT) {
-            _errno_ = ret.value();
+        const auto entry = next_entry(dirp);
+        if (not entry) {
+            _errno_ = entry.error().value();
             return nullptr;
         }
-        if (ret.value() == ENOENT) { return nullptr; }
+        if (*entry == nullptr) { return nullptr; }
 
-        if (fname.string().size() >= sizeof(dirp->dir_data.d_name)) {
-            _errno_ = EOVERFLOW;
-            return nullptr;
-        }
-        dirp->position += 1;
-        dirp->dir_data.d_ino    = stdata.st_ino;
-        dirp->dir_data.d_type   = stmode_to_type(stdata.st_mode);
-        dirp->dir_data.d_reclen = fname.string().size();
-        snprintf(dirp->dir_data.d_name, sizeof(dirp->dir_data.d_name), "%s", fname.c_str());
+        fill_dirent(**entry, dirp->dir_data);
         return &dirp->dir_data;
     }
 
@@ -189,30 +223,17 @@ namespace vfs::syscalls {
             _errno_ = EINVAL;
             return -1;
         }
-        auto&                 vfs = borrow_vfs();
-        std::filesystem::path fname;
-        struct stat           stdata {};
-        const auto            ret = vfs.dirnext(*dirp->dirh, fname, stdata);
-
-        if (ret and ret.value() != ENOENT) {
-            _errno_ = ret.value();
+        const auto next = next_entry(dirp);
+        if (not next) {
+            _errno_ = next.error().value();
             return -1;
         }
-
-        if (ret.value() == ENOENT) {
+        if (*next == nullptr) {
             *result = nullptr;
             return 0;
         }
 
-        if (fname.string().size() >= sizeof(dirp->dir_data.d_name)) {
-            _errno_ = EOVERFLOW;
-            return -1;
-        }
-        dirp->position += 1;
-        entry->d_ino    = stdata.st_ino;
-        entry->d_type   = stmode_to_type(stdata.st_mode);
-        entry->d_reclen = fname.string().size();
-        snprintf(entry->d_name, sizeof(entry->d_name), "%s", fname.c_str());
+        fill_dirent(**next, *entry);
         *result = entry;
         return 0;
     }
@@ -228,7 +249,7 @@ namespace vfs::syscalls {
             _errno_ = res.value();
             return;
         }
-        dirp->position = 0;
+        drop_batch(dirp, 0);
     }
 
     void seekdir(int& _errno_, DIR* dirp, const long int loc)
@@ -241,14 +262,23 @@ namespace vfs::syscalls {
             _errno_ = EINVAL;
             return;
         }
-        auto& vfs = borrow_vfs();
+        if (dirp->cookies) {
+            if (const auto res = borrow_vfs().dirseek(*dirp->dirh, loc)) {
+                _errno_ = res.value();
+                return;
+            }
+            drop_batch(dirp, loc);
+            return;
+        }
+        /// Without cookies, the position is the index of an entry that is reached by reading all the preceding ones
         if (static_cast<long>(dirp->position) > loc) {
-            vfs.dirreset(*dirp->dirh);
-            dirp->position = 0;
+            borrow_vfs().dirreset(*dirp->dirh);
+            drop_batch(dirp, 0);
+        }
+        while (static_cast<long>(dirp->position) < loc) {
+            const auto entry = next_entry(dirp);
+            if (not entry or *entry == nullptr) { break; }
         }
-        std::filesystem::path name;
-        struct stat           st {};
-        while ((static_cast<long>(dirp->position) < loc) && vfs.dirnext(*dirp->dirh, name, st).value() == 0) { dirp->position += 1; }
     }
 
     long int telldir(int& _errno_, DIR* dirp)
@@ -257,7 +287,7 @@ namespace vfs::syscalls {
             _errno_ = EBADF;
             return -1;
         }
-        return dirp->position;
+        return dirp->cookies ? dirp->cookie : static_cast<long>(dirp->position);
     }
 
     int chmod(int& _errno_, const char* path, mode_t mode) { return invoke_fs(_errno_, &VirtualFS::chmod, path, mode); }
@@ -266,6 +296,10 @@ namespace vfs::syscalls {
 
     int fsync(int& _errno_, int fd) { return invoke_fs(_errno_, &VirtualFS::fsync, fd); }
 
+    int fdatasync(int& _errno_, int fd) { return invoke_fs(_errno_, &VirtualFS::fdatasync, fd); }
+
+    int fallocate(int& _errno_, int fd, int mode, off_t offset, off_t len) { return invoke_fs(_errno_, &VirtualFS::fallocate, fd, Flags {static_cast<unsigned>(mode)}, offset, len); }
+
     int statvfs(int& _errno_, const char* path, struct statvfs* buf)
     {
         if (!buf) {
@@ -298,7 +332,7 @@ namespace vfs::syscalls {
 
     int isatty(int& _errno_, int fd) { return invoke_fs(_errno_, &VirtualFS::isatty, fd); }
 
-    int mount(int& _errno_, const char* dev, const char* dir, const char* fstype, unsigned long mountflags, const void*) { return invoke_fs(_errno_, &VirtualFS::mount, dev, dir, fstype, mountflags); }
+    int mount(int& _errno_, const char* dev, const char* dir, const char* fstype, unsigned long mountflags, const void*) { return invoke_fs(_errno_, &VirtualFS::mount, dev, dir, fstype, mountflags, vfs::MountOptions {}); }
 
     int umount(int& _errno_, const char* dev) { return invoke_fs(_errno_, &VirtualFS::umount, dev); }
 
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "defs.hpp"
+#include "executor.hpp"
+
+#include <atomic>
+#include <coroutine>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stop_token>
+
+namespace vfs {
+
+    class VirtualFS;
+
+    /**
+     * Awaitable VFS operation. Awaiting it schedules the operation on the I/O executor and suspends the coroutine, which is then resumed on the completion
+     * executor. Cancellation is honoured as long as the operation hasn't started yet, in that case the coroutine is resumed at once with ECANCELED.
+     * Buffers passed to the operation must stay valid until the coroutine is resumed.
+     */
+    template <typename T> class IoAwaitable {
+    public:
+        using operation = std::function<result<T>()>;
+
+        IoAwaitable(operation op, Executor& io, Executor& completion, std::stop_token token)
+            : m_state {std::make_shared<state>(std::move(op), completion)}
+            , m_io {io}
+            , m_token {std::move(token)}
+        {
+        }
+
+        [[nodiscard]] bool await_ready() const noexcept { return m_token.stop_requested(); }
+
+        void await_suspend(const std::coroutine_handle<> handle)
+        {
+            /// Once the stop callback is registered the coroutine may be resumed, and the awaitable destroyed, by another thread before this function
+            /// returns, hence nothing but locals may be touched from then on
+            const auto state = m_state;
+            Executor&  io    = m_io;
+            const auto token = m_token;
+            state->handle    = handle;
+            if (token.stop_possible()) { state->on_stop.emplace(token, canceller {state.get()}); }
+            io.post([state] {
+                if (state->claimed.exchange(true)) { return; }
+                state->complete(state->op());
+            });
+        }
+
+        result<T> await_resume()
+        {
+            if (not m_state->value) { return error(ECANCELED); }
+            return std::move(*m_state->value);
+        }
+
+    private:
+        struct state;
+        struct canceller {
+            state* owner;
+            void   operator()() const
+            {
+                if (not owner->claimed.exchange(true)) { owner->complete(error(ECANCELED)); }
+            }
+        };
+
+        struct state {
+            state(operation op, Executor& completion)
+                : op {std::move(op)}
+                , completion {completion}
+            {
+            }
+
+            /// Store the result and hand the coroutine over to the completion executor. Must not touch the state afterwards.
+            void complete(result<T> ret)
+            {
+                value = std::move(ret);
+                completion.post([h = handle] { h.resume(); });
+            }
+
+            operation                                    op;
+            Executor&                                    completion;
+            std::coroutine_handle<>                      handle;
+            std::atomic_bool                             claimed {false}; ///< Set by whoever completes the operation first: the I/O task or cancellation
+            std::optional<result<T>>                     value;
+            std::optional<std::stop_callback<canceller>> on_stop;
+        };
+
+        std::shared_ptr<state> m_state;
+        Executor&              m_io;
+        std::stop_token        m_token;
+    };
+
+    /// Coroutine front-end of VirtualFS. Operations are executed on the I/O executor by the blocking VirtualFS API.
+    class AsyncFS {
+    public:
+        /**
+         * @param vfs virtual filesystem operations are executed against
+         * @param io_executor executor running blocking VFS calls, it's also used to resume coroutines if no completion executor is given
+         */
+        AsyncFS(VirtualFS& vfs, Executor& io_executor);
+
+        auto async_read(int fd, std::span<char> buf, std::stop_token token = {}) -> IoAwaitable<std::size_t>;
+        auto async_read(int fd, std::span<char> buf, Executor& completion, std::stop_token token = {}) -> IoAwaitable<std::size_t>;
+        auto async_write(int fd, std::span<const char> buf, std::stop_token token = {}) -> IoAwaitable<std::size_t>;
+        auto async_write(int fd, std::span<const char> buf, Executor& completion, std::stop_token token = {}) -> IoAwaitable<std::size_t>;
+        auto async_open(std::filesystem::path path, int flags, int mode, std::stop_token token = {}) -> IoAwaitable<int>;
+        auto async_open(std::filesystem::path path, int flags, int mode, Executor& completion, std::stop_token token = {}) -> IoAwaitable<int>;
+
+    private:
+        VirtualFS& m_vfs;
+        Executor&  m_io;
+    };
+} // namespace vfs
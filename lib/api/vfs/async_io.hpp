@@ -0,0 +1,100 @@
+#pragma once
+
+#include "defs.hpp"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include <sys/stat.h>
+
+namespace vfs {
+
+    class VirtualFS;
+
+    enum class IoOpcode { read, write, fsync, open, close, stat, fstat };
+
+    /// Submission queue entry. Buffers and stat structures referenced by the entry must stay valid until its completion is reaped.
+    struct SubmissionEntry {
+        IoOpcode              opcode {};
+        int                   fd {-1};      ///< Target descriptor of read/write/fsync/close/fstat
+        std::filesystem::path path {};      ///< Target path of open/stat
+        int                   flags {};     ///< open flags
+        int                   mode {};      ///< open mode
+        char*                 buf {};       ///< Destination of read
+        const char*           data {};      ///< Source of write
+        std::size_t           len {};       ///< Length of read/write
+        struct stat*          st {};        ///< Destination of stat/fstat
+        std::uint64_t         user_data {}; ///< Opaque value copied to the completion entry
+
+        static SubmissionEntry read(int fd, char* buf, std::size_t len, std::uint64_t user_data);
+        static SubmissionEntry write(int fd, const char* data, std::size_t len, std::uint64_t user_data);
+        static SubmissionEntry fsync(int fd, std::uint64_t user_data);
+        static SubmissionEntry open(std::filesystem::path path, int flags, int mode, std::uint64_t user_data);
+        static SubmissionEntry close(int fd, std::uint64_t user_data);
+        static SubmissionEntry stat(std::filesystem::path path, struct stat& st, std::uint64_t user_data);
+        static SubmissionEntry fstat(int fd, struct stat& st, std::uint64_t user_data);
+    };
+
+    /// Completion queue entry. 'res' holds transferred bytes for read/write, a new descriptor for open and 0 for the rest of operations.
+    struct CompletionEntry {
+        std::uint64_t       user_data {};
+        result<std::size_t> res;
+    };
+
+    /**
+     * Asynchronous submission/completion interface of VirtualFS. Submitted requests are executed by a local pool of worker threads, thus a single
+     * application thread is able to keep several block devices busy at once. Requests targeting the same file descriptor are executed in the order
+     * of submission, requests targeting different descriptors run in parallel. Path based requests(open, stat) are not ordered at all.
+     */
+    class AsyncIO {
+    public:
+        /**
+         * @param vfs virtual filesystem requests are executed against
+         * @param workers number of worker threads, at least one is always spawned
+         */
+        AsyncIO(VirtualFS& vfs, std::size_t workers);
+        /// Waits for all submitted requests to finish. Completions that haven't been reaped are dropped.
+        ~AsyncIO();
+        AsyncIO(const AsyncIO&)                    = delete;
+        auto operator=(const AsyncIO&) -> AsyncIO& = delete;
+
+        /**
+         * Submit a batch of requests
+         * @param entries requests to be queued, they're copied hence the span can be released right after the call
+         * @return number of queued requests
+         */
+        std::size_t submit(std::span<const SubmissionEntry> entries);
+
+        /**
+         * Reap completed requests
+         * @param completions where to store completions
+         * @param min_complete block until at least that many completions are available(clamped to the size of 'completions' and to the number of requests in flight)
+         * @return number of stored completions
+         */
+        std::size_t reap(std::span<CompletionEntry> completions, std::size_t min_complete = 0);
+
+        /// Number of submitted requests whose completions haven't been reaped yet
+        [[nodiscard]] std::size_t in_flight() const;
+
+    private:
+        void                                  worker();
+        CompletionEntry                       execute(const SubmissionEntry& sqe);
+        std::deque<SubmissionEntry>::iterator next_runnable();
+
+        VirtualFS&                  m_vfs;
+        mutable std::mutex          m_mutex;
+        std::condition_variable     m_submitted;
+        std::condition_variable     m_completed;
+        std::deque<SubmissionEntry> m_pending;
+        std::vector<int>            m_busy_fds; ///< Descriptors with a request being executed
+        std::deque<CompletionEntry> m_completions;
+        std::size_t                 m_in_flight {};
+        bool                        m_stop {false};
+        std::vector<std::jthread>   m_workers;
+    };
+} // namespace vfs
@@ -8,9 +8,20 @@
 #pragma once
 
 #include "defs.hpp"
+#include <cstdint>
+#include <span>
 #include <string>
 
 namespace vfs {
+    /// Single segment of a scatter-gather request: 'count' blocks starting at 'lba' transferred from/to 'buf'
+    template <typename ByteT> struct basic_io_segment {
+        std::uint64_t lba;
+        std::size_t   count;
+        ByteT*        buf;
+    };
+    using read_segment  = basic_io_segment<std::byte>;
+    using write_segment = basic_io_segment<const std::byte>;
+
     class BlockDevice {
     public:
         using sector_t = std::uint64_t;
@@ -46,6 +57,34 @@ namespace vfs {
          */
         [[nodiscard]] virtual std::error_code read(std::byte& buf, sector_t lba, std::size_t count) = 0;
 
+        /**
+         * Write a batch of non-contiguous block ranges. Default implementation issues a separate 'write' per segment, devices able to handle a batch natively
+         * should override it.
+         * @param segments segments to be written, in order
+         * @return 0 in case of success, otherwise an error. Stops on the first failed segment.
+         */
+        [[nodiscard]] virtual std::error_code writev(const std::span<const write_segment> segments)
+        {
+            for (const auto& segment : segments) {
+                if (const auto err = write(*segment.buf, segment.lba, segment.count); err) { return err; }
+            }
+            return {};
+        }
+
+        /**
+         * Read a batch of non-contiguous block ranges. Default implementation issues a separate 'read' per segment, devices able to handle a batch natively
+         * should override it.
+         * @param segments segments to be read, in order
+         * @return 0 in case of success, otherwise an error. Stops on the first failed segment.
+         */
+        [[nodiscard]] virtual std::error_code readv(const std::span<const read_segment> segments)
+        {
+            for (const auto& segment : segments) {
+                if (const auto err = read(*segment.buf, segment.lba, segment.count); err) { return err; }
+            }
+            return {};
+        }
+
         [[nodiscard]] virtual result<std::size_t> get_sector_size() const  = 0;
         [[nodiscard]] virtual result<sector_t>    get_sector_count() const = 0;
         [[nodiscard]] virtual std::string         get_name() const         = 0;
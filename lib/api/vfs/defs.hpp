@@ -8,6 +8,7 @@
 #pragma once
 
 #include <bitset>
+#include <chrono>
 #include <mutex>
 #include <system_error>
 #include <expected>
@@ -21,10 +22,45 @@ namespace vfs {
         enum {
             read_only = 0,
             remount   = 5,
+            noatime   = 7,  ///< Don't update access times
+            relatime  = 21, ///< Update access time only if it's older than the modification or change time, or a day old
+            lazytime  = 25, ///< Keep timestamp updates in memory until the inode is written for another reason, on fsync or unmount
+        };
+    };
+    /// fallocate() mode, bit indices follow the FALLOC_FL_ values
+    struct FallocFlags {
+        enum {
+            keep_size = 0, ///< Don't extend the file size, blocks allocated past the end of file are released when it's truncated
         };
     };
     using Flags = std::bitset<32>;
 
+    /// Block cache replacement policy
+    enum class CachePolicy {
+        lru,       ///< Evict the least recently used block
+        two_queue, ///< 2Q, blocks used once are evicted first, so that sequential scans don't flush frequently used metadata
+    };
+
+    /// When journaled changes are committed
+    enum class JournalCommit {
+        per_operation, ///< Every operation is committed on its own before it returns
+        grouped,       ///< Operations are committed together every commit_interval, or earlier once they collect commit_blocks or on fsync
+        on_sync,       ///< Operations are committed together on fsync or once they collect commit_blocks only
+    };
+
+    /// Tunables of a mount point that don't fit into mount Flags
+    struct MountOptions {
+        std::size_t               cache_blocks {};                               ///< Capacity of the block cache in filesystem blocks, 0 selects the filesystem's default
+        CachePolicy               cache_policy {CachePolicy::lru};               ///< Ignored by filesystems without a block cache
+        bool                      write_back {};                                 ///< Keep dirty metadata and partial data blocks in the cache to be written by a background flusher, fsync or umount
+        unsigned                  dirty_ratio {20};                              ///< Percentage of the cache capacity that may be dirty before the flusher is woken up
+        std::chrono::milliseconds dirty_expire {5000};                           ///< Time after which dirty blocks are written back regardless of dirty_ratio
+        JournalCommit             journal_commit {JournalCommit::per_operation}; ///< Ignored by filesystems without a journal
+        std::chrono::milliseconds commit_interval {5000};                        ///< Period of JournalCommit::grouped commits
+        std::size_t               commit_blocks {1024};                          ///< Journal blocks a group of operations may collect before it's committed, limited to a quarter of the block cache
+        std::size_t               dentry_cache {128};                            ///< Capacity of the path lookup cache in directory entries, 0 disables it
+    };
+
     inline std::error_code from_errno(const int err) { return {err, std::generic_category()}; }
     inline auto            error(const int err) { return std::unexpected(from_errno(err)); }
     inline auto            error(const std::error_code err) { return std::unexpected(err); }
@@ -32,4 +68,7 @@ namespace vfs {
     /// Root base name used by auto-mount when underlying filesystem does not provide info about partition's name/label. In that case, root_base will be used to
     /// create a unique partition's mount point name.
     constexpr auto root_base = "/volume";
+
+    /// Default maximum number of simultaneously opened file descriptors(excluding stdin/stdout/stderr), see VirtualFS constructor
+    constexpr std::size_t max_open_files = 128;
 } // namespace vfs
@@ -31,6 +31,8 @@ namespace vfs {
         [[nodiscard]] std::error_code     flush() override;
         [[nodiscard]] std::error_code     write(const std::byte& buf, sector_t lba, std::size_t count) override;
         [[nodiscard]] std::error_code     read(std::byte& buf, sector_t lba, std::size_t count) override;
+        [[nodiscard]] std::error_code     writev(std::span<const write_segment> segments) override;
+        [[nodiscard]] std::error_code     readv(std::span<const read_segment> segments) override;
         [[nodiscard]] result<std::size_t> get_sector_size() const override;
         [[nodiscard]] result<sector_t>    get_sector_count() const override;
         [[nodiscard]] std::string         get_name() const override;
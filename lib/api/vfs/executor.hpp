@@ -0,0 +1,60 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace vfs {
+
+    /// Minimal executor interface. Implement it to plug VFS awaitables into an application specific scheduler.
+    class Executor {
+    public:
+        virtual ~Executor() = default;
+
+        /// Schedule a task for execution. Must be thread-safe, it's called from arbitrary threads.
+        virtual void post(std::function<void()> task) = 0;
+    };
+
+    /// Executor running tasks on a fixed pool of worker threads. Pending tasks are executed before the pool is destroyed.
+    class ThreadPoolExecutor final : public Executor {
+    public:
+        explicit ThreadPoolExecutor(std::size_t threads);
+        ~ThreadPoolExecutor() override;
+        ThreadPoolExecutor(const ThreadPoolExecutor&)                    = delete;
+        auto operator=(const ThreadPoolExecutor&) -> ThreadPoolExecutor& = delete;
+
+        void post(std::function<void()> task) override;
+
+    private:
+        void worker();
+
+        std::mutex                        m_mutex;
+        std::condition_variable           m_cond;
+        std::deque<std::function<void()>> m_tasks;
+        bool                              m_stop {false};
+        std::vector<std::jthread>         m_workers;
+    };
+
+    /// Executor queueing tasks until the owner runs them explicitly. Suitable for cooperative, single threaded schedulers.
+    class ManualExecutor final : public Executor {
+    public:
+        void post(std::function<void()> task) override;
+
+        /**
+         * Run all the tasks queued so far, tasks posted in the meantime are left for the next call
+         * @return number of executed tasks
+         */
+        std::size_t run_pending();
+
+        /// Wait until at least one task is queued and run all the pending ones
+        std::size_t run_one_batch();
+
+    private:
+        std::mutex                        m_mutex;
+        std::condition_variable           m_cond;
+        std::deque<std::function<void()>> m_tasks;
+    };
+} // namespace vfs
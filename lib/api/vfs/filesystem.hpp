@@ -8,12 +8,18 @@
 #pragma once
 
 #include <string>
+#include <string_view>
+#include <array>
+#include <span>
+#include <climits>
 #include <filesystem>
 #include <system_error>
+#include <sys/stat.h>
 #include "defs.hpp"
+#include "path_view.hpp"
+#include "partition_stats.hpp"
 
 struct statvfs;
-struct stat;
 
 namespace vfs {
 
@@ -21,45 +27,98 @@ namespace vfs {
     class DirectoryHandle;
     class BlockDevice;
 
+    /// Directory entry returned by dirnext_batch
+    struct DirEntry {
+        std::array<char, NAME_MAX + 1> name {};     ///< Null terminated entry name
+        struct stat                    st {};       ///< Only st_ino and the file type of st_mode are filled, unless the full stat was requested
+        off_t                          cookie {-1}; ///< Position following the entry, dirseek to it continues after the entry. -1 without dirseek support
+
+        [[nodiscard]] auto get_name() const noexcept -> std::string_view { return name.data(); }
+    };
+
+    /**
+     * Read-only file data exposed in place by read_pinned, e.g. a block pinned in the filesystem cache. The data stays in memory until the object is reset or
+     * destroyed, which releases it. Pinned data has to be released before its filesystem is unmounted.
+     */
+    class PinnedData {
+    public:
+        /// Filesystem specific release of the pinned memory
+        using release_fn = void (*)(void* owner, void* pin) noexcept;
+
+        PinnedData() = default;
+        PinnedData(std::span<const std::byte> data, release_fn release, void* owner, void* pin) noexcept;
+        ~PinnedData();
+        PinnedData(PinnedData&& other) noexcept;
+        auto operator=(PinnedData&& other) noexcept -> PinnedData&;
+        PinnedData(const PinnedData&)     = delete;
+        auto operator=(const PinnedData&) = delete;
+
+        [[nodiscard]] auto data() const noexcept -> std::span<const std::byte> { return m_data; }
+        [[nodiscard]] auto size() const noexcept -> std::size_t { return m_data.size(); }
+        [[nodiscard]] auto empty() const noexcept -> bool { return m_data.empty(); }
+        void               reset() noexcept;
+
+    private:
+        std::span<const std::byte> m_data;
+        release_fn                 m_release {};
+        void*                      m_owner {};
+        void*                      m_pin {};
+    };
+
     class Filesystem {
     public:
         virtual ~Filesystem()             = default;
         auto operator=(const Filesystem&) = delete;
 
-        virtual auto mount(std::string root, Flags flags) noexcept -> std::error_code = 0;
-        virtual auto unmount() noexcept -> std::error_code                            = 0;
-        virtual auto stat_vfs(const std::filesystem::path& path, struct statvfs& stat) noexcept -> std::error_code;
+        virtual auto mount(std::string root, Flags flags, const MountOptions& options) noexcept -> std::error_code = 0;
+        virtual auto unmount() noexcept -> std::error_code                                                        = 0;
+        virtual auto stat_vfs(PathView path, struct statvfs& stat) noexcept -> std::error_code;
+        virtual auto stat_cache() noexcept -> result<CacheStats>;
 
         /** Standard file access API */
-        virtual auto open(const std::filesystem::path& abspath, Flags flags, int mode) noexcept -> result<std::unique_ptr<FileHandle>> = 0;
-        virtual auto close(FileHandle& handle) noexcept -> std::error_code                                                             = 0;
-        virtual auto write(FileHandle& handle, const char* ptr, size_t len) noexcept -> result<std::size_t>                            = 0;
-        virtual auto read(FileHandle& handle, char* ptr, size_t len) noexcept -> result<std::size_t>                                   = 0;
+        virtual auto open(PathView abspath, Flags flags, int mode) noexcept -> result<std::unique_ptr<FileHandle>> = 0;
+        virtual auto close(FileHandle& handle) noexcept -> std::error_code                                         = 0;
+        virtual auto write(FileHandle& handle, const char* ptr, size_t len) noexcept -> result<std::size_t>        = 0;
+        virtual auto read(FileHandle& handle, char* ptr, size_t len) noexcept -> result<std::size_t>               = 0;
+        /// Read up to @p len bytes at @p offset in place, without copying them and without moving the file position. The data returned may be shorter than
+        /// requested, e.g. up to the end of a block, it's empty at the end of file. Not supported by default, read has to be used instead.
+        virtual auto read_pinned(FileHandle& handle, off_t offset, std::size_t len) noexcept -> result<PinnedData>;
         virtual auto lseek(FileHandle& handle, off_t pos, int dir) noexcept -> result<off_t>;
         virtual auto fstat(FileHandle& handle, struct stat& st) noexcept -> std::error_code;
-        virtual auto stat(const std::filesystem::path& file, struct stat& st) noexcept -> std::error_code;
-        virtual auto link(const std::filesystem::path& existing, const std::filesystem::path& newlink) noexcept -> std::error_code;
-        virtual auto symlink(const std::filesystem::path& existing, const std::filesystem::path& newlink) noexcept -> std::error_code;
-        virtual auto unlink(const std::filesystem::path& name) noexcept -> std::error_code;
-        virtual auto rmdir(const std::filesystem::path& name) noexcept -> std::error_code;
-        virtual auto rename(const std::filesystem::path& oldname, const std::filesystem::path& newname) noexcept -> std::error_code;
-        virtual auto mkdir(const std::filesystem::path& path, int mode) noexcept -> std::error_code;
+        virtual auto stat(PathView file, struct stat& st) noexcept -> std::error_code;
+        virtual auto link(PathView existing, PathView newlink) noexcept -> std::error_code;
+        virtual auto symlink(PathView existing, PathView newlink) noexcept -> std::error_code;
+        virtual auto unlink(PathView name) noexcept -> std::error_code;
+        virtual auto rmdir(PathView name) noexcept -> std::error_code;
+        virtual auto rename(PathView oldname, PathView newname) noexcept -> std::error_code;
+        virtual auto mkdir(PathView path, int mode) noexcept -> std::error_code;
 
         /** Directory support API */
-        virtual auto diropen(const std::filesystem::path& path) noexcept -> result<std::unique_ptr<DirectoryHandle>>;
+        virtual auto diropen(PathView path) noexcept -> result<std::unique_ptr<DirectoryHandle>>;
         virtual auto dirreset(DirectoryHandle& handle) noexcept -> std::error_code;
         virtual auto dirnext(DirectoryHandle& handle, std::filesystem::path& filename, struct stat& filestat) -> std::error_code;
+        /// Read up to entries.size() next entries at once, returns their number, 0 at the end of directory. With @p full_stat, the inode of every entry is read as
+        /// well, by the inode number, without looking up its path. By default, entries are read one by one with dirnext and full_stat isn't supported.
+        virtual auto dirnext_batch(DirectoryHandle& handle, std::span<DirEntry> entries, bool full_stat) noexcept -> result<std::size_t>;
+        /// Position of the next entry, an opaque cookie for dirseek. 0 is the start of directory.
+        virtual auto dirtell(DirectoryHandle& handle) noexcept -> result<off_t>;
+        /// Continue the listing at a position returned by dirtell or carried by a DirEntry, without reading the entries preceding it
+        virtual auto dirseek(DirectoryHandle& handle, off_t cookie) noexcept -> std::error_code;
         virtual auto dirclose(DirectoryHandle& handle) noexcept -> std::error_code;
 
         /** Other fops API */
         virtual auto ftruncate(FileHandle& handle, off_t len) noexcept -> std::error_code;
+        /// Allocate the blocks of a file range without writing them, they read as zeros. @p mode is a set of FallocFlags.
+        virtual auto fallocate(FileHandle& handle, Flags mode, off_t offset, off_t len) noexcept -> std::error_code;
         virtual auto fsync(FileHandle& handle) noexcept -> std::error_code;
-        virtual auto ioctl(const std::filesystem::path& path, int cmd, void* arg) noexcept -> std::error_code;
-        virtual auto utimens(const std::filesystem::path& path, std::array<timespec, 2>& tv) noexcept -> std::error_code;
+        /// Like fsync, but metadata changes that aren't needed to read the file back (e.g. timestamps) may be skipped. Falls back to fsync by default.
+        virtual auto fdatasync(FileHandle& handle) noexcept -> std::error_code;
+        virtual auto ioctl(PathView path, int cmd, void* arg) noexcept -> std::error_code;
+        virtual auto utimens(PathView path, std::array<timespec, 2>& tv) noexcept -> std::error_code;
         virtual auto flock(FileHandle& handle, int cmd) noexcept -> std::error_code;
         virtual auto isatty(FileHandle& handle) noexcept -> result<bool>;
 
-        virtual auto chmod(const std::filesystem::path& path, mode_t mode) noexcept -> std::error_code;
+        virtual auto chmod(PathView path, mode_t mode) noexcept -> std::error_code;
         virtual auto fchmod(FileHandle& handle, mode_t mode) noexcept -> std::error_code;
 
         /// Try to fetch partition label
@@ -88,7 +147,7 @@ namespace vfs {
         DirectoryHandle(const DirectoryHandle&) = delete;
         auto operator=(const DirectoryHandle&)  = delete;
 
-        [[nodiscard]] std::filesystem::path get_root() const noexcept;
+        [[nodiscard]] std::string_view get_root() const noexcept;
 
     private:
         std::string root;
@@ -102,8 +161,8 @@ namespace vfs {
         FileHandle(const FileHandle&)     = delete;
         auto operator=(const FileHandle&) = delete;
 
-        [[nodiscard]] std::filesystem::path get_path() const noexcept;
-        [[nodiscard]] std::filesystem::path get_root() const noexcept;
+        [[nodiscard]] const std::filesystem::path& get_path() const noexcept;
+        [[nodiscard]] std::string_view             get_root() const noexcept;
 
     private:
         std::filesystem::path abspath;
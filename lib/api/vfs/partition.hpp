@@ -23,6 +23,8 @@ namespace vfs {
         [[nodiscard]] std::error_code     flush() override;
         [[nodiscard]] std::error_code     write(const std::byte& buf, sector_t lba, std::size_t count) override;
         [[nodiscard]] std::error_code     read(std::byte& buf, sector_t lba, std::size_t count) override;
+        [[nodiscard]] std::error_code     writev(std::span<const write_segment> segments) override;
+        [[nodiscard]] std::error_code     readv(std::span<const read_segment> segments) override;
         [[nodiscard]] result<std::size_t> get_sector_size() const override;
         [[nodiscard]] result<sector_t>    get_sector_count() const override;
         [[nodiscard]] std::string         get_name() const override;
@@ -31,6 +33,11 @@ namespace vfs {
         Disk&               disk;
         tools::MBRPartition info;
 
+        /// Segments translated at once by vectored I/O, longer requests are passed to the disk in batches
+        static constexpr std::size_t segment_batch = 8;
+
         [[nodiscard]] sector_t translate_sector(sector_t sector) const;
+        template <typename SegmentT, typename TransferT>
+        [[nodiscard]] std::error_code translate_segments(std::span<const SegmentT> segments, const TransferT& transfer) const;
     };
 } // namespace vfs
\ No newline at end of file
@@ -8,9 +8,24 @@
 #pragma once
 
 #include "defs.hpp"
+#include <cstdint>
 #include <string>
 
 namespace vfs {
+    struct CacheStats {
+        std::size_t   capacity;      //!< Maximum number of cached blocks
+        std::size_t   blocks;        //!< Number of currently cached blocks
+        std::uint64_t hits;          //!< Block lookups satisfied by the cache
+        std::uint64_t misses;        //!< Block lookups that required a device access
+        std::uint64_t evictions;     //!< Blocks dropped to make room for new ones
+        std::size_t   dirty;         //!< Blocks waiting to be written back
+        std::uint64_t dentry_hits;   //!< Path components resolved by the directory entry cache
+        std::uint64_t dentry_misses; //!< Path components that required a directory search
+        std::size_t   inodes;        //!< In-memory inodes shared by the open files
+        std::size_t   pinned;        //!< Blocks pinned by readers of file data in place, they can't be evicted
+        std::uint64_t overflows;     //!< Blocks allocated beyond the capacity because every cached block was referenced
+    };
+
     struct PartitionStats {
         std::string disk_name;   //!< Disk or partition name, e.g. 'sd0p0'
         std::string mount_point; //!< Mount point path, e.g. '/root'
@@ -18,5 +33,6 @@ namespace vfs {
         Flags       flags;       //!< Mount point flags
         std::size_t used_space;  //!< Used space in bytes
         std::size_t free_space;  //!< Free space in bytes
+        CacheStats  cache;       //!< Block cache statistics, zeroed if the filesystem doesn't provide them
     };
 } // namespace vfs
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+namespace vfs {
+
+    /**
+     * Non-owning view of a null terminated path. It's implicitly created from C strings, std::string and std::filesystem::path, so that passing a path
+     * through the VirtualFS and Filesystem API never copies it. The viewed path has to outlive the call it's passed to.
+     */
+    class PathView {
+    public:
+        PathView(const char* path) noexcept
+            : str {path != nullptr ? path : ""}
+        {
+        }
+        PathView(const std::string& path) noexcept
+            : str {path}
+        {
+        }
+        PathView(const std::filesystem::path& path) noexcept
+            : str {path.native()}
+        {
+        }
+        /// @p path has to be null terminated at path[size]
+        PathView(const char* path, const std::size_t size) noexcept
+            : str {path, size}
+        {
+        }
+
+        [[nodiscard]] auto c_str() const noexcept -> const char* { return str.data(); }
+        [[nodiscard]] auto view() const noexcept -> std::string_view { return str; }
+        [[nodiscard]] auto empty() const noexcept -> bool { return str.empty(); }
+
+    private:
+        std::string_view str;
+    };
+
+} // namespace vfs
@@ -34,6 +34,7 @@ namespace vfs::tools::mkfs {
         bool                 journal;
         std::string          label;
         std::array<char, 16> uuid;
+        bool                 dir_index {true}; ///< Hashed directory index, a filesystem formatted without it gets it on its first read-write mount
     };
 
     /**
@@ -28,7 +28,12 @@ namespace vfs {
 
     class VirtualFS {
     public:
-        VirtualFS(DiskManager& dmngr, std::unique_ptr<StdStream>&& stream);
+        /**
+         * @param dmngr disk manager providing block devices to mount
+         * @param stream standard streams(stdin/stdout/stderr)
+         * @param max_files maximum number of simultaneously opened file descriptors, excluding the standard streams
+         */
+        VirtualFS(DiskManager& dmngr, std::unique_ptr<StdStream>&& stream, std::size_t max_files = max_open_files);
         ~VirtualFS();
         VirtualFS(const VirtualFS&)      = delete;
         auto operator=(const VirtualFS&) = delete;
@@ -59,9 +64,10 @@ namespace vfs {
          * Mount all available partitions within registered blockdevices automatically. Root directories will be filled automatically based on partition's label
          * or predefined prefix(if label is not available). It tries to mount all available partitions from all registered blok devices even if, during the
          * process, some can't be mounted. In that case, it tries to mount a next partition from the list.
+         * @param options mount options applied to every partition
          * @return 0 in case of success otherwise, an error code
          */
-        std::error_code mount_all();
+        std::error_code mount_all(const MountOptions& options = {});
 
         /**
          * Mount a specific partition
@@ -70,9 +76,10 @@ namespace vfs {
          * partition's label or predefined prefix, e.g. '/volumeX' where X is a unique number.
          * @param fstype filesystem type(e.g., 'ext4', 'ext3','vfat'). Pass empty string to detect type automatically.
          * @param flags optional mount flags
+         * @param options optional mount options, e.g. block cache capacity
          * @return 0 in case of success otherwise, an error code
          */
-        std::error_code mount(std::string_view disk_name, std::string root, std::string fstype, Flags flags = 0);
+        std::error_code mount(std::string_view disk_name, std::string root, std::string fstype, Flags flags = 0, const MountOptions& options = {});
 
         /**
          * Un-mount all partitions
@@ -103,44 +110,57 @@ namespace vfs {
          * Get information about corresponding partition for given path
          * @return partition stats
          */
-        auto stat_parts_of(const std::filesystem::path& path) noexcept -> result<PartitionStats>;
+        auto stat_parts_of(PathView path) noexcept -> result<PartitionStats>;
 
         /** Standard file access API */
-        auto open(const std::filesystem::path& path, int flags, int mode) noexcept -> result<int>;
+        auto open(PathView path, int flags, int mode) noexcept -> result<int>;
         auto close(int fd) noexcept -> std::error_code;
         auto write(int fd, const char* ptr, size_t len) noexcept -> result<std::size_t>;
         auto read(int fd, char* ptr, size_t len) noexcept -> result<std::size_t>;
+        /// Zero-copy read of up to @p len bytes at @p offset, the file position isn't changed. The data stays in place, e.g. pinned in the block cache, until
+        /// the returned object is destroyed. It may be shorter than requested, so larger ranges are read in a loop. Writing or truncating the range while
+        /// it's pinned leaves the pinned data undefined, hence it's meant for read-mostly files. ENOBUFS if too many blocks are pinned already.
+        auto read_pinned(int fd, off_t offset, std::size_t len) noexcept -> result<PinnedData>;
         auto lseek(int fd, off_t pos, int dir) noexcept -> result<off_t>;
         auto fstat(int fd, struct stat& st) noexcept -> std::error_code;
-        auto stat(const std::filesystem::path& path, struct stat& st) noexcept -> std::error_code;
-        auto link(const std::filesystem::path& existing, const std::filesystem::path& newlink) noexcept -> std::error_code;
-        auto symlink(const std::filesystem::path& existing, const std::filesystem::path& newlink) noexcept -> std::error_code;
-        auto unlink(const std::filesystem::path& name) noexcept -> std::error_code;
-        auto rename(const std::filesystem::path& oldname, const std::filesystem::path& newname) noexcept -> std::error_code;
-        auto mkdir(const std::filesystem::path& path, int mode) noexcept -> std::error_code;
-        auto rmdir(const std::filesystem::path& path) noexcept -> std::error_code;
+        auto stat(PathView path, struct stat& st) noexcept -> std::error_code;
+        auto link(PathView existing, PathView newlink) noexcept -> std::error_code;
+        auto symlink(PathView existing, PathView newlink) noexcept -> std::error_code;
+        auto unlink(PathView name) noexcept -> std::error_code;
+        auto rename(PathView oldname, PathView newname) noexcept -> std::error_code;
+        auto mkdir(PathView path, int mode) noexcept -> std::error_code;
+        auto rmdir(PathView path) noexcept -> std::error_code;
 
         /** Directory support API */
-        auto diropen(const std::filesystem::path& path) noexcept -> result<std::unique_ptr<DirectoryHandle>>;
+        auto diropen(PathView path) noexcept -> result<std::unique_ptr<DirectoryHandle>>;
         auto dirreset(DirectoryHandle& handle) noexcept -> std::error_code;
         auto dirnext(DirectoryHandle& handle, std::filesystem::path& filename, struct stat& filestat) noexcept -> std::error_code;
+        /// Read up to entries.size() next entries under a single lock, returns their number, 0 at the end of directory. With @p full_stat, entries get the
+        /// whole stat of their inodes, read without looking up the entry paths.
+        auto dirnext_batch(DirectoryHandle& handle, std::span<DirEntry> entries, bool full_stat = false) noexcept -> result<std::size_t>;
+        /// Opaque position of the next entry, see dirseek
+        auto dirtell(DirectoryHandle& handle) noexcept -> result<off_t>;
+        /// Continue the listing at a position returned by dirtell or carried by a DirEntry
+        auto dirseek(DirectoryHandle& handle, off_t cookie) noexcept -> std::error_code;
         auto dirclose(DirectoryHandle& handle) noexcept -> std::error_code;
 
         /** Other fops API */
         auto ftruncate(int fd, off_t len) noexcept -> std::error_code;
+        auto fallocate(int fd, Flags mode, off_t offset, off_t len) noexcept -> std::error_code;
         auto fsync(int fd) noexcept -> std::error_code;
-        auto ioctl(const std::filesystem::path& path, int cmd, void* arg) noexcept -> std::error_code;
-        auto utimens(const std::filesystem::path& path, std::array<timespec, 2>& tv) noexcept -> std::error_code;
+        auto fdatasync(int fd) noexcept -> std::error_code;
+        auto ioctl(PathView path, int cmd, void* arg) noexcept -> std::error_code;
+        auto utimens(PathView path, std::array<timespec, 2>& tv) noexcept -> std::error_code;
         auto flock(int fd, int cmd) noexcept -> std::error_code;
         auto isatty(int fd) noexcept -> result<bool>;
 
-        auto chmod(const std::filesystem::path& path, mode_t mode) noexcept -> std::error_code;
+        auto chmod(PathView path, mode_t mode) noexcept -> std::error_code;
         auto fchmod(int fd, mode_t mode) noexcept -> std::error_code;
 
         auto getcwd() noexcept -> std::filesystem::path;
-        auto chdir(const std::filesystem::path& name) noexcept -> std::error_code;
+        auto chdir(PathView name) noexcept -> std::error_code;
 
-        auto stat_vfs(const std::filesystem::path& path, struct statvfs& stat) noexcept -> std::error_code;
+        auto stat_vfs(PathView path, struct statvfs& stat) noexcept -> std::error_code;
 
     private:
         struct Pimpl;
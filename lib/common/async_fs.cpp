@@ -0,0 +1,41 @@
+#include "api/vfs/async_fs.hpp"
+#include "api/vfs/vfs.hpp"
+
+namespace vfs {
+
+    AsyncFS::AsyncFS(VirtualFS& vfs, Executor& io_executor)
+        : m_vfs {vfs}
+        , m_io {io_executor}
+    {
+    }
+
+    auto AsyncFS::async_read(const int fd, const std::span<char> buf, std::stop_token token) -> IoAwaitable<std::size_t>
+    {
+        return async_read(fd, buf, m_io, std::move(token));
+    }
+
+    auto AsyncFS::async_read(const int fd, const std::span<char> buf, Executor& completion, std::stop_token token) -> IoAwaitable<std::size_t>
+    {
+        return {[this, fd, buf] { return m_vfs.read(fd, buf.data(), buf.size()); }, m_io, completion, std::move(token)};
+    }
+
+    auto AsyncFS::async_write(const int fd, const std::span<const char> buf, std::stop_token token) -> IoAwaitable<std::size_t>
+    {
+        return async_write(fd, buf, m_io, std::move(token));
+    }
+
+    auto AsyncFS::async_write(const int fd, const std::span<const char> buf, Executor& completion, std::stop_token token) -> IoAwaitable<std::size_t>
+    {
+        return {[this, fd, buf] { return m_vfs.write(fd, buf.data(), buf.size()); }, m_io, completion, std::move(token)};
+    }
+
+    auto AsyncFS::async_open(std::filesystem::path path, const int flags, const int mode, std::stop_token token) -> IoAwaitable<int>
+    {
+        return async_open(std::move(path), flags, mode, m_io, std::move(token));
+    }
+
+    auto AsyncFS::async_open(std::filesystem::path path, const int flags, const int mode, Executor& completion, std::stop_token token) -> IoAwaitable<int>
+    {
+        return {[this, path = std::move(path), flags, mode] { return m_vfs.open(path, flags, mode); }, m_io, completion, std::move(token)};
+    }
+} // namespace vfs
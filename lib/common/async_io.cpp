@@ -0,0 +1,174 @@
+#include "api/vfs/async_io.hpp"
+#include "api/vfs/vfs.hpp"
+
+#include <algorithm>
+
+namespace vfs {
+    namespace {
+        bool targets_descriptor(const IoOpcode opcode) { return opcode != IoOpcode::open and opcode != IoOpcode::stat; }
+
+        result<std::size_t> to_result(const std::error_code err)
+        {
+            if (err) { return error(err); }
+            return 0;
+        }
+    } // namespace
+
+    SubmissionEntry SubmissionEntry::read(const int fd, char* buf, const std::size_t len, const std::uint64_t user_data)
+    {
+        SubmissionEntry sqe {.opcode = IoOpcode::read, .fd = fd, .buf = buf, .len = len, .user_data = user_data};
+        return sqe;
+    }
+    SubmissionEntry SubmissionEntry::write(const int fd, const char* data, const std::size_t len, const std::uint64_t user_data)
+    {
+        SubmissionEntry sqe {.opcode = IoOpcode::write, .fd = fd, .data = data, .len = len, .user_data = user_data};
+        return sqe;
+    }
+    SubmissionEntry SubmissionEntry::fsync(const int fd, const std::uint64_t user_data)
+    {
+        SubmissionEntry sqe {.opcode = IoOpcode::fsync, .fd = fd, .user_data = user_data};
+        return sqe;
+    }
+    SubmissionEntry SubmissionEntry::open(std::filesystem::path path, const int flags, const int mode, const std::uint64_t user_data)
+    {
+        SubmissionEntry sqe {.opcode = IoOpcode::open, .path = std::move(path), .flags = flags, .mode = mode, .user_data = user_data};
+        return sqe;
+    }
+    SubmissionEntry SubmissionEntry::close(const int fd, const std::uint64_t user_data)
+    {
+        SubmissionEntry sqe {.opcode = IoOpcode::close, .fd = fd, .user_data = user_data};
+        return sqe;
+    }
+    SubmissionEntry SubmissionEntry::stat(std::filesystem::path path, struct stat& st, const std::uint64_t user_data)
+    {
+        SubmissionEntry sqe {.opcode = IoOpcode::stat, .path = std::move(path), .st = &st, .user_data = user_data};
+        return sqe;
+    }
+    SubmissionEntry SubmissionEntry::fstat(const int fd, struct stat& st, const std::uint64_t user_data)
+    {
+        SubmissionEntry sqe {.opcode = IoOpcode::fstat, .fd = fd, .st = &st, .user_data = user_data};
+        return sqe;
+    }
+
+    AsyncIO::AsyncIO(VirtualFS& vfs, const std::size_t workers)
+        : m_vfs {vfs}
+    {
+        for (std::size_t i = 0; i < std::max<std::size_t>(workers, 1); ++i) {
+            m_workers.emplace_back([this] { worker(); });
+        }
+    }
+
+    AsyncIO::~AsyncIO()
+    {
+        {
+            std::lock_guard lock {m_mutex};
+            m_stop = true;
+        }
+        m_submitted.notify_all();
+        m_workers.clear();
+    }
+
+    std::size_t AsyncIO::submit(const std::span<const SubmissionEntry> entries)
+    {
+        {
+            std::lock_guard lock {m_mutex};
+            m_pending.insert(m_pending.end(), entries.begin(), entries.end());
+            m_in_flight += entries.size();
+        }
+        m_submitted.notify_all();
+        return entries.size();
+    }
+
+    std::size_t AsyncIO::reap(const std::span<CompletionEntry> completions, const std::size_t min_complete)
+    {
+        std::unique_lock lock {m_mutex};
+        /// Never wait for more completions than requests in flight, those would never arrive
+        const auto wanted = std::min({min_complete, completions.size(), m_in_flight});
+        m_completed.wait(lock, [&] { return m_completions.size() >= wanted; });
+
+        const auto count = std::min(completions.size(), m_completions.size());
+        std::move(m_completions.begin(), m_completions.begin() + static_cast<std::ptrdiff_t>(count), completions.begin());
+        m_completions.erase(m_completions.begin(), m_completions.begin() + static_cast<std::ptrdiff_t>(count));
+        m_in_flight -= count;
+        return count;
+    }
+
+    std::size_t AsyncIO::in_flight() const
+    {
+        std::lock_guard lock {m_mutex};
+        return m_in_flight;
+    }
+
+    /// Find the oldest request that can be executed right now, that is the one whose descriptor is neither being served nor targeted by an older request
+    std::deque<SubmissionEntry>::iterator AsyncIO::next_runnable()
+    {
+        std::vector<int> skipped;
+        for (auto it = m_pending.begin(); it != m_pending.end(); ++it) {
+            if (not targets_descriptor(it->opcode)) { return it; }
+            if (std::ranges::find(m_busy_fds, it->fd) == m_busy_fds.end() and std::ranges::find(skipped, it->fd) == skipped.end()) { return it; }
+            skipped.push_back(it->fd);
+        }
+        return m_pending.end();
+    }
+
+    void AsyncIO::worker()
+    {
+        std::unique_lock lock {m_mutex};
+        while (true) {
+            auto it = next_runnable();
+            if (it == m_pending.end()) {
+                if (m_stop and m_pending.empty()) { return; }
+                m_submitted.wait(lock);
+                continue;
+            }
+
+            const auto sqe = std::move(*it);
+            m_pending.erase(it);
+            const auto ordered = targets_descriptor(sqe.opcode);
+            if (ordered) { m_busy_fds.push_back(sqe.fd); }
+
+            lock.unlock();
+            auto cqe = execute(sqe);
+            lock.lock();
+
+            if (ordered) { m_busy_fds.erase(std::ranges::find(m_busy_fds, sqe.fd)); }
+            m_completions.push_back(std::move(cqe));
+            m_completed.notify_all();
+            /// Requests that waited for the descriptor can be picked up by other workers now
+            if (ordered) { m_submitted.notify_all(); }
+        }
+    }
+
+    CompletionEntry AsyncIO::execute(const SubmissionEntry& sqe)
+    {
+        CompletionEntry cqe {.user_data = sqe.user_data, .res = 0};
+        switch (sqe.opcode) {
+        case IoOpcode::read:
+            cqe.res = m_vfs.read(sqe.fd, sqe.buf, sqe.len);
+            break;
+        case IoOpcode::write:
+            cqe.res = m_vfs.write(sqe.fd, sqe.data, sqe.len);
+            break;
+        case IoOpcode::fsync:
+            cqe.res = to_result(m_vfs.fsync(sqe.fd));
+            break;
+        case IoOpcode::open:
+            if (const auto fd = m_vfs.open(sqe.path, sqe.flags, sqe.mode); fd) {
+                cqe.res = static_cast<std::size_t>(*fd);
+            } else {
+                cqe.res = error(fd.error());
+            }
+            break;
+        case IoOpcode::close:
+            cqe.res = to_result(m_vfs.close(sqe.fd));
+            break;
+        case IoOpcode::stat:
+            cqe.res = to_result(m_vfs.stat(sqe.path, *sqe.st));
+            break;
+        case IoOpcode::fstat:
+            cqe.res = to_result(m_vfs.fstat(sqe.fd, *sqe.st));
+            break;
+        }
+        return cqe;
+    }
+} // namespace vfs
@@ -44,6 +44,16 @@ namespace vfs {
         auto_lock _lock(mutex);
         return device.read(buf, lba, count);
     }
+    std::error_code Disk::writev(const std::span<const write_segment> segments)
+    {
+        auto_lock _lock(mutex);
+        return device.writev(segments);
+    }
+    std::error_code Disk::readv(const std::span<const read_segment> segments)
+    {
+        auto_lock _lock(mutex);
+        return device.readv(segments);
+    }
     result<std::size_t> Disk::get_sector_size() const
     {
         auto_lock _lock(mutex);
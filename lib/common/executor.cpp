@@ -0,0 +1,76 @@
+#include "api/vfs/executor.hpp"
+
+#include <algorithm>
+
+namespace vfs {
+
+    ThreadPoolExecutor::ThreadPoolExecutor(const std::size_t threads)
+    {
+        for (std::size_t i = 0; i < std::max<std::size_t>(threads, 1); ++i) {
+            m_workers.emplace_back([this] { worker(); });
+        }
+    }
+
+    ThreadPoolExecutor::~ThreadPoolExecutor()
+    {
+        {
+            std::lock_guard lock {m_mutex};
+            m_stop = true;
+        }
+        m_cond.notify_all();
+        m_workers.clear();
+    }
+
+    void ThreadPoolExecutor::post(std::function<void()> task)
+    {
+        {
+            std::lock_guard lock {m_mutex};
+            m_tasks.push_back(std::move(task));
+        }
+        m_cond.notify_one();
+    }
+
+    void ThreadPoolExecutor::worker()
+    {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock lock {m_mutex};
+                m_cond.wait(lock, [this] { return m_stop or not m_tasks.empty(); });
+                if (m_tasks.empty()) { return; }
+                task = std::move(m_tasks.front());
+                m_tasks.pop_front();
+            }
+            task();
+        }
+    }
+
+    void ManualExecutor::post(std::function<void()> task)
+    {
+        {
+            std::lock_guard lock {m_mutex};
+            m_tasks.push_back(std::move(task));
+        }
+        m_cond.notify_one();
+    }
+
+    std::size_t ManualExecutor::run_pending()
+    {
+        std::deque<std::function<void()>> tasks;
+        {
+            std::lock_guard lock {m_mutex};
+            tasks.swap(m_tasks);
+        }
+        for (auto& task : tasks) { task(); }
+        return tasks.size();
+    }
+
+    std::size_t ManualExecutor::run_one_batch()
+    {
+        {
+            std::unique_lock lock {m_mutex};
+            m_cond.wait(lock, [this] { return not m_tasks.empty(); });
+        }
+        return run_pending();
+    }
+} // namespace vfs
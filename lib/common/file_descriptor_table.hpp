@@ -0,0 +1,181 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace vfs {
+
+    /**
+     * Fixed-capacity table of open file descriptors.
+     * Like POSIX open(), the lowest free descriptor is allocated. Free slots are tracked by a lock-free bitmap, so allocation scans capacity / 64 words at most
+     * and release is O(1). Lookups are wait-free: every slot carries a generation counter(odd while
+     * the slot is occupied) and a counter of in-flight users. A reader registers itself as a user and then checks the generation, while a remover first bumps
+     * the generation and then waits for in-flight users to leave. Thanks to that, a value is never destroyed while it is borrowed.
+     */
+    template <typename ValueT> class file_descriptor_table {
+        struct slot;
+
+    public:
+        /// RAII guard of a borrowed table entry. The entry can't be removed from the table as long as the guard is alive.
+        class borrowed {
+        public:
+            borrowed() = default;
+            borrowed(borrowed&& oth) noexcept
+                : entry {std::exchange(oth.entry, nullptr)}
+            {
+            }
+            borrowed& operator=(borrowed&&) = delete;
+            borrowed(const borrowed&)       = delete;
+            borrowed& operator=(const borrowed&) = delete;
+            ~borrowed()
+            {
+                if (entry != nullptr) { entry->users.fetch_sub(1); }
+            }
+
+            explicit operator bool() const noexcept { return entry != nullptr; }
+            ValueT&  operator*() const noexcept { return *entry->value; }
+            ValueT*  operator->() const noexcept { return &*entry->value; }
+
+        private:
+            friend class file_descriptor_table;
+            explicit borrowed(slot* entry)
+                : entry {entry}
+            {
+            }
+            slot* entry {};
+        };
+
+        /**
+         * @param capacity maximum number of simultaneously opened descriptors
+         * @param first_fd number of the first descriptor, lower numbers are reserved(i.e. stdin/stdout/stderr)
+         */
+        file_descriptor_table(const std::size_t capacity, const int first_fd)
+            : slots {std::make_unique<slot[]>(capacity)}
+            , used {std::make_unique<std::atomic<std::uint64_t>[]>(words(capacity))}
+            , capacity {capacity}
+            , first_fd {first_fd}
+        {
+            /// Bits past the capacity are never free
+            if (const auto tail = capacity % word_bits; tail != 0) { used[words(capacity) - 1].store(~std::uint64_t {} << tail); }
+        }
+
+        file_descriptor_table(const file_descriptor_table&)            = delete;
+        file_descriptor_table& operator=(const file_descriptor_table&) = delete;
+
+        /**
+         * Insert a value into the table
+         * @param value value to be stored, it's left untouched if the table is full
+         * @return allocated file descriptor number or nullopt if the table is full
+         */
+        std::optional<int> insert(ValueT&& value)
+        {
+            const auto index = acquire_lowest();
+            if (index == npos) { return std::nullopt; }
+
+            auto& entry = slots[index];
+            entry.value.emplace(std::move(value));
+            /// Publish the value, generation becomes odd
+            entry.generation.fetch_add(1);
+            return first_fd + static_cast<int>(index);
+        }
+
+        /**
+         * Borrow a value associated with given file descriptor. Never blocks.
+         * @param fd file descriptor
+         * @return guard of the value, empty if the descriptor is not opened
+         */
+        borrowed get(const int fd) const
+        {
+            const auto entry = find_slot(fd);
+            if (entry == nullptr) { return {}; }
+
+            entry->users.fetch_add(1);
+            if ((entry->generation.load() & 1U) == 0) {
+                entry->users.fetch_sub(1);
+                return {};
+            }
+            return borrowed {entry};
+        }
+
+        [[nodiscard]] bool exist(const int fd) const { return static_cast<bool>(get(fd)); }
+
+        /**
+         * Remove a value from the table. Waits until all the users that borrowed the value in the meantime are gone, hence it must not be called while
+         * the calling thread holds a guard of the same descriptor.
+         * @param fd file descriptor
+         * @return removed value or nullopt if the descriptor is not opened
+         */
+        std::optional<ValueT> remove(const int fd)
+        {
+            const auto entry = find_slot(fd);
+            if (entry == nullptr) { return std::nullopt; }
+
+            auto generation = entry->generation.load();
+            do {
+                if ((generation & 1U) == 0) { return std::nullopt; }
+            } while (not entry->generation.compare_exchange_weak(generation, generation + 1));
+
+            while (entry->users.load() != 0) { std::this_thread::yield(); }
+
+            std::optional<ValueT> value {std::in_place, std::move(*entry->value)};
+            entry->value.reset();
+            release(static_cast<std::size_t>(entry - slots.get()));
+            return value;
+        }
+
+        /// Snapshot of currently opened descriptors
+        [[nodiscard]] std::vector<int> descriptors() const
+        {
+            std::vector<int> fds;
+            for (std::size_t i = 0; i < capacity; ++i) {
+                if ((slots[i].generation.load() & 1U) != 0) { fds.push_back(first_fd + static_cast<int>(i)); }
+            }
+            return fds;
+        }
+
+    private:
+        static constexpr auto npos      = std::numeric_limits<std::size_t>::max();
+        static constexpr auto word_bits = std::size_t {64};
+
+        struct slot {
+            std::atomic<std::uint32_t> generation {};
+            std::atomic<std::uint32_t> users {};
+            std::optional<ValueT>      value;
+        };
+
+        static constexpr std::size_t words(const std::size_t capacity) { return (capacity + word_bits - 1) / word_bits; }
+
+        slot* find_slot(const int fd) const
+        {
+            if (fd < first_fd or static_cast<std::size_t>(fd - first_fd) >= capacity) { return nullptr; }
+            return &slots[fd - first_fd];
+        }
+
+        /// Claim the lowest clear bit of the bitmap
+        std::size_t acquire_lowest()
+        {
+            for (std::size_t w = 0; w < words(capacity); ++w) {
+                auto bits = used[w].load();
+                while (bits != ~std::uint64_t {}) {
+                    const auto bit = static_cast<std::size_t>(std::countr_one(bits));
+                    if (used[w].compare_exchange_weak(bits, bits | (std::uint64_t {1} << bit))) { return w * word_bits + bit; }
+                }
+            }
+            return npos;
+        }
+
+        void release(const std::size_t index) { used[index / word_bits].fetch_and(~(std::uint64_t {1} << (index % word_bits))); }
+
+        std::unique_ptr<slot[]>                       slots;
+        std::unique_ptr<std::atomic<std::uint64_t>[]> used; ///< Bit set for every occupied slot
+        std::size_t                                   capacity;
+        int                                           first_fd;
+    };
+} // namespace vfs
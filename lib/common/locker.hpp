@@ -6,14 +6,24 @@ namespace vfs {
 
     template <typename ValueT, typename MutexT> class locker;
 
-    template <typename ValueT, typename MutexT> class locked {
+    /// Lock ownership policy. 'shared' requires MutexT to satisfy SharedMutex requirements.
+    enum class lock_mode { exclusive, shared };
+
+    template <typename ValueT, typename MutexT, lock_mode Mode = lock_mode::exclusive> class locked {
     public:
         locked(const locked& oth)        = delete;
         locked& operator=(const locked&) = delete;
         locked& operator=(locked&&)      = delete;
         locked(locked&& oth)             = delete;
 
-        ~locked() { mutex.unlock(); }
+        ~locked()
+        {
+            if constexpr (Mode == lock_mode::shared) {
+                mutex.unlock_shared();
+            } else {
+                mutex.unlock();
+            }
+        }
         ValueT& get() const { return value; }
         ValueT& operator*() const { return get(); }
 
@@ -24,7 +34,11 @@ namespace vfs {
             : value {value}
             , mutex {mutex}
         {
-            mutex.lock();
+            if constexpr (Mode == lock_mode::shared) {
+                mutex.lock_shared();
+            } else {
+                mutex.lock();
+            }
         }
         ValueT& value;
         MutexT& mutex;
@@ -39,6 +53,10 @@ namespace vfs {
 
         locked<ValueT, MutexT> lock() { return {value, mutex}; }
 
+        template <lock_mode Mode> locked<ValueT, MutexT, Mode> lock() { return {value, mutex}; }
+
+        locked<ValueT, MutexT, lock_mode::shared> lock_shared() { return {value, mutex}; }
+
     private:
         ValueT value;
         MutexT mutex;
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "normal_path.hpp"
+
+namespace vfs {
+
+    /**
+     * Prefix tree of mount roots keyed by path components. It resolves a path to the mount point with the longest matching root in O(path components).
+     * Lookups work on an immutable snapshot of the tree and never take a lock. Insertion and removal copy the tree, apply the change and publish the new
+     * version atomically, thus they are serialized with each other only.
+     */
+    template <typename ValueT> class mount_tree {
+    public:
+        mount_tree()
+            : m_root {std::make_shared<const node>()}
+        {
+        }
+
+        /**
+         * Find value of the mount point with the longest root matching given path
+         * @param path absolute, lexically normal path
+         * @return found value or nullopt if none of the roots is a prefix of the path
+         */
+        [[nodiscard]] std::optional<ValueT> find(const std::string_view path) const
+        {
+            const auto  snapshot = m_root.load(std::memory_order_acquire);
+            const node* current  = snapshot.get();
+            const node* best     = current->mounted ? current : nullptr;
+            for (const auto component : path_components {path}) {
+                current = current->child(component);
+                if (current == nullptr) { break; }
+                if (current->mounted) { best = current; }
+            }
+            return best != nullptr ? std::optional<ValueT> {best->value} : std::nullopt;
+        }
+
+        /**
+         * Find value of the mount point whose root is equal to given path
+         * @param root absolute mount point root
+         * @return found value or nullopt
+         */
+        [[nodiscard]] std::optional<ValueT> find_exact(const std::string_view root) const
+        {
+            if (not root.starts_with('/')) { return std::nullopt; }
+            const auto snapshot = m_root.load(std::memory_order_acquire);
+            const auto found    = snapshot->lookup(root);
+            return found != nullptr and found->mounted ? std::optional<ValueT> {found->value} : std::nullopt;
+        }
+
+        /**
+         * Insert a new mount point
+         * @param root absolute mount point root
+         * @param value value associated with the mount point
+         * @return true if inserted, false if given root is already occupied or not absolute
+         */
+        bool insert(const std::string_view root, ValueT value)
+        {
+            if (not root.starts_with('/')) { return false; }
+            std::lock_guard lock {m_write_mutex};
+
+            auto  copy    = std::make_shared<node>(*m_root.load(std::memory_order_relaxed));
+            node* current = copy.get();
+            for (const auto component : path_components {root}) { current = &current->child_or_insert(component); }
+            if (current->mounted) { return false; }
+
+            current->value   = std::move(value);
+            current->mounted = true;
+            m_root.store(std::move(copy), std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * Remove mount point
+         * @param root absolute mount point root
+         * @return true if removed, false if given root was not found
+         */
+        bool erase(const std::string_view root)
+        {
+            if (not root.starts_with('/')) { return false; }
+            std::lock_guard lock {m_write_mutex};
+
+            auto copy = std::make_shared<node>(*m_root.load(std::memory_order_relaxed));
+            if (not copy->erase(path_components {root}.begin())) { return false; }
+
+            m_root.store(std::move(copy), std::memory_order_release);
+            return true;
+        }
+
+        void clear()
+        {
+            std::lock_guard lock {m_write_mutex};
+            m_root.store(std::make_shared<const node>(), std::memory_order_release);
+        }
+
+        /// Invoke 'fun(root, value)' for every mount point available in the current snapshot of the tree
+        template <typename Fun> void for_each(Fun&& fun) const
+        {
+            const auto  snapshot = m_root.load(std::memory_order_acquire);
+            std::string root;
+            snapshot->visit(root, fun);
+        }
+
+    private:
+        struct node {
+            std::string       name;
+            ValueT            value {};
+            bool              mounted {false};
+            std::vector<node> children; ///< Sorted by name
+
+            [[nodiscard]] const node* child(const std::string_view component) const
+            {
+                const auto it = std::ranges::lower_bound(children, component, {}, &node::name);
+                return it != children.end() and it->name == component ? &*it : nullptr;
+            }
+
+            node& child_or_insert(const std::string_view component)
+            {
+                const auto it = std::ranges::lower_bound(children, component, {}, &node::name);
+                if (it != children.end() and it->name == component) { return *it; }
+                node fresh;
+                fresh.name = component;
+                return *children.insert(it, std::move(fresh));
+            }
+
+            [[nodiscard]] const node* lookup(const std::string_view path) const
+            {
+                const node* current = this;
+                for (const auto component : path_components {path}) {
+                    current = current->child(component);
+                    if (current == nullptr) { return nullptr; }
+                }
+                return current;
+            }
+
+            /// Remove value from the node pointed by 'it' and prune branches that don't lead to any mount point anymore
+            bool erase(path_components::iterator it)
+            {
+                if (it == path_components::iterator {}) {
+                    if (not mounted) { return false; }
+                    value   = {};
+                    mounted = false;
+                    return true;
+                }
+                const auto component = *it;
+                const auto child     = std::ranges::lower_bound(children, component, {}, &node::name);
+                if (child == children.end() or child->name != component) { return false; }
+                if (not child->erase(++it)) { return false; }
+                if (not child->mounted and child->children.empty()) { children.erase(child); }
+                return true;
+            }
+
+            template <typename Fun> void visit(std::string& path, Fun& fun) const
+            {
+                if (mounted) { fun(path.empty() ? std::string {"/"} : path, value); }
+                for (const auto& c : children) {
+                    const auto len = path.size();
+                    path.append("/").append(c.name);
+                    c.visit(path, fun);
+                    path.resize(len);
+                }
+            }
+        };
+
+        std::atomic<std::shared_ptr<const node>> m_root;
+        mutable std::mutex                       m_write_mutex;
+    };
+} // namespace vfs
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <climits>
+#include <cstddef>
+#include <string_view>
+#include <system_error>
+
+#include "api/vfs/defs.hpp"
+#include "api/vfs/path_view.hpp"
+
+namespace vfs {
+
+#ifdef PATH_MAX
+    constexpr std::size_t path_max = PATH_MAX;
+#else
+    constexpr std::size_t path_max = 1024;
+#endif
+
+    /// Iterates over components of a slash separated path. Empty components(leading, trailing or repeated separators) are skipped.
+    class path_components {
+    public:
+        class iterator {
+        public:
+            iterator() = default;
+            explicit iterator(const std::string_view path)
+                : rest {path}
+            {
+                advance();
+            }
+
+            std::string_view operator*() const { return current; }
+            iterator&        operator++()
+            {
+                advance();
+                return *this;
+            }
+            bool operator==(const iterator& oth) const { return current.data() == oth.current.data() and current.size() == oth.current.size(); }
+
+        private:
+            void advance()
+            {
+                const auto start = rest.find_first_not_of('/');
+                if (start == std::string_view::npos) {
+                    current = {};
+                    rest    = {};
+                    return;
+                }
+                rest           = rest.substr(start);
+                const auto end = std::min(rest.find('/'), rest.size());
+                current        = rest.substr(0, end);
+                rest           = rest.substr(end);
+            }
+
+            std::string_view current;
+            std::string_view rest;
+        };
+
+        explicit path_components(const std::string_view path)
+            : path {path}
+        {
+        }
+
+        [[nodiscard]] iterator begin() const { return iterator {path}; }
+        [[nodiscard]] iterator end() const { return {}; }
+
+    private:
+        std::string_view path;
+    };
+
+    /**
+     * Absolute, lexically normal path held in a fixed size buffer, so that resolving a path never allocates. Normalization follows
+     * std::filesystem::path::lexically_normal() for absolute paths: repeated separators and '.' components are removed, '..' removes the preceding
+     * component and a trailing separator is kept, as well as one following a trailing '.' or '..'.
+     */
+    class normal_path {
+    public:
+        normal_path() noexcept { buffer[0] = '\0'; }
+        normal_path(const normal_path&)    = delete;
+        auto operator=(const normal_path&) = delete;
+
+        /**
+         * Normalize a path into the buffer
+         * @param path path to normalize
+         * @return EINVAL if the path isn't absolute, ENAMETOOLONG if the normalized path doesn't fit path_max including the terminating null
+         */
+        auto assign(const std::string_view path) noexcept -> std::error_code
+        {
+            length    = 0;
+            buffer[0] = '\0';
+            if (not path.starts_with('/')) { return from_errno(EINVAL); }
+
+            buffer[length++] = '/';
+            bool trailing_sep {};
+            for (const auto component : path_components {path}) {
+                trailing_sep = component == "." or component == "..";
+                if (component == ".") { continue; }
+                if (component == "..") {
+                    length = std::max<std::size_t>(std::string_view {buffer.data(), length}.rfind('/'), 1);
+                    continue;
+                }
+                /// Separator, component, a possible trailing separator and the terminating null
+                if (length + component.size() + 3 > buffer.size()) {
+                    length    = 0;
+                    buffer[0] = '\0';
+                    return from_errno(ENAMETOOLONG);
+                }
+                if (length > 1) { buffer[length++] = '/'; }
+                std::copy(component.begin(), component.end(), buffer.begin() + length);
+                length += component.size();
+            }
+            if ((trailing_sep or path.ends_with('/')) and length > 1) { buffer[length++] = '/'; }
+            buffer[length] = '\0';
+            return {};
+        }
+
+        [[nodiscard]] auto c_str() const noexcept -> const char* { return buffer.data(); }
+        [[nodiscard]] auto view() const noexcept -> std::string_view { return {buffer.data(), length}; }
+        [[nodiscard]] auto size() const noexcept -> std::size_t { return length; }
+        [[nodiscard]] auto components() const noexcept -> path_components { return path_components {view()}; }
+
+        operator PathView() const noexcept { return {buffer.data(), length}; }
+
+    private:
+        std::array<char, path_max> buffer; ///< Left uninitialized past the terminating null, it's large
+        std::size_t                length {};
+    };
+} // namespace vfs
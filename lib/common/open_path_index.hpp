@@ -0,0 +1,74 @@
+#pragma once
+
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace vfs {
+
+    /// Reference counter of opened paths that enables delayed unlinking of files which are still opened
+    class open_path_index {
+    public:
+        /// Register a new user of the path
+        void acquire(const std::string_view path)
+        {
+            std::lock_guard lock {mutex};
+            auto            it = entries.find(path);
+            if (it == entries.end()) { it = entries.emplace(std::string {path}, entry {}).first; }
+            ++it->second.refcount;
+        }
+
+        /**
+         * Unregister a user of the path
+         * @param path file path
+         * @return true if it was the last user and the path was marked for unlink in the meantime
+         */
+        [[nodiscard]] bool release(const std::string_view path)
+        {
+            std::lock_guard lock {mutex};
+            const auto      it = entries.find(path);
+            if (it == entries.end() or --it->second.refcount != 0) { return false; }
+
+            const auto marked = it->second.marked_for_unlink;
+            entries.erase(it);
+            return marked;
+        }
+
+        /**
+         * Mark opened path to be unlinked as soon as the last user releases it
+         * @param path file path
+         * @return true if the path is opened and has been marked, false if the path is not opened
+         */
+        [[nodiscard]] bool mark_for_unlink(const std::string_view path)
+        {
+            std::lock_guard lock {mutex};
+            const auto      it = entries.find(path);
+            if (it == entries.end()) { return false; }
+            it->second.marked_for_unlink = true;
+            return true;
+        }
+
+        [[nodiscard]] bool exist(const std::string_view path) const
+        {
+            std::lock_guard lock {mutex};
+            return entries.contains(path);
+        }
+
+    private:
+        struct entry {
+            std::size_t refcount {};
+            bool        marked_for_unlink {false};
+        };
+
+        /// Looked up by string_view, only registering a new path allocates
+        struct path_hash {
+            using is_transparent = void;
+            std::size_t operator()(const std::string_view path) const noexcept { return std::hash<std::string_view> {}(path); }
+        };
+
+        std::unordered_map<std::string, entry, path_hash, std::equal_to<>> entries;
+        mutable std::mutex                                                 mutex;
+    };
+} // namespace vfs
@@ -1,6 +1,9 @@
 #include "api/vfs/partition.hpp"
 #include "api/vfs/disk.hpp"
 
+#include <algorithm>
+#include <array>
+
 namespace vfs {
     /// Build partition name in a form of <disk_name>p<partition_number>, i.e 'disk0p0'
     std::string create_partition_name(const std::string_view disk, const std::size_t index) { return std::string {disk} + "p" + std::to_string(index); }
@@ -17,8 +20,32 @@ namespace vfs {
         return disk.write(buf, translate_sector(lba), count);
     }
     std::error_code     Partition::read(std::byte& buf, const sector_t lba, const std::size_t count) { return disk.read(buf, translate_sector(lba), count); }
+    std::error_code Partition::writev(const std::span<const write_segment> segments)
+    {
+        return translate_segments(segments, [this](const auto batch) { return disk.writev(batch); });
+    }
+    std::error_code Partition::readv(const std::span<const read_segment> segments)
+    {
+        return translate_segments(segments, [this](const auto batch) { return disk.readv(batch); });
+    }
     result<std::size_t> Partition::get_sector_size() const { return disk.get_sector_size(); }
     result<BlockDevice::sector_t> Partition::get_sector_count() const { return info.num_sectors; }
     std::string                   Partition::get_name() const { return create_partition_name(disk.get_name(), info.physical_number); }
     BlockDevice::sector_t         Partition::translate_sector(const sector_t sector) const { return sector + info.start_sector; }
+    template <typename SegmentT, typename TransferT>
+    std::error_code Partition::translate_segments(std::span<const SegmentT> segments, const TransferT& transfer) const
+    {
+        /// Translated on the stack, a batch at a time, vectored I/O doesn't allocate
+        std::array<SegmentT, segment_batch> batch;
+        while (not segments.empty()) {
+            const auto count = std::min(segments.size(), batch.size());
+            std::ranges::transform(segments.first(count), batch.begin(), [this](SegmentT segment) {
+                segment.lba = translate_sector(segment.lba);
+                return segment;
+            });
+            if (const auto err = transfer(std::span<const SegmentT> {batch.data(), count})) { return err; }
+            segments = segments.subspan(count);
+        }
+        return {};
+    }
 } // namespace vfs
@@ -12,12 +12,16 @@
 #include "api/vfs/stdstream.hpp"
 
 #include "locker.hpp"
-#include "file_descriptor_container.hpp"
+#include "mount_tree.hpp"
+#include "normal_path.hpp"
+#include "file_descriptor_table.hpp"
+#include "open_path_index.hpp"
 #include "fstypes/filesystem_lwext4.hpp"
 #include "logger/log.hpp"
 
 #include <utility>
 #include <unordered_map>
+#include <shared_mutex>
 #include <sys/fcntl.h>
 #include <sys/statvfs.h>
 #include <sys/stat.h>
@@ -56,34 +60,39 @@ namespace vfs {
         stat.type        = mnt.type.name;
         stat.free_space  = stat_vfs.f_bfree * stat_vfs.f_bsize;
         stat.used_space  = (stat_vfs.f_blocks * stat_vfs.f_frsize) - stat.free_space;
+        stat.cache       = mnt.fs->stat_cache().value_or(CacheStats {});
 
         return stat;
     }
 
     struct VirtualFS::Pimpl {
-        using LockableMountPoint = locker<MountPoint, std::mutex>;
-
-        explicit Pimpl(DiskManager& mngr, std::unique_ptr<StdStream>&& stream)
+        /// Operations that only read the namespace of a mount point or access data of already opened files take the lock in shared mode. Operations
+        /// modifying the namespace(create, unlink, rename, ...) take it exclusively.
+        using LockableMountPoint = locker<MountPoint, std::shared_mutex>;
+
+        struct OpenFile {
+            std::unique_ptr<FileHandle>         handle;
+            std::shared_ptr<LockableMountPoint> mount;
+            /// Serializes data I/O on the handle(i.e. file position updates), independently of other handles of the same mount point
+            std::unique_ptr<std::mutex> io_mutex {std::make_unique<std::mutex>()};
+        };
+
+        explicit Pimpl(DiskManager& mngr, std::unique_ptr<StdStream>&& stream, const std::size_t max_files)
             : m_disk_mgr(mngr)
+            , m_fd_table(max_files, first_fd)
             , m_stdstream(std::move(stream))
         {
         }
 
-        auto find_mount_point(const std::string& path) noexcept -> std::optional<std::reference_wrapper<LockableMountPoint>>
-        {
-            for (auto& [key, locker] : m_mounts) {
-                if (path.find(key) != std::string::npos) { return *locker; }
-            }
-            return {};
-        }
-        auto absolute_path(const std::filesystem::path& path) const noexcept -> result<std::filesystem::path>
+        /// Find mount point with the longest root matching given path, i.e. '/data/volume0x' is never resolved to '/data/volume0'
+        auto find_mount_point(const std::string_view path) const noexcept -> std::shared_ptr<LockableMountPoint> { return m_mounts.find(path).value_or(nullptr); }
+        auto find_mount_root(const std::string_view root) const noexcept -> std::shared_ptr<LockableMountPoint> { return m_mounts.find_exact(root).value_or(nullptr); }
+        /// Normalize a path into a stack buffer, nothing is allocated on the way from the API to the filesystem
+        auto absolute_path(PathView path, normal_path& abspath) const noexcept -> std::error_code
         {
-            if (not path.has_root_path()) {
-                log_warning("Only absolute paths are supported");
-                return error(EINVAL);
-            }
-
-            return path.lexically_normal();
+            const auto err = abspath.assign(path.view());
+            if (err.value() == EINVAL) { log_warning("Only absolute paths are supported"); }
+            return err;
         }
 
         std::optional<fstype::Type> get_fs_type_from_mbr_code(const std::uint8_t mbr_code)
@@ -135,67 +144,74 @@ namespace vfs {
         {
             using Ret = std::invoke_result_t<decltype(method), Class, FileHandle&, Args...>;
 
-            m_mutex.lock();
-            if (not m_fd_container.exist(fd)) {
-                m_mutex.unlock();
-                return terror<Ret>(EBADF);
-            }
-            auto& fil = m_fd_container[fd];
-            m_mutex.unlock();
-
-            const auto locked = m_mounts.at(fil.get_root())->lock();
+            const auto file = m_fd_table.get(fd);
+            if (not file) { return terror<Ret>(EBADF); }
+            const auto      locked = file->mount->lock_shared();
+            std::lock_guard io_lock {*file->io_mutex};
 
-            return (locked.get().fs.get()->*method)(fil, std::forward<Args>(args)...);
+            return (locked.get().fs.get()->*method)(*file->handle, std::forward<Args>(args)...);
         }
 
-        template <typename Class, typename Method, typename... Args> auto invoke_fops(Method Class::* method, const std::filesystem::path& path, Args&&... args) -> decltype(auto)
+        template <lock_mode Mode = lock_mode::exclusive, typename Class, typename Method, typename... Args>
+        auto invoke_fops(Method Class::* method, PathView path, Args&&... args) -> decltype(auto)
         {
             if (path.empty()) { return from_errno(ENOENT); }
 
-            const auto abspath = absolute_path(path);
-            if (not abspath) { return from_errno(abspath.error().value()); }
-            const auto mount = find_mount_point(*abspath);
+            normal_path abspath;
+            if (auto err = absolute_path(path, abspath)) { return err; }
+            const auto mount = find_mount_point(abspath.view());
             if (not mount) { return from_errno(ENOENT); }
-            const auto& locked = mount->get().lock();
+            const auto& locked = mount->template lock<Mode>();
 
-            return (locked.get().fs.get()->*method)(*abspath, std::forward<Args>(args)...);
+            return (locked.get().fs.get()->*method)(abspath, std::forward<Args>(args)...);
         }
 
-        template <typename Class, typename Method, typename... Args> auto invoke_dirops(Method Class::* method, DirectoryHandle& handle, Args&&... args) -> std::error_code
+        template <typename Class, typename Method, typename... Args> auto invoke_dirops(Method Class::* method, DirectoryHandle& handle, Args&&... args) -> decltype(auto)
         {
-            const auto mp = m_mounts.at(handle.get_root())->lock();
+            using Ret = std::invoke_result_t<decltype(method), Class, DirectoryHandle&, Args...>;
+
+            const auto mount = find_mount_root(handle.get_root());
+            if (not mount) { return terror<Ret>(EBADF); }
+            const auto mp = mount->lock_shared();
             return (mp.get().fs.get()->*method)(handle, std::forward<Args>(args)...);
         }
 
         template <class Base, class T, typename... Args>
-        auto invoke_fops_same_mp(T Base::* method, const std::filesystem::path& path, const std::filesystem::path& path2, Args&&... args) -> std::error_code
+        auto invoke_fops_same_mp(T Base::* method, PathView path, PathView path2, Args&&... args) -> std::error_code
         {
             if (path.empty() || path2.empty()) { return from_errno(ENOENT); }
 
-            const auto abspath = absolute_path(path);
-            if (not abspath) { return abspath.error(); }
-            const auto abspath2 = absolute_path(path2);
-            if (not abspath2) { return abspath2.error(); }
+            normal_path abspath;
+            if (const auto err = absolute_path(path, abspath)) { return err; }
+            normal_path abspath2;
+            if (const auto err = absolute_path(path2, abspath2)) { return err; }
 
-            if (abspath->root_path() != abspath2->root_path()) {
+            const auto mount = find_mount_point(abspath.view());
+            if (not mount) { return from_errno(ENOENT); }
+            if (mount != find_mount_point(abspath2.view())) {
                 // Mount points are not the same
                 return from_errno(EXDEV);
             }
-
-            const auto mount = find_mount_point(*abspath);
-            if (not mount) { return from_errno(ENOENT); }
-            const auto& locked = mount->get().lock();
+            const auto& locked = mount->lock();
 
             if (locked.get().flags.test(MountFlags::read_only)) { return from_errno(EACCES); }
 
-            return (locked.get().fs.get()->*method)(*abspath, *abspath2, std::forward<Args>(args)...);
+            return (locked.get().fs.get()->*method)(abspath, abspath2, std::forward<Args>(args)...);
+        }
+        auto close_file(const int fd) -> std::error_code
+        {
+            const auto file = m_fd_table.remove(fd);
+            if (not file) { return from_errno(EBADF); }
+
+            const auto& path = file->handle->get_path();
+            auto       ret  = file->mount->lock_shared().get().fs->close(*file->handle);
+            if (m_open_paths.release(path.native())) { ret = invoke_fops(&Filesystem::unlink, path); }
+            return ret;
         }
+
         auto cleanup_opened_files() -> void
         {
-            for (const auto& [path, entry] : m_fd_container) {
-                for (const auto& fd : entry) { invoke_fops(&Filesystem::close, fd); }
-                if (entry.is_marked_for_unlink()) { invoke_fops(&Filesystem::unlink, path); }
-            }
+            for (const auto fd : m_fd_table.descriptors()) { std::ignore = close_file(fd); }
         }
 
         auto generate_unique_root_dir() -> std::string { return root_base + std::to_string(m_volume_index++); }
@@ -217,15 +233,19 @@ namespace vfs {
 
         DiskManager&                                                         m_disk_mgr;
         std::unordered_map<fstype::Type, std::unique_ptr<FilesystemFactory>> m_fs_factories;
-        std::unordered_map<std::string, std::unique_ptr<LockableMountPoint>> m_mounts;
+        mount_tree<std::shared_ptr<LockableMountPoint>>                      m_mounts;
         mutable std::recursive_mutex                                         m_mutex;
-        file_descriptor_container                                            m_fd_container;
+        file_descriptor_table<OpenFile>                                      m_fd_table;
+        open_path_index                                                      m_open_paths;
         std::uint32_t                                                        m_volume_index {};
         std::unique_ptr<StdStream>                                           m_stdstream;
+
+        /// Special descriptors(stdin,stdout,stderr) are handled separately
+        static constexpr int first_fd {3};
     };
 
-    VirtualFS::VirtualFS(DiskManager& dmngr, std::unique_ptr<StdStream>&& stream)
-        : pimpl(std::make_unique<Pimpl>(dmngr, std::move(stream)))
+    VirtualFS::VirtualFS(DiskManager& dmngr, std::unique_ptr<StdStream>&& stream, const std::size_t max_files)
+        : pimpl(std::make_unique<Pimpl>(dmngr, std::move(stream), max_files))
     {
     }
     VirtualFS::~VirtualFS()
@@ -249,7 +269,7 @@ namespace vfs {
         std::lock_guard lock {pimpl->m_mutex};
         return pimpl->m_fs_factories.erase(type) != 0 ? std::error_code {} : from_errno(ENOENT);
     }
-    std::error_code VirtualFS::mount_all()
+    std::error_code VirtualFS::mount_all(const MountOptions& options)
     {
         std::lock_guard lock {pimpl->m_mutex};
 
@@ -260,15 +280,15 @@ namespace vfs {
         for (auto& [name, handle] : pimpl->m_disk_mgr) {
             log_info("Scanning disk '%s'...", name.c_str());
 
-            std::for_each(handle->begin(), handle->end(), [this, &ret](const auto& p) {
-                const auto result = mount(p.get_name(), {}, {});
+            std::for_each(handle->begin(), handle->end(), [this, &ret, &options](const auto& p) {
+                const auto result = mount(p.get_name(), {}, {}, {}, options);
                 /// Capture first occurence of mount error, but keep mounting the rest of partitions
                 ret = not ret ? result : ret;
             });
         }
         return ret;
     }
-    std::error_code VirtualFS::mount(std::string_view disk_name, std::string root, std::string, Flags flags)
+    std::error_code VirtualFS::mount(std::string_view disk_name, std::string root, std::string, Flags flags, const MountOptions& options)
     {
         // TODO: handle explicit fstype passed
         std::lock_guard lock {pimpl->m_mutex};
@@ -287,21 +307,26 @@ namespace vfs {
             }
         }
 
-        if (pimpl->m_mounts.contains(root)) {
+        if (not root.starts_with('/')) {
+            log_error("Mount point '%s' of disk '%s' is not an absolute path", root.c_str(), disk->get_name().c_str());
+            return from_errno(EINVAL);
+        }
+        if (pimpl->find_mount_root(root)) {
             log_error("Disk '%s' already mounted as '%s'", disk->get_name().c_str(), root.c_str());
             return from_errno(EEXIST);
         }
 
-        if (const auto ret = fs->mount(root, flags)) {
+        if (const auto ret = fs->mount(root, flags, options)) {
             log_error("Failed to mount '%s' to '%s' with errno: %d", disk->get_name().c_str(), root.c_str(), ret);
             return ret;
         }
 
         log_info("Disk '%s' of type '%s' mounted successfully to '%s'", disk->get_name().c_str(), type.name.c_str(), root.c_str());
 
-        auto lockable = std::make_unique<Pimpl::LockableMountPoint>(MountPoint {std::move(fs), *disk, root, flags, type});
-        if (const auto [_, inserted] = pimpl->m_mounts.emplace(root, std::move(lockable)); not inserted) {
+        auto lockable = std::make_shared<Pimpl::LockableMountPoint>(MountPoint {std::move(fs), *disk, root, flags, type});
+        if (not pimpl->m_mounts.insert(root, lockable)) {
             log_error("Disk '%s' already mounted as '%s'", disk->get_name().c_str(), root.c_str());
+            lockable->lock().get().fs->unmount();
             return from_errno(EEXIST);
         }
 
@@ -313,14 +338,11 @@ namespace vfs {
         std::lock_guard lock {pimpl->m_mutex};
         std::error_code ret;
 
-        std::ignore = std::all_of(pimpl->m_mounts.begin(), pimpl->m_mounts.end(), [&ret](auto& m) {
-            auto& locked = m.second->lock().get();
-
-            if (const auto result = locked.fs->unmount()) {
-                ret = result;
-                return false;
-            }
-            return true;
+        pimpl->m_mounts.for_each([&ret](const auto&, const auto& mount) {
+            /// Stop un-mounting at the first error encountered
+            if (ret) { return; }
+            const auto& locked = mount->lock();
+            ret                = locked.get().fs->unmount();
         });
         pimpl->m_mounts.clear();
         pimpl->m_volume_index = 0;
@@ -331,13 +353,13 @@ namespace vfs {
     {
         std::lock_guard lock {pimpl->m_mutex};
 
-        if (const auto result = pimpl->m_mounts.find(std::string {mount_point}); result != pimpl->m_mounts.end()) {
+        if (const auto mount = pimpl->find_mount_root(mount_point)) {
             {
-                const auto& locked = result->second->lock();
+                const auto& locked = mount->lock();
                 if (const auto ret = locked.get().fs->unmount()) { return ret; }
             }
 
-            pimpl->m_mounts.erase(result);
+            pimpl->m_mounts.erase(mount_point);
             return {};
         }
         return from_errno(EINVAL);
@@ -347,62 +369,66 @@ namespace vfs {
         std::lock_guard lock {pimpl->m_mutex};
 
         std::vector<std::string> mount_names;
-        for (const auto& [root, _] : pimpl->m_mounts) { mount_names.emplace_back(root); }
+        pimpl->m_mounts.for_each([&mount_names](const auto& root, const auto&) { mount_names.emplace_back(root); });
         return mount_names;
     }
     auto VirtualFS::stat_parts() noexcept -> std::vector<PartitionStats>
     {
         std::vector<PartitionStats> stats;
-        for (auto& [_, mp] : pimpl->m_mounts) { stats.emplace_back(get_mount_point_stats(mp->lock().get())); }
+        pimpl->m_mounts.for_each([&stats](const auto&, const auto& mp) { stats.emplace_back(get_mount_point_stats(mp->lock_shared().get())); });
         return stats;
     }
-    auto VirtualFS::stat_parts_of(const std::filesystem::path& path) noexcept -> result<PartitionStats>
+    auto VirtualFS::stat_parts_of(PathView path) noexcept -> result<PartitionStats>
     {
-        auto mount = pimpl->find_mount_point(path);
+        normal_path abspath;
+        if (const auto err = pimpl->absolute_path(path, abspath)) { return error(err); }
+        const auto mount = pimpl->find_mount_point(abspath.view());
         if (!mount) { return error(ENOENT); }
-        const auto& locked = mount->get().lock();
+        const auto& locked = mount->lock_shared();
         return get_mount_point_stats(locked.get());
     }
 
     auto VirtualFS::getcwd() noexcept -> std::filesystem::path { /* TODO */ return {}; }
-    auto VirtualFS::chdir(const std::filesystem::path&) noexcept -> std::error_code { return from_errno(ENOTSUP); }
+    auto VirtualFS::chdir(PathView) noexcept -> std::error_code { return from_errno(ENOTSUP); }
 
-    auto VirtualFS::open(const std::filesystem::path& path, const int flags, const int mode) noexcept -> result<int>
+    auto VirtualFS::open(PathView path, const int flags, const int mode) noexcept -> result<int>
     {
-        std::lock_guard lock {pimpl->m_mutex};
+        normal_path abspath;
+        if (const auto err = pimpl->absolute_path(path, abspath)) { return error(err); }
 
-        const auto abspath = pimpl->absolute_path(path);
-        if (not abspath) { return error(abspath.error()); }
-
-        const auto mount = pimpl->find_mount_point(*abspath);
+        const auto mount = pimpl->find_mount_point(abspath.view());
         if (not mount) {
-            log_error("Unable to find mount point for path: '%s'", abspath->c_str());
+            log_error("Unable to find mount point for path: '%s'", abspath.c_str());
             return error(ENOENT);
         }
 
-        const auto& locked = mount->get().lock();
-
-        if ((flags & O_ACCMODE) != O_RDONLY && (locked.get().flags.test(MountFlags::read_only))) {
-            log_error("Trying to open file with 'WR' flag on read-only filesystem");
-            return error(EACCES);
+        /// Register the path before opening it, so the file can't be unlinked concurrently while it's being opened
+        pimpl->m_open_paths.acquire(abspath.view());
+        auto handle = [&]() -> result<std::unique_ptr<FileHandle>> {
+            const auto do_open = [&](const auto& locked) -> result<std::unique_ptr<FileHandle>> {
+                if ((flags & O_ACCMODE) != O_RDONLY && (locked.get().flags.test(MountFlags::read_only))) {
+                    log_error("Trying to open file with 'WR' flag on read-only filesystem");
+                    return error(EACCES);
+                }
+                return locked.get().fs->open(abspath, flags, mode);
+            };
+            /// Creating or truncating a file modifies the namespace
+            if ((flags & (O_CREAT | O_TRUNC)) != 0) { return do_open(mount->lock()); }
+            return do_open(mount->lock_shared());
+        }();
+
+        if (handle) {
+            auto file = Pimpl::OpenFile {std::move(handle.value()), mount};
+            if (const auto fd = pimpl->m_fd_table.insert(std::move(file))) { return *fd; }
+            log_error("Too many opened files");
+            std::ignore = mount->lock_shared().get().fs->close(*file.handle);
+            handle      = error(EMFILE);
         }
-
-        auto handle = locked.get().fs->open(*abspath, flags, mode);
-        if (not handle) { return error(handle.error()); }
-        return pimpl->m_fd_container.insert(path, std::move(handle.value()));
+        if (pimpl->m_open_paths.release(abspath.view())) { std::ignore = pimpl->invoke_fops(&Filesystem::unlink, abspath); }
+        return error(handle.error());
     }
 
-    auto VirtualFS::close(const int fd) noexcept -> std::error_code
-    {
-        std::lock_guard lock {pimpl->m_mutex};
-
-        if (not pimpl->m_fd_container.exist(fd)) { return from_errno(EBADF); }
-
-        const auto ret = pimpl->invoke_fops(&Filesystem::close, fd);
-        if (const auto path = pimpl->m_fd_container.remove(fd)) { return pimpl->invoke_fops(&Filesystem::unlink, path.value()); }
-
-        return ret;
-    }
+    auto VirtualFS::close(const int fd) noexcept -> std::error_code { return pimpl->close_file(fd); }
 
     auto VirtualFS::write(const int fd, const char* ptr, size_t len) noexcept -> result<std::size_t>
     {
@@ -416,6 +442,11 @@ namespace vfs {
         return pimpl->invoke_fops(&Filesystem::read, fd, ptr, len);
     }
 
+    auto VirtualFS::read_pinned(const int fd, off_t offset, std::size_t len) noexcept -> result<PinnedData>
+    {
+        return pimpl->invoke_fops(&Filesystem::read_pinned, fd, offset, len);
+    }
+
     auto VirtualFS::lseek(const int fd, off_t pos, int dir) noexcept -> result<off_t> { return pimpl->invoke_fops(&Filesystem::lseek, fd, pos, dir); }
 
     auto VirtualFS::fstat(const int fd, struct stat& st) noexcept -> std::error_code
@@ -431,45 +462,48 @@ namespace vfs {
 
     auto VirtualFS::ftruncate(const int fd, off_t len) noexcept -> std::error_code { return pimpl->invoke_fops(&Filesystem::ftruncate, fd, len); }
 
+    auto VirtualFS::fallocate(const int fd, const Flags mode, off_t offset, off_t len) noexcept -> std::error_code { return pimpl->invoke_fops(&Filesystem::fallocate, fd, mode, offset, len); }
+
     auto VirtualFS::fsync(const int fd) noexcept -> std::error_code { return pimpl->invoke_fops(&Filesystem::fsync, fd); }
 
+    auto VirtualFS::fdatasync(const int fd) noexcept -> std::error_code { return pimpl->invoke_fops(&Filesystem::fdatasync, fd); }
+
     auto VirtualFS::fchmod(const int fd, mode_t mode) noexcept -> std::error_code { return pimpl->invoke_fops(&Filesystem::fchmod, fd, mode); }
 
-    auto VirtualFS::stat(const std::filesystem::path& path, struct stat& st) noexcept -> std::error_code { return pimpl->invoke_fops(&Filesystem::stat, path, st); }
+    auto VirtualFS::stat(PathView path, struct stat& st) noexcept -> std::error_code { return pimpl->invoke_fops<lock_mode::shared>(&Filesystem::stat, path, st); }
 
-    auto VirtualFS::symlink(const std::filesystem::path& existing, const std::filesystem::path& newlink) noexcept -> std::error_code
+    auto VirtualFS::symlink(PathView existing, PathView newlink) noexcept -> std::error_code
     {
         return pimpl->invoke_fops(&Filesystem::symlink, existing, newlink);
     }
 
-    auto VirtualFS::link(const std::filesystem::path& existing, const std::filesystem::path& newlink) noexcept -> std::error_code { return pimpl->invoke_fops(&Filesystem::link, existing, newlink); }
+    auto VirtualFS::link(PathView existing, PathView newlink) noexcept -> std::error_code { return pimpl->invoke_fops(&Filesystem::link, existing, newlink); }
 
-    auto VirtualFS::unlink(const std::filesystem::path& name) noexcept -> std::error_code
+    auto VirtualFS::unlink(PathView name) noexcept -> std::error_code
     {
-        std::lock_guard lock {pimpl->m_mutex};
-        if (pimpl->m_fd_container.exist(name)) {
-            pimpl->m_fd_container[name].mark_for_unlink();
-            return {};
-        }
-        return pimpl->invoke_fops(&Filesystem::unlink, name);
+        if (name.empty()) { return from_errno(ENOENT); }
+        normal_path abspath;
+        if (const auto err = pimpl->absolute_path(name, abspath)) { return err; }
+        if (pimpl->m_open_paths.mark_for_unlink(abspath.view())) { return {}; }
+        return pimpl->invoke_fops(&Filesystem::unlink, abspath);
     }
 
-    auto VirtualFS::rename(const std::filesystem::path& oldname, const std::filesystem::path& newname) noexcept -> std::error_code
+    auto VirtualFS::rename(PathView oldname, PathView newname) noexcept -> std::error_code
     {
         return pimpl->invoke_fops_same_mp(&Filesystem::rename, oldname, newname);
     }
 
-    auto VirtualFS::diropen(const std::filesystem::path& path) noexcept -> result<std::unique_ptr<DirectoryHandle>>
+    auto VirtualFS::diropen(PathView path) noexcept -> result<std::unique_ptr<DirectoryHandle>>
     {
-        const auto abspath = pimpl->absolute_path(path);
-        if (not abspath) { return error(abspath.error()); }
-        const auto mount = pimpl->find_mount_point(*abspath);
+        normal_path abspath;
+        if (const auto err = pimpl->absolute_path(path, abspath)) { return error(err); }
+        const auto mount = pimpl->find_mount_point(abspath.view());
         if (!mount) {
-            log_error("Unable to find mount point for path: '%s'", abspath->c_str());
+            log_error("Unable to find mount point for path: '%s'", abspath.c_str());
             return error(ENOENT);
         }
-        const auto& locked = mount->get().lock();
-        return locked.get().fs->diropen(*abspath);
+        const auto& locked = mount->lock_shared();
+        return locked.get().fs->diropen(abspath);
     }
 
     auto VirtualFS::dirreset(DirectoryHandle& handle) noexcept -> std::error_code { return pimpl->invoke_dirops(&Filesystem::dirreset, handle); }
@@ -479,17 +513,26 @@ namespace vfs {
         return pimpl->invoke_dirops(&Filesystem::dirnext, handle, filename, filestat);
     }
 
+    auto VirtualFS::dirnext_batch(DirectoryHandle& handle, std::span<DirEntry> entries, bool full_stat) noexcept -> result<std::size_t>
+    {
+        return pimpl->invoke_dirops(&Filesystem::dirnext_batch, handle, entries, full_stat);
+    }
+
+    auto VirtualFS::dirtell(DirectoryHandle& handle) noexcept -> result<off_t> { return pimpl->invoke_dirops(&Filesystem::dirtell, handle); }
+
+    auto VirtualFS::dirseek(DirectoryHandle& handle, off_t cookie) noexcept -> std::error_code { return pimpl->invoke_dirops(&Filesystem::dirseek, handle, cookie); }
+
     auto VirtualFS::dirclose(DirectoryHandle& handle) noexcept -> std::error_code { return pimpl->invoke_dirops(&Filesystem::dirclose, handle); }
 
-    auto VirtualFS::mkdir(const std::filesystem::path& path, int mode) noexcept -> std::error_code { return pimpl->invoke_fops(&Filesystem::mkdir, path, mode); }
+    auto VirtualFS::mkdir(PathView path, int mode) noexcept -> std::error_code { return pimpl->invoke_fops(&Filesystem::mkdir, path, mode); }
 
-    auto VirtualFS::rmdir(const std::filesystem::path& path) noexcept -> std::error_code { return pimpl->invoke_fops(&Filesystem::rmdir, path); }
+    auto VirtualFS::rmdir(PathView path) noexcept -> std::error_code { return pimpl->invoke_fops(&Filesystem::rmdir, path); }
 
-    auto VirtualFS::stat_vfs(const std::filesystem::path& path, struct statvfs& stat) noexcept -> std::error_code { return pimpl->invoke_fops(&Filesystem::stat_vfs, path, stat); }
+    auto VirtualFS::stat_vfs(PathView path, struct statvfs& stat) noexcept -> std::error_code { return pimpl->invoke_fops<lock_mode::shared>(&Filesystem::stat_vfs, path, stat); }
 
-    auto VirtualFS::chmod(const std::filesystem::path& path, mode_t mode) noexcept -> std::error_code { return pimpl->invoke_fops(&Filesystem::chmod, path, mode); }
-    auto VirtualFS::ioctl(const std::filesystem::path& path, int cmd, void* arg) noexcept -> std::error_code { return pimpl->invoke_fops(&Filesystem::ioctl, path, cmd, arg); }
-    auto VirtualFS::utimens(const std::filesystem::path& path, std::array<timespec, 2>& tv) noexcept -> std::error_code { return pimpl->invoke_fops(&Filesystem::utimens, path, tv); }
+    auto VirtualFS::chmod(PathView path, mode_t mode) noexcept -> std::error_code { return pimpl->invoke_fops(&Filesystem::chmod, path, mode); }
+    auto VirtualFS::ioctl(PathView path, int cmd, void* arg) noexcept -> std::error_code { return pimpl->invoke_fops(&Filesystem::ioctl, path, cmd, arg); }
+    auto VirtualFS::utimens(PathView path, std::array<timespec, 2>& tv) noexcept -> std::error_code { return pimpl->invoke_fops(&Filesystem::utimens, path, tv); }
     auto VirtualFS::flock(const int fd, int cmd) noexcept -> std::error_code { return pimpl->invoke_fops(&Filesystem::flock, fd, cmd); }
     auto VirtualFS::isatty(const int fd) noexcept -> result<bool>
     {
@@ -1,6 +1,6 @@
 #pragma once
 
-#define CONFIG_EXTENTS_ENABLE 0
+#define CONFIG_EXTENTS_ENABLE 1
 #define CONFIG_XATTR_ENABLE 0
 #define CONFIG_EXT4_BLOCKDEVS_COUNT 4
 #define CONFIG_EXT4_MOUNTPOINTS_COUNT 4
@@ -1,33 +1,92 @@
 #include "api/vfs/filesystem.hpp"
+#include <algorithm>
 #include <cerrno>
 #include <utility>
 
 namespace vfs {
 
-    auto Filesystem::stat_vfs(const std::filesystem::path&, struct statvfs&) noexcept -> std::error_code { return from_errno(ENOTSUP); }
+    auto Filesystem::stat_vfs(PathView, struct statvfs&) noexcept -> std::error_code { return from_errno(ENOTSUP); }
+    auto Filesystem::stat_cache() noexcept -> result<CacheStats> { return error(ENOTSUP); }
+    auto Filesystem::read_pinned(FileHandle&, off_t, std::size_t) noexcept -> result<PinnedData> { return error(ENOTSUP); }
     auto Filesystem::lseek(FileHandle&, off_t, int) noexcept -> result<off_t> { return error(ENOTSUP); }
     auto Filesystem::fstat(FileHandle&, struct stat&) noexcept -> std::error_code { return from_errno(ENOTSUP); }
-    auto Filesystem::stat(const std::filesystem::path&, struct stat&) noexcept -> std::error_code { return from_errno(ENOTSUP); }
-    auto Filesystem::link(const std::filesystem::path&, const std::filesystem::path&) noexcept -> std::error_code { return from_errno(ENOTSUP); }
-    auto Filesystem::symlink(const std::filesystem::path&, const std::filesystem::path&) noexcept -> std::error_code { return from_errno(ENOTSUP); }
-    auto Filesystem::unlink(const std::filesystem::path&) noexcept -> std::error_code { return from_errno(ENOTSUP); }
-    auto Filesystem::rmdir(const std::filesystem::path&) noexcept -> std::error_code { return from_errno(ENOTSUP); }
-    auto Filesystem::rename(const std::filesystem::path&, const std::filesystem::path&) noexcept -> std::error_code { return from_errno(ENOTSUP); }
-    auto Filesystem::mkdir(const std::filesystem::path&, int) noexcept -> std::error_code { return from_errno(ENOTSUP); }
-    auto Filesystem::diropen(const std::filesystem::path&) noexcept -> result<std::unique_ptr<DirectoryHandle>> { return error(ENOTSUP); }
+    auto Filesystem::stat(PathView, struct stat&) noexcept -> std::error_code { return from_errno(ENOTSUP); }
+    auto Filesystem::link(PathView, PathView) noexcept -> std::error_code { return from_errno(ENOTSUP); }
+    auto Filesystem::symlink(PathView, PathView) noexcept -> std::error_code { return from_errno(ENOTSUP); }
+    auto Filesystem::unlink(PathView) noexcept -> std::error_code { return from_errno(ENOTSUP); }
+    auto Filesystem::rmdir(PathView) noexcept -> std::error_code { return from_errno(ENOTSUP); }
+    auto Filesystem::rename(PathView, PathView) noexcept -> std::error_code { return from_errno(ENOTSUP); }
+    auto Filesystem::mkdir(PathView, int) noexcept -> std::error_code { return from_errno(ENOTSUP); }
+    auto Filesystem::diropen(PathView) noexcept -> result<std::unique_ptr<DirectoryHandle>> { return error(ENOTSUP); }
     auto Filesystem::dirreset(DirectoryHandle&) noexcept -> std::error_code { return from_errno(ENOTSUP); }
     auto Filesystem::dirnext(DirectoryHandle&, std::filesystem::path&, struct stat&) -> std::error_code { return from_errno(ENOTSUP); }
+    auto Filesystem::dirnext_batch(DirectoryHandle& handle, std::span<DirEntry> entries, bool full_stat) noexcept -> result<std::size_t>
+    {
+        if (full_stat) { return error(ENOTSUP); }
+        std::size_t           count {};
+        std::filesystem::path filename;
+        for (auto& entry : entries) {
+            /// Errors following some entries are reported by the next call
+            if (const auto err = dirnext(handle, filename, entry.st)) {
+                if (err.value() == ENOENT or count > 0) { break; }
+                return error(err);
+            }
+            const auto& name = filename.native();
+            if (name.size() >= entry.name.size()) { return error(ENAMETOOLONG); }
+            std::copy(name.begin(), name.end(), entry.name.begin());
+            entry.name[name.size()] = '\0';
+            ++count;
+        }
+        return count;
+    }
+    auto Filesystem::dirtell(DirectoryHandle&) noexcept -> result<off_t> { return error(ENOTSUP); }
+    auto Filesystem::dirseek(DirectoryHandle&, off_t) noexcept -> std::error_code { return from_errno(ENOTSUP); }
     auto Filesystem::dirclose(DirectoryHandle&) noexcept -> std::error_code { return from_errno(ENOTSUP); }
     auto Filesystem::ftruncate(FileHandle&, off_t) noexcept -> std::error_code { return from_errno(ENOTSUP); }
+    auto Filesystem::fallocate(FileHandle&, Flags, off_t, off_t) noexcept -> std::error_code { return from_errno(ENOTSUP); }
     auto Filesystem::fsync(FileHandle&) noexcept -> std::error_code { return from_errno(ENOTSUP); }
-    auto Filesystem::ioctl(const std::filesystem::path&, int, void*) noexcept -> std::error_code { return from_errno(ENOTSUP); }
-    auto Filesystem::utimens(const std::filesystem::path&, std::array<timespec, 2>&) noexcept -> std::error_code { return from_errno(ENOTSUP); }
+    auto Filesystem::fdatasync(FileHandle& handle) noexcept -> std::error_code { return fsync(handle); }
+    auto Filesystem::ioctl(PathView, int, void*) noexcept -> std::error_code { return from_errno(ENOTSUP); }
+    auto Filesystem::utimens(PathView, std::array<timespec, 2>&) noexcept -> std::error_code { return from_errno(ENOTSUP); }
     auto Filesystem::flock(FileHandle&, int) noexcept -> std::error_code { return from_errno(ENOTSUP); }
     auto Filesystem::isatty(FileHandle&) noexcept -> result<bool> { return error(ENOTSUP); }
-    auto Filesystem::chmod(const std::filesystem::path&, mode_t) noexcept -> std::error_code { return from_errno(ENOTSUP); }
+    auto Filesystem::chmod(PathView, mode_t) noexcept -> std::error_code { return from_errno(ENOTSUP); }
     auto Filesystem::fchmod(FileHandle&, mode_t) noexcept -> std::error_code { return from_errno(ENOTSUP); }
     auto Filesystem::get_label() noexcept -> result<std::string> { return error(ENOTSUP); }
 
+    PinnedData::PinnedData(std::span<const std::byte> data, release_fn release, void* owner, void* pin) noexcept
+        : m_data(data)
+        , m_release(release)
+        , m_owner(owner)
+        , m_pin(pin)
+    {
+    }
+    PinnedData::~PinnedData() { reset(); }
+    PinnedData::PinnedData(PinnedData&& other) noexcept
+        : m_data(std::exchange(other.m_data, {}))
+        , m_release(std::exchange(other.m_release, nullptr))
+        , m_owner(std::exchange(other.m_owner, nullptr))
+        , m_pin(std::exchange(other.m_pin, nullptr))
+    {
+    }
+    auto PinnedData::operator=(PinnedData&& other) noexcept -> PinnedData&
+    {
+        if (this != &other) {
+            reset();
+            m_data    = std::exchange(other.m_data, {});
+            m_release = std::exchange(other.m_release, nullptr);
+            m_owner   = std::exchange(other.m_owner, nullptr);
+            m_pin     = std::exchange(other.m_pin, nullptr);
+        }
+        return *this;
+    }
+    void PinnedData::reset() noexcept
+    {
+        if (m_release != nullptr) { m_release(m_owner, m_pin); }
+        m_data    = {};
+        m_release = nullptr;
+    }
+
     FileHandle::FileHandle(std::string root, std::filesystem::path abspath)
         : abspath(std::move(abspath))
         , root(std::move(root))
@@ -37,7 +96,7 @@ namespace vfs {
         : root(std::move(root))
     {
     }
-    std::filesystem::path DirectoryHandle::get_root() const noexcept { return root; }
-    std::filesystem::path FileHandle::get_path() const noexcept { return abspath; }
-    std::filesystem::path FileHandle::get_root() const noexcept { return root; }
+    std::string_view             DirectoryHandle::get_root() const noexcept { return root; }
+    const std::filesystem::path& FileHandle::get_path() const noexcept { return abspath; }
+    std::string_view             FileHandle::get_root() const noexcept { return root; }
 } // namespace vfs
@@ -11,25 +11,27 @@
 
 #include <sys/statvfs.h>
 #include <sys/stat.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <climits>
 #include <cerrno>
 #include <cstring>
+#include <limits>
+#include <mutex>
+#include <utility>
 
 namespace vfs {
     namespace {
 
         constexpr file_handle_lwext4&      from(FileHandle& handle) { return static_cast<file_handle_lwext4&>(handle); }
         constexpr directory_handle_lwext4& from(DirectoryHandle& handle) { return static_cast<directory_handle_lwext4&>(handle); }
-        constexpr std::string              to_native_path(const std::string& root, const std::string& path)
-        {
-            if (path == root) { return path + "/"; }
-            return path;
-        }
         constexpr std::string to_native_path(const std::string& root) { return root + "/"; }
 
         template <typename T, typename... Args> auto invoke_fs(FileHandle& handle, T efs_fun, Args&&... args) { return from_errno(efs_fun(&from(handle).get_raw(), std::forward<Args>(args)...)); }
 
-        template <typename T, typename... Args> auto invoke_fs(T efs_fun, const std::filesystem::path& path, Args&&... args) { return from_errno(efs_fun(path.c_str(), std::forward<Args>(args)...)); }
+        template <typename T, typename... Args> auto invoke_fs(T efs_fun, PathView path, Args&&... args) { return from_errno(efs_fun(path.c_str(), std::forward<Args>(args)...)); }
 
         template <typename T, typename... Args> auto invoke_fs(DirectoryHandle& handle, T efs_fun, Args&&... args) { return from_errno(efs_fun(&from(handle).get_raw(), std::forward<Args>(args)...)); }
 
@@ -48,16 +50,55 @@ namespace vfs {
                 return S_IFIFO;
             case EXT4_DE_SOCK:
                 return S_IFSOCK;
+            case EXT4_DE_SYMLINK:
+                return S_IFLNK;
             default:
                 return 0;
             }
         }
 
+        /// Holes aren't backed by any block, pinned reads of them return zeros from here, in chunks of up to its size
+        constexpr std::array<std::byte, 4096> zero_block {};
+
+        void unpin(void* owner, void* pin) noexcept
+        {
+            ext4_pin epin {static_cast<ext4_mountpoint*>(owner), static_cast<ext4_buf*>(pin)};
+            ext4_funpin(&epin);
+        }
+
+        /// Under relatime, access time older than that is updated even if the file hasn't been modified since it was last accessed
+        constexpr std::uint32_t relatime_interval = 24 * 60 * 60;
+
         std::time_t get_posix_time()
         {
             const auto time = std::time(nullptr);
             return time == std::time_t {-1} ? 0 : time;
         }
+
+        /// lwext4 lock callbacks don't carry any context, hence every lwext4 mount point slot gets its own pair of callbacks bound to a dedicated mutex
+        template <std::size_t Slot> struct mount_lock {
+            static inline std::mutex mutex;
+            static void              lock() { mutex.lock(); }
+            static void              unlock() { mutex.unlock(); }
+            static constexpr auto    ops = ext4_lock {lock, unlock};
+        };
+
+        template <std::size_t... Slots> constexpr auto make_mount_locks(std::index_sequence<Slots...>)
+        {
+            return std::array<const ext4_lock*, sizeof...(Slots)> {&mount_lock<Slots>::ops...};
+        }
+
+        constexpr auto                                             mount_locks = make_mount_locks(std::make_index_sequence<CONFIG_EXT4_MOUNTPOINTS_COUNT> {});
+        std::array<std::atomic_flag, CONFIG_EXT4_MOUNTPOINTS_COUNT> mount_locks_in_use {};
+
+        std::optional<std::size_t> acquire_mount_lock()
+        {
+            for (std::size_t i = 0; i < mount_locks_in_use.size(); ++i) {
+                if (not mount_locks_in_use[i].test_and_set()) { return i; }
+            }
+            return std::nullopt;
+        }
+        void release_mount_lock(const std::size_t slot) { mount_locks_in_use[slot].clear(); }
     } // namespace
 
     filesystem_lwext4::filesystem_lwext4(BlockDevice& bdev, Flags flags)
@@ -66,10 +107,11 @@ namespace vfs {
         , m_handle(m_blockdev)
     {
     }
-    auto filesystem_lwext4::mount(std::string root, const Flags flags) noexcept -> std::error_code
+    auto filesystem_lwext4::mount(std::string root, const Flags flags, const MountOptions& options) noexcept -> std::error_code
     {
-        m_root = root;
-        root   = to_native_path(root);
+        m_root        = root;
+        m_native_root = to_native_path(root);
+        root          = m_native_root;
 
         auto err = ext4_device_register(&m_handle.get_blockdev(), m_blockdev.get_name().c_str());
         if (err) {
@@ -77,12 +119,16 @@ namespace vfs {
             return from_errno(err);
         }
 
-        err = ext4_mount(m_blockdev.get_name().c_str(), root.c_str(), flags.test(MountFlags::read_only));
+        const auto cache_blocks = static_cast<std::uint32_t>(std::min<std::size_t>(options.cache_blocks, std::numeric_limits<std::uint32_t>::max()));
+        const auto policy       = options.cache_policy == CachePolicy::two_queue ? EXT4_BCACHE_POLICY_2Q : EXT4_BCACHE_POLICY_LRU;
+        err = ext4_mount_with_cache(m_blockdev.get_name().c_str(), root.c_str(), flags.test(MountFlags::read_only), cache_blocks, policy);
         if (err) {
             log_error("Unable to mount ext4 errno %i", err);
             ext4_device_unregister(m_blockdev.get_name().c_str());
             return from_errno(err);
         }
+        /// The superblock lives as long as the mount point, hence stat doesn't have to look it up by the mount point name every time
+        ext4_get_sblock(root.c_str(), &m_sblock);
 
         err = ext4_recover(root.c_str());
         if (err) {
@@ -100,13 +146,68 @@ namespace vfs {
             return from_errno(err);
         }
 
+        /// From now on, lwext4 serializes access to its internals(block cache, allocators, journal) on its own, so VFS doesn't have to lock a whole mount
+        /// point for the duration of every operation
+        m_lock_slot = acquire_mount_lock();
+        if (m_lock_slot) {
+            ext4_mount_setup_locks(root.c_str(), mount_locks[*m_lock_slot]);
+        } else {
+            log_warning("No free lwext4 lock slots, '%s' will rely on external locking only", root.c_str());
+        }
+
+        m_options     = options;
+        m_mount_flags = flags;
+        if (options.dentry_cache != CONFIG_DCACHE_SIZE) {
+            const auto entries = static_cast<std::uint32_t>(std::min<std::size_t>(options.dentry_cache, std::numeric_limits<std::uint32_t>::max()));
+            if ((err = ext4_mount_setup_dcache(root.c_str(), entries))) { log_warning("Unable to resize the directory entry cache errno %i", err); }
+        }
+        ext4_get_dcache(root.c_str(), &m_dcache);
+        ext4_get_icache(root.c_str(), &m_icache);
+        if (options.journal_commit != JournalCommit::per_operation) {
+            const auto commit_blocks = static_cast<std::uint32_t>(std::min<std::size_t>(options.commit_blocks, std::numeric_limits<std::uint32_t>::max()));
+            if ((err = ext4_journal_group_commit(root.c_str(), commit_blocks))) { log_warning("Unable to enable journal group commit errno %i", err); }
+        }
+
+        /// The flusher runs concurrently with VFS operations, hence write-back and timed commits depend on lwext4 internal locking
+        if (not m_lock_slot and options.write_back) {
+            log_warning("Write-back requires lwext4 locking, '%s' will write through", root.c_str());
+            m_options.write_back = false;
+        }
+        if (not m_lock_slot and options.journal_commit == JournalCommit::grouped) {
+            log_warning("Timed journal commits require lwext4 locking, '%s' will commit on fsync only", root.c_str());
+            m_options.journal_commit = JournalCommit::on_sync;
+        }
+        if (m_options.write_back) { ext4_cache_write_back(root.c_str(), true); }
+        if (m_options.write_back or m_options.journal_commit == JournalCommit::grouped) {
+            m_flusher = std::jthread {[this](const std::stop_token stop) { flusher(stop); }};
+        }
+
         return {};
     }
 
     auto filesystem_lwext4::unmount() noexcept -> std::error_code
     {
-        const auto native_root = to_native_path(m_root);
+        const auto& native_root = m_native_root;
+
+        /// Pinned blocks are referenced by the readers, the mount point has to stay intact until they are released
+        if (pinned_blocks() > 0) {
+            log_error("Unable to unmount device with pinned blocks");
+            return from_errno(EBUSY);
+        }
+
+        if (m_flusher.joinable()) {
+            m_flusher.request_stop();
+            m_flusher.join();
+        }
+        /// Leaving write-back mode writes all dirty blocks back
+        if (m_options.write_back) {
+            if (const auto err = ext4_cache_write_back(native_root.c_str(), false)) {
+                log_error("Unable to write back dirty blocks %i", err);
+                return from_errno(err);
+            }
+        }
 
+        /// Stopping the journal commits operations still waiting for a group commit
         auto err = ext4_journal_stop(native_root.c_str());
         if (err) {
             log_warning("Unable to stop ext4 journal %i", err);
@@ -117,14 +218,22 @@ namespace vfs {
             log_error("Unable to unmount device");
             return from_errno(err);
         }
+        m_sblock = nullptr;
+        m_dcache = nullptr;
+        m_icache = nullptr;
+        if (m_lock_slot) {
+            ext4_mount_setup_locks(native_root.c_str(), nullptr);
+            release_mount_lock(*m_lock_slot);
+            m_lock_slot.reset();
+        }
 
         return from_errno(ext4_device_unregister(m_blockdev.get_name().c_str()));
     }
 
     // Stat the filesystem
-    auto filesystem_lwext4::stat_vfs([[maybe_unused]] const std::filesystem::path& path, struct statvfs& stat) noexcept -> std::error_code
+    auto filesystem_lwext4::stat_vfs([[maybe_unused]] PathView path, struct statvfs& stat) noexcept -> std::error_code
     {
-        const auto native_root = to_native_path(m_root);
+        const auto& native_root = m_native_root;
 
         ext4_mount_stats estats {};
         auto             err = ext4_mount_point_stats(native_root.c_str(), &estats);
@@ -146,28 +255,154 @@ namespace vfs {
         return {};
     }
 
-    auto filesystem_lwext4::open(const std::filesystem::path& abspath, const Flags flags, [[maybe_unused]] const int mode) noexcept -> result<std::unique_ptr<FileHandle>>
+    auto filesystem_lwext4::stat_cache() noexcept -> result<CacheStats>
+    {
+        const auto bc = m_handle.get_blockdev().bc;
+        if (bc == nullptr) { return error(ENXIO); }
+
+        /// Counters are updated under the lwext4 mount lock
+        if (m_lock_slot) { mount_locks[*m_lock_slot]->lock(); }
+        const auto       dentry_hits   = m_dcache ? m_dcache->hit_cnt : 0;
+        const auto       dentry_misses = m_dcache ? m_dcache->miss_cnt : 0;
+        const auto       inodes        = m_icache ? m_icache->cnt : 0;
+        const CacheStats stats {bc->cnt, bc->ref_blocks, bc->hit_cnt, bc->miss_cnt, bc->evict_cnt, bc->dirty_cnt, dentry_hits, dentry_misses, inodes, bc->pin_cnt, bc->pool_overflow_cnt};
+        if (m_lock_slot) { mount_locks[*m_lock_slot]->unlock(); }
+        return stats;
+    }
+
+    auto filesystem_lwext4::dirty_blocks() noexcept -> std::size_t
     {
-        auto       handle = std::make_unique<file_handle_lwext4>(m_root, abspath);
+        const auto bc = m_handle.get_blockdev().bc;
+        if (bc == nullptr) { return 0; }
+
+        if (m_lock_slot) { mount_locks[*m_lock_slot]->lock(); }
+        const std::size_t dirty = bc->dirty_cnt;
+        if (m_lock_slot) { mount_locks[*m_lock_slot]->unlock(); }
+        return dirty;
+    }
+
+    auto filesystem_lwext4::pinned_blocks() noexcept -> std::size_t
+    {
+        const auto bc = m_handle.get_blockdev().bc;
+        if (bc == nullptr) { return 0; }
+
+        if (m_lock_slot) { mount_locks[*m_lock_slot]->lock(); }
+        const std::size_t pinned = bc->pin_cnt;
+        if (m_lock_slot) { mount_locks[*m_lock_slot]->unlock(); }
+        return pinned;
+    }
+
+    void filesystem_lwext4::balance_dirty() noexcept
+    {
+        if (not m_options.write_back) { return; }
+        if (dirty_blocks() * 100 < m_handle.get_blockdev().bc->cnt * std::size_t {m_options.dirty_ratio}) { return; }
+        {
+            std::lock_guard lock {m_flusher_mutex};
+            m_flush_requested = true;
+        }
+        m_flusher_cond.notify_one();
+    }
+
+    void filesystem_lwext4::flusher(const std::stop_token stop)
+    {
+        using clock             = std::chrono::steady_clock;
+        using std::chrono::milliseconds;
+        const auto& native_root = m_native_root;
+        const auto timed_commit = m_options.journal_commit == JournalCommit::grouped;
+        const auto check_period = std::max(std::min(m_options.write_back ? m_options.dirty_expire / 4 : milliseconds::max(),
+                                                    timed_commit ? m_options.commit_interval : milliseconds::max()),
+                                           milliseconds {1});
+
+        clock::time_point dirty_since {}; ///< When dirty blocks were first noticed, epoch if there are none
+        auto              next_commit = clock::now() + m_options.commit_interval;
+        std::unique_lock  lock {m_flusher_mutex};
+        while (not stop.stop_requested()) {
+            m_flusher_cond.wait_for(lock, stop, check_period, [this] { return m_flush_requested; });
+            const auto requested = std::exchange(m_flush_requested, false);
+            lock.unlock();
+
+            /// Commit first, so that blocks of the committed operations are written back in the same round
+            if (timed_commit and clock::now() >= next_commit) {
+                if (const auto err = ext4_journal_commit(native_root.c_str())) { log_error("Journal commit failed errno %i", err); }
+                next_commit = clock::now() + m_options.commit_interval;
+            }
+
+            if (m_options.write_back and dirty_blocks() == 0) {
+                dirty_since = {};
+            } else if (m_options.write_back) {
+                const auto now = clock::now();
+                if (dirty_since == clock::time_point {}) { dirty_since = now; }
+                if (requested or now - dirty_since >= m_options.dirty_expire) {
+                    if (const auto err = ext4_cache_flush(native_root.c_str())) { log_error("Write-back of dirty blocks failed errno %i", err); }
+                    dirty_since = {};
+                }
+            }
+            lock.lock();
+        }
+    }
+
+    auto filesystem_lwext4::open(PathView abspath, const Flags flags, [[maybe_unused]] const int mode) noexcept -> result<std::unique_ptr<FileHandle>>
+    {
+        auto       handle = std::make_unique<file_handle_lwext4>(m_root, std::filesystem::path {abspath.view()});
         const auto err    = ext4_fopen2(&handle->get_raw(), abspath.c_str(), static_cast<int>(flags.to_ullong()));
         if (err == EOK) {
-            ext4_atime_set(abspath.c_str(), get_posix_time());
+            touch_on_open(*handle, static_cast<int>(flags.to_ullong()));
             return handle;
         }
         return error(err);
     }
 
+    void filesystem_lwext4::touch_on_open(file_handle_lwext4& handle, const int flags) noexcept
+    {
+        if (m_mount_flags.test(MountFlags::read_only)) { return; }
+
+        ext4_inode ino;
+        if (ext4_file_inode_fill(&handle.get_raw(), &ino) != EOK) { return; }
+
+        const auto    now   = static_cast<std::uint32_t>(get_posix_time());
+        const auto    atime = ext4_inode_get_access_time(&ino);
+        const auto    mtime = ext4_inode_get_modif_time(&ino);
+        const auto    ctime = ext4_inode_get_change_inode_time(&ino);
+        std::uint32_t new_atime {};
+        std::uint32_t new_mtime {};
+
+        if (handle.get_raw().created) {
+            new_atime = now;
+            new_mtime = now;
+        } else {
+            if ((flags & O_TRUNC) != 0 and (flags & O_ACCMODE) != O_RDONLY) { new_mtime = now; }
+            if (not m_mount_flags.test(MountFlags::noatime)) {
+                const auto stale = atime <= mtime or atime <= ctime or now - atime >= relatime_interval;
+                if (not m_mount_flags.test(MountFlags::relatime) or stale) { new_atime = now; }
+            }
+        }
+        if (new_atime == 0 and new_mtime == 0) { return; }
+        if (const auto err = ext4_ftimes_set(&handle.get_raw(), new_atime, new_mtime, m_mount_flags.test(MountFlags::lazytime))) {
+            log_warning("Unable to update timestamps errno %i", err);
+        }
+    }
+
     auto filesystem_lwext4::close(FileHandle& handle) noexcept -> std::error_code
     {
+        auto& nhandle = from(handle);
+        /// Only a handle which was written to changes the modification time, the update goes to its inode instead of looking up the path again
+        if (nhandle.modified) {
+            if (const auto err = ext4_ftimes_set(&nhandle.get_raw(), 0, static_cast<std::uint32_t>(get_posix_time()), m_mount_flags.test(MountFlags::lazytime))) {
+                log_warning("Unable to update timestamps errno %i", err);
+            }
+        }
         const auto err = invoke_fs(handle, ::ext4_fclose);
-        if (not err) { return from_errno(ext4_mtime_set(handle.get_path().c_str(), get_posix_time())); }
+        balance_dirty();
         return err;
     }
 
     auto filesystem_lwext4::write(FileHandle& handle, const char* ptr, size_t len) noexcept -> result<std::size_t>
     {
         std::size_t n_written {};
-        if (const auto err = invoke_fs(handle, ::ext4_fwrite, ptr, len, &n_written)) { return error(err); }
+        const auto  err = invoke_fs(handle, ::ext4_fwrite, ptr, len, &n_written);
+        if (n_written > 0) { from(handle).modified = true; }
+        balance_dirty();
+        if (err) { return error(err); }
         return n_written;
     }
 
@@ -178,6 +413,21 @@ namespace vfs {
         return n_read;
     }
 
+    auto filesystem_lwext4::read_pinned(FileHandle& handle, off_t offset, std::size_t len) noexcept -> result<PinnedData>
+    {
+        if (offset < 0) { return error(EINVAL); }
+        if (len == 0) { return PinnedData {}; }
+
+        ext4_pin    pin {};
+        const void* data {};
+        std::size_t avail {};
+        if (const auto err = ext4_fpin(&from(handle).get_raw(), static_cast<std::uint64_t>(offset), &pin, &data, &avail)) { return error(err); }
+        if (data == nullptr) { return PinnedData {std::span {zero_block}.first(std::min({len, avail, zero_block.size()})), nullptr, nullptr, nullptr}; }
+
+        const auto bytes = std::span {static_cast<const std::byte*>(data), std::min(len, avail)};
+        return PinnedData {bytes, unpin, pin.mp, pin.buf};
+    }
+
     auto filesystem_lwext4::lseek(FileHandle& handle, off_t pos, int dir) noexcept -> result<off_t>
     {
         auto& nhandle = from(handle);
@@ -185,52 +435,63 @@ namespace vfs {
         return ext4_ftell(&nhandle.get_raw());
     }
 
-    auto filesystem_lwext4::_stat(const std::filesystem::path& path, struct stat* st) noexcept -> std::error_code
+    auto filesystem_lwext4::native_path(const PathView path) const noexcept -> const char*
     {
-        uint32_t     inonum;
-        ext4_inode   ino;
-        ext4_sblock* sb;
-        auto         err = ext4_raw_inode_fill(to_native_path(m_root, path).c_str(), &inonum, &ino);
-        if (err) { return from_errno(err); }
-        err = ext4_get_sblock(to_native_path(m_root).c_str(), &sb);
-        if (err) { return from_errno(err); }
-        std::memset(st, 0, sizeof(*st));
-        st->st_ino       = inonum;
-        const auto btype = ext4_inode_type(sb, &ino);
-        st->st_mode      = ext4_inode_get_mode(sb, &ino) | ino_to_st_mode(btype);
+        /// lwext4 names its mount points with a trailing separator, the mount root itself has to be passed in that form
+        return path.view() == m_root ? m_native_root.c_str() : path.c_str();
+    }
+
+    void filesystem_lwext4::fill_stat(const std::uint32_t inonum, ext4_inode& ino, struct stat& st) const noexcept
+    {
+        std::memset(&st, 0, sizeof(st));
+        st.st_ino        = inonum;
+        const auto btype = ext4_inode_type(m_sblock, &ino);
+        st.st_mode       = ext4_inode_get_mode(m_sblock, &ino) | ino_to_st_mode(btype);
         // Update file type
-        st->st_nlink   = ext4_inode_get_links_cnt(&ino);
-        st->st_uid     = ext4_inode_get_uid(&ino);
-        st->st_gid     = ext4_inode_get_gid(&ino);
-        st->st_blocks  = ext4_inode_get_blocks_count(sb, &ino);
-        st->st_size    = ext4_inode_get_size(sb, &ino);
-        st->st_blksize = ext4_sb_get_block_size(sb);
-        st->st_dev     = ext4_inode_get_dev(&ino);
-        st->st_atime   = ext4_inode_get_access_time(&ino);
-        st->st_ctime   = ext4_inode_get_change_inode_time(&ino);
-        st->st_mtime   = ext4_inode_get_modif_time(&ino);
+        st.st_nlink   = ext4_inode_get_links_cnt(&ino);
+        st.st_uid     = ext4_inode_get_uid(&ino);
+        st.st_gid     = ext4_inode_get_gid(&ino);
+        st.st_blocks  = ext4_inode_get_blocks_count(m_sblock, &ino);
+        st.st_size    = ext4_inode_get_size(m_sblock, &ino);
+        st.st_blksize = ext4_sb_get_block_size(m_sblock);
+        st.st_dev     = ext4_inode_get_dev(&ino);
+        st.st_atime   = ext4_inode_get_access_time(&ino);
+        st.st_ctime   = ext4_inode_get_change_inode_time(&ino);
+        st.st_mtime   = ext4_inode_get_modif_time(&ino);
+    }
+
+    auto filesystem_lwext4::_stat(PathView path, struct stat* st) noexcept -> std::error_code
+    {
+        uint32_t   inonum;
+        ext4_inode ino;
+        if (const auto err = ext4_raw_inode_fill(native_path(path), &inonum, &ino)) { return from_errno(err); }
+        fill_stat(inonum, ino, *st);
         return {};
     }
 
     auto filesystem_lwext4::fstat(FileHandle& handle, struct stat& st) noexcept -> std::error_code
     {
-        auto& nhandle = from(handle);
-        return _stat(nhandle.get_path().c_str(), &st);
+        /// The handle already knows its inode, so only the inode table is accessed, without walking the path
+        auto&      nhandle = from(handle);
+        ext4_inode ino;
+        if (const auto err = ext4_file_inode_fill(&nhandle.get_raw(), &ino)) { return from_errno(err); }
+        fill_stat(nhandle.get_raw().inode, ino, st);
+        return {};
     }
 
-    auto filesystem_lwext4::stat(const std::filesystem::path& path, struct stat& st) noexcept -> std::error_code { return _stat(path, &st); }
+    auto filesystem_lwext4::stat(PathView path, struct stat& st) noexcept -> std::error_code { return _stat(path, &st); }
 
-    auto filesystem_lwext4::link(const std::filesystem::path& existing, const std::filesystem::path& newlink) noexcept -> std::error_code
+    auto filesystem_lwext4::link(PathView existing, PathView newlink) noexcept -> std::error_code
     {
         return invoke_fs(::ext4_flink, existing.c_str(), newlink.c_str());
     }
 
-    auto filesystem_lwext4::symlink(const std::filesystem::path& existing, const std::filesystem::path& newlink) noexcept -> std::error_code
+    auto filesystem_lwext4::symlink(PathView existing, PathView newlink) noexcept -> std::error_code
     {
         return invoke_fs(::ext4_fsymlink, existing.c_str(), newlink.c_str());
     }
 
-    auto filesystem_lwext4::unlink(const std::filesystem::path& name) noexcept -> std::error_code
+    auto filesystem_lwext4::unlink(PathView name) noexcept -> std::error_code
     {
         if (ext4_inode_exist(name.c_str(), EXT4_DE_DIR) == 0) {
             log_warning("rmdir syscall instead of unlink is recommended for remove directory");
@@ -239,20 +500,20 @@ namespace vfs {
         return from_errno(ext4_fremove(name.c_str()));
     }
 
-    auto filesystem_lwext4::rmdir(const std::filesystem::path& name) noexcept -> std::error_code { return from_errno(ext4_dir_rm(name.c_str())); }
+    auto filesystem_lwext4::rmdir(PathView name) noexcept -> std::error_code { return from_errno(ext4_dir_rm(name.c_str())); }
 
-    auto filesystem_lwext4::rename(const std::filesystem::path& oldname, const std::filesystem::path& newname) noexcept -> std::error_code
+    auto filesystem_lwext4::rename(PathView oldname, PathView newname) noexcept -> std::error_code
     {
         return invoke_fs(::ext4_frename, oldname.c_str(), newname.c_str());
     }
 
-    auto filesystem_lwext4::mkdir(const std::filesystem::path& path, [[maybe_unused]] int mode) noexcept -> std::error_code { return from_errno(ext4_dir_mk(path.c_str())); }
+    auto filesystem_lwext4::mkdir(PathView path, [[maybe_unused]] int mode) noexcept -> std::error_code { return from_errno(ext4_dir_mk(path.c_str())); }
 
-    auto filesystem_lwext4::diropen(const std::filesystem::path& path) noexcept -> result<std::unique_ptr<DirectoryHandle>>
+    auto filesystem_lwext4::diropen(PathView path) noexcept -> result<std::unique_ptr<DirectoryHandle>>
     {
         auto dirp = std::make_unique<directory_handle_lwext4>(m_root);
 
-        const auto ret = ext4_dir_open(&dirp->get_raw(), to_native_path(m_root, path).c_str());
+        const auto ret = ext4_dir_open(&dirp->get_raw(), native_path(path));
         if (ret == 0) { return dirp; }
         return error(ret);
     }
@@ -275,9 +536,46 @@ namespace vfs {
         return from_errno(ENOENT);
     }
 
+    auto filesystem_lwext4::dirnext_batch(DirectoryHandle& handle, std::span<DirEntry> entries, bool full_stat) noexcept -> result<std::size_t>
+    {
+        struct batch {
+            const filesystem_lwext4& fs;
+            std::span<DirEntry>      entries;
+        } ctx {*this, entries};
+
+        const auto fill = [](void* arg, std::size_t idx, const ext4_direntry* dentry, std::uint64_t next_off, const ext4_inode* inode) {
+            auto& ctx   = *static_cast<batch*>(arg);
+            auto& entry = ctx.entries[idx];
+            std::memcpy(entry.name.data(), dentry->name, dentry->name_length);
+            entry.name[dentry->name_length] = '\0';
+            entry.cookie                    = static_cast<off_t>(next_off);
+            if (inode != nullptr) {
+                auto ino = *inode;
+                ctx.fs.fill_stat(dentry->inode, ino, entry.st);
+                return;
+            }
+            std::memset(&entry.st, 0, sizeof(entry.st));
+            entry.st.st_ino  = dentry->inode;
+            entry.st.st_mode = ino_to_st_mode(dentry->inode_type);
+        };
+
+        std::size_t count {};
+        if (const auto err = ext4_dir_entry_next_batch(&from(handle).get_raw(), fill, &ctx, entries.size(), full_stat, &count)) { return error(err); }
+        return count;
+    }
+
+    /// Cookies are byte offsets of the entries in the directory, for hashed directories too, as their leaf blocks are listed in the block order
+    auto filesystem_lwext4::dirtell(DirectoryHandle& handle) noexcept -> result<off_t> { return static_cast<off_t>(ext4_dir_entry_tell(&from(handle).get_raw())); }
+
+    auto filesystem_lwext4::dirseek(DirectoryHandle& handle, off_t cookie) noexcept -> std::error_code
+    {
+        if (cookie < 0) { return from_errno(EINVAL); }
+        return invoke_fs(handle, ::ext4_dir_entry_seek, static_cast<std::uint64_t>(cookie));
+    }
+
     auto filesystem_lwext4::dirclose(DirectoryHandle& handle) noexcept -> std::error_code { return invoke_fs(handle, ::ext4_dir_close); }
 
-    auto filesystem_lwext4::chmod(const std::filesystem::path& path, const mode_t mode) noexcept -> std::error_code
+    auto filesystem_lwext4::chmod(PathView path, const mode_t mode) noexcept -> std::error_code
     {
         const auto err = ext4_mode_set(path.c_str(), mode);
         if (err == EOK) { ext4_mtime_set(path.c_str(), get_posix_time()); }
@@ -295,33 +593,29 @@ namespace vfs {
 
     auto filesystem_lwext4::ftruncate(FileHandle& handle, off_t len) noexcept -> std::error_code
     {
-        return invoke_fs(
-            handle,
-            [](ext4_file* file, uint64_t length) {
-                int err = ext4_ftruncate(file, length);
-                if (err == ENOTSUP) {
-                    // NOTE: Ext4 ftruncate supports only shrinking
-                    const auto zbuf_len = 8192;
-                    auto       buf      = std::make_unique<char[]>(zbuf_len);
-                    err                 = 0;
-                    for (size_t n = 0; n < length / zbuf_len; ++n) {
-                        err = ext4_fwrite(file, buf.get(), zbuf_len, nullptr);
-                        if (err) {
-                            err = -err;
-                            break;
-                        }
-                    }
-                    if (!err) {
-                        const ssize_t remain = length % zbuf_len;
-                        if (remain > 0) { err = -ext4_fwrite(file, buf.get(), remain, nullptr); }
-                    }
-                }
-                return err;
-            },
-            len);
+        if (len < 0) { return from_errno(EINVAL); }
+        // NOTE: Growing the file is a sparse size change, no blocks are allocated
+        const auto err = invoke_fs(handle, ::ext4_ftruncate, len);
+        if (not err) { from(handle).modified = true; }
+        balance_dirty();
+        return err;
     }
 
-    auto filesystem_lwext4::fsync([[maybe_unused]] FileHandle& handle) noexcept -> std::error_code { return from_errno(ext4_cache_flush(to_native_path(m_root).c_str())); }
+    auto filesystem_lwext4::fallocate(FileHandle& handle, const Flags mode, const off_t offset, const off_t len) noexcept -> std::error_code
+    {
+        if (offset < 0 or len <= 0) { return from_errno(EINVAL); }
+        if ((mode & ~Flags {}.set(FallocFlags::keep_size)).any()) { return from_errno(ENOTSUP); }
+        const auto keep_size = mode.test(FallocFlags::keep_size);
+        auto&      file      = from(handle).get_raw();
+        const auto err       = ext4_fallocate(&file, offset, len, keep_size);
+        if (err == EOK) { from(handle).modified = true; }
+        balance_dirty();
+        return from_errno(err);
+    }
+
+    auto filesystem_lwext4::fsync(FileHandle& handle) noexcept -> std::error_code { return invoke_fs(handle, ::ext4_fsync); }
+
+    auto filesystem_lwext4::fdatasync(FileHandle& handle) noexcept -> std::error_code { return invoke_fs(handle, ::ext4_fdatasync); }
 
     auto filesystem_lwext4::get_label() noexcept -> result<std::string>
     {
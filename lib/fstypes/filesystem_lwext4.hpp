@@ -5,43 +5,57 @@
 
 #include <ext4.h>
 
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <thread>
+
 namespace vfs {
     class partition;
+    class file_handle_lwext4;
 
     class filesystem_lwext4 final : public Filesystem {
     public:
         filesystem_lwext4(BlockDevice& bdev, Flags flags);
 
-        auto mount(std::string root, Flags flags) noexcept -> std::error_code override;
+        auto mount(std::string root, Flags flags, const MountOptions& options) noexcept -> std::error_code override;
         auto unmount() noexcept -> std::error_code override;
-        auto stat_vfs(const std::filesystem::path& path, struct statvfs& stat) noexcept -> std::error_code override;
+        auto stat_vfs(PathView path, struct statvfs& stat) noexcept -> std::error_code override;
+        auto stat_cache() noexcept -> result<CacheStats> override;
 
         /** Standard file access API */
-        auto open(const std::filesystem::path& abspath, Flags flags, int mode) noexcept -> result<std::unique_ptr<FileHandle>> override;
+        auto open(PathView abspath, Flags flags, int mode) noexcept -> result<std::unique_ptr<FileHandle>> override;
         auto close(FileHandle& handle) noexcept -> std::error_code override;
         auto write(FileHandle& handle, const char* ptr, size_t len) noexcept -> result<std::size_t> override;
         auto read(FileHandle& handle, char* ptr, size_t len) noexcept -> result<std::size_t> override;
+        auto read_pinned(FileHandle& handle, off_t offset, std::size_t len) noexcept -> result<PinnedData> override;
         auto lseek(FileHandle& handle, off_t pos, int dir) noexcept -> result<off_t> override;
         auto fstat(FileHandle& handle, struct stat& st) noexcept -> std::error_code override;
-        auto stat(const std::filesystem::path& file, struct stat& st) noexcept -> std::error_code override;
-        auto link(const std::filesystem::path& existing, const std::filesystem::path& newlink) noexcept -> std::error_code override;
-        auto symlink(const std::filesystem::path& existing, const std::filesystem::path& newlink) noexcept -> std::error_code override;
-        auto unlink(const std::filesystem::path& name) noexcept -> std::error_code override;
-        auto rmdir(const std::filesystem::path& name) noexcept -> std::error_code override;
-        auto rename(const std::filesystem::path& oldname, const std::filesystem::path& newname) noexcept -> std::error_code override;
-        auto mkdir(const std::filesystem::path& path, int mode) noexcept -> std::error_code override;
+        auto stat(PathView file, struct stat& st) noexcept -> std::error_code override;
+        auto link(PathView existing, PathView newlink) noexcept -> std::error_code override;
+        auto symlink(PathView existing, PathView newlink) noexcept -> std::error_code override;
+        auto unlink(PathView name) noexcept -> std::error_code override;
+        auto rmdir(PathView name) noexcept -> std::error_code override;
+        auto rename(PathView oldname, PathView newname) noexcept -> std::error_code override;
+        auto mkdir(PathView path, int mode) noexcept -> std::error_code override;
 
         /** Directory support API */
-        auto diropen(const std::filesystem::path& path) noexcept -> result<std::unique_ptr<DirectoryHandle>> override;
+        auto diropen(PathView path) noexcept -> result<std::unique_ptr<DirectoryHandle>> override;
         auto dirreset(DirectoryHandle& handle) noexcept -> std::error_code override;
         auto dirnext(DirectoryHandle& handle, std::filesystem::path& filename, struct stat& filestat) -> std::error_code override;
+        auto dirnext_batch(DirectoryHandle& handle, std::span<DirEntry> entries, bool full_stat) noexcept -> result<std::size_t> override;
+        auto dirtell(DirectoryHandle& handle) noexcept -> result<off_t> override;
+        auto dirseek(DirectoryHandle& handle, off_t cookie) noexcept -> std::error_code override;
         auto dirclose(DirectoryHandle& handle) noexcept -> std::error_code override;
 
         /** Other fops API */
         auto ftruncate(FileHandle& handle, off_t len) noexcept -> std::error_code override;
+        auto fallocate(FileHandle& handle, Flags mode, off_t offset, off_t len) noexcept -> std::error_code override;
         auto fsync(FileHandle& handle) noexcept -> std::error_code override;
+        auto fdatasync(FileHandle& handle) noexcept -> std::error_code override;
 
-        auto chmod(const std::filesystem::path& path, mode_t mode) noexcept -> std::error_code override;
+        auto chmod(PathView path, mode_t mode) noexcept -> std::error_code override;
         auto fchmod(FileHandle& handle, mode_t mode) noexcept -> std::error_code override;
 
         auto isatty(FileHandle& handle) noexcept -> result<bool> override;
@@ -49,14 +63,40 @@ namespace vfs {
         auto get_label() noexcept -> result<std::string> override;
 
     private:
-        auto _stat(const std::filesystem::path& path, struct stat* st) noexcept -> std::error_code;
-
+        auto _stat(PathView path, struct stat* st) noexcept -> std::error_code;
+        void fill_stat(std::uint32_t inonum, ext4_inode& ino, struct stat& st) const noexcept;
+        /// Path as lwext4 expects it, without copying it
+        auto native_path(PathView path) const noexcept -> const char*;
+        /// Update timestamps of a file just opened, the access time follows the noatime/relatime mount flags
+        void touch_on_open(file_handle_lwext4& handle, int flags) noexcept;
+
+        /// Number of dirty blocks waiting in the block cache
+        auto dirty_blocks() noexcept -> std::size_t;
+        /// Number of blocks pinned by read_pinned
+        auto pinned_blocks() noexcept -> std::size_t;
+        /// Wake up the flusher if dirty blocks exceed the mount's dirty ratio, called after operations writing file data
+        void balance_dirty() noexcept;
+        /// Write-back flusher, writes dirty blocks when woken up by balance_dirty() or once they've been dirty for longer than dirty_expire. It also commits
+        /// the journal every commit_interval if operations are committed in groups.
+        void flusher(std::stop_token stop);
 
     private:
-        BlockDevice&  m_blockdev;
-        Flags         m_flags;
-        lwext4_handle m_handle;
-        std::string   m_root;
+        BlockDevice&               m_blockdev;
+        Flags                      m_flags;
+        Flags                      m_mount_flags;
+        lwext4_handle              m_handle;
+        std::string                m_root;
+        std::string                m_native_root; ///< m_root with a trailing separator, the name of the lwext4 mount point
+        std::optional<std::size_t> m_lock_slot; ///< Slot of the lock passed to lwext4 to guard its internals
+        MountOptions               m_options;
+        ext4_sblock*               m_sblock {}; ///< Superblock of the mounted filesystem, owned by lwext4
+        ext4_dcache*               m_dcache {}; ///< Directory entry cache of the mounted filesystem, owned by lwext4
+        ext4_icache*               m_icache {}; ///< In-memory inodes of the open files, owned by lwext4
+
+        std::mutex                  m_flusher_mutex;
+        std::condition_variable_any m_flusher_cond;
+        bool                        m_flush_requested {};
+        std::jthread                m_flusher; ///< Runs only if the mount point uses write-back caching or timed journal commits
     };
 
     class filesystem_factory_lwext4 final : public FilesystemFactory {
@@ -67,6 +107,8 @@ namespace vfs {
     class file_handle_lwext4 final : public FileHandle, public RawHandle<ext4_file> {
     public:
         using FileHandle::FileHandle;
+
+        bool modified {}; ///< File data was written through the handle, its modification time is updated on close
     };
 
     class directory_handle_lwext4 final : public DirectoryHandle, public RawHandle<ext4_dir> {
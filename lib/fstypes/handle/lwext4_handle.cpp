@@ -1,8 +1,11 @@
 #include "lwext4_handle.hpp"
 
 #include "logger/log.hpp"
+#include <algorithm>
+#include <array>
 #include <cstring>
 #include <cinttypes>
+#include <span>
 
 namespace vfs {
 
@@ -24,6 +27,26 @@ namespace vfs {
         return err.value();
     }
 
+    int lwext4_handle::readv(ext4_blockdev* bdev, const ext4_io_segment* segs, const std::uint32_t seg_cnt)
+    {
+        const auto ctx = static_cast<lwext4_handle*>(bdev->bdif->p_user);
+        if (!ctx) { return -EIO; }
+        /// lwext4 batches at most CONFIG_FREAD_SEGMENTS_COUNT segments, they are converted on the stack
+        std::array<read_segment, CONFIG_FREAD_SEGMENTS_COUNT> segments;
+        for (auto pending = std::span {segs, seg_cnt}; not pending.empty();) {
+            const auto count = std::min(pending.size(), segments.size());
+            std::ranges::transform(pending.first(count), segments.begin(), [](const ext4_io_segment& seg) {
+                return read_segment {seg.blk_id, seg.blk_cnt, static_cast<std::byte*>(seg.buf)};
+            });
+            if (const auto err = ctx->device.readv(std::span<const read_segment> {segments.data(), count})) {
+                log_error("Vectored sector read error errno: %i on block: %" PRIu64 " segments: %" PRIu32, err.value(), segs[0].blk_id, seg_cnt);
+                return err.value();
+            }
+            pending = pending.subspan(count);
+        }
+        return 0;
+    }
+
     int lwext4_handle::open(ext4_blockdev*) { return 0; }
 
     int lwext4_handle::close(ext4_blockdev*) { return 0; }
@@ -40,6 +63,7 @@ namespace vfs {
         std::memset(&bdev, 0, sizeof(bdev));
         ifc.open         = open;
         ifc.bread        = read;
+        ifc.breadv       = readv;
         ifc.bwrite       = write;
         ifc.close        = close;
         buf              = std::make_unique<std::uint8_t[]>(*sect_size);
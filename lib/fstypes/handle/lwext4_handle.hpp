@@ -16,6 +16,7 @@ namespace vfs {
     private:
         static int write(ext4_blockdev* bdev, const void* buf, std::uint64_t blk_id, std::uint32_t blk_cnt);
         static int read(ext4_blockdev* bdev, void* buf, std::uint64_t blk_id, std::uint32_t blk_cnt);
+        static int readv(ext4_blockdev* bdev, const ext4_io_segment* segs, std::uint32_t seg_cnt);
         static int open(ext4_blockdev* bdev);
         static int close(ext4_blockdev* bdev);
 
@@ -52,6 +52,8 @@ extern "C" {
 #include <ext4_debug.h>
 
 #include <ext4_blockdev.h>
+#include <ext4_dcache.h>
+#include <ext4_icache.h>
 
 /********************************OS LOCK INFERFACE***************************/
 
@@ -84,8 +86,39 @@ typedef struct ext4_file {
 
 	/**@brief   Actual file position.*/
 	uint64_t fpos;
+
+	/**@brief   In-memory inode shared by the files opened with the same
+	 *          inode, NULL if the inode table is accessed directly.*/
+	struct ext4_cinode *ci;
+
+	/**@brief   Last run of contiguously mapped blocks looked up, following
+	 *          blocks of the run are resolved without a lookup.*/
+	uint32_t map_iblock;
+
+	/**@brief   Length of the mapped run, 0 if there is none.*/
+	uint32_t map_count;
+
+	/**@brief   First physical block of the mapped run.*/
+	uint64_t map_fblock;
+
+	/**@brief   Unmap generation of the in-memory inode the run is valid
+	 *          for.*/
+	uint32_t map_gen;
+
+	/**@brief   The file was created by the open call (O_CREAT).*/
+	bool created;
 } ext4_file;
 
+/**@brief   Block of file data pinned in the block cache (@ref ext4_fpin). */
+typedef struct ext4_pin {
+
+	/**@brief   Mount point handle.*/
+	struct ext4_mountpoint *mp;
+
+	/**@brief   Pinned buffer, NULL if nothing is pinned.*/
+	struct ext4_buf *buf;
+} ext4_pin;
+
 /*****************************DIRECTORY DESCRIPTOR***************************/
 
 /**@brief   Directory entry descriptor. */
@@ -144,6 +177,23 @@ int ext4_mount(const char *dev_name,
 	       const char *mount_point,
 	       bool read_only);
 
+/**@brief   Mount a block device with EXT4 partition to the mount point
+ *          using a block cache of given capacity.
+ *
+ * @param   dev_name Block device name (@ref ext4_device_register).
+ * @param   mount_point Mount point.
+ * @param   read_only mount as read-only mode.
+ * @param   cache_size block cache capacity in filesystem blocks,
+ *          0 selects CONFIG_BLOCK_DEV_CACHE_SIZE.
+ * @param   policy block cache replacement policy.
+ *
+ * @return Standard error code */
+int ext4_mount_with_cache(const char *dev_name,
+			  const char *mount_point,
+			  bool read_only,
+			  uint32_t cache_size,
+			  enum ext4_bcache_policy policy);
+
 /**@brief   Umount operation.
  *
  * @param   mount_point Mount point.
@@ -182,6 +232,29 @@ int ext4_journal_stop(const char *mount_point);
  * @return Standard error code. */
 int ext4_recover(const char *mount_point);
 
+/**@brief   Enables group commit. Transactions of consecutive operations
+ *          are merged and committed together once they collect
+ *          max_blocks blocks, or on @ref ext4_journal_commit,
+ *          @ref ext4_fsync and @ref ext4_journal_stop.
+ * @warning Must be called after @ref ext4_journal_start. An operation
+ *          failing while other operations wait for the commit isn't
+ *          rolled back.
+ *
+ * @param   mount_point Mount point.
+ * @param   max_blocks Block budget of a transaction, limited to a quarter
+ *          of the journal and a quarter of the block cache. 0 commits
+ *          every operation on its own.
+ *
+ * @return  Standard error code. */
+int ext4_journal_group_commit(const char *mount_point, uint32_t max_blocks);
+
+/**@brief   Commits the transaction collected in group commit mode.
+ *
+ * @param   mount_point Mount point.
+ *
+ * @return  Standard error code. */
+int ext4_journal_commit(const char *mount_point);
+
 /**@brief   Some of the filesystem stats. */
 struct ext4_mount_stats {
 	uint32_t inodes_count;
@@ -223,6 +296,30 @@ int ext4_mount_setup_locks(const char *mount_point,
  * @return Standard error code. */
 int ext4_get_sblock(const char *mount_point, struct ext4_sblock **sb);
 
+/**@brief   Resize the directory entry cache of a mp, dropping its entries.
+ *
+ * @param   mount_point Mount point.
+ * @param   entries Cache capacity, 0 disables the cache.
+ *
+ * @return Standard error code. */
+int ext4_mount_setup_dcache(const char *mount_point, uint32_t entries);
+
+/**@brief   Acquire the directory entry cache pointer of a mp.
+ *
+ * @param   mount_point Mount point.
+ * @param   dc Directory entry cache handle
+ *
+ * @return Standard error code. */
+int ext4_get_dcache(const char *mount_point, struct ext4_dcache **dc);
+
+/**@brief   Acquire the inode cache pointer of a mp.
+ *
+ * @param   mount_point Mount point.
+ * @param   ic Inode cache handle
+ *
+ * @return Standard error code. */
+int ext4_get_icache(const char *mount_point, struct ext4_icache **ic);
+
 /**@brief   Enable/disable write back cache mode.
  * @warning Default model of cache is write trough. It means that when You do:
  *
@@ -268,6 +365,23 @@ int ext4_cache_write_back(const char *path, bool on);
  * @return  Standard error code. */
 int ext4_cache_flush(const char *path);
 
+/**@brief   Commit the pending journal transaction and write back cached
+ *          changes of a file and the metadata shared with other files
+ *          (bitmaps, directories, journal).
+ *
+ * @param   file File handle.
+ *
+ * @return  Standard error code. */
+int ext4_fsync(ext4_file *file);
+
+/**@brief   Like @ref ext4_fsync, but skips changes of the file that
+ *          update its timestamps only.
+ *
+ * @param   file File handle.
+ *
+ * @return  Standard error code. */
+int ext4_fdatasync(ext4_file *file);
+
 /********************************FILE OPERATIONS*****************************/
 
 /**@brief   Remove file by path.
@@ -338,6 +452,20 @@ int ext4_fclose(ext4_file *file);
  * @return  Standard error code.*/
 int ext4_ftruncate(ext4_file *file, uint64_t size);
 
+/**@brief   Allocate the blocks of a file range without writing them, they
+ *          read as zeros until they are written. Block mapped files can't
+ *          record unwritten blocks, holes of the range are allocated and
+ *          zeroed instead, keep_size isn't supported for them.
+ *
+ * @param   file      File handle.
+ * @param   offset    Offset of the range.
+ * @param   len       Length of the range.
+ * @param   keep_size Don't extend the file size to the end of the range.
+ *
+ * @return  Standard error code.*/
+int ext4_fallocate(ext4_file *file, uint64_t offset, uint64_t len,
+		   bool keep_size);
+
 /**@brief   Read data from file.
  *
  * @param   file File handle.
@@ -348,6 +476,34 @@ int ext4_ftruncate(ext4_file *file, uint64_t size);
  * @return  Standard error code.*/
 int ext4_fread(ext4_file *file, void *buf, size_t size, size_t *rcnt);
 
+/**@brief   Read data from file in place. Instead of being copied, the block
+ *          holding the data is pinned in the block cache: it's taken out of
+ *          the replacement queues and stays in memory until it's released
+ *          by @ref ext4_funpin. Only regular files can be read this way.
+ *
+ * @warning Pinned data of a range written, truncated or removed while it's
+ *          pinned is undefined. Pins must be released before unmounting.
+ *
+ * @param   file File handle.
+ * @param   off  Offset of the data, the file position isn't changed.
+ * @param   pin  Pinned block, its buf is NULL if nothing was pinned.
+ * @param   data Data at the offset, NULL for a hole, which reads as zeros
+ *               and isn't pinned.
+ * @param   len  Bytes available at the offset, up to the end of the block
+ *               or of the file, 0 at the end of file.
+ *
+ * @return  Standard error code, ENOBUFS if pinned blocks would take more
+ *          than a half of the block cache.*/
+int ext4_fpin(ext4_file *file, uint64_t off, ext4_pin *pin, const void **data,
+	      size_t *len);
+
+/**@brief   Release a block pinned by @ref ext4_fpin, so that it can be
+ *          evicted from the block cache again. Blocks freed or written while
+ *          pinned are dropped from the cache.
+ *
+ * @param   pin Pinned block.*/
+void ext4_funpin(ext4_pin *pin);
+
 /**@brief   Write data to file.
  *
  * @param   file File handle.
@@ -395,6 +551,14 @@ uint64_t ext4_fsize(ext4_file *file);
 int ext4_raw_inode_fill(const char *path, uint32_t *ret_ino,
 			struct ext4_inode *inode);
 
+/**@brief Get inode of an opened file, without resolving its path.
+ *
+ * @param file  File handle.
+ * @param inode Inode internals.
+ *
+ * @return  Standard error code.*/
+int ext4_file_inode_fill(ext4_file *file, struct ext4_inode *inode);
+
 /**@brief Check if inode exists.
  *
  * @param path    Parh to file/dir/link.
@@ -446,6 +610,20 @@ int ext4_owner_set(const char *path, uint32_t uid, uint32_t gid);
  * @return  Standard error code.*/
 int ext4_owner_get(const char *path, uint32_t *uid, uint32_t *gid);
 
+/**@brief Set access and modification time of an open file. Times are
+ *        updated in its inode, no path lookup is done.
+ *
+ * @param file  File handle.
+ * @param atime Access timestamp, 0 keeps the current one.
+ * @param mtime Modification timestamp, also sets the change time,
+ *              0 keeps the current ones.
+ * @param lazy  Keep the update in memory until the inode is written for
+ *              another reason, on file sync or unmount.
+ *
+ * @return  Standard error code.*/
+int ext4_ftimes_set(ext4_file *file, uint32_t atime, uint32_t mtime,
+		    bool lazy);
+
 /**@brief Set file/directory/link access time.
  *
  * @param path  Path to file/dir/link.
@@ -611,6 +789,52 @@ int ext4_dir_close(ext4_dir *dir);
  * @return  Directory entry id (NULL if no entry)*/
 const ext4_direntry *ext4_dir_entry_next(ext4_dir *dir);
 
+/**@brief   Directory entry callback of @ref ext4_dir_entry_next_batch.
+ *
+ * @param   arg   User argument.
+ * @param   idx   Index of the entry within the batch.
+ * @param   de    Directory entry.
+ * @param   next_off Offset of the following entry, see @ref ext4_dir_entry_tell.
+ * @param   inode Inode the entry refers to, NULL unless requested.*/
+typedef void (*ext4_dir_entry_cb)(void *arg, size_t idx,
+				  const ext4_direntry *de, uint64_t next_off,
+				  const struct ext4_inode *inode);
+
+/**@brief   Return several next directory entries at once, under a single
+ *          lock of the mount point. Inodes are read by the inode number of
+ *          the entries, the path isn't looked up.
+ *
+ * @param   dir    Directory handle.
+ * @param   cb     Called for every entry.
+ * @param   arg    User argument of the callback.
+ * @param   count  Maximum number of entries.
+ * @param   inodes Read the inodes the entries refer to.
+ * @param   rcount Number of entries returned, 0 at the end of directory.
+ *
+ * @return  Standard error code, reported only if no entry was returned.*/
+int ext4_dir_entry_next_batch(ext4_dir *dir, ext4_dir_entry_cb cb, void *arg,
+			      size_t count, bool inodes, size_t *rcount);
+
+/**@brief   Offset of the next directory entry, a position that may be
+ *          restored with @ref ext4_dir_entry_seek. It's the directory size
+ *          once all entries were returned.
+ *
+ * @param   dir Directory handle.
+ *
+ * @return  Offset in the directory.*/
+uint64_t ext4_dir_entry_tell(ext4_dir *dir);
+
+/**@brief   Continue from an offset returned by @ref ext4_dir_entry_tell.
+ *          Only the block holding the offset is read. If the entry at the
+ *          offset was removed since, the listing continues with the
+ *          following one.
+ *
+ * @param   dir Directory handle.
+ * @param   off Offset in the directory.
+ *
+ * @return  Standard error code.*/
+int ext4_dir_entry_seek(ext4_dir *dir, uint64_t off);
+
 /**@brief   Rewine directory entry offset.
  *
  * @param   dir Directory handle.*/
@@ -101,6 +101,38 @@ int ext4_balloc_alloc_block(struct ext4_inode_ref *inode_ref,
 			    ext4_fsblk_t goal,
 			    ext4_fsblk_t *baddr);
 
+/**@brief   Allocate a run of contiguous blocks to map at a logical block
+ *          of an inode. Blocks preallocated for the inode at the logical
+ *          block are used first. Otherwise the run is searched in a single
+ *          pass over the group bitmaps; for an open inode up to
+ *          @ref CONFIG_PREALLOC_BLOCKS are allocated at once and the blocks
+ *          not mapped now stay preallocated for the following logical
+ *          blocks.
+ * @param   inode_ref inode reference
+ * @param   iblock logical block the run is mapped at
+ * @param   goal goal block
+ * @param   count maximum number of blocks to map
+ * @param   room unmapped logical blocks from iblock the inode may
+ *          preallocate for, 0 not to preallocate
+ * @param   baddr first allocated block address
+ * @param   allocated number of allocated blocks, at least one
+ * @return  standard error code*/
+int ext4_balloc_alloc_blocks(struct ext4_inode_ref *inode_ref,
+			     ext4_lblk_t iblock, ext4_fsblk_t goal,
+			     uint32_t count, uint32_t room,
+			     ext4_fsblk_t *baddr, uint32_t *allocated);
+
+/**@brief   Free the blocks preallocated for an inode.
+ * @param   fs filesystem
+ * @param   ci cached inode
+ * @return  standard error code*/
+int ext4_balloc_discard_prealloc(struct ext4_fs *fs, struct ext4_cinode *ci);
+
+/**@brief   Free the blocks preallocated for all cached inodes.
+ * @param   fs filesystem
+ * @return  standard error code*/
+int ext4_balloc_discard_all_prealloc(struct ext4_fs *fs);
+
 /**@brief   Try allocate selected block.
  * @param   inode_ref inode reference
  * @param   baddr block address to allocate
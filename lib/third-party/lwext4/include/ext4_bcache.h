@@ -43,6 +43,7 @@ extern "C" {
 
 #include <ext4_config.h>
 
+#include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include <misc/tree.h>
@@ -65,6 +66,27 @@ struct ext4_block {
 
 struct ext4_bcache;
 
+/**@brief   Replacement policy of block cache*/
+enum ext4_bcache_policy {
+	/**@brief   Evict the least recently used buffer*/
+	EXT4_BCACHE_POLICY_LRU,
+
+	/**@brief   2Q: buffers referenced once are kept in a FIFO, only
+	 *          buffers requested again shortly after their eviction make
+	 *          it to the main LRU queue. One-time scans can't push out
+	 *          frequently used blocks.*/
+	EXT4_BCACHE_POLICY_2Q
+};
+
+/**@brief   Replacement queue of a buffer*/
+enum ext4_bcache_queue {
+	/**@brief   Main LRU queue*/
+	EXT4_BCACHE_QUEUE_AM,
+
+	/**@brief   FIFO of buffers referenced once (2Q only)*/
+	EXT4_BCACHE_QUEUE_A1IN
+};
+
 /**@brief   Single block descriptor*/
 struct ext4_buf {
 	/**@brief   Flags*/
@@ -82,6 +104,9 @@ struct ext4_buf {
 	/**@brief   LRU id.*/
 	uint32_t lru_id;
 
+	/**@brief   Replacement queue (@ref ext4_bcache_queue)*/
+	uint8_t queue;
+
 	/**@brief   Reference count table*/
 	uint32_t refctr;
 
@@ -91,14 +116,26 @@ struct ext4_buf {
 	/**@brief   Whether or not buffer is on dirty list.*/
 	bool on_dirty_list;
 
+	/**@brief   I-node whose changes the buffer holds since it was last
+	 *          written, 0 if none, EXT4_BCACHE_INO_SHARED if the changes
+	 *          belong to several i-nodes or no i-node at all.*/
+	uint32_t dirty_ino;
+
+	/**@brief   Changes of dirty_ino are timestamp updates only.*/
+	bool dirty_times_only;
+
 	/**@brief   LBA tree node*/
 	RB_ENTRY(ext4_buf) lba_node;
 
-	/**@brief   LRU tree node*/
+	/**@brief   LRU tree node (of either replacement queue)*/
 	RB_ENTRY(ext4_buf) lru_node;
 
 	/**@brief   Dirty list node*/
-	SLIST_ENTRY(ext4_buf) dirty_node;
+	LIST_ENTRY(ext4_buf) dirty_node;
+
+	/**@brief   Next buffer in the same bucket of LBA hash index, or next
+	 *          free buffer of the pool while the buffer is not in use*/
+	struct ext4_buf *hash_next;
 
 	/**@brief   Callback routine after a disk-write operation.
 	 * @param   bc block cache descriptor
@@ -132,6 +169,10 @@ struct ext4_bcache {
 	/**@brief   Maximum referenced datablocks*/
 	uint32_t max_ref_blocks;
 
+	/**@brief   Referenced datablocks pinned by readers of file data in
+	 *          place (@ref ext4_fpin), they can't be evicted*/
+	uint32_t pin_cnt;
+
 	/**@brief   The blockdev binded to this block cache*/
 	struct ext4_blockdev *bdev;
 
@@ -141,13 +182,88 @@ struct ext4_bcache {
 	/**@brief   A tree holding all bufs*/
 	RB_HEAD(ext4_buf_lba, ext4_buf) lba_root;
 
-	/**@brief   A tree holding unreferenced bufs*/
+	/**@brief   Hash index of all bufs by LBA, used for point lookups
+	 *          of large caches. NULL if the cache is small enough
+	 *          to be searched by lba_root only.*/
+	struct ext4_buf **hash;
+
+	/**@brief   Hash index bucket mask (bucket count - 1)*/
+	uint32_t hash_mask;
+
+	/**@brief   Memory of the buffer pool, allocated once at init*/
+	void *pool_mem;
+
+	/**@brief   Pool buffers, cnt plus CONFIG_BCACHE_POOL_RESERVE*/
+	uint32_t pool_cnt;
+
+	/**@brief   Pool buffer descriptors (pool_cnt entries)*/
+	struct ext4_buf *pool_bufs;
+
+	/**@brief   Pool block payloads (pool_cnt * itemsize bytes, aligned to
+	 *          CONFIG_BCACHE_POOL_ALIGN)*/
+	uint8_t *pool_data;
+
+	/**@brief   Free pool buffers*/
+	struct ext4_buf *pool_free;
+
+	/**@brief   Buffers allocated from heap because the pool was exhausted
+	 *          (all of its buffers referenced at once)*/
+	uint64_t pool_overflow_cnt;
+
+	/**@brief   Lookups satisfied by the cache*/
+	uint64_t hit_cnt;
+
+	/**@brief   Lookups that required a new buffer*/
+	uint64_t miss_cnt;
+
+	/**@brief   Unreferenced buffers dropped to make room for new ones*/
+	uint64_t evict_cnt;
+
+	/**@brief   Replacement policy (@ref ext4_bcache_policy)*/
+	uint8_t policy;
+
+	/**@brief   A tree holding unreferenced bufs of the main LRU queue*/
 	RB_HEAD(ext4_buf_lru, ext4_buf) lru_root;
 
-	/**@brief   A singly-linked list holding dirty buffers*/
-	SLIST_HEAD(ext4_buf_dirty, ext4_buf) dirty_list;
+	/**@brief   A tree holding unreferenced bufs of the A1in FIFO (2Q)*/
+	RB_HEAD(ext4_buf_a1, ext4_buf) a1_root;
+
+	/**@brief   Buffers in the A1in FIFO, referenced or not (2Q)*/
+	uint32_t a1_cnt;
+
+	/**@brief   Ring of LBAs recently evicted from the A1in FIFO (2Q)*/
+	uint64_t *ghost;
+
+	/**@brief   Ghost ring capacity*/
+	uint32_t ghost_size;
+
+	/**@brief   Valid entries of the ghost ring*/
+	uint32_t ghost_len;
+
+	/**@brief   Next ghost ring slot to be overwritten*/
+	uint32_t ghost_pos;
+
+	/**@brief   A list holding dirty buffers*/
+	LIST_HEAD(ext4_buf_dirty, ext4_buf) dirty_list;
+
+	/**@brief   Buffers on dirty list*/
+	uint32_t dirty_cnt;
+
+	/**@brief   Changes of dirty list, lets walkers of the list find out
+	 *          whether writing a buffer changed anything but the buffer*/
+	uint32_t dirty_gen;
+
+	/**@brief   I-node that buffers dirtied by the current operation are
+	 *          attributed to, 0 if the operation isn't bound to a file.*/
+	uint32_t dirty_owner;
+
+	/**@brief   The current operation updates timestamps only.*/
+	bool dirty_owner_times_only;
 };
 
+/**@brief   Dirty buffer owner of changes not bound to a single i-node*/
+#define EXT4_BCACHE_INO_SHARED UINT32_MAX
+
 /**@brief buffer state bits
  *
  *  - BC♡UPTODATE: Buffer contains valid data.
@@ -156,12 +272,15 @@ struct ext4_bcache {
  *              when no one references it.
  *  - BC_TMP: Buffer will be dropped once its refctr
  *            reaches zero.
+ *  - BC_TRANS: Buffer belongs to a journal transaction which
+ *              is not committed yet, it must not be written back.
  */
 enum bcache_state_bits {
 	BC_UPTODATE,
 	BC_DIRTY,
 	BC_FLUSH,
-	BC_TMP
+	BC_TMP,
+	BC_TRANS
 };
 
 #define ext4_bcache_set_flag(buf, b)    \
@@ -176,11 +295,42 @@ enum bcache_state_bits {
 static inline void ext4_bcache_set_dirty(struct ext4_buf *buf) {
 	ext4_bcache_set_flag(buf, BC_UPTODATE);
 	ext4_bcache_set_flag(buf, BC_DIRTY);
+	if (!buf->dirty_ino)
+		buf->dirty_ino = EXT4_BCACHE_INO_SHARED;
 }
 
 static inline void ext4_bcache_clear_dirty(struct ext4_buf *buf) {
 	ext4_bcache_clear_flag(buf, BC_UPTODATE);
 	ext4_bcache_clear_flag(buf, BC_DIRTY);
+	buf->dirty_ino = 0;
+}
+
+/**@brief   Attribute buffers dirtied from now on to an i-node, until
+ *          the owner is reset to 0.
+ * @param   bc block cache descriptor
+ * @param   ino i-node number, 0 for none
+ * @param   times_only the changes are timestamp updates only*/
+static inline void ext4_bcache_set_dirty_owner(struct ext4_bcache *bc,
+					       uint32_t ino, bool times_only) {
+	bc->dirty_owner = ino;
+	bc->dirty_owner_times_only = times_only;
+}
+
+/**@brief   Record the current dirty owner on a buffer being modified.
+ * @param   bc block cache descriptor
+ * @param   buf buffer descriptor*/
+static inline void ext4_bcache_tag_dirty(struct ext4_bcache *bc,
+					 struct ext4_buf *buf) {
+	uint32_t ino = bc->dirty_owner ? bc->dirty_owner
+				       : EXT4_BCACHE_INO_SHARED;
+	if (!buf->dirty_ino) {
+		buf->dirty_ino = ino;
+		buf->dirty_times_only = bc->dirty_owner_times_only;
+	} else if (buf->dirty_ino != ino) {
+		buf->dirty_ino = EXT4_BCACHE_INO_SHARED;
+	} else {
+		buf->dirty_times_only &= bc->dirty_owner_times_only;
+	}
 }
 
 /**@brief   Increment reference counter of buf by 1.*/
@@ -195,8 +345,10 @@ static inline void ext4_bcache_clear_dirty(struct ext4_buf *buf) {
 static inline void
 ext4_bcache_insert_dirty_node(struct ext4_bcache *bc, struct ext4_buf *buf) {
 	if (!buf->on_dirty_list) {
-		SLIST_INSERT_HEAD(&bc->dirty_list, buf, dirty_node);
+		LIST_INSERT_HEAD(&bc->dirty_list, buf, dirty_node);
 		buf->on_dirty_list = true;
+		bc->dirty_cnt++;
+		bc->dirty_gen++;
 	}
 }
 
@@ -206,8 +358,10 @@ ext4_bcache_insert_dirty_node(struct ext4_bcache *bc, struct ext4_buf *buf) {
 static inline void
 ext4_bcache_remove_dirty_node(struct ext4_bcache *bc, struct ext4_buf *buf) {
 	if (buf->on_dirty_list) {
-		SLIST_REMOVE(&bc->dirty_list, buf, ext4_buf, dirty_node);
+		LIST_REMOVE(buf, dirty_node);
 		buf->on_dirty_list = false;
+		bc->dirty_cnt--;
+		bc->dirty_gen++;
 	}
 }
 
@@ -220,6 +374,14 @@ ext4_bcache_remove_dirty_node(struct ext4_bcache *bc, struct ext4_buf *buf) {
 int ext4_bcache_init_dynamic(struct ext4_bcache *bc, uint32_t cnt,
 			     uint32_t itemsize);
 
+/**@brief   Select replacement policy of block cache. Must be called
+ *          before the cache is used.
+ * @param   bc block cache descriptor
+ * @param   policy replacement policy
+ * @return  standard error code*/
+int ext4_bcache_set_policy(struct ext4_bcache *bc,
+			   enum ext4_bcache_policy policy);
+
 /**@brief   Do cleanup works on block cache.
  * @param   bc block cache descriptor.*/
 void ext4_bcache_cleanup(struct ext4_bcache *bc);
@@ -234,6 +396,17 @@ int ext4_bcache_fini_dynamic(struct ext4_bcache *bc);
  * @return  buffer with the lowest LRU counter*/
 struct ext4_buf *ext4_buf_lowest_lru(struct ext4_bcache *bc);
 
+/**@brief   Get the unreferenced buffer to be evicted next according to
+ *          the replacement policy.
+ * @param   bc block cache descriptor
+ * @return  buffer to evict or NULL if all buffers are referenced*/
+struct ext4_buf *ext4_bcache_victim(struct ext4_bcache *bc);
+
+/**@brief   Evict unreferenced (and clean) buffer from bcache.
+ * @param   bc block cache descriptor
+ * @param   buf buffer*/
+void ext4_bcache_evict_buf(struct ext4_bcache *bc, struct ext4_buf *buf);
+
 /**@brief   Drop unreferenced buffer from bcache.
  * @param   bc block cache descriptor
  * @param   buf buffer*/
@@ -253,6 +426,21 @@ void ext4_bcache_invalidate_lba(struct ext4_bcache *bc,
 				uint64_t from,
 				uint32_t cnt);
 
+/**@brief   Copy the data of dirty buffers of a range over a buffer read
+ *          from the device, which doesn't hold it yet.
+ * @param   bc block cache descriptor
+ * @param   from starting lba
+ * @param   cnt block counts
+ * @param   dst data of the range, one block after another*/
+void ext4_bcache_copy_dirty(struct ext4_bcache *bc, uint64_t from,
+			    uint32_t cnt, void *dst);
+
+/**@brief   Find buffer of given LBA without referencing it.
+ * @param   bc block cache descriptor
+ * @param   lba logical block address
+ * @return  block cache buffer or NULL if not cached*/
+struct ext4_buf *ext4_bcache_find(struct ext4_bcache *bc, uint64_t lba);
+
 /**@brief   Find existing buffer from block cache memory.
  *          Unreferenced block allocation is based on LRU
  *          (Last Recently Used) algorithm.
@@ -46,6 +46,18 @@ extern "C" {
 #include <stdbool.h>
 #include <stdint.h>
 
+/**@brief   Single segment of a vectored block request.*/
+struct ext4_io_segment {
+	/**@brief   First block id*/
+	uint64_t blk_id;
+
+	/**@brief   Block count*/
+	uint32_t blk_cnt;
+
+	/**@brief   Data buffer*/
+	void *buf;
+};
+
 struct ext4_blockdev_iface {
 	/**@brief   Open device function
 	 * @param   bdev block device.*/
@@ -70,6 +82,14 @@ struct ext4_blockdev_iface {
 	 * @param   bdev block device.*/
 	int (*close)(struct ext4_blockdev *bdev);
 
+	/**@brief   Vectored block read function. Not mandatory field, segments
+	 *          are read one by one with bread if not provided.
+	 * @param   bdev block device
+	 * @param   segs segments to be read
+	 * @param   seg_cnt segment count*/
+	int (*breadv)(struct ext4_blockdev *bdev,
+		      const struct ext4_io_segment *segs, uint32_t seg_cnt);
+
 	/**@brief   Lock block device. Required in multi partition mode
 	 *          operations. Not mandatory field.
 	 * @param   bdev block device.*/
@@ -216,6 +236,15 @@ int ext4_block_set(struct ext4_blockdev *bdev, struct ext4_block *b);
 int ext4_blocks_get_direct(struct ext4_blockdev *bdev, void *buf, uint64_t lba,
 			   uint32_t cnt);
 
+/**@brief   Vectored block read procedure (without cache). Logical block
+ *          addresses of the segments are translated in place.
+ * @param   bdev block device descriptor
+ * @param   segs segments to be read
+ * @param   seg_cnt segment count
+ * @return  standard error code*/
+int ext4_blocks_get_direct_vec(struct ext4_blockdev *bdev,
+			       struct ext4_io_segment *segs, uint32_t seg_cnt);
+
 /**@brief   Block write procedure (without cache)
  * @param   bdev block device descriptor
  * @param   buf output buffer
@@ -247,6 +276,15 @@ int ext4_block_readbytes(struct ext4_blockdev *bdev, uint64_t off, void *buf,
  * @return  standard error code*/
 int ext4_block_cache_flush(struct ext4_blockdev *bdev);
 
+/**@brief   Flush dirty buffers holding changes of an i-node, together
+ *          with buffers shared with other i-nodes or not bound to any
+ * @param   bdev block device descriptor
+ * @param   ino i-node number
+ * @param   datasync skip buffers holding timestamp updates only
+ * @return  standard error code*/
+int ext4_block_cache_flush_ino(struct ext4_blockdev *bdev, uint32_t ino,
+			       bool datasync);
+
 /**@brief   Enable/disable write back cache mode
  * @param   bdev block device descriptor
  * @param   on_off
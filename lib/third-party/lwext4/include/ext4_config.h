@@ -123,11 +123,53 @@ extern "C" {
 #define CONFIG_BLOCK_DEV_ENABLE_STATS 1
 #endif
 
+/**@brief   Maximum number of discontiguous block runs gathered by a single
+ *          file read before they are submitted to the block device.*/
+#ifndef CONFIG_FREAD_SEGMENTS_COUNT
+#define CONFIG_FREAD_SEGMENTS_COUNT 8
+#endif
+
 /**@brief   Cache size of block device.*/
 #ifndef CONFIG_BLOCK_DEV_CACHE_SIZE
 #define CONFIG_BLOCK_DEV_CACHE_SIZE 8
 #endif
 
+/**@brief   Minimum block cache size indexed by a hash table in addition
+ *          to the LBA tree.*/
+#ifndef CONFIG_BCACHE_HASH_THRESHOLD
+#define CONFIG_BCACHE_HASH_THRESHOLD 64
+#endif
+
+/**@brief   Directory entry cache size (entries) of a mount point,
+ *          0 disables the cache.*/
+#ifndef CONFIG_DCACHE_SIZE
+#define CONFIG_DCACHE_SIZE 128
+#endif
+
+/**@brief   Longest name held by the directory entry cache.*/
+#ifndef CONFIG_DCACHE_NAME_LEN
+#define CONFIG_DCACHE_NAME_LEN 32
+#endif
+
+/**@brief   Maximum number of closed files whose lazily updated
+ *          timestamps wait in memory to be written.*/
+#ifndef CONFIG_ICACHE_LAZY_COUNT
+#define CONFIG_ICACHE_LAZY_COUNT 32
+#endif
+
+/**@brief   Blocks a linear directory may take before it's converted to
+ *          a hashed index, once it needs another one. Takes effect with
+ *          the dir_index feature.*/
+#ifndef CONFIG_DIR_INDEX_THRESHOLD
+#define CONFIG_DIR_INDEX_THRESHOLD 1
+#endif
+
+/**@brief   Blocks allocated at once by an append to an open file, the
+ *          ones not mapped yet are kept for the following appends,
+ *          0 or 1 disables preallocation.*/
+#ifndef CONFIG_PREALLOC_BLOCKS
+#define CONFIG_PREALLOC_BLOCKS 32
+#endif
 
 /**@brief   Maximum block device name*/
 #ifndef CONFIG_EXT4_MAX_BLOCKDEV_NAME
@@ -173,6 +215,27 @@ extern "C" {
 #define CONFIG_USE_USER_MALLOC 0
 #endif
 
+/**@brief Switches allocation of block cache buffer pools from
+ *        ext4_malloc/ext4_free to user provided ext4_user_pool_malloc and
+ *        ext4_user_pool_free, e.g. to place them in a dedicated memory
+ *        region*/
+#ifndef CONFIG_USE_USER_POOL_MALLOC
+#define CONFIG_USE_USER_POOL_MALLOC 0
+#endif
+
+/**@brief Alignment of block payloads in block cache buffer pool*/
+#ifndef CONFIG_BCACHE_POOL_ALIGN
+#define CONFIG_BCACHE_POOL_ALIGN 64
+#endif
+
+/**@brief Buffers preallocated in block cache buffer pool on top of the
+ *        cache capacity. They hold the journal blocks written by a commit
+ *        of a transaction, whose blocks stay referenced until it's
+ *        committed, when no cached block can be evicted.*/
+#ifndef CONFIG_BCACHE_POOL_RESERVE
+#define CONFIG_BCACHE_POOL_RESERVE 4
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2026 mprogramming
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup lwext4
+ * @{
+ */
+/**
+ * @file  ext4_dcache.h
+ * @brief Directory entry cache, maps (parent inode, name) to child inode.
+ */
+
+#ifndef EXT4_DCACHE_H_
+#define EXT4_DCACHE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <ext4_config.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <misc/tree.h>
+#include <misc/queue.h>
+
+/**@brief   Cached directory entry*/
+struct ext4_dentry {
+	/**@brief   Parent directory inode, 0 if the entry is unused*/
+	uint32_t parent;
+
+	/**@brief   Child inode, 0 if the name doesn't exist (negative entry)*/
+	uint32_t ino;
+
+	/**@brief   Child inode type (EXT4_INODE_MODE_*)*/
+	uint32_t imode;
+
+	/**@brief   Name length*/
+	uint8_t name_len;
+
+	/**@brief   Name, not null terminated*/
+	char name[CONFIG_DCACHE_NAME_LEN];
+
+	/**@brief   (parent, name) tree node*/
+	RB_ENTRY(ext4_dentry) node;
+
+	/**@brief   LRU list node*/
+	TAILQ_ENTRY(ext4_dentry) lru_node;
+};
+
+/**@brief   Directory entry cache descriptor*/
+struct ext4_dcache {
+	/**@brief   Number of entries*/
+	uint32_t cnt;
+
+	/**@brief   Preallocated entries*/
+	struct ext4_dentry *entries;
+
+	/**@brief   Used entries, ordered by (parent, name)*/
+	RB_HEAD(ext4_dentry_tree, ext4_dentry) root;
+
+	/**@brief   All entries, most recently used first, unused at the tail*/
+	TAILQ_HEAD(ext4_dentry_lru, ext4_dentry) lru;
+
+	/**@brief   Lookups satisfied by the cache*/
+	uint64_t hit_cnt;
+
+	/**@brief   Lookups that required a directory search*/
+	uint64_t miss_cnt;
+};
+
+/**@brief   Allocate the cache.
+ * @param   dc cache descriptor
+ * @param   cnt number of entries, 0 disables the cache
+ * @return  standard error code*/
+int ext4_dcache_init(struct ext4_dcache *dc, uint32_t cnt);
+
+/**@brief   Release the cache.
+ * @param   dc cache descriptor*/
+void ext4_dcache_fini(struct ext4_dcache *dc);
+
+/**@brief   Find an entry.
+ * @param   dc cache descriptor, may be NULL
+ * @param   parent parent directory inode
+ * @param   name entry name
+ * @param   name_len entry name length
+ * @return  cached entry, NULL if not cached*/
+struct ext4_dentry *ext4_dcache_lookup(struct ext4_dcache *dc, uint32_t parent,
+				       const char *name, uint32_t name_len);
+
+/**@brief   Remember the result of a directory search. Names longer than
+ *          CONFIG_DCACHE_NAME_LEN, "." and ".." aren't cached.
+ * @param   dc cache descriptor, may be NULL
+ * @param   parent parent directory inode
+ * @param   name entry name
+ * @param   name_len entry name length
+ * @param   ino child inode, 0 if the name doesn't exist
+ * @param   imode child inode type*/
+void ext4_dcache_insert(struct ext4_dcache *dc, uint32_t parent,
+			const char *name, uint32_t name_len, uint32_t ino,
+			uint32_t imode);
+
+/**@brief   Forget an entry, called whenever it's added to or removed
+ *          from its directory.
+ * @param   dc cache descriptor, may be NULL
+ * @param   parent parent directory inode
+ * @param   name entry name
+ * @param   name_len entry name length*/
+void ext4_dcache_invalidate(struct ext4_dcache *dc, uint32_t parent,
+			    const char *name, uint32_t name_len);
+
+/**@brief   Forget all entries of a directory, called when it's released.
+ * @param   dc cache descriptor, may be NULL
+ * @param   parent directory inode*/
+void ext4_dcache_invalidate_dir(struct ext4_dcache *dc, uint32_t parent);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EXT4_DCACHE_H_ */
+
+/**
+ * @}
+ */
@@ -101,6 +101,13 @@ int ext4_dir_dx_add_entry(struct ext4_inode_ref *parent,
 int ext4_dir_dx_reset_parent_inode(struct ext4_inode_ref *dir,
                                    uint32_t parent_inode);
 
+/**@brief Convert a linear directory to an indexed one. Entries are kept
+ *        in memory while the directory blocks are rewritten.
+ * @param dir Directory i-node
+ * @return Error code, ENOMEM or ENOTSUP leave the directory linear
+ */
+int ext4_dir_dx_convert(struct ext4_inode_ref *dir);
+
 #ifdef __cplusplus
 }
 #endif
@@ -55,6 +55,14 @@ int ext4_extent_get_blocks(struct ext4_inode_ref *inode_ref, ext4_lblk_t iblock,
 			   uint32_t max_blocks, ext4_fsblk_t *result, bool create,
 			   uint32_t *blocks_count);
 
+/**@brief Allocate the unmapped blocks of a range as unwritten extents,
+ *        they read as zeros until they are written.
+ * @param inode_ref I-node to allocate blocks to
+ * @param iblock    First logical block of the range
+ * @param count     Number of logical blocks of the range
+ * @return Error code */
+int ext4_extent_alloc_unwritten(struct ext4_inode_ref *inode_ref,
+				ext4_lblk_t iblock, uint32_t count);
 
 /**@brief Release all data blocks starting from specified logical block.
  * @param inode_ref   I-node to release blocks from
@@ -49,6 +49,8 @@ extern "C" {
 #include <ext4_config.h>
 #include <ext4_types.h>
 #include <ext4_misc.h>
+#include <ext4_dcache.h>
+#include <ext4_icache.h>
 
 #include <stdint.h>
 #include <stdbool.h>
@@ -67,6 +69,12 @@ struct ext4_fs {
 	struct jbd_fs *jbd_fs;
 	struct jbd_journal *jbd_journal;
 	struct jbd_trans *curr_trans;
+
+	/**@brief   Directory entry cache, NULL if there is none.*/
+	struct ext4_dcache *dcache;
+
+	/**@brief   Inodes of the open files, NULL if there is none.*/
+	struct ext4_icache *icache;
 };
 
 struct ext4_block_group_ref {
@@ -139,6 +147,13 @@ int ext4_fs_init(struct ext4_fs *fs, struct ext4_blockdev *bdev,
  */
 int ext4_fs_fini(struct ext4_fs *fs);
 
+/**@brief Enable the hashed directory index of a filesystem formatted
+ *        without it, linear directories are converted as they grow.
+ * @param fs Filesystem, left as it is if mounted read only
+ * @return Error code
+ */
+int ext4_fs_enable_dir_index(struct ext4_fs *fs);
+
 /**@brief Check filesystem's features, if supported by this driver
  * Function can return EOK and set read_only flag. It mean's that
  * there are some not-supported features, that can cause problems
@@ -240,6 +255,19 @@ int ext4_fs_get_inode_dblk_idx(struct ext4_inode_ref *inode_ref,
 				 ext4_lblk_t iblock, ext4_fsblk_t *fblock,
 				 bool support_unwritten);
 
+/**@brief Get physical address of a run of logical blocks.
+ * @param inode_ref    I-node to find blocks of
+ * @param iblock       First logical block
+ * @param max_blocks   Longest run to look up
+ * @param fblock       First physical block, 0 for a hole
+ * @param blocks_count Length of the run mapped contiguously (or of the hole)
+ *                     from iblock, only extents map runs longer than 1
+ * @return Error code
+ */
+int ext4_fs_get_inode_dblk_run(struct ext4_inode_ref *inode_ref,
+			       ext4_lblk_t iblock, uint32_t max_blocks,
+			       ext4_fsblk_t *fblock, uint32_t *blocks_count);
+
 /**@brief Initialize a part of unwritten range of the inode.
  * @param inode_ref I-node to proceed on.
  * @param iblock    Logical index of block
@@ -249,6 +277,19 @@ int ext4_fs_get_inode_dblk_idx(struct ext4_inode_ref *inode_ref,
 int ext4_fs_init_inode_dblk_idx(struct ext4_inode_ref *inode_ref,
 				  ext4_lblk_t iblock, ext4_fsblk_t *fblock);
 
+/**@brief Get a run of physical blocks of the i-node, a hole or an unwritten
+ *        range is allocated and written first.
+ * @param inode_ref    I-node to proceed on
+ * @param iblock       Logical index of the first block
+ * @param max_blocks   Maximum length of the run
+ * @param fblock       Output physical address of the first block
+ * @param blocks_count Output number of contiguous blocks from fblock
+ * @return Error code
+ */
+int ext4_fs_init_inode_dblk_run(struct ext4_inode_ref *inode_ref,
+				ext4_lblk_t iblock, uint32_t max_blocks,
+				ext4_fsblk_t *fblock, uint32_t *blocks_count);
+
 /**@brief Append following logical block to the i-node.
  * @param inode_ref I-node to append block to
  * @param fblock    Output physical block address of newly allocated block
@@ -258,6 +299,18 @@ int ext4_fs_init_inode_dblk_idx(struct ext4_inode_ref *inode_ref,
 int ext4_fs_append_inode_dblk(struct ext4_inode_ref *inode_ref,
 			      ext4_fsblk_t *fblock, ext4_lblk_t *iblock);
 
+/**@brief Append a run of following logical blocks to the i-node.
+ * @param inode_ref    I-node to append blocks to
+ * @param max_blocks   Maximum number of blocks to append
+ * @param fblock       Output physical block address of the first block
+ * @param iblock       Output logical number of the first block
+ * @param blocks_count Output number of appended contiguous blocks
+ * @return Error code
+ */
+int ext4_fs_append_inode_dblks(struct ext4_inode_ref *inode_ref,
+			       uint32_t max_blocks, ext4_fsblk_t *fblock,
+			       ext4_lblk_t *iblock, uint32_t *blocks_count);
+
 /**@brief   Increment inode link count.
  * @param   inode_ref none handle
  */
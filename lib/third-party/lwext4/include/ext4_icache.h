@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) 2026 mprogramming
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup lwext4
+ * @{
+ */
+/**
+ * @file  ext4_icache.h
+ * @brief Inode cache, in-memory inodes shared by the open files.
+ */
+
+#ifndef EXT4_ICACHE_H_
+#define EXT4_ICACHE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <ext4_config.h>
+#include <ext4_types.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <misc/tree.h>
+#include <misc/queue.h>
+
+/**@brief   In-memory inode. While it's cached, it holds the most recent
+ *          state of the inode, the inode table is updated from it once it's
+ *          dirty (@ref ext4_fs_get_inode_ref).*/
+struct ext4_cinode {
+	/**@brief   Inode number*/
+	uint32_t index;
+
+	/**@brief   Open files referencing the inode*/
+	uint32_t refctr;
+
+	/**@brief   Outstanding references to the inode table copy
+	 *          (@ref ext4_fs_get_inode_ref)*/
+	uint32_t table_refs;
+
+	/**@brief   Incremented when blocks of the inode are unmapped, block
+	 *          runs remembered by the files get stale*/
+	uint32_t map_gen;
+
+	/**@brief   Preallocation window, blocks allocated for the inode but not
+	 *          mapped yet, reserved for the logical blocks following an
+	 *          append (@ref ext4_balloc_alloc_blocks)*/
+	ext4_lblk_t pa_lblk;
+	ext4_fsblk_t pa_pblk;
+	uint32_t pa_len;
+
+	/**@brief   Changed since it was last copied to the inode table*/
+	bool dirty;
+
+	/**@brief   Only timestamps changed, writing them may be put off until
+	 *          the inode is written for another reason, even after the
+	 *          last file referencing it is closed*/
+	bool lazy;
+
+	/**@brief   The inode was released, the entry is kept for the files
+	 *          still referencing it only*/
+	bool detached;
+
+	/**@brief   Inode content*/
+	struct ext4_inode inode;
+
+	/**@brief   Inode number tree node*/
+	RB_ENTRY(ext4_cinode) node;
+
+	/**@brief   Dirty list node*/
+	TAILQ_ENTRY(ext4_cinode) dirty_node;
+};
+
+/**@brief   Inode cache descriptor*/
+struct ext4_icache {
+	/**@brief   Bytes of an inode kept in memory, the on disk inode size
+	 *          limited to the size of @ref ext4_inode*/
+	uint32_t inode_size;
+
+	/**@brief   Number of cached inodes*/
+	uint32_t cnt;
+
+	/**@brief   Number of lazily written inodes no file references*/
+	uint32_t unref_cnt;
+
+	/**@brief   Cached inodes, ordered by inode number*/
+	RB_HEAD(ext4_cinode_tree, ext4_cinode) root;
+
+	/**@brief   Inodes waiting to be written to the inode table*/
+	TAILQ_HEAD(ext4_cinode_dirty, ext4_cinode) dirty_list;
+};
+
+/**@brief   Initialize the cache.
+ * @param   ic cache descriptor
+ * @param   inode_size on disk inode size*/
+void ext4_icache_init(struct ext4_icache *ic, uint32_t inode_size);
+
+/**@brief   Stop caching all inodes, files still referencing them keep
+ *          their copies.
+ * @param   ic cache descriptor*/
+void ext4_icache_fini(struct ext4_icache *ic);
+
+/**@brief   Find an inode.
+ * @param   ic cache descriptor, may be NULL
+ * @param   index inode number
+ * @return  cached inode, NULL if not cached*/
+struct ext4_cinode *ext4_icache_find(struct ext4_icache *ic, uint32_t index);
+
+/**@brief   Iterate the cached inodes in inode number order.
+ * @param   ic cache descriptor, may be NULL
+ * @param   ci previous inode, NULL to get the first one
+ * @return  next cached inode, NULL at the end*/
+struct ext4_cinode *ext4_icache_next(struct ext4_icache *ic,
+				     struct ext4_cinode *ci);
+
+/**@brief   Get a reference of a cached inode, or cache it.
+ * @param   ic cache descriptor
+ * @param   index inode number
+ * @param   inode inode content to cache if it isn't cached yet
+ * @return  cached inode, NULL if out of memory*/
+struct ext4_cinode *ext4_icache_get(struct ext4_icache *ic, uint32_t index,
+				    const struct ext4_inode *inode);
+
+/**@brief   Put back a reference, the last one releases the inode. Dirty
+ *          inodes have to be written to the inode table before, unless
+ *          they are lazy, these are released once they're written.
+ * @param   ic cache descriptor
+ * @param   ci cached inode*/
+void ext4_icache_put(struct ext4_icache *ic, struct ext4_cinode *ci);
+
+/**@brief   Mark an inode changed.
+ * @param   ic cache descriptor
+ * @param   ci cached inode
+ * @param   lazy only timestamps changed*/
+void ext4_icache_set_dirty(struct ext4_icache *ic, struct ext4_cinode *ci,
+			   bool lazy);
+
+/**@brief   Mark an inode copied to the inode table. Releases a lazily
+ *          written inode no file references.
+ * @param   ic cache descriptor
+ * @param   ci cached inode*/
+void ext4_icache_clear_dirty(struct ext4_icache *ic, struct ext4_cinode *ci);
+
+/**@brief   Stop caching an inode, called when it's released. Files still
+ *          referencing it keep their copy, it's never written back.
+ * @param   ic cache descriptor, may be NULL
+ * @param   index inode number*/
+void ext4_icache_detach(struct ext4_icache *ic, uint32_t index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EXT4_ICACHE_H_ */
+
+/**
+ * @}
+ */
@@ -582,6 +582,70 @@ struct ext4_dir_entry_tail {
 #define EXT4_JOURNAL_INO 8
 
 #define EXT4_GOOD_OLD_FIRST_INO 11
+
+/*
+ * Extent tree on disk structures. The root lives in the i-node blocks
+ * array, the other nodes take a whole block each.
+ */
+#pragma pack(push, 1)
+
+/*
+ * Tail of an extent tree block, it holds the checksum. Block sizes always
+ * leave at least 4 bytes after the last 12 bytes long entry.
+ */
+struct ext4_extent_tail {
+	uint32_t et_checksum; /* crc32c(uuid+inum+igeneration+extentblock) */
+};
+
+/*
+ * Leaf entry, maps a run of logical blocks to physical ones.
+ */
+struct ext4_extent {
+	uint32_t first_block; /* First logical block extent covers */
+	uint16_t block_count; /* Number of blocks covered by extent */
+	uint16_t start_hi;    /* High 16 bits of physical block */
+	uint32_t start_lo;    /* Low 32 bits of physical block */
+};
+
+/*
+ * Index entry, points to the node covering logical blocks from its first
+ * block on.
+ */
+struct ext4_extent_index {
+	uint32_t first_block; /* Index covers logical blocks from 'block' */
+	uint32_t leaf_lo;     /* Pointer to the physical block of the next
+			       * level. leaf or next index could be there */
+	uint16_t leaf_hi;     /* High 16 bits of physical block */
+	uint16_t padding;
+};
+
+/*
+ * Header of each extent tree node.
+ */
+struct ext4_extent_header {
+	uint16_t magic;
+	uint16_t entries_count;     /* Number of valid entries */
+	uint16_t max_entries_count; /* Capacity of store in entries */
+	uint16_t depth;             /* Has tree real underlying blocks? */
+	uint32_t generation;        /* generation of the tree */
+};
+
+#pragma pack(pop)
+
+#define EXT4_EXTENT_MAGIC 0xF30A
+
+/*
+ * Longest initialized extent, longer lengths mark unwritten extents.
+ */
+#define EXT4_EXT_INIT_MAX_LEN (1u << 15)
+#define EXT4_EXT_UNWRITTEN_MAX_LEN (EXT4_EXT_INIT_MAX_LEN - 1)
+
+/*
+ * Deepest extent tree, even 1 KiB blocks address the whole logical block
+ * range with it.
+ */
+#define EXT4_EXT_MAX_DEPTH 5
+
 #define EXT_MAX_BLOCKS (ext4_lblk_t) (-1)
 #define IN_RANGE(b, first, len)	((b) >= (first) && (b) <= (first) + (len) - 1)
 
@@ -836,6 +900,18 @@ struct jbd_sb {
 
 #endif
 
+#if CONFIG_USE_USER_POOL_MALLOC
+
+#define ext4_pool_malloc ext4_user_pool_malloc
+#define ext4_pool_free   ext4_user_pool_free
+
+#else
+
+#define ext4_pool_malloc ext4_malloc
+#define ext4_pool_free   ext4_free
+
+#endif
+
 
 #endif /* EXT4_TYPES_H_ */
 
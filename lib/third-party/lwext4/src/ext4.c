@@ -45,6 +45,8 @@
 #include <ext4_trans.h>
 #include <ext4_blockdev.h>
 #include <ext4_fs.h>
+#include <ext4_balloc.h>
+#include <ext4_extent.h>
 #include <ext4_dir.h>
 #include <ext4_inode.h>
 #include <ext4_super.h>
@@ -64,9 +66,11 @@
 			(_m)->os_locks->lock();                                \
 	} while (0)
 
-/**@brief   Mount point OS dependent unlock*/
+/**@brief   Mount point OS dependent unlock. Ends attribution of dirtied
+ *          buffers to a file (@ref ext4_bcache_set_dirty_owner).*/
 #define EXT4_MP_UNLOCK(_m)                                                     \
 	do {                                                                   \
+		ext4_bcache_set_dirty_owner(&(_m)->bc, 0, false);              \
 		if ((_m)->os_locks)                                            \
 			(_m)->os_locks->unlock();                              \
 	} while (0)
@@ -92,8 +96,22 @@ struct ext4_mountpoint {
 	/**@brief   Journal.*/
 	struct jbd_journal jbd_journal;
 
+	/**@brief   Block budget of a group commit transaction, 0 commits
+	 *          every operation on its own
+	 *          (@ref ext4_journal_group_commit).*/
+	uint32_t commit_blocks;
+
+	/**@brief   Operations collected by the current transaction.*/
+	uint32_t trans_ops;
+
 	/**@brief   Block cache.*/
 	struct ext4_bcache bc;
+
+	/**@brief   Directory entry cache.*/
+	struct ext4_dcache dcache;
+
+	/**@brief   Inodes of the open files.*/
+	struct ext4_icache icache;
 };
 
 /**@brief   Block devices descriptor.*/
@@ -362,6 +380,15 @@ static int ext4_unlink(struct ext4_mountpoint *mp,
 
 int ext4_mount(const char *dev_name, const char *mount_point,
 	       bool read_only)
+{
+	return ext4_mount_with_cache(dev_name, mount_point, read_only,
+				     CONFIG_BLOCK_DEV_CACHE_SIZE,
+				     EXT4_BCACHE_POLICY_LRU);
+}
+
+int ext4_mount_with_cache(const char *dev_name, const char *mount_point,
+			  bool read_only, uint32_t cache_size,
+			  enum ext4_bcache_policy policy)
 {
 	int r;
 	uint32_t bsize;
@@ -413,16 +440,34 @@ int ext4_mount(const char *dev_name, const char *mount_point,
 		return r;
 	}
 
+#if CONFIG_DIR_INDEX_ENABLE
+	r = ext4_fs_enable_dir_index(&mp->fs);
+	if (r != EOK) {
+		ext4_block_fini(bd);
+		return r;
+	}
+#endif
+
 	bsize = ext4_sb_get_block_size(&mp->fs.sb);
 	ext4_block_set_lb_size(bd, bsize);
 	bc = &mp->bc;
 
-	r = ext4_bcache_init_dynamic(bc, CONFIG_BLOCK_DEV_CACHE_SIZE, bsize);
+	if (!cache_size)
+		cache_size = CONFIG_BLOCK_DEV_CACHE_SIZE;
+
+	r = ext4_bcache_init_dynamic(bc, cache_size, bsize);
 	if (r != EOK) {
 		ext4_block_fini(bd);
 		return r;
 	}
 
+	r = ext4_bcache_set_policy(bc, policy);
+	if (r != EOK) {
+		ext4_bcache_fini_dynamic(bc);
+		ext4_block_fini(bd);
+		return r;
+	}
+
 	if (bsize != bc->itemsize)
 		return ENOTSUP;
 
@@ -435,12 +480,46 @@ int ext4_mount(const char *dev_name, const char *mount_point,
 		return r;
 	}
 
+	r = ext4_dcache_init(&mp->dcache, CONFIG_DCACHE_SIZE);
+	if (r != EOK) {
+		ext4_bcache_cleanup(bc);
+		ext4_block_fini(bd);
+		ext4_bcache_fini_dynamic(bc);
+		return r;
+	}
+
+	ext4_icache_init(&mp->icache, ext4_get16(&mp->fs.sb, inode_size));
+
+	mp->fs.dcache = &mp->dcache;
+	mp->fs.icache = &mp->icache;
 	bd->fs = &mp->fs;
 	mp->mounted = 1;
 	return r;
 }
 
 
+/**@brief   Copy dirty in-memory inodes to the inode table, as part of the
+ *          current transaction if there is one.*/
+static int ext4_icache_writeback(struct ext4_mountpoint *mp)
+{
+	struct ext4_cinode *ci;
+	struct ext4_inode_ref ref;
+	int r;
+
+	while ((ci = TAILQ_FIRST(&mp->icache.dirty_list))) {
+		r = ext4_fs_get_inode_ref(&mp->fs, ci->index, &ref);
+		if (r != EOK)
+			return r;
+
+		/*Putting back a modified reference clears the dirty flag*/
+		ref.dirty = true;
+		r = ext4_fs_put_inode_ref(&ref);
+		if (r != EOK)
+			return r;
+	}
+	return EOK;
+}
+
 int ext4_umount(const char *mount_point)
 {
 	int i;
@@ -457,12 +536,31 @@ int ext4_umount(const char *mount_point)
 	if (!mp)
 		return ENODEV;
 
+	/*Pinned blocks are referenced from outside of the mount point*/
+	if (mp->bc.pin_cnt)
+		return EBUSY;
+
+	/*Preallocated blocks of the files left open*/
+	r = ext4_balloc_discard_all_prealloc(&mp->fs);
+	if (r != EOK)
+		goto Finish;
+
+	/*Lazily updated inodes of a filesystem without journal*/
+	r = ext4_icache_writeback(mp);
+	if (r != EOK)
+		goto Finish;
+
 	r = ext4_fs_fini(&mp->fs);
 	if (r != EOK)
 		goto Finish;
 
 	mp->mounted = 0;
 
+	mp->fs.dcache = NULL;
+	ext4_dcache_fini(&mp->dcache);
+	mp->fs.icache = NULL;
+	ext4_icache_fini(&mp->icache);
+
 	ext4_bcache_cleanup(mp->fs.bdev->bc);
 	ext4_bcache_fini_dynamic(mp->fs.bdev->bc);
 
@@ -517,6 +615,10 @@ Finish:
 	return r;
 }
 
+static int __ext4_trans_commit(struct ext4_mountpoint *mp);
+static int ext4_trans_start(struct ext4_mountpoint *mp);
+static int ext4_trans_commit(struct ext4_mountpoint *mp);
+
 __unused
 static int __ext4_journal_stop(const char *mount_point)
 {
@@ -531,6 +633,11 @@ static int __ext4_journal_stop(const char *mount_point)
 
 	if (ext4_sb_feature_com(&mp->fs.sb,
 				EXT4_FCOM_HAS_JOURNAL)) {
+		r = ext4_trans_commit(mp);
+		if (r != EOK)
+			goto Finish;
+
+		mp->commit_blocks = 0;
 		r = jbd_journal_stop(&mp->jbd_journal);
 		if (r != EOK) {
 			mp->jbd_fs.dirty = false;
@@ -626,31 +733,62 @@ static int __ext4_trans_start(struct ext4_mountpoint *mp)
 			goto Finish;
 		}
 		mp->fs.curr_trans = trans;
+		mp->trans_ops = 0;
 	}
 Finish:
 	return r;
 }
 
 __unused
-static int __ext4_trans_stop(struct ext4_mountpoint *mp)
+static int __ext4_trans_commit(struct ext4_mountpoint *mp)
 {
 	int r = EOK;
 
 	if (mp->fs.jbd_journal && mp->fs.curr_trans) {
 		struct jbd_journal *journal = mp->fs.jbd_journal;
 		struct jbd_trans *trans = mp->fs.curr_trans;
+
+		/*Inodes changed in memory only are committed along with
+		 * the blocks they map*/
+		int wr = ext4_icache_writeback(mp);
 		r = jbd_journal_commit_trans(journal, trans);
+		if (r == EOK)
+			r = wr;
 		mp->fs.curr_trans = NULL;
 	}
 	return r;
 }
 
+__unused
+static int __ext4_trans_stop(struct ext4_mountpoint *mp)
+{
+	if (mp->fs.jbd_journal && mp->fs.curr_trans) {
+		/*In group commit mode the transaction stays open for the
+		 * following operations until it collects its block budget.
+		 * Its blocks stay referenced until then, it's committed
+		 * early if no cached block is left for eviction.*/
+		mp->trans_ops++;
+		if ((uint32_t)mp->fs.curr_trans->data_cnt < mp->commit_blocks &&
+		    !(ext4_bcache_is_full(&mp->bc) &&
+		      !ext4_bcache_victim(&mp->bc)))
+			return EOK;
+	}
+	return __ext4_trans_commit(mp);
+}
+
 __unused
 static void __ext4_trans_abort(struct ext4_mountpoint *mp)
 {
 	if (mp->fs.jbd_journal && mp->fs.curr_trans) {
 		struct jbd_journal *journal = mp->fs.jbd_journal;
 		struct jbd_trans *trans = mp->fs.curr_trans;
+
+		/*Changes of the operations collected so far can't be
+		 * discarded, whatever the failed one managed to change is
+		 * committed with them, like on a filesystem without journal*/
+		if (mp->trans_ops)
+			return;
+
 		jbd_journal_free_trans(journal, trans, true);
 		mp->fs.curr_trans = NULL;
 	}
@@ -683,6 +821,71 @@ int ext4_recover(const char *mount_point __unused)
 	return r;
 }
 
+static int ext4_trans_commit(struct ext4_mountpoint *mp __unused)
+{
+	int r = EOK;
+
+	/*In-memory inodes are committed even if no operation is waiting*/
+	if (!mp->fs.jbd_journal)
+		return ext4_icache_writeback(mp);
+	if (!TAILQ_EMPTY(&mp->icache.dirty_list))
+		ext4_trans_start(mp);
+#if CONFIG_JOURNALING_ENABLE
+	r = __ext4_trans_commit(mp);
+#endif
+	return r;
+}
+
+int ext4_journal_group_commit(const char *mount_point, uint32_t max_blocks)
+{
+	int r = EOK;
+	struct ext4_mountpoint *mp = ext4_get_mount(mount_point);
+
+	if (!mp)
+		return ENOENT;
+
+	EXT4_MP_LOCK(mp);
+	if (mp->fs.jbd_journal) {
+		/*A transaction has to fit in the journal along with the
+		 * ones being checkpointed, limit it to a quarter of it*/
+		struct jbd_sb *sb = &mp->jbd_fs.sb;
+		uint32_t limit = (jbd_get32(sb, maxlen) -
+				  jbd_get32(sb, first)) / 4;
+
+		/*Blocks of the transaction are referenced until it's
+		 * committed, it may take half of the cache left over by
+		 * the blocks pinned by readers (@ref ext4_fpin)*/
+		uint32_t cache_limit = (mp->bc.cnt - mp->bc.cnt / 2) / 2;
+		if (limit > cache_limit)
+			limit = cache_limit;
+
+		mp->commit_blocks = max_blocks < limit ? max_blocks : limit;
+		if (!mp->commit_blocks) {
+			ext4_block_cache_write_back(mp->fs.bdev, 1);
+			r = ext4_trans_commit(mp);
+			ext4_block_cache_write_back(mp->fs.bdev, 0);
+		}
+	}
+	EXT4_MP_UNLOCK(mp);
+	return r;
+}
+
+int ext4_journal_commit(const char *mount_point)
+{
+	int r;
+	struct ext4_mountpoint *mp = ext4_get_mount(mount_point);
+
+	if (!mp)
+		return ENOENT;
+
+	EXT4_MP_LOCK(mp);
+	ext4_block_cache_write_back(mp->fs.bdev, 1);
+	r = ext4_trans_commit(mp);
+	ext4_block_cache_write_back(mp->fs.bdev, 0);
+	EXT4_MP_UNLOCK(mp);
+	return r;
+}
+
 static int ext4_trans_start(struct ext4_mountpoint *mp __unused)
 {
 	int r = EOK;
@@ -695,6 +898,11 @@ static int ext4_trans_start(struct ext4_mountpoint *mp __unused)
 static int ext4_trans_stop(struct ext4_mountpoint *mp __unused)
 {
 	int r = EOK;
+
+	/*Without a journal there is no commit to wait for, in-memory inodes
+	 * are written at the end of the operation*/
+	if (!mp->fs.jbd_journal)
+		return ext4_icache_writeback(mp);
 #if CONFIG_JOURNALING_ENABLE
 	r = __ext4_trans_stop(mp);
 #endif
@@ -753,6 +961,46 @@ int ext4_mount_setup_locks(const char *mount_point,
 	return EOK;
 }
 
+int ext4_mount_setup_dcache(const char *mount_point, uint32_t entries)
+{
+	int r;
+	struct ext4_mountpoint *mp = ext4_get_mount(mount_point);
+
+	if (!mp)
+		return ENOENT;
+
+	EXT4_MP_LOCK(mp);
+	mp->fs.dcache = NULL;
+	ext4_dcache_fini(&mp->dcache);
+	r = ext4_dcache_init(&mp->dcache, entries);
+	if (r == EOK)
+		mp->fs.dcache = &mp->dcache;
+	EXT4_MP_UNLOCK(mp);
+	return r;
+}
+
+int ext4_get_dcache(const char *mount_point, struct ext4_dcache **dc)
+{
+	struct ext4_mountpoint *mp = ext4_get_mount(mount_point);
+
+	if (!mp)
+		return ENOENT;
+
+	*dc = &mp->dcache;
+	return EOK;
+}
+
+int ext4_get_icache(const char *mount_point, struct ext4_icache **ic)
+{
+	struct ext4_mountpoint *mp = ext4_get_mount(mount_point);
+
+	if (!mp)
+		return ENOENT;
+
+	*ic = &mp->icache;
+	return EOK;
+}
+
 /********************************FILE OPERATIONS*****************************/
 
 static int ext4_path_check(const char *path, bool *is_goal)
@@ -856,7 +1104,8 @@ static int ext4_trunc_inode(struct ext4_mountpoint *mp,
 			ext4_trans_stop(mp);
 	}
 
-	if (inode_size > new_size) {
+	/*Same size still releases the blocks beyond the end of file*/
+	if (inode_size >= new_size) {
 
 		inode_size = new_size;
 
@@ -937,8 +1186,12 @@ static int ext4_generic_open2(ext4_file *f, const char *path, int flags,
 	struct ext4_mountpoint *mp = ext4_get_mount(path);
 	struct ext4_dir_search_result result;
 	struct ext4_inode_ref ref;
+	struct ext4_dentry *de;
 
 	f->mp = 0;
+	f->ci = NULL;
+	f->map_count = 0;
+	f->created = false;
 
 	if (!mp)
 		return ENOENT;
@@ -979,11 +1232,23 @@ static int ext4_generic_open2(ext4_file *f, const char *path, int flags,
 			break;
 		}
 
-		r = ext4_dir_find_entry(&result, &ref, path, len);
+		/*Names known to the directory entry cache don't need a
+		 * directory search, including those known to not exist*/
+		de = ext4_dcache_lookup(fs->dcache, ref.index, path, len);
+		if (de)
+			r = de->ino ? EOK : ENOENT;
+		else
+			r = ext4_dir_find_entry(&result, &ref, path, len);
+
 		if (r != EOK) {
 
 			/*Destroy last result*/
-			ext4_dir_destroy_result(&ref, &result);
+			if (!de) {
+				ext4_dir_destroy_result(&ref, &result);
+				if (r == ENOENT && !(f->flags & O_CREAT))
+					ext4_dcache_insert(fs->dcache, ref.index,
+							   path, len, 0, 0);
+			}
 			if (r != ENOENT)
 				break;
 
@@ -1013,31 +1278,44 @@ static int ext4_generic_open2(ext4_file *f, const char *path, int flags,
 			}
 
 			ext4_fs_put_inode_ref(&child_ref);
+			f->created = is_goal;
 			continue;
 		}
 
 		if (parent_inode)
 			*parent_inode = ref.index;
 
-		next_inode = ext4_dir_en_get_inode(result.dentry);
-		if (ext4_sb_feature_incom(sb, EXT4_FINCOM_FILETYPE)) {
-			uint8_t t;
-			t = ext4_dir_en_get_inode_type(sb, result.dentry);
-			imode = ext4_fs_correspond_inode_mode(t);
+		if (de) {
+			next_inode = de->ino;
+			imode = de->imode;
 		} else {
-			struct ext4_inode_ref child_ref;
-			r = ext4_fs_get_inode_ref(fs, next_inode, &child_ref);
+			next_inode = ext4_dir_en_get_inode(result.dentry);
+			if (ext4_sb_feature_incom(sb, EXT4_FINCOM_FILETYPE)) {
+				uint8_t t;
+				t = ext4_dir_en_get_inode_type(sb,
+							       result.dentry);
+				imode = ext4_fs_correspond_inode_mode(t);
+			} else {
+				struct ext4_inode_ref child_ref;
+				r = ext4_fs_get_inode_ref(fs, next_inode,
+							  &child_ref);
+				if (r != EOK) {
+					ext4_dir_destroy_result(&ref, &result);
+					break;
+				}
+
+				imode = ext4_inode_type(sb, child_ref.inode);
+				ext4_fs_put_inode_ref(&child_ref);
+			}
+
+			r = ext4_dir_destroy_result(&ref, &result);
 			if (r != EOK)
 				break;
 
-			imode = ext4_inode_type(sb, child_ref.inode);
-			ext4_fs_put_inode_ref(&child_ref);
+			ext4_dcache_insert(fs->dcache, ref.index, path, len,
+					   next_inode, imode);
 		}
 
-		r = ext4_dir_destroy_result(&ref, &result);
-		if (r != EOK)
-			break;
-
 		/*If expected file error*/
 		if (imode != EXT4_INODE_MODE_DIRECTORY && !is_goal) {
 			r = ENOENT;
@@ -1436,6 +1714,30 @@ int ext4_cache_flush(const char *path)
 	return ret;
 }
 
+static int ext4_fsync_ino(ext4_file *file, bool datasync)
+{
+	int r;
+	ext4_assert(file && file->mp);
+
+	EXT4_MP_LOCK(file->mp);
+	r = ext4_trans_commit(file->mp);
+	if (r == EOK)
+		r = ext4_block_cache_flush_ino(file->mp->fs.bdev, file->inode,
+					       datasync);
+	EXT4_MP_UNLOCK(file->mp);
+	return r;
+}
+
+int ext4_fsync(ext4_file *file)
+{
+	return ext4_fsync_ino(file, false);
+}
+
+int ext4_fdatasync(ext4_file *file)
+{
+	return ext4_fsync_ino(file, true);
+}
+
 int ext4_fremove(const char *path)
 {
 	ext4_file f;
@@ -1539,6 +1841,255 @@ Finish:
 	return r;
 }
 
+/**@brief   Attach the shared in-memory inode to a file just opened. Files
+ *          the inode can't be cached for access the inode table instead.*/
+static void ext4_file_cache_inode(ext4_file *file, int open_r)
+{
+	struct ext4_inode_ref ref;
+	struct ext4_inode inode;
+
+	file->ci = NULL;
+	if (open_r != EOK)
+		return;
+
+	if (!ext4_icache_find(&file->mp->icache, file->inode)) {
+		if (ext4_fs_get_inode_ref(&file->mp->fs, file->inode, &ref))
+			return;
+		memcpy(&inode, ref.inode, file->mp->icache.inode_size);
+		ext4_fs_put_inode_ref(&ref);
+	}
+	file->ci = ext4_icache_get(&file->mp->icache, file->inode, &inode);
+}
+
+/**@brief   Get the inode reference of a file. It's backed by the in-memory
+ *          inode if the file has one, the inode table isn't accessed then.*/
+static int ext4_file_get_inode_ref(ext4_file *file,
+				   struct ext4_inode_ref *ref)
+{
+	if (!file->ci)
+		return ext4_fs_get_inode_ref(&file->mp->fs, file->inode, ref);
+
+	memset(ref, 0, sizeof(struct ext4_inode_ref));
+	ref->inode = &file->ci->inode;
+	ref->fs = &file->mp->fs;
+	ref->index = file->inode;
+	return EOK;
+}
+
+/**@brief   Put back a reference got by @ref ext4_file_get_inode_ref.
+ *          Changes of the in-memory inode are written to the inode table
+ *          on commit.*/
+static int ext4_file_put_inode_ref(ext4_file *file,
+				   struct ext4_inode_ref *ref)
+{
+	if (!file->ci)
+		return ext4_fs_put_inode_ref(ref);
+
+	if (ref->dirty)
+		ext4_icache_set_dirty(&file->mp->icache, file->ci, false);
+	return EOK;
+}
+
+/**@brief   Physical block of a file block from the last run the file
+ *          looked up.
+ * @return  true if the block belongs to the run*/
+static bool ext4_file_cached_dblk(ext4_file *file, ext4_lblk_t iblock,
+				  ext4_fsblk_t *fblock)
+{
+	if (!file->ci || file->map_gen != file->ci->map_gen)
+		return false;
+	if (iblock < file->map_iblock ||
+	    iblock - file->map_iblock >= file->map_count)
+		return false;
+
+	*fblock = file->map_fblock + iblock - file->map_iblock;
+	return true;
+}
+
+/**@brief   Get the physical block of a file block, 0 for a hole. The run
+ *          of blocks mapped contiguously with it is remembered, so
+ *          sequential access looks up every extent once.*/
+static int ext4_file_get_dblk(ext4_file *file, struct ext4_inode_ref *ref,
+			      ext4_lblk_t iblock, ext4_fsblk_t *fblock)
+{
+	uint32_t count;
+	int r;
+
+	if (ext4_file_cached_dblk(file, iblock, fblock))
+		return EOK;
+
+	r = ext4_fs_get_inode_dblk_run(ref, iblock, EXT_MAX_BLOCKS - iblock,
+				       fblock, &count);
+	if (r != EOK || !*fblock || !file->ci)
+		return r;
+
+	file->map_iblock = iblock;
+	file->map_count = count;
+	file->map_fblock = *fblock;
+	file->map_gen = file->ci->map_gen;
+	return EOK;
+}
+
+/**@brief   Get the physical block of a file block, a hole or an unwritten
+ *          range is allocated and written first, in a run of up to
+ *          max_blocks the caller overwrites.
+ * @param   fresh set if the block wasn't written before, NULL if the
+ *          caller overwrites it all*/
+static int ext4_file_init_dblk(ext4_file *file, struct ext4_inode_ref *ref,
+			       ext4_lblk_t iblock, uint32_t max_blocks,
+			       ext4_fsblk_t *fblock, bool *fresh)
+{
+	uint32_t count;
+	int r;
+
+	if (fresh)
+		*fresh = false;
+
+	r = ext4_file_get_dblk(file, ref, iblock, fblock);
+	if (r != EOK || *fblock)
+		return r;
+
+	r = ext4_fs_init_inode_dblk_run(ref, iblock, max_blocks, fblock,
+					&count);
+	if (r != EOK)
+		return r;
+
+	if (fresh)
+		*fresh = true;
+
+	if (file->ci) {
+		file->map_iblock = iblock;
+		file->map_count = count;
+		file->map_fblock = *fblock;
+		file->map_gen = file->ci->map_gen;
+	}
+	return EOK;
+}
+
+/**@brief   Read a part of a block. The cached copy of the block, if there
+ *          is one, is newer than the device as it may be dirty.*/
+static int ext4_file_read_part(ext4_file *file, ext4_fsblk_t fblock,
+			       uint32_t off, void *buf, uint32_t len)
+{
+	struct ext4_blockdev *bdev = file->mp->fs.bdev;
+	uint32_t block_size = ext4_sb_get_block_size(&file->mp->fs.sb);
+	struct ext4_block b;
+	int r;
+
+	if (!ext4_bcache_find_get(bdev->bc, &b, fblock))
+		return ext4_block_readbytes(bdev, fblock * block_size + off,
+					    buf, len);
+
+	if (ext4_bcache_test_flag(b.buf, BC_UPTODATE)) {
+		memcpy(buf, b.data + off, len);
+		r = EOK;
+	} else {
+		r = ext4_block_readbytes(bdev, fblock * block_size + off, buf,
+					 len);
+	}
+
+	ext4_block_set(bdev, &b);
+	return r;
+}
+
+/**@brief   Write a part of a block through the block cache, in write-back
+ *          mode it's left dirty there. The rest of a block that wasn't
+ *          written before is zeroed, it reads as zeros while it's
+ *          a hole or unwritten.*/
+static int ext4_file_write_part(ext4_file *file, ext4_fsblk_t fblock,
+				bool fresh, uint32_t off, const void *buf,
+				uint32_t len)
+{
+	struct ext4_blockdev *bdev = file->mp->fs.bdev;
+	uint32_t block_size = ext4_sb_get_block_size(&file->mp->fs.sb);
+	struct ext4_block b;
+	int r;
+
+	if (fresh) {
+		r = ext4_block_get_noread(bdev, &b, fblock);
+		if (r != EOK)
+			return r;
+
+		memset(b.data, 0, block_size);
+	} else {
+		r = ext4_block_get(bdev, &b, fblock);
+		if (r != EOK)
+			return r;
+	}
+
+	memcpy(b.data + off, buf, len);
+	ext4_bcache_tag_dirty(bdev->bc, b.buf);
+	ext4_bcache_set_dirty(b.buf);
+	return ext4_block_set(bdev, &b);
+}
+
+/**@brief   Zero the last block of a file past its end, before the file
+ *          grows over it.*/
+static int ext4_file_zero_tail(ext4_file *file, struct ext4_inode_ref *ref,
+			       uint64_t size)
+{
+	struct ext4_blockdev *bdev = file->mp->fs.bdev;
+	uint32_t block_size = ext4_sb_get_block_size(&file->mp->fs.sb);
+	uint32_t unalg = size % block_size;
+	ext4_fsblk_t fblock;
+	struct ext4_block b;
+	int r;
+
+	if (!unalg)
+		return EOK;
+
+	r = ext4_file_get_dblk(file, ref, (ext4_lblk_t)(size / block_size),
+			       &fblock);
+	if (r != EOK || !fblock)
+		return r;
+
+	r = ext4_block_get(bdev, &b, fblock);
+	if (r != EOK)
+		return r;
+
+	memset(b.data + unalg, 0, block_size - unalg);
+	ext4_bcache_tag_dirty(bdev->bc, b.buf);
+	ext4_bcache_set_dirty(b.buf);
+	return ext4_block_set(bdev, &b);
+}
+
+/**@brief   Allocate and zero the holes of a range of file blocks. Block
+ *          maps can't tell blocks that aren't written yet, hence they
+ *          are written with zeros.*/
+static int ext4_file_fill_holes(ext4_file *file, struct ext4_inode_ref *ref,
+				ext4_lblk_t first, ext4_lblk_t last)
+{
+	struct ext4_blockdev *bdev = file->mp->fs.bdev;
+	uint32_t block_size = ext4_sb_get_block_size(&file->mp->fs.sb);
+	ext4_fsblk_t fblock;
+	struct ext4_block b;
+	ext4_lblk_t iblock;
+	bool fresh;
+	int r;
+
+	for (iblock = first; iblock <= last; iblock++) {
+		r = ext4_file_init_dblk(file, ref, iblock, last - iblock + 1,
+					&fblock, &fresh);
+		if (r != EOK)
+			return r;
+
+		if (!fresh)
+			continue;
+
+		r = ext4_block_get_noread(bdev, &b, fblock);
+		if (r != EOK)
+			return r;
+
+		memset(b.data, 0, block_size);
+		ext4_bcache_tag_dirty(bdev->bc, b.buf);
+		ext4_bcache_set_dirty(b.buf);
+		r = ext4_block_set(bdev, &b);
+		if (r != EOK)
+			return r;
+	}
+	return EOK;
+}
+
 int ext4_fopen(ext4_file *file, const char *path, const char *flags)
 {
 	struct ext4_mountpoint *mp = ext4_get_mount(path);
@@ -1551,6 +2102,7 @@ int ext4_fopen(ext4_file *file, const char *path, const char *flags)
 
 	ext4_block_cache_write_back(mp->fs.bdev, 1);
 	r = ext4_generic_open(file, path, flags, true, 0, 0);
+	ext4_file_cache_inode(file, r);
 	ext4_block_cache_write_back(mp->fs.bdev, 0);
 
 	EXT4_MP_UNLOCK(mp);
@@ -1582,6 +2134,7 @@ int ext4_fopen2(ext4_file *file, const char *path, int flags)
 		else
 			ext4_trans_abort(mp);
 	}
+	ext4_file_cache_inode(file, r);
 
 	ext4_block_cache_write_back(mp->fs.bdev, 0);
 	EXT4_MP_UNLOCK(mp);
@@ -1591,14 +2144,42 @@ int ext4_fopen2(ext4_file *file, const char *path, int flags)
 
 int ext4_fclose(ext4_file *file)
 {
+	int r = EOK;
+	struct ext4_mountpoint *mp;
+
 	ext4_assert(file && file->mp);
 
+	mp = file->mp;
+	if (file->ci) {
+		EXT4_MP_LOCK(mp);
+		/*The last reference has to write back what's waiting for
+		 * a commit, lazy timestamps may wait further*/
+		bool lazy = file->ci->lazy &&
+			    mp->icache.unref_cnt < CONFIG_ICACHE_LAZY_COUNT;
+		bool last = file->ci->refctr == 1;
+		if (last && (file->ci->pa_len || (file->ci->dirty && !lazy))) {
+			ext4_block_cache_write_back(mp->fs.bdev, 1);
+			ext4_trans_start(mp);
+			r = ext4_balloc_discard_prealloc(&mp->fs, file->ci);
+			if (r == EOK && file->ci->dirty && !lazy)
+				r = ext4_icache_writeback(mp);
+			if (r != EOK)
+				ext4_trans_abort(mp);
+			else
+				r = ext4_trans_stop(mp);
+			ext4_block_cache_write_back(mp->fs.bdev, 0);
+		}
+		ext4_icache_put(&mp->icache, file->ci);
+		EXT4_MP_UNLOCK(mp);
+	}
+
+	file->ci = NULL;
 	file->mp = 0;
 	file->flags = 0;
 	file->inode = 0;
 	file->fpos = file->fsize = 0;
 
-	return EOK;
+	return r;
 }
 
 static int ext4_ftruncate_no_lock(ext4_file *file, uint64_t size)
@@ -1615,8 +2196,16 @@ static int ext4_ftruncate_no_lock(ext4_file *file, uint64_t size)
 
 	/*Sync file size*/
 	file->fsize = ext4_inode_get_size(&file->mp->fs.sb, ref.inode);
-	if (file->fsize <= size) {
-		r = EOK;
+
+	/*Growth only changes the size, the range appended is a hole*/
+	if (file->fsize < size) {
+		r = ext4_file_zero_tail(file, &ref, file->fsize);
+		if (r != EOK)
+			goto Finish;
+
+		ext4_inode_set_size(ref.inode, size);
+		ref.dirty = true;
+		file->fsize = size;
 		goto Finish;
 	}
 
@@ -1656,16 +2245,96 @@ int ext4_ftruncate(ext4_file *f, uint64_t size)
 	if (f->flags & O_RDONLY)
 		return EPERM;
 
-	EXT4_MP_LOCK(f->mp);
+	EXT4_MP_LOCK(f->mp);
+	ext4_bcache_set_dirty_owner(&f->mp->bc, f->inode, false);
+
+	ext4_trans_start(f->mp);
+	r = ext4_ftruncate_no_lock(f, size);
+	if (r != EOK)
+		ext4_trans_abort(f->mp);
+	else
+		ext4_trans_stop(f->mp);
+
+	EXT4_MP_UNLOCK(f->mp);
+	return r;
+}
+
+int ext4_fallocate(ext4_file *file, uint64_t offset, uint64_t len,
+		   bool keep_size)
+{
+	struct ext4_inode_ref ref;
+	int r;
+
+	ext4_assert(file && file->mp);
+
+	if (file->mp->fs.read_only)
+		return EROFS;
+
+	if ((file->flags & O_ACCMODE) == O_RDONLY)
+		return EBADF;
+
+	if (!len)
+		return EINVAL;
+
+	EXT4_MP_LOCK(file->mp);
+	ext4_bcache_set_dirty_owner(&file->mp->bc, file->inode, false);
+	ext4_trans_start(file->mp);
+
+	struct ext4_sblock *const sb = &file->mp->fs.sb;
+	uint32_t block_size = ext4_sb_get_block_size(sb);
+	uint64_t first = offset / block_size;
+	uint64_t last = (offset + len - 1) / block_size;
+
+	r = ext4_file_get_inode_ref(file, &ref);
+	if (r != EOK) {
+		ext4_trans_abort(file->mp);
+		EXT4_MP_UNLOCK(file->mp);
+		return r;
+	}
+
+	if (last >= EXT_MAX_BLOCKS) {
+		r = EFBIG;
+		goto Finish;
+	}
+
+#if CONFIG_EXTENT_ENABLE && CONFIG_EXTENTS_ENABLE
+	if ((ext4_sb_feature_incom(sb, EXT4_FINCOM_EXTENTS)) &&
+	    (ext4_inode_has_flag(ref.inode, EXT4_INODE_FLAG_EXTENTS)))
+		r = ext4_extent_alloc_unwritten(&ref, (ext4_lblk_t)first,
+						(uint32_t)(last - first + 1));
+	else
+#endif
+		/*Blocks past the end of file would outlive it*/
+		r = keep_size ? ENOTSUP
+			      : ext4_file_fill_holes(file, &ref,
+						     (ext4_lblk_t)first,
+						     (ext4_lblk_t)last);
+	if (r != EOK)
+		goto Finish;
+
+	file->fsize = ext4_inode_get_size(sb, ref.inode);
+	if (!keep_size && offset + len > file->fsize) {
+		r = ext4_file_zero_tail(file, &ref, file->fsize);
+		if (r != EOK)
+			goto Finish;
+
+		file->fsize = offset + len;
+		ext4_inode_set_size(ref.inode, file->fsize);
+		ref.dirty = true;
+	}
+
+Finish:
+	if (r == EOK)
+		r = ext4_file_put_inode_ref(file, &ref);
+	else
+		ext4_file_put_inode_ref(file, &ref);
 
-	ext4_trans_start(f->mp);
-	r = ext4_ftruncate_no_lock(f, size);
 	if (r != EOK)
-		ext4_trans_abort(f->mp);
+		ext4_trans_abort(file->mp);
 	else
-		ext4_trans_stop(f->mp);
+		ext4_trans_stop(file->mp);
 
-	EXT4_MP_UNLOCK(f->mp);
+	EXT4_MP_UNLOCK(file->mp);
 	return r;
 }
 
@@ -1680,6 +2349,13 @@ int ext4_fread(ext4_file *file, void *buf, size_t size, size_t *rcnt)
 	ext4_fsblk_t fblock_start;
 	uint32_t fblock_count;
 
+	struct ext4_io_segment segs[CONFIG_FREAD_SEGMENTS_COUNT];
+	/*Segments in filesystem blocks, segs are translated to device blocks*/
+	struct ext4_io_segment fs_segs[CONFIG_FREAD_SEGMENTS_COUNT];
+	uint32_t seg_cnt;
+	uint32_t i;
+	size_t pending;
+
 	uint8_t *u8_buf = buf;
 	int r;
 	struct ext4_inode_ref ref;
@@ -1700,7 +2376,7 @@ int ext4_fread(ext4_file *file, void *buf, size_t size, size_t *rcnt)
 	if (rcnt)
 		*rcnt = 0;
 
-	r = ext4_fs_get_inode_ref(fs, file->inode, &ref);
+	r = ext4_file_get_inode_ref(file, &ref);
 	if (r != EOK) {
 		EXT4_MP_UNLOCK(file->mp);
 		return r;
@@ -1743,14 +2419,14 @@ int ext4_fread(ext4_file *file, void *buf, size_t size, size_t *rcnt)
 		if (size > (block_size - unalg))
 			len = block_size - unalg;
 
-		r = ext4_fs_get_inode_dblk_idx(&ref, iblock_idx, &fblock, true);
+		r = ext4_file_get_dblk(file, &ref, iblock_idx, &fblock);
 		if (r != EOK)
 			goto Finish;
 
 		/* Do we get an unwritten range? */
 		if (fblock != 0) {
-			uint64_t off = fblock * block_size + unalg;
-			r = ext4_block_readbytes(file->mp->fs.bdev, off, u8_buf, len);
+			r = ext4_file_read_part(file, fblock, unalg, u8_buf,
+						len);
 			if (r != EOK)
 				goto Finish;
 
@@ -1769,52 +2445,81 @@ int ext4_fread(ext4_file *file, void *buf, size_t size, size_t *rcnt)
 		iblock_idx++;
 	}
 
-	fblock_start = 0;
-	fblock_count = 0;
+	seg_cnt = 0;
+	pending = 0;
 	while (size >= block_size) {
+		/*Gather a run of contiguous blocks, or of holes*/
+		r = ext4_file_get_dblk(file, &ref, iblock_idx, &fblock_start);
+		if (r != EOK)
+			goto Finish;
+
+		iblock_idx++;
+		fblock_count = 1;
 		while (iblock_idx < iblock_last) {
-			r = ext4_fs_get_inode_dblk_idx(&ref, iblock_idx,
-						       &fblock, true);
+			r = ext4_file_get_dblk(file, &ref, iblock_idx,
+					       &fblock);
 			if (r != EOK)
 				goto Finish;
 
-			iblock_idx++;
-
-			if (!fblock_start)
-				fblock_start = fblock;
-
-			if ((fblock_start + fblock_count) != fblock)
+			if (fblock_start ? fblock != fblock_start + fblock_count
+					 : fblock != 0)
 				break;
 
+			iblock_idx++;
 			fblock_count++;
 		}
 
-		r = ext4_blocks_get_direct(file->mp->fs.bdev, u8_buf, fblock_start,
-					   fblock_count);
-		if (r != EOK)
-			goto Finish;
+		if (fblock_start) {
+			segs[seg_cnt].blk_id = fblock_start;
+			segs[seg_cnt].blk_cnt = fblock_count;
+			segs[seg_cnt].buf = u8_buf;
+			fs_segs[seg_cnt] = segs[seg_cnt];
+			seg_cnt++;
+		} else {
+			memset(u8_buf, 0, block_size * fblock_count);
+		}
 
 		size -= block_size * fblock_count;
 		u8_buf += block_size * fblock_count;
-		file->fpos += block_size * fblock_count;
+		pending += block_size * fblock_count;
 
-		if (rcnt)
-			*rcnt += block_size * fblock_count;
+		/*Submit gathered runs in one vectored request*/
+		if (seg_cnt == CONFIG_FREAD_SEGMENTS_COUNT || size < block_size) {
+			if (seg_cnt)
+				r = ext4_blocks_get_direct_vec(
+				    file->mp->fs.bdev, segs, seg_cnt);
+			if (r != EOK)
+				goto Finish;
 
-		fblock_start = fblock;
-		fblock_count = 1;
+			/*Partial writes may be waiting in the cache*/
+			for (i = 0; i < seg_cnt; i++)
+				ext4_bcache_copy_dirty(file->mp->fs.bdev->bc,
+						       fs_segs[i].blk_id,
+						       fs_segs[i].blk_cnt,
+						       fs_segs[i].buf);
+
+			file->fpos += pending;
+
+			if (rcnt)
+				*rcnt += pending;
+
+			seg_cnt = 0;
+			pending = 0;
+		}
 	}
 
 	if (size) {
-		uint64_t off;
-		r = ext4_fs_get_inode_dblk_idx(&ref, iblock_idx, &fblock, true);
+		r = ext4_file_get_dblk(file, &ref, iblock_idx, &fblock);
 		if (r != EOK)
 			goto Finish;
 
-		off = fblock * block_size;
-		r = ext4_block_readbytes(file->mp->fs.bdev, off, u8_buf, size);
-		if (r != EOK)
-			goto Finish;
+		if (fblock) {
+			r = ext4_file_read_part(file, fblock, 0, u8_buf, size);
+			if (r != EOK)
+				goto Finish;
+		} else {
+			memset(u8_buf, 0, size);
+		}
 
 		file->fpos += size;
 
@@ -1823,11 +2528,109 @@ int ext4_fread(ext4_file *file, void *buf, size_t size, size_t *rcnt)
 	}
 
 Finish:
-	ext4_fs_put_inode_ref(&ref);
+	ext4_file_put_inode_ref(file, &ref);
+	EXT4_MP_UNLOCK(file->mp);
+	return r;
+}
+
+int ext4_fpin(ext4_file *file, uint64_t off, ext4_pin *pin, const void **data,
+	      size_t *len)
+{
+	struct ext4_inode_ref ref;
+	struct ext4_block b;
+	ext4_fsblk_t fblock;
+	uint32_t block_size;
+	uint32_t unalg;
+	int r;
+
+	ext4_assert(file && file->mp && pin && data && len);
+
+	pin->mp = file->mp;
+	pin->buf = NULL;
+	*data = NULL;
+	*len = 0;
+
+	if (file->flags & O_WRONLY)
+		return EPERM;
+
+	EXT4_MP_LOCK(file->mp);
+
+	struct ext4_sblock *const sb = &file->mp->fs.sb;
+	struct ext4_bcache *const bc = &file->mp->bc;
+
+	r = ext4_file_get_inode_ref(file, &ref);
+	if (r != EOK) {
+		EXT4_MP_UNLOCK(file->mp);
+		return r;
+	}
+
+	/*Data of the other file types may be stored in the inode itself*/
+	if (!ext4_inode_is_type(sb, ref.inode, EXT4_INODE_MODE_FILE)) {
+		r = EINVAL;
+		goto Finish;
+	}
+
+	/*Sync file size*/
+	file->fsize = ext4_inode_get_size(sb, ref.inode);
+	if (off >= file->fsize)
+		goto Finish;
+
+	block_size = ext4_sb_get_block_size(sb);
+	unalg = off % block_size;
+
+	r = ext4_file_get_dblk(file, &ref, (ext4_lblk_t)(off / block_size),
+			       &fblock);
+	if (r != EOK)
+		goto Finish;
+
+	/*Pinned blocks can't be evicted, the other half of the cache is
+	 * left to metadata*/
+	if (fblock && bc->pin_cnt >= bc->cnt / 2) {
+		r = ENOBUFS;
+		goto Finish;
+	}
+
+	if (fblock) {
+		r = ext4_block_get(file->mp->fs.bdev, &b, fblock);
+		if (r != EOK)
+			goto Finish;
+
+		bc->pin_cnt++;
+		pin->buf = b.buf;
+		*data = b.data + unalg;
+	}
+
+	*len = block_size - unalg;
+	if (*len > file->fsize - off)
+		*len = (size_t)(file->fsize - off);
+
+Finish:
+	ext4_file_put_inode_ref(file, &ref);
 	EXT4_MP_UNLOCK(file->mp);
 	return r;
 }
 
+void ext4_funpin(ext4_pin *pin)
+{
+	struct ext4_block b;
+
+	ext4_assert(pin);
+
+	if (!pin->buf)
+		return;
+
+	b.lb_id = pin->buf->lba;
+	b.buf = pin->buf;
+	b.data = pin->buf->data;
+
+	EXT4_MP_LOCK(pin->mp);
+	pin->mp->bc.pin_cnt--;
+	ext4_block_set(pin->mp->fs.bdev, &b);
+	EXT4_MP_UNLOCK(pin->mp);
+
+	pin->buf = NULL;
+}
+
 int ext4_fwrite(ext4_file *file, const void *buf, size_t size, size_t *wcnt)
 {
 	uint32_t unalg;
@@ -1840,6 +2643,10 @@ int ext4_fwrite(ext4_file *file, const void *buf, size_t size, size_t *wcnt)
 	ext4_fsblk_t fblk;
 	ext4_fsblk_t fblock_start;
 
+	uint32_t app_count;
+	ext4_fsblk_t app_fblk = 0;
+	bool fresh;
+
 	struct ext4_inode_ref ref;
 	const uint8_t *u8_buf = buf;
 	int r, rr = EOK;
@@ -1856,6 +2663,7 @@ int ext4_fwrite(ext4_file *file, const void *buf, size_t size, size_t *wcnt)
 		return EOK;
 
 	EXT4_MP_LOCK(file->mp);
+	ext4_bcache_set_dirty_owner(&file->mp->bc, file->inode, false);
 	ext4_trans_start(file->mp);
 
 	struct ext4_fs *const fs = &file->mp->fs;
@@ -1864,7 +2672,7 @@ int ext4_fwrite(ext4_file *file, const void *buf, size_t size, size_t *wcnt)
 	if (wcnt)
 		*wcnt = 0;
 
-	r = ext4_fs_get_inode_ref(fs, file->inode, &ref);
+	r = ext4_file_get_inode_ref(file, &ref);
 	if (r != EOK) {
 		ext4_trans_abort(file->mp);
 		EXT4_MP_UNLOCK(file->mp);
@@ -1887,12 +2695,11 @@ int ext4_fwrite(ext4_file *file, const void *buf, size_t size, size_t *wcnt)
 		if (size > (block_size - unalg))
 			len = block_size - unalg;
 
-		r = ext4_fs_init_inode_dblk_idx(&ref, iblk_idx, &fblk);
+		r = ext4_file_init_dblk(file, &ref, iblk_idx, 1, &fblk, &fresh);
 		if (r != EOK)
 			goto Finish;
 
-		off = fblk * block_size + unalg;
-		r = ext4_block_writebytes(file->mp->fs.bdev, off, u8_buf, len);
+		r = ext4_file_write_part(file, fblk, fresh, unalg, u8_buf, len);
 		if (r != EOK)
 			goto Finish;
 
@@ -1913,23 +2720,35 @@ int ext4_fwrite(ext4_file *file, const void *buf, size_t size, size_t *wcnt)
 
 	fblock_start = 0;
 	fblock_count = 0;
+	app_count = 0;
 	while (size >= block_size) {
 
 		while (iblk_idx < iblock_last) {
 			if (iblk_idx < ifile_blocks) {
-				r = ext4_fs_init_inode_dblk_idx(&ref, iblk_idx,
-								&fblk);
+				uint32_t last = iblock_last < ifile_blocks
+						    ? iblock_last
+						    : ifile_blocks;
+				r = ext4_file_init_dblk(file, &ref, iblk_idx,
+							last - iblk_idx, &fblk,
+							NULL);
 				if (r != EOK)
 					goto Finish;
 			} else {
-				rr = ext4_fs_append_inode_dblk(&ref, &fblk,
-							       &iblk_idx);
-				if (rr != EOK) {
-					/* Unable to append more blocks. But
-					 * some block might be allocated already
-					 * */
-					break;
+				/*Blocks up to the last one written are
+				 * appended in runs*/
+				if (!app_count) {
+					rr = ext4_fs_append_inode_dblks(
+					    &ref, iblock_last - iblk_idx,
+					    &app_fblk, &iblk_idx, &app_count);
+					if (rr != EOK) {
+						/* Unable to append more blocks.
+						 * But some block might be
+						 * allocated already */
+						break;
+					}
 				}
+				fblk = app_fblk++;
+				app_count--;
 			}
 
 			iblk_idx++;
@@ -1944,6 +2763,8 @@ int ext4_fwrite(ext4_file *file, const void *buf, size_t size, size_t *wcnt)
 			fblock_count++;
 		}
 
+		ext4_bcache_invalidate_lba(file->mp->fs.bdev->bc,
+					   fblock_start, fblock_count);
 		r = ext4_blocks_set_direct(file->mp->fs.bdev, u8_buf, fblock_start,
 					   fblock_count);
 		if (r != EOK)
@@ -1975,9 +2796,10 @@ int ext4_fwrite(ext4_file *file, const void *buf, size_t size, size_t *wcnt)
 		goto Finish;
 
 	if (size) {
-		uint64_t off;
+		fresh = false;
 		if (iblk_idx < ifile_blocks) {
-			r = ext4_fs_init_inode_dblk_idx(&ref, iblk_idx, &fblk);
+			r = ext4_file_init_dblk(file, &ref, iblk_idx, 1, &fblk,
+						&fresh);
 			if (r != EOK)
 				goto Finish;
 		} else {
@@ -1987,8 +2809,7 @@ int ext4_fwrite(ext4_file *file, const void *buf, size_t size, size_t *wcnt)
 				goto out_fsize;
 		}
 
-		off = fblk * block_size;
-		r = ext4_block_writebytes(file->mp->fs.bdev, off, u8_buf, size);
+		r = ext4_file_write_part(file, fblk, fresh, 0, u8_buf, size);
 		if (r != EOK)
 			goto Finish;
 
@@ -2006,7 +2827,7 @@ out_fsize:
 	}
 
 Finish:
-	r = ext4_fs_put_inode_ref(&ref);
+	r = ext4_file_put_inode_ref(file, &ref);
 
 	if (r != EOK)
 		ext4_trans_abort(file->mp);
@@ -2017,8 +2838,22 @@ Finish:
 	return r;
 }
 
+/**@brief   Sync file size with the in-memory inode, it's shared with the
+ *          files that might have changed it.*/
+static void ext4_file_sync_size(ext4_file *file)
+{
+	if (!file->ci)
+		return;
+
+	EXT4_MP_LOCK(file->mp);
+	file->fsize = ext4_inode_get_size(&file->mp->fs.sb, &file->ci->inode);
+	EXT4_MP_UNLOCK(file->mp);
+}
+
 int ext4_fseek(ext4_file *file, int64_t offset, uint32_t origin)
 {
+	ext4_file_sync_size(file);
+
 	switch (origin) {
 	case SEEK_SET:
 		if (offset < 0 || (uint64_t)offset > file->fsize)
@@ -2051,6 +2886,7 @@ uint64_t ext4_ftell(ext4_file *file)
 
 uint64_t ext4_fsize(ext4_file *file)
 {
+	ext4_file_sync_size(file);
 	return file->fsize;
 }
 
@@ -2128,6 +2964,33 @@ int ext4_raw_inode_fill(const char *path, uint32_t *ret_ino,
 	return r;
 }
 
+int ext4_file_inode_fill(ext4_file *file, struct ext4_inode *inode)
+{
+	int r;
+	struct ext4_inode_ref inode_ref;
+
+	ext4_assert(file && file->mp && inode);
+
+	EXT4_MP_LOCK(file->mp);
+	if (file->ci) {
+		memcpy(inode, &file->ci->inode, sizeof(struct ext4_inode));
+		EXT4_MP_UNLOCK(file->mp);
+		return EOK;
+	}
+
+	r = ext4_fs_get_inode_ref(&file->mp->fs, file->inode, &inode_ref);
+	if (r != EOK) {
+		EXT4_MP_UNLOCK(file->mp);
+		return r;
+	}
+
+	memcpy(inode, inode_ref.inode, sizeof(struct ext4_inode));
+	ext4_fs_put_inode_ref(&inode_ref);
+	EXT4_MP_UNLOCK(file->mp);
+
+	return r;
+}
+
 int ext4_inode_exist(const char *path, int type)
 {
 	int r;
@@ -2266,6 +3129,61 @@ int ext4_owner_get(const char *path, uint32_t *uid, uint32_t *gid)
 	return r;
 }
 
+static void ext4_inode_touch(struct ext4_inode *inode, uint32_t atime,
+			     uint32_t mtime)
+{
+	if (atime)
+		ext4_inode_set_access_time(inode, atime);
+	if (mtime) {
+		ext4_inode_set_modif_time(inode, mtime);
+		ext4_inode_set_change_inode_time(inode, mtime);
+	}
+}
+
+int ext4_ftimes_set(ext4_file *file, uint32_t atime, uint32_t mtime,
+		    bool lazy)
+{
+	struct ext4_inode_ref inode_ref;
+	struct ext4_mountpoint *mp;
+	int r;
+
+	ext4_assert(file && file->mp);
+	mp = file->mp;
+
+	if (mp->fs.read_only)
+		return EROFS;
+
+	EXT4_MP_LOCK(mp);
+	if (lazy && file->ci) {
+		ext4_inode_touch(&file->ci->inode, atime, mtime);
+		ext4_icache_set_dirty(&mp->icache, file->ci, true);
+		EXT4_MP_UNLOCK(mp);
+		return EOK;
+	}
+
+	ext4_bcache_set_dirty_owner(&mp->bc, file->inode, true);
+	ext4_block_cache_write_back(mp->fs.bdev, 1);
+	ext4_trans_start(mp);
+
+	/*Inode is looked up by number, pending changes of the in-memory
+	 * inode are written along*/
+	r = ext4_fs_get_inode_ref(&mp->fs, file->inode, &inode_ref);
+	if (r == EOK) {
+		ext4_inode_touch(inode_ref.inode, atime, mtime);
+		inode_ref.dirty = true;
+		r = ext4_fs_put_inode_ref(&inode_ref);
+	}
+
+	if (r != EOK)
+		ext4_trans_abort(mp);
+	else
+		r = ext4_trans_stop(mp);
+
+	ext4_block_cache_write_back(mp->fs.bdev, 0);
+	EXT4_MP_UNLOCK(mp);
+	return r;
+}
+
 int ext4_atime_set(const char *path, uint32_t atime)
 {
 	struct ext4_inode_ref inode_ref;
@@ -2284,6 +3202,7 @@ int ext4_atime_set(const char *path, uint32_t atime)
 	if (r != EOK)
 		goto Finish;
 
+	ext4_bcache_set_dirty_owner(&mp->bc, inode_ref.index, true);
 	ext4_inode_set_access_time(inode_ref.inode, atime);
 	inode_ref.dirty = true;
 	r = ext4_trans_put_inode_ref(mp, &inode_ref);
@@ -2312,6 +3231,7 @@ int ext4_mtime_set(const char *path, uint32_t mtime)
 	if (r != EOK)
 		goto Finish;
 
+	ext4_bcache_set_dirty_owner(&mp->bc, inode_ref.index, true);
 	ext4_inode_set_modif_time(inode_ref.inode, mtime);
 	inode_ref.dirty = true;
 	r = ext4_trans_put_inode_ref(mp, &inode_ref);
@@ -2340,6 +3260,7 @@ int ext4_ctime_set(const char *path, uint32_t ctime)
 	if (r != EOK)
 		goto Finish;
 
+	ext4_bcache_set_dirty_owner(&mp->bc, inode_ref.index, true);
 	ext4_inode_set_change_inode_time(inode_ref.inode, ctime);
 	inode_ref.dirty = true;
 	r = ext4_trans_put_inode_ref(mp, &inode_ref);
@@ -3177,58 +4098,166 @@ int ext4_dir_close(ext4_dir *dir)
     return ext4_fclose(&dir->f);
 }
 
-const ext4_direntry *ext4_dir_entry_next(ext4_dir *dir)
+/**@brief   Copy the entry the iterator points to into the directory handle.*/
+static void ext4_dir_entry_fill(ext4_dir *dir, struct ext4_dir_iter *it)
 {
-#define EXT4_DIR_ENTRY_OFFSET_TERM (uint64_t)(-1)
+	struct ext4_sblock *sb = &dir->f.mp->fs.sb;
+	uint16_t name_length = ext4_dir_en_get_name_len(sb, it->curr);
+
+	memset(&dir->de.name, 0, sizeof(dir->de.name));
+	memcpy(&dir->de.name, it->curr->name, name_length);
+
+	/* Directly copying the content isn't safe for Big-endian targets*/
+	dir->de.inode = ext4_dir_en_get_inode(it->curr);
+	dir->de.entry_length = ext4_dir_en_get_entry_len(it->curr);
+	dir->de.name_length = name_length;
+	dir->de.inode_type = ext4_dir_en_get_inode_type(sb, it->curr);
+}
 
+const ext4_direntry *ext4_dir_entry_next(ext4_dir *dir)
+{
 	int r;
-	uint16_t name_length;
 	ext4_direntry *de = 0;
 	struct ext4_inode_ref dir_inode;
 	struct ext4_dir_iter it;
 
 	EXT4_MP_LOCK(dir->f.mp);
 
-	if (dir->next_off == EXT4_DIR_ENTRY_OFFSET_TERM) {
-		EXT4_MP_UNLOCK(dir->f.mp);
-		return 0;
+	r = ext4_fs_get_inode_ref(&dir->f.mp->fs, dir->f.inode, &dir_inode);
+	if (r != EOK) {
+		goto Finish;
 	}
 
-	r = ext4_fs_get_inode_ref(&dir->f.mp->fs, dir->f.inode, &dir_inode);
+	r = ext4_dir_iterator_init(&it, &dir_inode, dir->next_off);
 	if (r != EOK) {
+		ext4_fs_put_inode_ref(&dir_inode);
 		goto Finish;
 	}
 
+	/*Entry a seek stopped at may be removed since*/
+	while (r == EOK && it.curr && !ext4_dir_en_get_inode(it.curr))
+		r = ext4_dir_iterator_next(&it);
+
+	if (r == EOK && it.curr) {
+		ext4_dir_entry_fill(dir, &it);
+		de = &dir->de;
+		ext4_dir_iterator_next(&it);
+	}
+
+	/*Past the last entry, the offset is the directory size*/
+	dir->next_off = it.curr_off;
+
+	ext4_dir_iterator_fini(&it);
+	ext4_fs_put_inode_ref(&dir_inode);
+
+Finish:
+	EXT4_MP_UNLOCK(dir->f.mp);
+	return de;
+}
+
+int ext4_dir_entry_next_batch(ext4_dir *dir, ext4_dir_entry_cb cb, void *arg,
+			      size_t count, bool inodes, size_t *rcount)
+{
+	int r = EOK;
+	size_t n = 0;
+	struct ext4_fs *fs = &dir->f.mp->fs;
+	struct ext4_inode_ref dir_inode;
+	struct ext4_inode_ref child;
+	struct ext4_dir_iter it;
+
+	ext4_assert(cb);
+
+	EXT4_MP_LOCK(dir->f.mp);
+
+	if (!count)
+		goto Finish;
+
+	r = ext4_fs_get_inode_ref(fs, dir->f.inode, &dir_inode);
+	if (r != EOK)
+		goto Finish;
+
 	r = ext4_dir_iterator_init(&it, &dir_inode, dir->next_off);
 	if (r != EOK) {
 		ext4_fs_put_inode_ref(&dir_inode);
 		goto Finish;
 	}
 
-	memset(&dir->de.name, 0, sizeof(dir->de.name));
-	name_length = ext4_dir_en_get_name_len(&dir->f.mp->fs.sb,
-					       it.curr);
-	memcpy(&dir->de.name, it.curr->name, name_length);
+	while (it.curr && n < count) {
+		/*Entry the last call stopped at may be removed since*/
+		if (!ext4_dir_en_get_inode(it.curr)) {
+			r = ext4_dir_iterator_next(&it);
+			if (r != EOK)
+				break;
+			continue;
+		}
 
-	/* Directly copying the content isn't safe for Big-endian targets*/
-	dir->de.inode = ext4_dir_en_get_inode(it.curr);
-	dir->de.entry_length = ext4_dir_en_get_entry_len(it.curr);
-	dir->de.name_length = name_length;
-	dir->de.inode_type = ext4_dir_en_get_inode_type(&dir->f.mp->fs.sb,
-						      it.curr);
+		ext4_dir_entry_fill(dir, &it);
+
+		/*Entry isn't consumed unless its inode is read*/
+		if (inodes) {
+			r = ext4_fs_get_inode_ref(fs, dir->de.inode, &child);
+			if (r != EOK)
+				break;
+		}
 
-	de = &dir->de;
+		r = ext4_dir_iterator_next(&it);
+		cb(arg, n++, &dir->de, it.curr_off, inodes ? child.inode : NULL);
+		if (inodes)
+			ext4_fs_put_inode_ref(&child);
+		if (r != EOK)
+			break;
+	}
+
+	dir->next_off = it.curr_off;
+
+	ext4_dir_iterator_fini(&it);
+	ext4_fs_put_inode_ref(&dir_inode);
+
+Finish:
+	EXT4_MP_UNLOCK(dir->f.mp);
+	if (rcount)
+		*rcount = n;
+	return n ? EOK : r;
+}
+
+uint64_t ext4_dir_entry_tell(ext4_dir *dir)
+{
+	return dir->next_off;
+}
+
+int ext4_dir_entry_seek(ext4_dir *dir, uint64_t off)
+{
+	int r;
+	uint32_t block_size;
+	struct ext4_inode_ref dir_inode;
+	struct ext4_dir_iter it;
+
+	if (off % 4)
+		return EINVAL;
+
+	EXT4_MP_LOCK(dir->f.mp);
+
+	r = ext4_fs_get_inode_ref(&dir->f.mp->fs, dir->f.inode, &dir_inode);
+	if (r != EOK)
+		goto Finish;
 
-	ext4_dir_iterator_next(&it);
+	/*Entries are walked from the start of the block holding the offset,
+	 *an entry removed since the offset was taken is merged into the
+	 *previous one, the next entry is taken instead*/
+	block_size = ext4_sb_get_block_size(&dir->f.mp->fs.sb);
+	r = ext4_dir_iterator_init(&it, &dir_inode, off - off % block_size);
+	while (r == EOK && it.curr && it.curr_off < off)
+		r = ext4_dir_iterator_next(&it);
 
-	dir->next_off = it.curr ? it.curr_off : EXT4_DIR_ENTRY_OFFSET_TERM;
+	if (r == EOK)
+		dir->next_off = it.curr_off;
 
 	ext4_dir_iterator_fini(&it);
 	ext4_fs_put_inode_ref(&dir_inode);
 
 Finish:
 	EXT4_MP_UNLOCK(dir->f.mp);
-	return de;
+	return r;
 }
 
 void ext4_dir_entry_rewind(ext4_dir *dir)
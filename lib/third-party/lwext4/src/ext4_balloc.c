@@ -230,13 +230,14 @@ int ext4_balloc_free_block(struct ext4_inode_ref *inode_ref, ext4_fsblk_t baddr)
 	return rc;
 }
 
-int ext4_balloc_free_blocks(struct ext4_inode_ref *inode_ref,
-			    ext4_fsblk_t first, uint32_t count)
+/**@brief   Release a run of blocks in the bitmaps, the blocks count of
+ *          the owner isn't changed.*/
+static int ext4_balloc_free_run(struct ext4_fs *fs, ext4_fsblk_t first,
+				uint32_t count)
 {
 	int rc = EOK;
 	uint32_t blk_cnt = count;
 	ext4_fsblk_t start_block = first;
-	struct ext4_fs *fs = inode_ref->fs;
 	struct ext4_sblock *sb = &fs->sb;
 
 	/* Compute indexes */
@@ -305,20 +306,11 @@ int ext4_balloc_free_blocks(struct ext4_inode_ref *inode_ref,
 			return rc;
 		}
 
-		uint32_t block_size = ext4_sb_get_block_size(sb);
-
 		/* Update superblock free blocks count */
 		uint64_t sb_free_blocks = ext4_sb_get_free_blocks_cnt(sb);
 		sb_free_blocks += free_cnt;
 		ext4_sb_set_free_blocks_cnt(sb, sb_free_blocks);
 
-		/* Update inode blocks count */
-		uint64_t ino_blocks;
-		ino_blocks = ext4_inode_get_blocks_count(sb, inode_ref->inode);
-		ino_blocks -= free_cnt * (block_size / EXT4_INODE_BLOCK_SIZE);
-		ext4_inode_set_blocks_count(sb, inode_ref->inode, ino_blocks);
-		inode_ref->dirty = true;
-
 		/* Update block group free blocks count */
 		uint32_t free_blocks;
 		free_blocks = ext4_bg_get_free_blocks_count(bg, sb);
@@ -349,9 +341,34 @@ int ext4_balloc_free_blocks(struct ext4_inode_ref *inode_ref,
 	return rc;
 }
 
-int ext4_balloc_alloc_block(struct ext4_inode_ref *inode_ref,
-			    ext4_fsblk_t goal,
-			    ext4_fsblk_t *fblock)
+/**@brief   Add blocks to the blocks count of an inode, negative to
+ *          remove them.*/
+static void ext4_balloc_add_inode_blocks(struct ext4_inode_ref *inode_ref,
+					 int64_t count)
+{
+	struct ext4_sblock *sb = &inode_ref->fs->sb;
+	uint32_t block_size = ext4_sb_get_block_size(sb);
+
+	uint64_t ino_blocks = ext4_inode_get_blocks_count(sb, inode_ref->inode);
+	ino_blocks += count * (block_size / EXT4_INODE_BLOCK_SIZE);
+	ext4_inode_set_blocks_count(sb, inode_ref->inode, ino_blocks);
+	inode_ref->dirty = true;
+}
+
+int ext4_balloc_free_blocks(struct ext4_inode_ref *inode_ref,
+			    ext4_fsblk_t first, uint32_t count)
+{
+	int rc = ext4_balloc_free_run(inode_ref->fs, first, count);
+	if (rc != EOK)
+		return rc;
+
+	ext4_balloc_add_inode_blocks(inode_ref, -(int64_t)count);
+	return EOK;
+}
+
+static int ext4_balloc_alloc_one(struct ext4_inode_ref *inode_ref,
+				 ext4_fsblk_t goal,
+				 ext4_fsblk_t *fblock)
 {
 	ext4_fsblk_t alloc = 0;
 	ext4_fsblk_t bmp_blk_adr;
@@ -582,6 +599,243 @@ success:
 	return r;
 }
 
+int ext4_balloc_alloc_block(struct ext4_inode_ref *inode_ref,
+			    ext4_fsblk_t goal,
+			    ext4_fsblk_t *fblock)
+{
+	int r = ext4_balloc_alloc_one(inode_ref, goal, fblock);
+	if (r != ENOSPC)
+		return r;
+
+	/*Space might be held by the preallocation windows*/
+	r = ext4_balloc_discard_all_prealloc(inode_ref->fs);
+	if (r != EOK)
+		return r;
+
+	return ext4_balloc_alloc_one(inode_ref, goal, fblock);
+}
+
+/**@brief   Length of the run of free bits starting at a free bit, limited
+ *          to the wanted length.*/
+static uint32_t ext4_balloc_run_len(uint8_t *bmap, uint32_t bit,
+				    uint32_t ebit, uint32_t want)
+{
+	uint32_t len = 1;
+
+	while (len < want && bit + len < ebit &&
+	       ext4_bmap_is_bit_clr(bmap, bit + len))
+		len++;
+	return len;
+}
+
+/**@brief   Find the longest run of free bits in a bitmap range, stops at
+ *          the first one of the wanted length.
+ * @return  length of the run, 0 if there is no free bit*/
+static uint32_t ext4_balloc_find_run(uint8_t *bmap, uint32_t sbit,
+				     uint32_t ebit, uint32_t want,
+				     uint32_t *first)
+{
+	uint32_t best = 0, bit = sbit, idx, len;
+
+	while (bit < ebit && ext4_bmap_bit_find_clr(bmap, bit, ebit, &idx) == EOK) {
+		len = ext4_balloc_run_len(bmap, idx, ebit, want);
+
+		if (len > best) {
+			best = len;
+			*first = idx;
+			if (len == want)
+				break;
+		}
+		bit = idx + len;
+	}
+	return best;
+}
+
+/**@brief   Allocate a run of up to count contiguous blocks, starting at the
+ *          goal if it's free or else the longest run of the first group
+ *          with free blocks, groups are searched from the goal group on.
+ *          The blocks count of the owner isn't changed.*/
+static int ext4_balloc_alloc_run(struct ext4_fs *fs, ext4_fsblk_t goal,
+				 uint32_t count, ext4_fsblk_t *baddr,
+				 uint32_t *allocated)
+{
+	struct ext4_sblock *sb = &fs->sb;
+	struct ext4_block_group_ref bg_ref;
+	struct ext4_block b;
+	uint32_t bg_cnt = ext4_block_group_cnt(sb);
+	uint32_t bgid = ext4_balloc_get_bgid_of_block(sb, goal);
+	uint32_t goal_idx = ext4_fs_addr_to_idx_bg(sb, goal);
+	uint32_t i, idx = 0, len = 0;
+	int r;
+
+	/*The goal group is searched from the goal first, from its start at
+	 * the end*/
+	for (i = 0; i <= bg_cnt; i++, bgid = (bgid + 1) % bg_cnt) {
+		r = ext4_fs_get_block_group_ref(fs, bgid, &bg_ref);
+		if (r != EOK)
+			return r;
+
+		struct ext4_bgroup *bg = bg_ref.block_group;
+		if (!ext4_bg_get_free_blocks_count(bg, sb)) {
+			r = ext4_fs_put_block_group_ref(&bg_ref);
+			if (r != EOK)
+				return r;
+			continue;
+		}
+
+		ext4_fsblk_t first_in_bg = ext4_balloc_get_block_of_bgid(sb, bgid);
+		uint32_t sidx = ext4_fs_addr_to_idx_bg(sb, first_in_bg);
+		uint32_t eidx = ext4_blocks_in_group_cnt(sb, bgid);
+		if (!i && goal_idx > sidx)
+			sidx = goal_idx;
+
+		ext4_fsblk_t bmp_blk_adr = ext4_bg_get_block_bitmap(bg, sb);
+		r = ext4_trans_block_get(fs->bdev, &b, bmp_blk_adr);
+		if (r != EOK) {
+			ext4_fs_put_block_group_ref(&bg_ref);
+			return r;
+		}
+
+		if (!ext4_balloc_verify_bitmap_csum(sb, bg, b.data)) {
+			ext4_dbg(DEBUG_BALLOC,
+				DBG_WARN "Bitmap checksum failed."
+				"Group: %" PRIu32"\n",
+				bg_ref.index);
+		}
+
+		/*A run continuing the goal is kept even if it's shorter*/
+		if (!i && sidx < eidx && ext4_bmap_is_bit_clr(b.data, sidx)) {
+			idx = sidx;
+			len = ext4_balloc_run_len(b.data, idx, eidx, count);
+		} else
+			len = ext4_balloc_find_run(b.data, sidx, eidx, count,
+						   &idx);
+
+		if (len) {
+			uint32_t j;
+			for (j = 0; j < len; j++)
+				ext4_bmap_bit_set(b.data, idx + j);
+
+			ext4_balloc_set_bitmap_csum(sb, bg, b.data);
+			ext4_trans_set_block_dirty(b.buf);
+		}
+
+		r = ext4_block_set(fs->bdev, &b);
+		if (r != EOK) {
+			ext4_fs_put_block_group_ref(&bg_ref);
+			return r;
+		}
+
+		if (len) {
+			/* Update superblock free blocks count */
+			uint64_t sb_free_blocks = ext4_sb_get_free_blocks_cnt(sb);
+			ext4_sb_set_free_blocks_cnt(sb, sb_free_blocks - len);
+
+			/* Update block group free blocks count */
+			uint32_t fb_cnt = ext4_bg_get_free_blocks_count(bg, sb);
+			ext4_bg_set_free_blocks_count(bg, sb, fb_cnt - len);
+			bg_ref.dirty = true;
+		}
+
+		r = ext4_fs_put_block_group_ref(&bg_ref);
+		if (r != EOK)
+			return r;
+
+		if (len) {
+			*baddr = ext4_fs_bg_idx_to_addr(sb, idx, bgid);
+			*allocated = len;
+			return EOK;
+		}
+	}
+
+	return ENOSPC;
+}
+
+int ext4_balloc_alloc_blocks(struct ext4_inode_ref *inode_ref,
+			     ext4_lblk_t iblock, ext4_fsblk_t goal,
+			     uint32_t count, uint32_t room,
+			     ext4_fsblk_t *baddr, uint32_t *allocated)
+{
+	struct ext4_fs *fs = inode_ref->fs;
+	struct ext4_cinode *ci = ext4_icache_find(fs->icache, inode_ref->index);
+	uint32_t want = count, got;
+	int r;
+
+	ext4_assert(count);
+
+	if (ci && ci->pa_len) {
+		if (ci->pa_lblk == iblock) {
+			got = ci->pa_len < count ? ci->pa_len : count;
+			*baddr = ci->pa_pblk;
+			ci->pa_lblk += got;
+			ci->pa_pblk += got;
+			ci->pa_len -= got;
+			goto success;
+		}
+
+		/*Not an append continuing the window*/
+		r = ext4_balloc_discard_prealloc(fs, ci);
+		if (r != EOK)
+			return r;
+	}
+
+	if (ci && want < CONFIG_PREALLOC_BLOCKS && room > want)
+		want = room < CONFIG_PREALLOC_BLOCKS ? room : CONFIG_PREALLOC_BLOCKS;
+
+	r = ext4_balloc_alloc_run(fs, goal, want, baddr, &got);
+	if (r == ENOSPC) {
+		/*Space might be held by the windows of other inodes*/
+		r = ext4_balloc_discard_all_prealloc(fs);
+		if (r != EOK)
+			return r;
+
+		r = ext4_balloc_alloc_run(fs, goal, count, baddr, &got);
+	}
+	if (r != EOK)
+		return r;
+
+	if (got > count) {
+		ci->pa_lblk = iblock + count;
+		ci->pa_pblk = *baddr + count;
+		ci->pa_len = got - count;
+		got = count;
+	}
+
+success:
+	ext4_balloc_add_inode_blocks(inode_ref, got);
+	*allocated = got;
+	return EOK;
+}
+
+int ext4_balloc_discard_prealloc(struct ext4_fs *fs, struct ext4_cinode *ci)
+{
+	int r;
+
+	if (!ci->pa_len)
+		return EOK;
+
+	r = ext4_balloc_free_run(fs, ci->pa_pblk, ci->pa_len);
+	if (r != EOK)
+		return r;
+
+	ci->pa_len = 0;
+	return EOK;
+}
+
+int ext4_balloc_discard_all_prealloc(struct ext4_fs *fs)
+{
+	struct ext4_cinode *ci;
+	int r;
+
+	for (ci = ext4_icache_next(fs->icache, NULL); ci;
+	     ci = ext4_icache_next(fs->icache, ci)) {
+		r = ext4_balloc_discard_prealloc(fs, ci);
+		if (r != EOK)
+			return r;
+	}
+	return EOK;
+}
+
 int ext4_balloc_try_alloc_block(struct ext4_inode_ref *inode_ref,
 				ext4_fsblk_t baddr, bool *free)
 {
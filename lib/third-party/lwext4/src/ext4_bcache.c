@@ -66,10 +66,129 @@ RB_GENERATE_INTERNAL(ext4_buf_lba, ext4_buf, lba_node,
 		     ext4_bcache_lba_compare, static inline)
 RB_GENERATE_INTERNAL(ext4_buf_lru, ext4_buf, lru_node,
 		     ext4_bcache_lru_compare, static inline)
+RB_GENERATE_INTERNAL(ext4_buf_a1, ext4_buf, lru_node,
+		     ext4_bcache_lru_compare, static inline)
+
+/*Marks a ghost ring entry which was taken back to the cache*/
+#define EXT4_BCACHE_GHOST_NONE UINT64_MAX
+
+static void ext4_bcache_lru_insert(struct ext4_bcache *bc,
+				   struct ext4_buf *buf)
+{
+	if (buf->queue == EXT4_BCACHE_QUEUE_A1IN)
+		RB_INSERT(ext4_buf_a1, &bc->a1_root, buf);
+	else
+		RB_INSERT(ext4_buf_lru, &bc->lru_root, buf);
+}
+
+static void ext4_bcache_lru_remove(struct ext4_bcache *bc,
+				   struct ext4_buf *buf)
+{
+	if (buf->queue == EXT4_BCACHE_QUEUE_A1IN)
+		RB_REMOVE(ext4_buf_a1, &bc->a1_root, buf);
+	else
+		RB_REMOVE(ext4_buf_lru, &bc->lru_root, buf);
+}
+
+static void ext4_bcache_ghost_record(struct ext4_bcache *bc, uint64_t lba)
+{
+	bc->ghost[bc->ghost_pos] = lba;
+	bc->ghost_pos = (bc->ghost_pos + 1) % bc->ghost_size;
+	if (bc->ghost_len < bc->ghost_size)
+		bc->ghost_len++;
+}
+
+/**@brief   Check whether the block was recently evicted from A1in and
+ *          forget it if so. The ring is small compared to the cost of a
+ *          block read, so it is searched linearly.*/
+static bool ext4_bcache_ghost_take(struct ext4_bcache *bc, uint64_t lba)
+{
+	uint32_t i;
+	for (i = 0; i < bc->ghost_len; i++) {
+		if (bc->ghost[i] == lba) {
+			bc->ghost[i] = EXT4_BCACHE_GHOST_NONE;
+			return true;
+		}
+	}
+	return false;
+}
+
+static inline uint32_t ext4_bcache_hash(struct ext4_bcache *bc, uint64_t lba)
+{
+	/*Fibonacci hashing spreads sequential LBAs over all buckets*/
+	return (uint32_t)((lba * 0x9E3779B97F4A7C15ULL) >> 32) & bc->hash_mask;
+}
+
+static void ext4_bcache_hash_insert(struct ext4_bcache *bc,
+				    struct ext4_buf *buf)
+{
+	struct ext4_buf **bucket;
+	if (!bc->hash)
+		return;
+
+	bucket = &bc->hash[ext4_bcache_hash(bc, buf->lba)];
+	buf->hash_next = *bucket;
+	*bucket = buf;
+}
+
+static void ext4_bcache_hash_remove(struct ext4_bcache *bc,
+				    struct ext4_buf *buf)
+{
+	struct ext4_buf **it;
+	if (!bc->hash)
+		return;
+
+	for (it = &bc->hash[ext4_bcache_hash(bc, buf->lba)]; *it;
+	     it = &(*it)->hash_next) {
+		if (*it == buf) {
+			*it = buf->hash_next;
+			buf->hash_next = NULL;
+			return;
+		}
+	}
+}
+
+/**@brief   Allocate all the buffers of the cache in one go. Payloads are
+ *          placed first, aligned to CONFIG_BCACHE_POOL_ALIGN, and followed
+ *          by descriptors.*/
+static int ext4_bcache_pool_init(struct ext4_bcache *bc)
+{
+	uint32_t i;
+	uintptr_t data;
+	size_t data_size, size;
+
+	bc->pool_cnt = bc->cnt + CONFIG_BCACHE_POOL_RESERVE;
+	data_size = (size_t)bc->pool_cnt * bc->itemsize;
+	size = data_size + CONFIG_BCACHE_POOL_ALIGN +
+	       (size_t)bc->pool_cnt * sizeof(struct ext4_buf);
+
+	bc->pool_mem = ext4_pool_malloc(size);
+	if (!bc->pool_mem)
+		return ENOMEM;
+
+	data = ((uintptr_t)bc->pool_mem + CONFIG_BCACHE_POOL_ALIGN - 1) &
+	       ~(uintptr_t)(CONFIG_BCACHE_POOL_ALIGN - 1);
+	bc->pool_data = (uint8_t *)data;
+	bc->pool_bufs = (struct ext4_buf *)(bc->pool_data + data_size);
+
+	for (i = bc->pool_cnt; i > 0; i--) {
+		bc->pool_bufs[i - 1].hash_next = bc->pool_free;
+		bc->pool_free = &bc->pool_bufs[i - 1];
+	}
+	return EOK;
+}
+
+static bool ext4_bcache_in_pool(struct ext4_bcache *bc, struct ext4_buf *buf)
+{
+	return bc->pool_bufs && buf >= bc->pool_bufs &&
+	       buf < bc->pool_bufs + bc->pool_cnt;
+}
 
 int ext4_bcache_init_dynamic(struct ext4_bcache *bc, uint32_t cnt,
 			     uint32_t itemsize)
 {
+	int r;
+	uint32_t buckets = 1;
 	ext4_assert(bc && cnt && itemsize);
 
 	memset(bc, 0, sizeof(struct ext4_bcache));
@@ -79,6 +198,23 @@ int ext4_bcache_init_dynamic(struct ext4_bcache *bc, uint32_t cnt,
 	bc->ref_blocks = 0;
 	bc->max_ref_blocks = 0;
 
+	r = ext4_bcache_pool_init(bc);
+	if (r != EOK)
+		return r;
+
+	if (cnt >= CONFIG_BCACHE_HASH_THRESHOLD) {
+		while (buckets < cnt)
+			buckets <<= 1;
+
+		bc->hash = ext4_calloc(buckets, sizeof(struct ext4_buf *));
+		if (!bc->hash) {
+			ext4_pool_free(bc->pool_mem);
+			return ENOMEM;
+		}
+
+		bc->hash_mask = buckets - 1;
+	}
+
 	return EOK;
 }
 
@@ -91,8 +227,36 @@ void ext4_bcache_cleanup(struct ext4_bcache *bc)
 	}
 }
 
+int ext4_bcache_set_policy(struct ext4_bcache *bc,
+			   enum ext4_bcache_policy policy)
+{
+	ext4_assert(bc && RB_EMPTY(&bc->lba_root));
+
+	ext4_free(bc->ghost);
+	bc->ghost = NULL;
+	bc->ghost_size = 0;
+	bc->ghost_len = 0;
+	bc->ghost_pos = 0;
+	bc->policy = EXT4_BCACHE_POLICY_LRU;
+
+	if (policy == EXT4_BCACHE_POLICY_2Q) {
+		bc->ghost_size = bc->cnt / 2 ? bc->cnt / 2 : 1;
+		bc->ghost = ext4_malloc(bc->ghost_size * sizeof(uint64_t));
+		if (!bc->ghost) {
+			bc->ghost_size = 0;
+			return ENOMEM;
+		}
+	}
+
+	bc->policy = policy;
+	return EOK;
+}
+
 int ext4_bcache_fini_dynamic(struct ext4_bcache *bc)
 {
+	ext4_free(bc->hash);
+	ext4_free(bc->ghost);
+	ext4_pool_free(bc->pool_mem);
 	memset(bc, 0, sizeof(struct ext4_bcache));
 	return EOK;
 }
@@ -102,10 +266,16 @@ int ext4_bcache_fini_dynamic(struct ext4_bcache *bc)
  *  This is ext4_bcache, the module handling basic buffer-cache stuff.
  *
  *  Buffers in a bcache are sorted by their LBA and stored in a
- *  RB-Tree(lba_root).
+ *  RB-Tree(lba_root). Large caches additionally index buffers in a hash
+ *  table, which serves point lookups, while the tree is kept for ordered
+ *  traversals (range invalidation, cleanup).
  *
  *  Bcache also maintains another RB-Tree(lru_root) right now, where
- *  buffers are sorted by their LRU id.
+ *  buffers are sorted by their LRU id. With the 2Q replacement policy,
+ *  buffers referenced only once live in a separate FIFO (a1_root, also
+ *  ordered by LRU id, which isn't refreshed on hits). They move to
+ *  lru_root only if they are requested again shortly after being
+ *  evicted, which is tracked by a ring of evicted LBAs (ghost).
  *
  *  A singly-linked list is used to track those dirty buffers which are
  *  ready to be flushed. (Those buffers which are dirty but also referenced
@@ -120,7 +290,19 @@ static struct ext4_buf *
 ext4_buf_alloc(struct ext4_bcache *bc, uint64_t lba)
 {
 	void *data;
-	struct ext4_buf *buf;
+	struct ext4_buf *buf = bc->pool_free;
+	if (buf) {
+		bc->pool_free = buf->hash_next;
+		memset(buf, 0, sizeof(struct ext4_buf));
+		buf->lba = lba;
+		buf->data = bc->pool_data +
+			    (size_t)(buf - bc->pool_bufs) * bc->itemsize;
+		buf->bc = bc;
+		return buf;
+	}
+
+	/*Every pool buffer is referenced, fall back to heap*/
+	bc->pool_overflow_cnt++;
 	data = ext4_malloc(bc->itemsize);
 	if (!data)
 		return NULL;
@@ -139,6 +321,13 @@ ext4_buf_alloc(struct ext4_bcache *bc, uint64_t lba)
 
 static void ext4_buf_free(struct ext4_buf *buf)
 {
+	struct ext4_bcache *bc = buf->bc;
+	if (ext4_bcache_in_pool(bc, buf)) {
+		buf->hash_next = bc->pool_free;
+		bc->pool_free = buf;
+		return;
+	}
+
 	ext4_free(buf->data);
 	ext4_free(buf);
 }
@@ -146,18 +335,56 @@ static void ext4_buf_free(struct ext4_buf *buf)
 static struct ext4_buf *
 ext4_buf_lookup(struct ext4_bcache *bc, uint64_t lba)
 {
+	struct ext4_buf *buf;
 	struct ext4_buf tmp = {
 		.lba = lba
 	};
 
+	if (bc->hash) {
+		buf = bc->hash[ext4_bcache_hash(bc, lba)];
+		while (buf && buf->lba != lba)
+			buf = buf->hash_next;
+
+		return buf;
+	}
+
 	return RB_FIND(ext4_buf_lba, &bc->lba_root, &tmp);
 }
 
+struct ext4_buf *ext4_bcache_find(struct ext4_bcache *bc, uint64_t lba)
+{
+	return ext4_buf_lookup(bc, lba);
+}
+
 struct ext4_buf *ext4_buf_lowest_lru(struct ext4_bcache *bc)
 {
 	return RB_MIN(ext4_buf_lru, &bc->lru_root);
 }
 
+struct ext4_buf *ext4_bcache_victim(struct ext4_bcache *bc)
+{
+	uint32_t a1_max = bc->cnt / 4 ? bc->cnt / 4 : 1;
+	struct ext4_buf *a1 = RB_MIN(ext4_buf_a1, &bc->a1_root);
+
+	/*A1in gets a quarter of the cache, the rest belongs to Am*/
+	if (a1 && (bc->a1_cnt > a1_max || RB_EMPTY(&bc->lru_root)))
+		return a1;
+
+	if (!RB_EMPTY(&bc->lru_root))
+		return RB_MIN(ext4_buf_lru, &bc->lru_root);
+
+	return a1;
+}
+
+void ext4_bcache_evict_buf(struct ext4_bcache *bc, struct ext4_buf *buf)
+{
+	if (buf->queue == EXT4_BCACHE_QUEUE_A1IN)
+		ext4_bcache_ghost_record(bc, buf->lba);
+
+	ext4_bcache_drop_buf(bc, buf);
+	bc->evict_cnt++;
+}
+
 void ext4_bcache_drop_buf(struct ext4_bcache *bc, struct ext4_buf *buf)
 {
 	/* Warn on dropping any referenced buffers.*/
@@ -166,9 +393,13 @@ void ext4_bcache_drop_buf(struct ext4_bcache *bc, struct ext4_buf *buf)
 				"lba: %" PRIu64 ", refctr: %" PRIu32 "\n",
 				buf->lba, buf->refctr);
 	} else
-		RB_REMOVE(ext4_buf_lru, &bc->lru_root, buf);
+		ext4_bcache_lru_remove(bc, buf);
+
+	if (buf->queue == EXT4_BCACHE_QUEUE_A1IN)
+		bc->a1_cnt--;
 
 	RB_REMOVE(ext4_buf_lba, &bc->lba_root, buf);
+	ext4_bcache_hash_remove(bc, buf);
 
 	/*Forcibly drop dirty buffer.*/
 	if (ext4_bcache_test_flag(buf, BC_DIRTY))
@@ -196,12 +427,37 @@ void ext4_bcache_invalidate_lba(struct ext4_bcache *bc,
 				uint32_t cnt)
 {
 	uint64_t end = from + cnt - 1;
-	struct ext4_buf *tmp = ext4_buf_lookup(bc, from), *buf;
-	RB_FOREACH_FROM(buf, ext4_buf_lba, tmp) {
-		if (buf->lba > end)
-			break;
+	struct ext4_buf tmp = {
+		.lba = from
+	};
+	struct ext4_buf *buf;
 
+	/*The range starts at the first cached buffer, which isn't
+	 * necessarily the one of the first block*/
+	for (buf = RB_NFIND(ext4_buf_lba, &bc->lba_root, &tmp);
+	     buf && buf->lba <= end;
+	     buf = RB_NEXT(ext4_buf_lba, &bc->lba_root, buf))
 		ext4_bcache_invalidate_buf(bc, buf);
+}
+
+void ext4_bcache_copy_dirty(struct ext4_bcache *bc, uint64_t from,
+			    uint32_t cnt, void *dst)
+{
+	uint64_t end = from + cnt - 1;
+	struct ext4_buf tmp = {
+		.lba = from
+	};
+	struct ext4_buf *buf;
+
+	for (buf = RB_NFIND(ext4_buf_lba, &bc->lba_root, &tmp);
+	     buf && buf->lba <= end;
+	     buf = RB_NEXT(ext4_buf_lba, &bc->lba_root, buf)) {
+		if (!ext4_bcache_test_flag(buf, BC_DIRTY) ||
+		    !ext4_bcache_test_flag(buf, BC_UPTODATE))
+			continue;
+
+		memcpy((uint8_t *)dst + (buf->lba - from) * bc->itemsize,
+		       buf->data, bc->itemsize);
 	}
 }
 
@@ -214,9 +470,10 @@ ext4_bcache_find_get(struct ext4_bcache *bc, struct ext4_block *b,
 		/* If buffer is not referenced. */
 		if (!buf->refctr) {
 			/* Assign new value to LRU id and increment LRU counter
-			 * by 1*/
-			buf->lru_id = ++bc->lru_ctr;
-			RB_REMOVE(ext4_buf_lru, &bc->lru_root, buf);
+			 * by 1. A1in is a FIFO, keep its order.*/
+			ext4_bcache_lru_remove(bc, buf);
+			if (buf->queue != EXT4_BCACHE_QUEUE_A1IN)
+				buf->lru_id = ++bc->lru_ctr;
 			if (ext4_bcache_test_flag(buf, BC_DIRTY))
 				ext4_bcache_remove_dirty_node(bc, buf);
 
@@ -237,16 +494,27 @@ int ext4_bcache_alloc(struct ext4_bcache *bc, struct ext4_block *b,
 	/* Try to search the buffer with exaxt LBA. */
 	struct ext4_buf *buf = ext4_bcache_find_get(bc, b, b->lb_id);
 	if (buf) {
+		bc->hit_cnt++;
 		*is_new = false;
 		return EOK;
 	}
 
+	bc->miss_cnt++;
+
 	/* We need to allocate one buffer.*/
 	buf = ext4_buf_alloc(bc, b->lb_id);
 	if (!buf)
 		return ENOMEM;
 
+	/* Blocks seen for the first time (or long ago) start in A1in. */
+	if (bc->policy == EXT4_BCACHE_POLICY_2Q &&
+	    !ext4_bcache_ghost_take(bc, b->lb_id)) {
+		buf->queue = EXT4_BCACHE_QUEUE_A1IN;
+		bc->a1_cnt++;
+	}
+
 	RB_INSERT(ext4_buf_lba, &bc->lba_root, buf);
+	ext4_bcache_hash_insert(bc, buf);
 	/* One more buffer in bcache now. :-) */
 	bc->ref_blocks++;
 
@@ -287,7 +555,7 @@ int ext4_bcache_free(struct ext4_bcache *bc, struct ext4_block *b)
 
 	/* We are the last one touching this buffer, do the cleanups. */
 	if (!buf->refctr) {
-		RB_INSERT(ext4_buf_lru, &bc->lru_root, buf);
+		ext4_bcache_lru_insert(bc, buf);
 		/* This buffer is ready to be flushed. */
 		if (ext4_bcache_test_flag(buf, BC_DIRTY) &&
 		    ext4_bcache_test_flag(buf, BC_UPTODATE)) {
@@ -161,6 +161,7 @@ int ext4_block_flush_buf(struct ext4_blockdev *bdev, struct ext4_buf *buf)
 
 		ext4_bcache_remove_dirty_node(bc, buf);
 		ext4_bcache_clear_flag(buf, BC_DIRTY);
+		buf->dirty_ino = 0;
 		if (buf->end_write) {
 			bc->dont_shake = true;
 			buf->end_write(bc, buf, r, buf->end_write_arg);
@@ -192,11 +193,9 @@ int ext4_block_cache_shake(struct ext4_blockdev *bdev)
 
 	bdev->bc->dont_shake = true;
 
-	while (!RB_EMPTY(&bdev->bc->lru_root) &&
-		ext4_bcache_is_full(bdev->bc)) {
+	while (ext4_bcache_is_full(bdev->bc) &&
+		(buf = ext4_bcache_victim(bdev->bc))) {
 
-		buf = ext4_buf_lowest_lru(bdev->bc);
-		ext4_assert(buf);
 		if (ext4_bcache_test_flag(buf, BC_DIRTY)) {
 			r = ext4_block_flush_buf(bdev, buf);
 			if (r != EOK)
@@ -204,7 +203,7 @@ int ext4_block_cache_shake(struct ext4_blockdev *bdev)
 
 		}
 
-		ext4_bcache_drop_buf(bdev->bc, buf);
+		ext4_bcache_evict_buf(bdev->bc, buf);
 	}
 	bdev->bc->dont_shake = false;
 	return r;
@@ -226,10 +225,13 @@ int ext4_block_get_noread(struct ext4_blockdev *bdev, struct ext4_block *b,
 
 	b->lb_id = lba;
 
-	/*If cache is full we have to (flush and) drop it anyway :(*/
-	r = ext4_block_cache_shake(bdev);
-	if (r != EOK)
-		return r;
+	/*If cache is full we have to (flush and) drop it anyway :(
+	 *There's no need to make room for a block which is already cached.*/
+	if (!ext4_bcache_find(bdev->bc, lba)) {
+		r = ext4_block_cache_shake(bdev);
+		if (r != EOK)
+			return r;
+	}
 
 	r = ext4_bcache_alloc(bdev->bc, b, &is_new);
 	if (r != EOK)
@@ -292,6 +294,36 @@ int ext4_blocks_get_direct(struct ext4_blockdev *bdev, void *buf, uint64_t lba,
 	return ext4_bdif_bread(bdev, buf, pba, pb_cnt * cnt);
 }
 
+int ext4_blocks_get_direct_vec(struct ext4_blockdev *bdev,
+			       struct ext4_io_segment *segs, uint32_t seg_cnt)
+{
+	uint32_t pb_cnt;
+	uint32_t i;
+	int r = EOK;
+
+	ext4_assert(bdev && segs);
+
+	pb_cnt = bdev->lg_bsize / bdev->bdif->ph_bsize;
+	for (i = 0; i < seg_cnt; i++) {
+		segs[i].blk_id = (segs[i].blk_id * bdev->lg_bsize +
+				  bdev->part_offset) / bdev->bdif->ph_bsize;
+		segs[i].blk_cnt *= pb_cnt;
+	}
+
+	if (!bdev->bdif->breadv) {
+		for (i = 0; i < seg_cnt && r == EOK; i++)
+			r = ext4_bdif_bread(bdev, segs[i].buf, segs[i].blk_id,
+					    segs[i].blk_cnt);
+		return r;
+	}
+
+	ext4_bdif_lock(bdev);
+	r = bdev->bdif->breadv(bdev, segs, seg_cnt);
+	bdev->bdif->bread_ctr++;
+	ext4_bdif_unlock(bdev);
+	return r;
+}
+
 int ext4_blocks_set_direct(struct ext4_blockdev *bdev, const void *buf,
 			   uint64_t lba, uint32_t cnt)
 {
@@ -441,20 +473,73 @@ int ext4_block_readbytes(struct ext4_blockdev *bdev, uint64_t off, void *buf,
 	return r;
 }
 
-int ext4_block_cache_flush(struct ext4_blockdev *bdev)
+/**@brief   Write back dirty buffers accepted by match in a single walk of
+ *          the dirty list. Write-back callbacks may alter the list, the
+ *          walk starts over only if they changed anything but the buffer
+ *          just written.*/
+static int ext4_block_cache_flush_match(struct ext4_blockdev *bdev,
+					bool (*match)(struct ext4_buf *buf,
+						      uint32_t ino,
+						      bool datasync),
+					uint32_t ino, bool datasync)
 {
-	while (!SLIST_EMPTY(&bdev->bc->dirty_list)) {
+	struct ext4_bcache *bc = bdev->bc;
+	struct ext4_buf *buf = LIST_FIRST(&bc->dirty_list);
+	while (buf) {
+		struct ext4_buf *next = LIST_NEXT(buf, dirty_node);
+		uint32_t gen = bc->dirty_gen;
 		int r;
-		struct ext4_buf *buf = SLIST_FIRST(&bdev->bc->dirty_list);
-		ext4_assert(buf);
+		if (!match(buf, ino, datasync)) {
+			buf = next;
+			continue;
+		}
+
 		r = ext4_block_flush_buf(bdev, buf);
 		if (r != EOK)
 			return r;
 
+		if (bc->dirty_gen == gen ||
+		    (bc->dirty_gen == gen + 1 && !buf->on_dirty_list))
+			buf = next;
+		else
+			buf = LIST_FIRST(&bc->dirty_list);
 	}
 	return EOK;
 }
 
+static bool ext4_block_committed(struct ext4_buf *buf, uint32_t ino __unused,
+				 bool datasync __unused)
+{
+	/*Buffers of an uncommitted transaction are skipped, they
+	 * may reach the disk only after the journal commit*/
+	return !ext4_bcache_test_flag(buf, BC_TRANS);
+}
+
+int ext4_block_cache_flush(struct ext4_blockdev *bdev)
+{
+	return ext4_block_cache_flush_match(bdev, ext4_block_committed, 0,
+					    false);
+}
+
+static bool ext4_block_ino_depends(struct ext4_buf *buf, uint32_t ino,
+				   bool datasync)
+{
+	if (ext4_bcache_test_flag(buf, BC_TRANS))
+		return false;
+
+	if (buf->dirty_ino != ino)
+		return buf->dirty_ino == EXT4_BCACHE_INO_SHARED;
+
+	return !(datasync && buf->dirty_times_only);
+}
+
+int ext4_block_cache_flush_ino(struct ext4_blockdev *bdev, uint32_t ino,
+			       bool datasync)
+{
+	return ext4_block_cache_flush_match(bdev, ext4_block_ino_depends, ino,
+					    datasync);
+}
+
 int ext4_block_cache_write_back(struct ext4_blockdev *bdev, uint8_t on_off)
 {
 	if (on_off)
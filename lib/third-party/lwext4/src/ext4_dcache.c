@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2026 mprogramming
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup lwext4
+ * @{
+ */
+/**
+ * @file  ext4_dcache.c
+ * @brief Directory entry cache, maps (parent inode, name) to child inode.
+ */
+
+#include <ext4_config.h>
+#include <ext4_types.h>
+#include <ext4_dcache.h>
+#include <ext4_debug.h>
+#include <ext4_errno.h>
+
+#include <string.h>
+#include <stdlib.h>
+
+static int ext4_dentry_compare(struct ext4_dentry *a, struct ext4_dentry *b)
+{
+	if (a->parent != b->parent)
+		return a->parent > b->parent ? 1 : -1;
+	if (a->name_len != b->name_len)
+		return a->name_len > b->name_len ? 1 : -1;
+	return memcmp(a->name, b->name, a->name_len);
+}
+
+RB_GENERATE_INTERNAL(ext4_dentry_tree, ext4_dentry, node,
+		     ext4_dentry_compare, static inline)
+
+static bool ext4_dcache_key(struct ext4_dentry *key, uint32_t parent,
+			    const char *name, uint32_t name_len)
+{
+	if (name_len > CONFIG_DCACHE_NAME_LEN)
+		return false;
+
+	key->parent = parent;
+	key->name_len = name_len;
+	memcpy(key->name, name, name_len);
+	return true;
+}
+
+static void ext4_dcache_drop(struct ext4_dcache *dc, struct ext4_dentry *de)
+{
+	RB_REMOVE(ext4_dentry_tree, &dc->root, de);
+	de->parent = 0;
+	TAILQ_REMOVE(&dc->lru, de, lru_node);
+	TAILQ_INSERT_TAIL(&dc->lru, de, lru_node);
+}
+
+int ext4_dcache_init(struct ext4_dcache *dc, uint32_t cnt)
+{
+	ext4_assert(dc);
+
+	memset(dc, 0, sizeof(struct ext4_dcache));
+	RB_INIT(&dc->root);
+	TAILQ_INIT(&dc->lru);
+	if (!cnt)
+		return EOK;
+
+	dc->entries = ext4_calloc(cnt, sizeof(struct ext4_dentry));
+	if (!dc->entries)
+		return ENOMEM;
+
+	dc->cnt = cnt;
+	for (uint32_t i = 0; i < cnt; ++i)
+		TAILQ_INSERT_TAIL(&dc->lru, &dc->entries[i], lru_node);
+
+	return EOK;
+}
+
+void ext4_dcache_fini(struct ext4_dcache *dc)
+{
+	ext4_assert(dc);
+
+	ext4_free(dc->entries);
+	memset(dc, 0, sizeof(struct ext4_dcache));
+}
+
+struct ext4_dentry *ext4_dcache_lookup(struct ext4_dcache *dc, uint32_t parent,
+				       const char *name, uint32_t name_len)
+{
+	struct ext4_dentry key, *de;
+
+	if (!dc || !dc->cnt || !ext4_dcache_key(&key, parent, name, name_len))
+		return NULL;
+
+	de = RB_FIND(ext4_dentry_tree, &dc->root, &key);
+	if (!de) {
+		dc->miss_cnt++;
+		return NULL;
+	}
+
+	dc->hit_cnt++;
+	TAILQ_REMOVE(&dc->lru, de, lru_node);
+	TAILQ_INSERT_HEAD(&dc->lru, de, lru_node);
+	return de;
+}
+
+void ext4_dcache_insert(struct ext4_dcache *dc, uint32_t parent,
+			const char *name, uint32_t name_len, uint32_t ino,
+			uint32_t imode)
+{
+	struct ext4_dentry *de;
+
+	if (!dc || !dc->cnt)
+		return;
+
+	/*Dot entries of a directory change on rename without the name
+	 * being added or removed*/
+	if ((name_len == 1 && name[0] == '.') ||
+	    (name_len == 2 && name[0] == '.' && name[1] == '.'))
+		return;
+
+	if (name_len > CONFIG_DCACHE_NAME_LEN)
+		return;
+
+	ext4_dcache_invalidate(dc, parent, name, name_len);
+
+	/*Reuse the least recently used entry*/
+	de = TAILQ_LAST(&dc->lru, ext4_dentry_lru);
+	if (de->parent)
+		RB_REMOVE(ext4_dentry_tree, &dc->root, de);
+
+	ext4_dcache_key(de, parent, name, name_len);
+	de->ino = ino;
+	de->imode = imode;
+	RB_INSERT(ext4_dentry_tree, &dc->root, de);
+	TAILQ_REMOVE(&dc->lru, de, lru_node);
+	TAILQ_INSERT_HEAD(&dc->lru, de, lru_node);
+}
+
+void ext4_dcache_invalidate(struct ext4_dcache *dc, uint32_t parent,
+			    const char *name, uint32_t name_len)
+{
+	struct ext4_dentry key, *de;
+
+	if (!dc || !dc->cnt || !ext4_dcache_key(&key, parent, name, name_len))
+		return;
+
+	de = RB_FIND(ext4_dentry_tree, &dc->root, &key);
+	if (de)
+		ext4_dcache_drop(dc, de);
+}
+
+void ext4_dcache_invalidate_dir(struct ext4_dcache *dc, uint32_t parent)
+{
+	struct ext4_dentry key = {.parent = parent}, *de;
+
+	if (!dc || !dc->cnt)
+		return;
+
+	/*Entries of a directory are adjacent in the tree, the key with an
+	 * empty name precedes all of them*/
+	de = RB_NFIND(ext4_dentry_tree, &dc->root, &key);
+	while (de && de->parent == parent) {
+		struct ext4_dentry *next = RB_NEXT(ext4_dentry_tree,
+						   &dc->root, de);
+		ext4_dcache_drop(dc, de);
+		de = next;
+	}
+}
+
+/**
+ * @}
+ */
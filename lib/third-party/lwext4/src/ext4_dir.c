@@ -347,6 +347,9 @@ int ext4_dir_add_entry(struct ext4_inode_ref *parent, const char *name,
 	struct ext4_fs *fs = parent->fs;
 	struct ext4_sblock *sb = &parent->fs->sb;
 
+	/* Drop a negative entry of the name */
+	ext4_dcache_invalidate(fs->dcache, parent->index, name, name_len);
+
 #if CONFIG_DIR_INDEX_ENABLE
 	/* Index adding (if allowed) */
 	if ((ext4_sb_feature_com(sb, EXT4_FCOM_DIR_INDEX)) &&
@@ -409,6 +412,19 @@ int ext4_dir_add_entry(struct ext4_inode_ref *parent, const char *name,
 			return EOK;
 	}
 
+#if CONFIG_DIR_INDEX_ENABLE
+	/* Linear directory outgrowing the threshold gets an index */
+	if (ext4_sb_feature_com(sb, EXT4_FCOM_DIR_INDEX) &&
+	    total_blocks >= CONFIG_DIR_INDEX_THRESHOLD) {
+		r = ext4_dir_dx_convert(parent);
+		if (r == EOK)
+			return ext4_dir_dx_add_entry(parent, child, name,
+						     name_len);
+		if (r != ENOMEM && r != ENOTSUP)
+			return r;
+	}
+#endif
+
 	/* No free block found - needed to allocate next data block */
 
 	iblock = 0;
@@ -532,6 +548,9 @@ int ext4_dir_remove_entry(struct ext4_inode_ref *parent, const char *name,
 	if (!ext4_inode_is_type(sb, parent->inode, EXT4_INODE_MODE_DIRECTORY))
 		return ENOTDIR;
 
+	ext4_dcache_invalidate(parent->fs->dcache, parent->index, name,
+			       name_len);
+
 	/* Try to find entry */
 	struct ext4_dir_search_result result;
 	int rc = ext4_dir_find_entry(&result, parent, name, name_len);
@@ -346,6 +346,32 @@ static void ext4_dir_set_dx_csum(struct ext4_inode_ref *inode_ref,
 
 /****************************************************************************/
 
+/**@brief Fill a directory block with an empty entry, marks it dirty.
+ * @param dir   Directory i-node
+ * @param block Block to initialize
+ */
+static void ext4_dir_dx_init_leaf(struct ext4_inode_ref *dir,
+				  struct ext4_block *block)
+{
+	struct ext4_sblock *sb = &dir->fs->sb;
+	uint32_t block_size = ext4_sb_get_block_size(sb);
+	struct ext4_dir_en *be = (void *)block->data;
+
+	if (ext4_sb_feature_ro_com(sb, EXT4_FRO_COM_METADATA_CSUM)) {
+		uint16_t len = block_size - sizeof(struct ext4_dir_entry_tail);
+		ext4_dir_en_set_entry_len(be, len);
+		ext4_dir_en_set_name_len(sb, be, 0);
+		ext4_dir_en_set_inode_type(sb, be, EXT4_DE_UNKNOWN);
+		ext4_dir_init_entry_tail(EXT4_DIRENT_TAIL(be, block_size));
+		ext4_dir_set_csum(dir, be);
+	} else {
+		ext4_dir_en_set_entry_len(be, block_size);
+	}
+
+	ext4_dir_en_set_inode(be, 0);
+	ext4_trans_set_block_dirty(block->buf);
+}
+
 int ext4_dir_dx_init(struct ext4_inode_ref *dir, struct ext4_inode_ref *parent)
 {
 	/* Load block 0, where will be index root located */
@@ -430,23 +456,7 @@ int ext4_dir_dx_init(struct ext4_inode_ref *dir, struct ext4_inode_ref *parent)
 		return rc;
 	}
 
-	/* Fill the whole block with empty entry */
-	struct ext4_dir_en *be = (void *)new_block.data;
-
-	if (ext4_sb_feature_ro_com(sb, EXT4_FRO_COM_METADATA_CSUM)) {
-		uint16_t len = block_size - sizeof(struct ext4_dir_entry_tail);
-		ext4_dir_en_set_entry_len(be, len);
-		ext4_dir_en_set_name_len(sb, be, 0);
-		ext4_dir_en_set_inode_type(sb, be, EXT4_DE_UNKNOWN);
-		ext4_dir_init_entry_tail(EXT4_DIRENT_TAIL(be, block_size));
-		ext4_dir_set_csum(dir, be);
-	} else {
-		ext4_dir_en_set_entry_len(be, block_size);
-	}
-
-	ext4_dir_en_set_inode(be, 0);
-
-	ext4_trans_set_block_dirty(new_block.buf);
+	ext4_dir_dx_init_leaf(dir, &new_block);
 	rc = ext4_block_set(dir->fs->bdev, &new_block);
 	if (rc != EOK) {
 		ext4_block_set(dir->fs->bdev, &block);
@@ -1397,6 +1407,150 @@ int ext4_dir_dx_reset_parent_inode(struct ext4_inode_ref *dir,
 	return ext4_block_set(dir->fs->bdev, &block);
 }
 
+/**@brief Stand-in i-node reference of an entry moved by a conversion,
+ *        writing an entry needs the i-node number and type only.
+ * @param ref   Reference to fill
+ * @param inode I-node backing the reference
+ * @param fs    Filesystem
+ * @param index I-node number
+ * @param type  Directory entry type (EXT4_DE_*)
+ */
+static void ext4_dir_dx_entry_ref(struct ext4_inode_ref *ref,
+				  struct ext4_inode *inode, struct ext4_fs *fs,
+				  uint32_t index, uint8_t type)
+{
+	static const uint16_t modes[] = {
+		[EXT4_DE_REG_FILE] = EXT4_INODE_MODE_FILE,
+		[EXT4_DE_DIR] = EXT4_INODE_MODE_DIRECTORY,
+		[EXT4_DE_CHRDEV] = EXT4_INODE_MODE_CHARDEV,
+		[EXT4_DE_BLKDEV] = EXT4_INODE_MODE_BLOCKDEV,
+		[EXT4_DE_FIFO] = EXT4_INODE_MODE_FIFO,
+		[EXT4_DE_SOCK] = EXT4_INODE_MODE_SOCKET,
+		[EXT4_DE_SYMLINK] = EXT4_INODE_MODE_SOFTLINK,
+	};
+
+	memset(inode, 0, sizeof(struct ext4_inode));
+	if (type < sizeof(modes) / sizeof(modes[0]))
+		ext4_inode_set_mode(&fs->sb, inode, modes[type]);
+
+	memset(ref, 0, sizeof(struct ext4_inode_ref));
+	ref->fs = fs;
+	ref->index = index;
+	ref->inode = inode;
+}
+
+/* Entry copy: i-node number, type, name length and name */
+#define EXT4_DIR_DX_COPY_HDR 6
+
+int ext4_dir_dx_convert(struct ext4_inode_ref *dir)
+{
+	struct ext4_fs *fs = dir->fs;
+	struct ext4_sblock *sb = &fs->sb;
+	uint32_t block_size = ext4_sb_get_block_size(sb);
+	uint64_t dir_size = ext4_inode_get_size(sb, dir->inode);
+	uint32_t blocks = (uint32_t)(dir_size / block_size);
+	uint32_t parent = 0;
+	struct ext4_inode_ref ref;
+	struct ext4_inode inode;
+	struct ext4_dir_iter it;
+	struct ext4_block b;
+	ext4_fsblk_t fblock;
+	uint32_t iblock;
+	size_t len = 0, off;
+	uint8_t *copy;
+	int r;
+
+	/* Every entry takes more space in its block than its copy */
+	copy = ext4_malloc(dir_size);
+	if (!copy)
+		return ENOMEM;
+
+	r = ext4_dir_iterator_init(&it, dir, 0);
+	if (r != EOK)
+		goto Finish;
+
+	while (it.curr) {
+		uint32_t ino = ext4_dir_en_get_inode(it.curr);
+		uint16_t name_len = ext4_dir_en_get_name_len(sb, it.curr);
+
+		if (ino && name_len == 2 && !memcmp(it.curr->name, "..", 2)) {
+			parent = ino;
+		} else if (ino && !(name_len == 1 && it.curr->name[0] == '.')) {
+			memcpy(copy + len, &ino, sizeof(ino));
+			copy[len + 4] = ext4_dir_en_get_inode_type(sb, it.curr);
+			copy[len + 5] = (uint8_t)name_len;
+			memcpy(copy + len + EXT4_DIR_DX_COPY_HDR, it.curr->name,
+			       name_len);
+			len += EXT4_DIR_DX_COPY_HDR + name_len;
+		}
+
+		r = ext4_dir_iterator_next(&it);
+		if (r != EOK) {
+			ext4_dir_iterator_fini(&it);
+			goto Finish;
+		}
+	}
+
+	r = ext4_dir_iterator_fini(&it);
+	if (r != EOK)
+		goto Finish;
+
+	/* Nothing was changed so far, a directory without its parent entry
+	 * is left as it is */
+	if (!parent) {
+		r = ENOTSUP;
+		goto Finish;
+	}
+
+	/* Root and first leaf take the first two blocks */
+	if (blocks < EXT4_DIR_DX_INIT_BCNT) {
+		r = ext4_fs_append_inode_dblk(dir, &fblock, &iblock);
+		if (r != EOK)
+			goto Finish;
+	}
+
+	/* Remaining blocks are left empty, new leaves are appended */
+	for (iblock = EXT4_DIR_DX_INIT_BCNT; iblock < blocks; iblock++) {
+		r = ext4_fs_get_inode_dblk_idx(dir, iblock, &fblock, false);
+		if (r != EOK)
+			goto Finish;
+
+		r = ext4_trans_block_get_noread(fs->bdev, &b, fblock);
+		if (r != EOK)
+			goto Finish;
+
+		ext4_dir_dx_init_leaf(dir, &b);
+		r = ext4_block_set(fs->bdev, &b);
+		if (r != EOK)
+			goto Finish;
+	}
+
+	ext4_dir_dx_entry_ref(&ref, &inode, fs, parent, EXT4_DE_DIR);
+	r = ext4_dir_dx_init(dir, &ref);
+	if (r != EOK)
+		goto Finish;
+
+	ext4_inode_set_flag(dir->inode, EXT4_INODE_FLAG_INDEX);
+	dir->dirty = true;
+
+	for (off = 0; off < len; off += EXT4_DIR_DX_COPY_HDR + copy[off + 5]) {
+		uint32_t ino;
+
+		memcpy(&ino, copy + off, sizeof(ino));
+		ext4_dir_dx_entry_ref(&ref, &inode, fs, ino, copy[off + 4]);
+		r = ext4_dir_dx_add_entry(dir, &ref,
+					  (const char *)copy + off +
+					  EXT4_DIR_DX_COPY_HDR,
+					  copy[off + 5]);
+		if (r != EOK)
+			goto Finish;
+	}
+
+Finish:
+	ext4_free(copy);
+	return r;
+}
+
 /**
  * @}
  */
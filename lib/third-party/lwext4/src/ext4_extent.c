@@ -0,0 +1,1021 @@
+/*
+ * Copyright (c) 2026 mprogramming
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup lwext4
+ * @{
+ */
+/**
+ * @file  ext4_extent.c
+ * @brief Extent tree, maps runs of logical blocks to physical ones.
+ */
+
+#include <ext4_config.h>
+#include <ext4_types.h>
+#include <ext4_misc.h>
+#include <ext4_errno.h>
+#include <ext4_debug.h>
+
+#include <ext4_blockdev.h>
+#include <ext4_trans.h>
+#include <ext4_fs.h>
+#include <ext4_super.h>
+#include <ext4_crc32.h>
+#include <ext4_balloc.h>
+#include <ext4_extent.h>
+
+#include <string.h>
+
+#if CONFIG_EXTENT_ENABLE && CONFIG_EXTENTS_ENABLE
+
+/**@brief   Node of the extent tree on the way from the root to a leaf.*/
+struct ext4_extent_path {
+	/**@brief   Node block, lb_id is 0 for the root held by the i-node*/
+	struct ext4_block block;
+
+	/**@brief   Node header*/
+	struct ext4_extent_header *header;
+
+	/**@brief   Index followed to the next level (index nodes)*/
+	struct ext4_extent_index *index;
+
+	/**@brief   Last extent starting at or before the searched block,
+	 *          NULL if there is none (leaf)*/
+	struct ext4_extent *extent;
+};
+
+#define EXT_FIRST_EXTENT(h) ((struct ext4_extent *)((h) + 1))
+#define EXT_FIRST_INDEX(h) ((struct ext4_extent_index *)((h) + 1))
+#define EXT_LAST_EXTENT(h)                                                     \
+	(EXT_FIRST_EXTENT(h) + to_le16((h)->entries_count) - 1)
+#define EXT_LAST_INDEX(h) (EXT_FIRST_INDEX(h) + to_le16((h)->entries_count) - 1)
+
+static inline ext4_fsblk_t ext4_ext_pblock(struct ext4_extent *ex)
+{
+	return to_le32(ex->start_lo) |
+	       ((ext4_fsblk_t)to_le16(ex->start_hi) << 32);
+}
+
+static inline void ext4_ext_store_pblock(struct ext4_extent *ex,
+					 ext4_fsblk_t pb)
+{
+	ex->start_lo = to_le32((uint32_t)pb);
+	ex->start_hi = to_le16((uint16_t)(pb >> 32));
+}
+
+static inline ext4_fsblk_t ext4_idx_pblock(struct ext4_extent_index *idx)
+{
+	return to_le32(idx->leaf_lo) |
+	       ((ext4_fsblk_t)to_le16(idx->leaf_hi) << 32);
+}
+
+static inline void ext4_idx_store_pblock(struct ext4_extent_index *idx,
+					 ext4_fsblk_t pb)
+{
+	idx->leaf_lo = to_le32((uint32_t)pb);
+	idx->leaf_hi = to_le16((uint16_t)(pb >> 32));
+}
+
+static inline bool ext4_ext_is_unwritten(struct ext4_extent *ex)
+{
+	return to_le16(ex->block_count) > EXT4_EXT_INIT_MAX_LEN;
+}
+
+static inline uint32_t ext4_ext_get_len(struct ext4_extent *ex)
+{
+	uint32_t len = to_le16(ex->block_count);
+	return len > EXT4_EXT_INIT_MAX_LEN ? len - EXT4_EXT_INIT_MAX_LEN
+					   : len;
+}
+
+static inline void ext4_ext_set_len(struct ext4_extent *ex, uint32_t len,
+				    bool unwritten)
+{
+	ex->block_count =
+	    to_le16((uint16_t)(unwritten ? len + EXT4_EXT_INIT_MAX_LEN : len));
+}
+
+static inline uint16_t ext4_ext_space_root(void)
+{
+	return (sizeof(((struct ext4_inode *)0)->blocks) -
+		sizeof(struct ext4_extent_header)) /
+	       sizeof(struct ext4_extent);
+}
+
+static inline uint16_t ext4_ext_space_block(struct ext4_sblock *sb)
+{
+	return (ext4_sb_get_block_size(sb) -
+		sizeof(struct ext4_extent_header)) /
+	       sizeof(struct ext4_extent);
+}
+
+static inline struct ext4_extent_header *
+ext4_extent_root(struct ext4_inode_ref *inode_ref)
+{
+	return ext4_inode_get_extent_header(inode_ref->inode);
+}
+
+#if CONFIG_META_CSUM_ENABLE
+static struct ext4_extent_tail *
+ext4_extent_get_tail(struct ext4_extent_header *h)
+{
+	return (struct ext4_extent_tail *)(EXT_FIRST_EXTENT(h) +
+					   to_le16(h->max_entries_count));
+}
+
+static uint32_t ext4_extent_block_csum(struct ext4_inode_ref *inode_ref,
+				       struct ext4_extent_header *h)
+{
+	uint32_t csum;
+	struct ext4_sblock *sb = &inode_ref->fs->sb;
+	uint32_t ino_index = to_le32(inode_ref->index);
+	uint32_t ino_gen = to_le32(ext4_inode_get_generation(inode_ref->inode));
+
+	/* First calculate crc32 checksum against fs uuid */
+	csum = ext4_crc32c(EXT4_CRC32_INIT, sb->uuid, sizeof(sb->uuid));
+	/* Then calculate crc32 checksum against inode number
+	 * and inode generation */
+	csum = ext4_crc32c(csum, &ino_index, sizeof(ino_index));
+	csum = ext4_crc32c(csum, &ino_gen, sizeof(ino_gen));
+	/* Finally calculate crc32 checksum against the node up to the tail */
+	csum = ext4_crc32c(csum, h,
+			   (uint32_t)((char *)ext4_extent_get_tail(h) -
+				      (char *)h));
+	return csum;
+}
+
+static bool ext4_extent_verify_csum(struct ext4_inode_ref *inode_ref,
+				    struct ext4_extent_header *h)
+{
+	if (!ext4_sb_feature_ro_com(&inode_ref->fs->sb,
+				    EXT4_FRO_COM_METADATA_CSUM))
+		return true;
+
+	return ext4_extent_get_tail(h)->et_checksum ==
+	       to_le32(ext4_extent_block_csum(inode_ref, h));
+}
+
+static void ext4_extent_set_csum(struct ext4_inode_ref *inode_ref,
+				 struct ext4_extent_header *h)
+{
+	if (!ext4_sb_feature_ro_com(&inode_ref->fs->sb,
+				    EXT4_FRO_COM_METADATA_CSUM))
+		return;
+
+	ext4_extent_get_tail(h)->et_checksum =
+	    to_le32(ext4_extent_block_csum(inode_ref, h));
+}
+#else
+#define ext4_extent_verify_csum(...) true
+#define ext4_extent_set_csum(...)
+#endif
+
+/**@brief   Check a node header read from disk.*/
+static int ext4_extent_check_header(struct ext4_extent_header *h,
+				    uint16_t depth, uint16_t max)
+{
+	if (to_le16(h->magic) != EXT4_EXTENT_MAGIC)
+		return EIO;
+	if (to_le16(h->depth) != depth)
+		return EIO;
+	if (to_le16(h->max_entries_count) > max)
+		return EIO;
+	if (to_le16(h->entries_count) > to_le16(h->max_entries_count))
+		return EIO;
+	return EOK;
+}
+
+/**@brief   Read an extent tree block.*/
+static int ext4_extent_get_node(struct ext4_inode_ref *inode_ref,
+				ext4_fsblk_t pblock, uint16_t depth,
+				struct ext4_block *block)
+{
+	struct ext4_fs *fs = inode_ref->fs;
+	struct ext4_extent_header *h;
+	int r;
+
+	r = ext4_trans_block_get(fs->bdev, block, pblock);
+	if (r != EOK)
+		return r;
+
+	h = (struct ext4_extent_header *)block->data;
+	r = ext4_extent_check_header(h, depth, ext4_ext_space_block(&fs->sb));
+	if (r != EOK) {
+		ext4_dbg(DEBUG_EXTENT,
+			 DBG_WARN "Bad extent node. Inode: %" PRIu32 ", "
+			 "Block: %" PRIu64 "\n",
+			 inode_ref->index, pblock);
+		ext4_block_set(fs->bdev, block);
+		return r;
+	}
+
+	if (!ext4_extent_verify_csum(inode_ref, h)) {
+		ext4_dbg(DEBUG_EXTENT,
+			 DBG_WARN "Extent node checksum failed. "
+			 "Inode: %" PRIu32 ", Block: %" PRIu64 "\n",
+			 inode_ref->index, pblock);
+	}
+	return EOK;
+}
+
+/**@brief   Mark a node of the path modified.*/
+static int ext4_extent_node_dirty(struct ext4_inode_ref *inode_ref,
+				  struct ext4_extent_path *p)
+{
+	if (!p->block.lb_id) {
+		inode_ref->dirty = true;
+		return EOK;
+	}
+
+	ext4_extent_set_csum(inode_ref, p->header);
+	return ext4_trans_set_block_dirty(p->block.buf);
+}
+
+static void ext4_extent_put_path(struct ext4_inode_ref *inode_ref,
+				 struct ext4_extent_path *path, uint16_t depth)
+{
+	for (uint16_t i = 1; i <= depth; i++) {
+		if (path[i].block.lb_id)
+			ext4_block_set(inode_ref->fs->bdev, &path[i].block);
+	}
+}
+
+/**@brief   Walk the tree from the root to the leaf covering a logical
+ *          block.
+ * @param   inode_ref i-node
+ * @param   iblock logical block
+ * @param   path nodes on the way, released by @ref ext4_extent_put_path
+ * @param   depth tree depth
+ * @return  standard error code*/
+static int ext4_extent_find(struct ext4_inode_ref *inode_ref,
+			    ext4_lblk_t iblock, struct ext4_extent_path *path,
+			    uint16_t *depth)
+{
+	struct ext4_extent_header *h = ext4_extent_root(inode_ref);
+	uint16_t d, level;
+	int r;
+
+	if (to_le16(h->magic) != EXT4_EXTENT_MAGIC)
+		return EIO;
+
+	d = to_le16(h->depth);
+	if (d > EXT4_EXT_MAX_DEPTH)
+		return EIO;
+
+	memset(path, 0, sizeof(struct ext4_extent_path) * (d + 1));
+	for (level = 0; level < d; level++) {
+		struct ext4_extent_index *l, *m, *rr;
+
+		path[level].header = h;
+		if (!h->entries_count) {
+			r = EIO;
+			goto Fail;
+		}
+
+		/*Last index starting at or before the block, the first one
+		 * otherwise*/
+		l = EXT_FIRST_INDEX(h) + 1;
+		rr = EXT_LAST_INDEX(h);
+		while (l <= rr) {
+			m = l + (rr - l) / 2;
+			if (iblock < to_le32(m->first_block))
+				rr = m - 1;
+			else
+				l = m + 1;
+		}
+		path[level].index = l - 1;
+
+		r = ext4_extent_get_node(inode_ref,
+					 ext4_idx_pblock(path[level].index),
+					 d - level - 1, &path[level + 1].block);
+		if (r != EOK)
+			goto Fail;
+
+		h = (struct ext4_extent_header *)path[level + 1].block.data;
+	}
+
+	path[d].header = h;
+	path[d].extent = NULL;
+	if (h->entries_count &&
+	    iblock >= to_le32(EXT_FIRST_EXTENT(h)->first_block)) {
+		struct ext4_extent *l, *m, *rr;
+
+		l = EXT_FIRST_EXTENT(h) + 1;
+		rr = EXT_LAST_EXTENT(h);
+		while (l <= rr) {
+			m = l + (rr - l) / 2;
+			if (iblock < to_le32(m->first_block))
+				rr = m - 1;
+			else
+				l = m + 1;
+		}
+		path[d].extent = l - 1;
+	}
+
+	*depth = d;
+	return EOK;
+
+Fail:
+	ext4_extent_put_path(inode_ref, path, level);
+	return r;
+}
+
+/**@brief   First logical block after the found extent that is mapped,
+ *          EXT_MAX_BLOCKS if there is none.*/
+static ext4_lblk_t ext4_extent_next_allocated(struct ext4_extent_path *path,
+					      uint16_t depth)
+{
+	struct ext4_extent_header *h = path[depth].header;
+	struct ext4_extent *next;
+
+	next = path[depth].extent ? path[depth].extent + 1
+				  : EXT_FIRST_EXTENT(h);
+	if (next <= EXT_LAST_EXTENT(h))
+		return to_le32(next->first_block);
+
+	while (depth--) {
+		if (path[depth].index < EXT_LAST_INDEX(path[depth].header))
+			return to_le32((path[depth].index + 1)->first_block);
+	}
+	return EXT_MAX_BLOCKS;
+}
+
+/**@brief   Propagate the first block of a leaf to the indexes above, as
+ *          long as the node is the first one of its parent.*/
+static int ext4_extent_correct_indexes(struct ext4_inode_ref *inode_ref,
+				       struct ext4_extent_path *path,
+				       uint16_t depth)
+{
+	uint32_t first = EXT_FIRST_EXTENT(path[depth].header)->first_block;
+	int r;
+
+	while (depth--) {
+		struct ext4_extent_index *idx = path[depth].index;
+
+		if (idx->first_block == first)
+			break;
+
+		idx->first_block = first;
+		r = ext4_extent_node_dirty(inode_ref, &path[depth]);
+		if (r != EOK)
+			return r;
+
+		if (idx != EXT_FIRST_INDEX(path[depth].header))
+			break;
+	}
+	return EOK;
+}
+
+/**@brief   Allocate and initialize a new tree block.*/
+static int ext4_extent_new_node(struct ext4_inode_ref *inode_ref,
+				ext4_fsblk_t goal, uint16_t depth,
+				struct ext4_block *block)
+{
+	struct ext4_fs *fs = inode_ref->fs;
+	struct ext4_extent_header *h;
+	ext4_fsblk_t pblock;
+	int r;
+
+	if (!goal) {
+		r = ext4_fs_indirect_find_goal(inode_ref, &goal);
+		if (r != EOK)
+			return r;
+	}
+
+	r = ext4_balloc_alloc_block(inode_ref, goal, &pblock);
+	if (r != EOK)
+		return r;
+
+	r = ext4_trans_block_get_noread(fs->bdev, block, pblock);
+	if (r != EOK) {
+		ext4_balloc_free_block(inode_ref, pblock);
+		return r;
+	}
+
+	memset(block->data, 0, ext4_sb_get_block_size(&fs->sb));
+	h = (struct ext4_extent_header *)block->data;
+	h->magic = to_le16(EXT4_EXTENT_MAGIC);
+	h->depth = to_le16(depth);
+	h->max_entries_count = to_le16(ext4_ext_space_block(&fs->sb));
+	return EOK;
+}
+
+/**@brief   Move the content of the full root to a new block the root
+ *          points to, the tree grows by one level.*/
+static int ext4_extent_grow(struct ext4_inode_ref *inode_ref,
+			    struct ext4_extent_path *path)
+{
+	struct ext4_extent_header *root = path[0].header;
+	struct ext4_extent_header *h;
+	struct ext4_extent_index *idx;
+	struct ext4_block block;
+	uint16_t depth = to_le16(root->depth);
+	int r;
+
+	if (depth == EXT4_EXT_MAX_DEPTH)
+		return ENOSPC;
+
+	r = ext4_extent_new_node(inode_ref, 0, depth, &block);
+	if (r != EOK)
+		return r;
+
+	h = (struct ext4_extent_header *)block.data;
+	h->entries_count = root->entries_count;
+	memcpy(EXT_FIRST_EXTENT(h), EXT_FIRST_EXTENT(root),
+	       sizeof(struct ext4_extent) * to_le16(root->entries_count));
+	ext4_extent_set_csum(inode_ref, h);
+	ext4_trans_set_block_dirty(block.buf);
+
+	idx = EXT_FIRST_INDEX(root);
+	idx->first_block = EXT_FIRST_EXTENT(h)->first_block;
+	ext4_idx_store_pblock(idx, block.lb_id);
+	root->entries_count = to_le16(1);
+	root->depth = to_le16(depth + 1);
+	inode_ref->dirty = true;
+
+	return ext4_block_set(inode_ref->fs->bdev, &block);
+}
+
+/**@brief   Split a full node, its parent has room for one more index.
+ *          Appending past the last entry of a node starts a new one,
+ *          otherwise the upper half of the entries moves.*/
+static int ext4_extent_split(struct ext4_inode_ref *inode_ref,
+			     struct ext4_extent_path *path, uint16_t level,
+			     uint16_t depth, ext4_lblk_t iblock)
+{
+	struct ext4_extent_header *node = path[level].header;
+	struct ext4_extent_path *parent = &path[level - 1];
+	struct ext4_extent_header *h;
+	struct ext4_extent_index *idx;
+	struct ext4_block block;
+	uint16_t cnt = to_le16(node->entries_count);
+	uint16_t split;
+	uint32_t first;
+	int r;
+
+	if (level == depth)
+		split = iblock > to_le32(EXT_LAST_EXTENT(node)->first_block)
+			    ? cnt : cnt / 2;
+	else
+		split = path[level].index == EXT_LAST_INDEX(node)
+			    ? cnt - 1 : cnt / 2;
+
+	r = ext4_extent_new_node(inode_ref, path[level].block.lb_id + 1,
+				 depth - level, &block);
+	if (r != EOK)
+		return r;
+
+	h = (struct ext4_extent_header *)block.data;
+	h->entries_count = to_le16(cnt - split);
+	memcpy(EXT_FIRST_EXTENT(h), EXT_FIRST_EXTENT(node) + split,
+	       sizeof(struct ext4_extent) * (cnt - split));
+	first = split < cnt ? EXT_FIRST_EXTENT(h)->first_block
+			    : to_le32(iblock);
+	ext4_extent_set_csum(inode_ref, h);
+	ext4_trans_set_block_dirty(block.buf);
+
+	node->entries_count = to_le16(split);
+	r = ext4_extent_node_dirty(inode_ref, &path[level]);
+	if (r != EOK) {
+		ext4_block_set(inode_ref->fs->bdev, &block);
+		return r;
+	}
+
+	idx = parent->index + 1;
+	memmove(idx + 1, idx,
+		(EXT_LAST_INDEX(parent->header) - parent->index) *
+		    sizeof(struct ext4_extent_index));
+	idx->first_block = first;
+	ext4_idx_store_pblock(idx, block.lb_id);
+	parent->header->entries_count =
+	    to_le16(to_le16(parent->header->entries_count) + 1);
+
+	r = ext4_extent_node_dirty(inode_ref, parent);
+	ext4_block_set(inode_ref->fs->bdev, &block);
+	return r;
+}
+
+/**@brief   Insert a run of blocks, merged with its neighbours when they
+ *          are contiguous and of the same kind, written or unwritten.*/
+static int ext4_extent_insert(struct ext4_inode_ref *inode_ref,
+			      ext4_lblk_t iblock, ext4_fsblk_t pblock,
+			      uint32_t count, bool unwritten)
+{
+	struct ext4_extent_path path[EXT4_EXT_MAX_DEPTH + 1];
+	struct ext4_extent_header *leaf;
+	struct ext4_extent *ex, *next;
+	uint32_t max_len = unwritten ? EXT4_EXT_UNWRITTEN_MAX_LEN
+				     : EXT4_EXT_INIT_MAX_LEN;
+	uint16_t depth, level;
+	int r;
+
+	for (;;) {
+		r = ext4_extent_find(inode_ref, iblock, path, &depth);
+		if (r != EOK)
+			return r;
+
+		leaf = path[depth].header;
+		ex = path[depth].extent;
+		next = ex ? ex + 1 : EXT_FIRST_EXTENT(leaf);
+
+		/*Append to the extent before*/
+		if (ex && ext4_ext_is_unwritten(ex) == unwritten) {
+			uint32_t len = ext4_ext_get_len(ex);
+
+			if (to_le32(ex->first_block) + len == iblock &&
+			    ext4_ext_pblock(ex) + len == pblock &&
+			    len + count <= max_len) {
+				ext4_ext_set_len(ex, len + count, unwritten);
+				r = ext4_extent_node_dirty(inode_ref,
+							   &path[depth]);
+				goto Finish;
+			}
+		}
+
+		/*Prepend to the extent after*/
+		if (next <= EXT_LAST_EXTENT(leaf) &&
+		    ext4_ext_is_unwritten(next) == unwritten) {
+			uint32_t len = ext4_ext_get_len(next);
+
+			if (iblock + count == to_le32(next->first_block) &&
+			    pblock + count == ext4_ext_pblock(next) &&
+			    len + count <= max_len) {
+				next->first_block = to_le32(iblock);
+				ext4_ext_store_pblock(next, pblock);
+				ext4_ext_set_len(next, len + count, unwritten);
+				r = ext4_extent_node_dirty(inode_ref,
+							   &path[depth]);
+				if (r == EOK && next == EXT_FIRST_EXTENT(leaf))
+					r = ext4_extent_correct_indexes(
+					    inode_ref, path, depth);
+				goto Finish;
+			}
+		}
+
+		if (leaf->entries_count != leaf->max_entries_count) {
+			memmove(next + 1, next,
+				(EXT_LAST_EXTENT(leaf) + 1 - next) *
+				    sizeof(struct ext4_extent));
+			next->first_block = to_le32(iblock);
+			ext4_ext_store_pblock(next, pblock);
+			ext4_ext_set_len(next, count, unwritten);
+			leaf->entries_count =
+			    to_le16(to_le16(leaf->entries_count) + 1);
+
+			r = ext4_extent_node_dirty(inode_ref, &path[depth]);
+			if (r == EOK && next == EXT_FIRST_EXTENT(leaf))
+				r = ext4_extent_correct_indexes(inode_ref,
+								path, depth);
+			goto Finish;
+		}
+
+		/*Make room in the leaf: split the nearest node whose parent
+		 * has a free index, or grow the tree if there is none*/
+		for (level = depth; level > 0; level--) {
+			struct ext4_extent_header *h = path[level - 1].header;
+			if (h->entries_count != h->max_entries_count)
+				break;
+		}
+
+		if (level)
+			r = ext4_extent_split(inode_ref, path, level, depth,
+					      iblock);
+		else
+			r = ext4_extent_grow(inode_ref, path);
+
+		ext4_extent_put_path(inode_ref, path, depth);
+		if (r != EOK)
+			return r;
+	}
+
+Finish:
+	ext4_extent_put_path(inode_ref, path, depth);
+	return r;
+}
+
+/**@brief   Mark a range of an unwritten extent written. The rest of the
+ *          extent stays unwritten, split off before and after the range.
+ * @param   inode_ref i-node
+ * @param   iblock first logical block of the range
+ * @param   count number of blocks, all within a single unwritten extent
+ * @param   pblock physical block of iblock
+ * @return  standard error code*/
+static int ext4_extent_convert(struct ext4_inode_ref *inode_ref,
+			       ext4_lblk_t iblock, uint32_t count,
+			       ext4_fsblk_t *pblock)
+{
+	struct ext4_extent_path path[EXT4_EXT_MAX_DEPTH + 1];
+	struct ext4_extent *ex;
+	uint16_t depth;
+	int r;
+
+	r = ext4_extent_find(inode_ref, iblock, path, &depth);
+	if (r != EOK)
+		return r;
+
+	ex = path[depth].extent;
+	ext4_assert(ex && ext4_ext_is_unwritten(ex));
+
+	ext4_lblk_t first = to_le32(ex->first_block);
+	uint32_t len = ext4_ext_get_len(ex);
+	uint32_t off = iblock - first;
+	uint32_t after = len - off - count;
+	ext4_fsblk_t start = ext4_ext_pblock(ex);
+
+	*pblock = start + off;
+	if (!off && !after) {
+		ext4_ext_set_len(ex, len, false);
+		r = ext4_extent_node_dirty(inode_ref, &path[depth]);
+		ext4_extent_put_path(inode_ref, path, depth);
+		return r;
+	}
+
+	/*The written range is inserted on its own, merged with the written
+	 * extent before or after it if they are contiguous*/
+	if (!off) {
+		ex->first_block = to_le32(first + count);
+		ext4_ext_store_pblock(ex, start + count);
+		ext4_ext_set_len(ex, len - count, true);
+		r = ext4_extent_node_dirty(inode_ref, &path[depth]);
+		if (r == EOK && ex == EXT_FIRST_EXTENT(path[depth].header))
+			r = ext4_extent_correct_indexes(inode_ref, path, depth);
+	} else {
+		ext4_ext_set_len(ex, off, true);
+		r = ext4_extent_node_dirty(inode_ref, &path[depth]);
+	}
+	ext4_extent_put_path(inode_ref, path, depth);
+	if (r != EOK)
+		return r;
+
+	r = ext4_extent_insert(inode_ref, iblock, *pblock, count, false);
+	if (r == EOK && off && after)
+		r = ext4_extent_insert(inode_ref, iblock + count,
+				       *pblock + count, after, true);
+	return r;
+}
+
+void ext4_extent_tree_init(struct ext4_inode_ref *inode_ref)
+{
+	struct ext4_extent_header *h = ext4_extent_root(inode_ref);
+
+	h->magic = to_le16(EXT4_EXTENT_MAGIC);
+	h->entries_count = 0;
+	h->max_entries_count = to_le16(ext4_ext_space_root());
+	h->depth = 0;
+	h->generation = 0;
+
+	inode_ref->dirty = true;
+}
+
+int ext4_extent_get_blocks(struct ext4_inode_ref *inode_ref, ext4_lblk_t iblock,
+			   uint32_t max_blocks, ext4_fsblk_t *result, bool create,
+			   uint32_t *blocks_count)
+{
+	struct ext4_extent_path path[EXT4_EXT_MAX_DEPTH + 1];
+	struct ext4_extent *ex;
+	ext4_fsblk_t goal = 0;
+	ext4_fsblk_t pblock = 0;
+	ext4_lblk_t next;
+	uint32_t count;
+	uint16_t depth;
+	int r;
+
+	*result = 0;
+	if (blocks_count)
+		*blocks_count = 0;
+
+	r = ext4_extent_find(inode_ref, iblock, path, &depth);
+	if (r != EOK)
+		return r;
+
+	ex = path[depth].extent;
+	if (ex) {
+		ext4_lblk_t first = to_le32(ex->first_block);
+		uint32_t len = ext4_ext_get_len(ex);
+
+		if (IN_RANGE(iblock, first, len)) {
+			count = first + len - iblock;
+			if (count > max_blocks)
+				count = max_blocks;
+
+			/*Unwritten extents read as holes, a range of one is
+			 * written when it's created*/
+			bool unwritten = ext4_ext_is_unwritten(ex);
+			if (!unwritten)
+				*result = ext4_ext_pblock(ex) + iblock - first;
+
+			ext4_extent_put_path(inode_ref, path, depth);
+			if (unwritten && create) {
+				r = ext4_extent_convert(inode_ref, iblock, count,
+							result);
+				if (r != EOK)
+					return r;
+			}
+
+			if (blocks_count)
+				*blocks_count = count;
+			return EOK;
+		}
+		goal = ext4_ext_pblock(ex) + iblock - first;
+	}
+
+	next = ext4_extent_next_allocated(path, depth);
+	ext4_extent_put_path(inode_ref, path, depth);
+
+	count = next - iblock;
+	if (count > max_blocks)
+		count = max_blocks;
+
+	if (!create) {
+		if (blocks_count)
+			*blocks_count = count;
+		return EOK;
+	}
+
+	if (!goal) {
+		r = ext4_fs_indirect_find_goal(inode_ref, &goal);
+		if (r != EOK)
+			return r;
+	}
+
+	if (count > EXT4_EXT_INIT_MAX_LEN)
+		count = EXT4_EXT_INIT_MAX_LEN;
+
+	/*Appends may preallocate up to the next mapped block*/
+	struct ext4_sblock *sb = &inode_ref->fs->sb;
+	uint32_t block_size = ext4_sb_get_block_size(sb);
+	uint64_t size = ext4_inode_get_size(sb, inode_ref->inode);
+	uint32_t room = 0;
+	if (iblock >= (size + block_size - 1) / block_size)
+		room = next - iblock;
+
+	r = ext4_balloc_alloc_blocks(inode_ref, iblock, goal, count, room,
+				     &pblock, &count);
+	if (r != EOK)
+		return r;
+
+	r = ext4_extent_insert(inode_ref, iblock, pblock, count, false);
+	if (r != EOK) {
+		ext4_balloc_free_blocks(inode_ref, pblock, count);
+		return r;
+	}
+
+	*result = pblock;
+	if (blocks_count)
+		*blocks_count = count;
+	return EOK;
+}
+
+int ext4_extent_alloc_unwritten(struct ext4_inode_ref *inode_ref,
+				ext4_lblk_t iblock, uint32_t count)
+{
+	struct ext4_extent_path path[EXT4_EXT_MAX_DEPTH + 1];
+	struct ext4_extent *ex;
+	ext4_fsblk_t goal, pblock;
+	ext4_lblk_t next;
+	uint32_t n;
+	uint16_t depth;
+	int r;
+
+	while (count) {
+		r = ext4_extent_find(inode_ref, iblock, path, &depth);
+		if (r != EOK)
+			return r;
+
+		goal = 0;
+		ex = path[depth].extent;
+		if (ex) {
+			ext4_lblk_t first = to_le32(ex->first_block);
+			uint32_t len = ext4_ext_get_len(ex);
+
+			/*Mapped blocks are kept as they are*/
+			if (IN_RANGE(iblock, first, len)) {
+				ext4_extent_put_path(inode_ref, path, depth);
+				n = first + len - iblock;
+				n = n < count ? n : count;
+				iblock += n;
+				count -= n;
+				continue;
+			}
+			goal = ext4_ext_pblock(ex) + iblock - first;
+		}
+
+		next = ext4_extent_next_allocated(path, depth);
+		ext4_extent_put_path(inode_ref, path, depth);
+
+		n = next - iblock;
+		n = n < count ? n : count;
+		if (n > EXT4_EXT_UNWRITTEN_MAX_LEN)
+			n = EXT4_EXT_UNWRITTEN_MAX_LEN;
+
+		if (!goal) {
+			r = ext4_fs_indirect_find_goal(inode_ref, &goal);
+			if (r != EOK)
+				return r;
+		}
+
+		r = ext4_balloc_alloc_blocks(inode_ref, iblock, goal, n, 0,
+					     &pblock, &n);
+		if (r != EOK)
+			return r;
+
+		r = ext4_extent_insert(inode_ref, iblock, pblock, n, true);
+		if (r != EOK) {
+			ext4_balloc_free_blocks(inode_ref, pblock, n);
+			return r;
+		}
+
+		iblock += n;
+		count -= n;
+	}
+	return EOK;
+}
+
+/**@brief   Release a range of blocks from a subtree.
+ * @param   inode_ref i-node
+ * @param   h node header
+ * @param   from first logical block to release
+ * @param   to last logical block to release
+ * @param   modified set if the node was changed
+ * @return  standard error code*/
+static int ext4_extent_remove_node(struct ext4_inode_ref *inode_ref,
+				   struct ext4_extent_header *h,
+				   ext4_lblk_t from, ext4_lblk_t to,
+				   bool *modified)
+{
+	struct ext4_fs *fs = inode_ref->fs;
+	uint16_t depth = to_le16(h->depth);
+	uint16_t cnt = to_le16(h->entries_count);
+	uint16_t i, kept = 0;
+	int r = EOK;
+
+	if (!depth) {
+		struct ext4_extent *ex = EXT_FIRST_EXTENT(h);
+
+		for (i = 0; i < cnt; i++) {
+			struct ext4_extent cur = ex[i];
+			ext4_lblk_t first = to_le32(cur.first_block);
+			uint32_t len = ext4_ext_get_len(&cur);
+			ext4_lblk_t last = first + len - 1;
+			bool unwritten = ext4_ext_is_unwritten(&cur);
+			ext4_lblk_t start, end;
+
+			if (last < from || first > to) {
+				ex[kept++] = cur;
+				continue;
+			}
+
+			start = first > from ? first : from;
+			end = last < to ? last : to;
+
+			/*Punching a hole splits the extent in two*/
+			if (start > first && end < last &&
+			    cnt == to_le16(h->max_entries_count)) {
+				r = ENOTSUP;
+				break;
+			}
+
+			r = ext4_balloc_free_blocks(
+			    inode_ref, ext4_ext_pblock(&cur) + start - first,
+			    end - start + 1);
+			if (r != EOK)
+				break;
+
+			*modified = true;
+			if (end < last) {
+				struct ext4_extent tail = cur;
+
+				tail.first_block = to_le32(end + 1);
+				ext4_ext_store_pblock(&tail, ext4_ext_pblock(&cur) +
+								 end + 1 - first);
+				ext4_ext_set_len(&tail, last - end, unwritten);
+				if (start == first) {
+					ex[kept++] = tail;
+					continue;
+				}
+
+				/*The tail is kept by the next iteration*/
+				memmove(&ex[i + 2], &ex[i + 1],
+					(cnt - i - 1) * sizeof(*ex));
+				ex[i + 1] = tail;
+				cnt++;
+			}
+			if (start > first) {
+				ext4_ext_set_len(&cur, start - first,
+						 unwritten);
+				ex[kept++] = cur;
+			}
+		}
+		/*Entries after a failure are kept as they are*/
+		for (; i < cnt; i++)
+			ex[kept++] = ex[i];
+
+		h->entries_count = to_le16(kept);
+		return r;
+	}
+
+	struct ext4_extent_index *idx = EXT_FIRST_INDEX(h);
+	for (i = 0; i < cnt; i++) {
+		struct ext4_extent_index cur = idx[i];
+		ext4_lblk_t first = to_le32(cur.first_block);
+		ext4_lblk_t last = i + 1 < cnt
+				       ? to_le32(idx[i + 1].first_block) - 1
+				       : EXT_MAX_BLOCKS;
+		struct ext4_extent_header *child;
+		struct ext4_block block;
+		bool child_modified = false;
+
+		if (r != EOK || last < from || first > to) {
+			idx[kept++] = cur;
+			continue;
+		}
+
+		r = ext4_extent_get_node(inode_ref, ext4_idx_pblock(&cur),
+					 depth - 1, &block);
+		if (r != EOK) {
+			idx[kept++] = cur;
+			continue;
+		}
+
+		child = (struct ext4_extent_header *)block.data;
+		r = ext4_extent_remove_node(inode_ref, child, from, to,
+					    &child_modified);
+		if (child_modified) {
+			ext4_extent_set_csum(inode_ref, child);
+			ext4_trans_set_block_dirty(block.buf);
+		}
+
+		if (r == EOK && !child->entries_count) {
+			ext4_block_set(fs->bdev, &block);
+			r = ext4_balloc_free_block(inode_ref,
+						   ext4_idx_pblock(&cur));
+			*modified = true;
+			continue;
+		}
+
+		if (child_modified && child->entries_count) {
+			/*First entries of both node types share the offset*/
+			cur.first_block = EXT_FIRST_EXTENT(child)->first_block;
+			*modified = true;
+		}
+		idx[kept++] = cur;
+		ext4_block_set(fs->bdev, &block);
+	}
+
+	h->entries_count = to_le16(kept);
+	return r;
+}
+
+int ext4_extent_remove_space(struct ext4_inode_ref *inode_ref, ext4_lblk_t from,
+			     ext4_lblk_t to)
+{
+	struct ext4_extent_header *root = ext4_extent_root(inode_ref);
+	bool modified = false;
+	int r;
+
+	if (to_le16(root->magic) != EXT4_EXTENT_MAGIC ||
+	    to_le16(root->depth) > EXT4_EXT_MAX_DEPTH)
+		return EIO;
+
+	r = ext4_extent_remove_node(inode_ref, root, from, to, &modified);
+
+	/*Empty tree gets back to a single leaf held by the i-node*/
+	if (!root->entries_count && root->depth) {
+		root->depth = 0;
+		modified = true;
+	}
+
+	if (modified)
+		inode_ref->dirty = true;
+	return r;
+}
+
+#endif
+
+/**
+ * @}
+ */
@@ -71,6 +71,9 @@ int ext4_fs_init(struct ext4_fs *fs, struct ext4_blockdev *bdev,
 
 	fs->read_only = read_only;
 
+	fs->dcache = NULL;
+	fs->icache = NULL;
+
 	r = ext4_sb_read(fs->bdev, &fs->sb);
 	if (r != EOK)
 		return r;
@@ -123,6 +126,34 @@ int ext4_fs_init(struct ext4_fs *fs, struct ext4_blockdev *bdev,
 	return r;
 }
 
+int ext4_fs_enable_dir_index(struct ext4_fs *fs)
+{
+	struct ext4_sblock *sb = &fs->sb;
+	uint32_t flags = ext4_get32(sb, flags);
+	bool seeded = false;
+
+	if (fs->read_only || ext4_sb_feature_com(sb, EXT4_FCOM_DIR_INDEX))
+		return EOK;
+
+	/* Filesystems formatted without the index may lack the hash setup */
+	for (size_t i = 0; i < sizeof(sb->hash_seed) / sizeof(sb->hash_seed[0]); ++i)
+		seeded = seeded || sb->hash_seed[i];
+
+	if (!seeded)
+		memcpy(sb->hash_seed, sb->uuid, sizeof(sb->hash_seed));
+
+	if (sb->default_hash_version == EXT2_HTREE_LEGACY)
+		sb->default_hash_version = EXT2_HTREE_HALF_MD4;
+
+	if (!(flags & (EXT4_SUPERBLOCK_FLAGS_SIGNED_HASH |
+		       EXT4_SUPERBLOCK_FLAGS_UNSIGNED_HASH)))
+		ext4_set32(sb, flags, flags | EXT4_SUPERBLOCK_FLAGS_SIGNED_HASH);
+
+	ext4_set32(sb, features_compatible,
+		   ext4_get32(sb, features_compatible) | EXT4_FCOM_DIR_INDEX);
+	return ext4_sb_write(fs->bdev, sb);
+}
+
 int ext4_fs_fini(struct ext4_fs *fs)
 {
 	ext4_assert(fs);
@@ -780,6 +811,17 @@ __ext4_fs_get_inode_ref(struct ext4_fs *fs, uint32_t index,
 			ref->index);
 	}
 
+	/* In-memory inode of an open file is more recent than the inode
+	 * table, unless it has been copied there already. The block isn't
+	 * marked dirty, that's left to a reference changing the inode, or
+	 * to the commit writing dirty inodes back. */
+	struct ext4_cinode *ci = ext4_icache_find(fs->icache, ref->index);
+	if (ci) {
+		if (ci->dirty && !ci->table_refs)
+			memcpy(ref->inode, &ci->inode, fs->icache->inode_size);
+		ci->table_refs++;
+	}
+
 	return EOK;
 }
 
@@ -791,6 +833,9 @@ int ext4_fs_get_inode_ref(struct ext4_fs *fs, uint32_t index,
 
 int ext4_fs_put_inode_ref(struct ext4_inode_ref *ref)
 {
+	struct ext4_icache *ic = ref->fs->icache;
+	struct ext4_cinode *ci = ext4_icache_find(ic, ref->index);
+
 	/* Check if reference modified */
 	if (ref->dirty) {
 		/* Mark block dirty for writing changes to physical device */
@@ -798,6 +843,14 @@ int ext4_fs_put_inode_ref(struct ext4_inode_ref *ref)
 		ext4_trans_set_block_dirty(ref->block.buf);
 	}
 
+	/* Keep the in-memory inode up to date */
+	if (ci) {
+		memcpy(&ci->inode, ref->inode, ic->inode_size);
+		ci->table_refs--;
+		if (ref->dirty)
+			ext4_icache_clear_dirty(ic, ci);
+	}
+
 	/* Put back block, that contains i-node */
 	return ext4_block_set(ref->fs->bdev, &ref->block);
 }
@@ -936,6 +989,11 @@ int ext4_fs_free_inode(struct ext4_inode_ref *inode_ref)
 	uint32_t offset;
 	uint32_t suboff;
 	int rc;
+
+	/*Entries of a released directory mustn't be found if its inode
+	 * is reused*/
+	ext4_dcache_invalidate_dir(fs->dcache, inode_ref->index);
+	ext4_icache_detach(fs->icache, inode_ref->index);
 #if CONFIG_EXTENT_ENABLE && CONFIG_EXTENTS_ENABLE
 	/* For extents must be data block destroyed by other way */
 	if ((ext4_sb_feature_incom(&fs->sb, EXT4_FINCOM_EXTENTS)) &&
@@ -1186,15 +1244,34 @@ int ext4_fs_truncate_inode(struct ext4_inode_ref *inode_ref, uint64_t new_size)
 	if (!ext4_inode_can_truncate(sb, inode_ref->inode))
 		return EINVAL;
 
-	/* If sizes are equal, nothing has to be done. */
+	bool extents = false;
+#if CONFIG_EXTENT_ENABLE && CONFIG_EXTENTS_ENABLE
+	extents = ext4_sb_feature_incom(sb, EXT4_FINCOM_EXTENTS) &&
+		  ext4_inode_has_flag(inode_ref->inode, EXT4_INODE_FLAG_EXTENTS);
+#endif
+
+	/* If sizes are equal, nothing has to be done, except releasing the
+	 * blocks allocated beyond the end of an extent mapped file. */
 	uint64_t old_size = ext4_inode_get_size(sb, inode_ref->inode);
-	if (old_size == new_size)
+	if (old_size == new_size && !extents)
 		return EOK;
 
 	/* It's not supported to make the larger file by truncate operation */
 	if (old_size < new_size)
 		return EINVAL;
 
+	/* Block runs remembered by the open files get stale */
+	struct ext4_cinode *ci = ext4_icache_find(inode_ref->fs->icache,
+						  inode_ref->index);
+	if (ci) {
+		ci->map_gen++;
+
+		/* Preallocated blocks beyond the end are released as well */
+		r = ext4_balloc_discard_prealloc(inode_ref->fs, ci);
+		if (r != EOK)
+			return r;
+	}
+
 	/* For symbolic link which is small enough */
 	v = ext4_inode_is_type(sb, inode_ref->inode, EXT4_INODE_MODE_SOFTLINK);
 	if (v && old_size < sizeof(inode_ref->inode->blocks) &&
@@ -1225,17 +1302,14 @@ int ext4_fs_truncate_inode(struct ext4_inode_ref *inode_ref, uint64_t new_size)
 	uint32_t old_blocks_cnt = (uint32_t)((old_size + block_size - 1) / block_size);
 	uint32_t diff_blocks_cnt = old_blocks_cnt - new_blocks_cnt;
 #if CONFIG_EXTENT_ENABLE && CONFIG_EXTENTS_ENABLE
-	if ((ext4_sb_feature_incom(sb, EXT4_FINCOM_EXTENTS)) &&
-	    (ext4_inode_has_flag(inode_ref->inode, EXT4_INODE_FLAG_EXTENTS))) {
+	if (extents) {
 
-		/* Extents require special operation */
-		if (diff_blocks_cnt) {
-			r = ext4_extent_remove_space(inode_ref, new_blocks_cnt,
-						     EXT_MAX_BLOCKS);
-			if (r != EOK)
-				return r;
-
-		}
+		/* Extents require special operation, blocks allocated beyond
+		 * the end of file are released as well */
+		r = ext4_extent_remove_space(inode_ref, new_blocks_cnt,
+					     EXT_MAX_BLOCKS);
+		if (r != EOK)
+			return r;
 	} else
 #endif
 	{
@@ -1465,6 +1539,28 @@ int ext4_fs_get_inode_dblk_idx(struct ext4_inode_ref *inode_ref,
 						   false, support_unwritten);
 }
 
+int ext4_fs_get_inode_dblk_run(struct ext4_inode_ref *inode_ref,
+			       ext4_lblk_t iblock, uint32_t max_blocks,
+			       ext4_fsblk_t *fblock, uint32_t *blocks_count)
+{
+	struct ext4_fs *fs = inode_ref->fs;
+
+	*blocks_count = 1;
+	if (ext4_inode_get_size(&fs->sb, inode_ref->inode) == 0) {
+		*fblock = 0;
+		return EOK;
+	}
+
+#if CONFIG_EXTENT_ENABLE && CONFIG_EXTENTS_ENABLE
+	if ((ext4_sb_feature_incom(&fs->sb, EXT4_FINCOM_EXTENTS)) &&
+	    (ext4_inode_has_flag(inode_ref->inode, EXT4_INODE_FLAG_EXTENTS)))
+		return ext4_extent_get_blocks(inode_ref, iblock, max_blocks,
+					      fblock, false, blocks_count);
+#endif
+	return ext4_fs_get_inode_dblk_idx_internal(inode_ref, iblock, fblock,
+						   false, true);
+}
+
 int ext4_fs_init_inode_dblk_idx(struct ext4_inode_ref *inode_ref,
 				ext4_lblk_t iblock, ext4_fsblk_t *fblock)
 {
@@ -1472,6 +1568,46 @@ int ext4_fs_init_inode_dblk_idx(struct ext4_inode_ref *inode_ref,
 						   true, true);
 }
 
+static int ext4_fs_set_inode_data_block_index(struct ext4_inode_ref *inode_ref,
+				       ext4_lblk_t iblock, ext4_fsblk_t fblock);
+
+int ext4_fs_init_inode_dblk_run(struct ext4_inode_ref *inode_ref,
+				ext4_lblk_t iblock, uint32_t max_blocks,
+				ext4_fsblk_t *fblock, uint32_t *blocks_count)
+{
+	struct ext4_fs *fs = inode_ref->fs;
+	ext4_fsblk_t goal;
+	int rc;
+
+	*blocks_count = 1;
+#if CONFIG_EXTENT_ENABLE && CONFIG_EXTENTS_ENABLE
+	if ((ext4_sb_feature_incom(&fs->sb, EXT4_FINCOM_EXTENTS)) &&
+	    (ext4_inode_has_flag(inode_ref->inode, EXT4_INODE_FLAG_EXTENTS)))
+		return ext4_extent_get_blocks(inode_ref, iblock, max_blocks,
+					      fblock, true, blocks_count);
+#endif
+	rc = ext4_fs_get_inode_dblk_idx_internal(inode_ref, iblock, fblock,
+						 false, true);
+	if (rc != EOK || *fblock)
+		return rc;
+
+	/* Fill a hole of a sparse file */
+	rc = ext4_fs_indirect_find_goal(inode_ref, &goal);
+	if (rc != EOK)
+		return rc;
+
+	rc = ext4_balloc_alloc_block(inode_ref, goal, fblock);
+	if (rc != EOK)
+		return rc;
+
+	rc = ext4_fs_set_inode_data_block_index(inode_ref, iblock, *fblock);
+	if (rc != EOK) {
+		ext4_balloc_free_block(inode_ref, *fblock);
+		*fblock = 0;
+	}
+	return rc;
+}
+
 static int ext4_fs_set_inode_data_block_index(struct ext4_inode_ref *inode_ref,
 				       ext4_lblk_t iblock, ext4_fsblk_t fblock)
 {
@@ -1638,8 +1774,9 @@ static int ext4_fs_set_inode_data_block_index(struct ext4_inode_ref *inode_ref,
 }
 
 
-int ext4_fs_append_inode_dblk(struct ext4_inode_ref *inode_ref,
-			      ext4_fsblk_t *fblock, ext4_lblk_t *iblock)
+int ext4_fs_append_inode_dblks(struct ext4_inode_ref *inode_ref,
+			       uint32_t max_blocks, ext4_fsblk_t *fblock,
+			       ext4_lblk_t *iblock, uint32_t *blocks_count)
 {
 #if CONFIG_EXTENT_ENABLE && CONFIG_EXTENTS_ENABLE
 	/* Handle extents separately */
@@ -1647,20 +1784,23 @@ int ext4_fs_append_inode_dblk(struct ext4_inode_ref *inode_ref,
 	    (ext4_inode_has_flag(inode_ref->inode, EXT4_INODE_FLAG_EXTENTS))) {
 		int rc;
 		ext4_fsblk_t current_fsblk;
+		uint32_t count;
 		struct ext4_sblock *sb = &inode_ref->fs->sb;
 		uint64_t inode_size = ext4_inode_get_size(sb, inode_ref->inode);
 		uint32_t block_size = ext4_sb_get_block_size(sb);
 		*iblock = (uint32_t)((inode_size + block_size - 1) / block_size);
 
-		rc = ext4_extent_get_blocks(inode_ref, *iblock, 1,
-						&current_fsblk, true, NULL);
+		rc = ext4_extent_get_blocks(inode_ref, *iblock, max_blocks,
+						&current_fsblk, true, &count);
 		if (rc != EOK)
 			return rc;
 
 		*fblock = current_fsblk;
+		*blocks_count = count;
 		ext4_assert(*fblock);
 
-		ext4_inode_set_size(inode_ref->inode, inode_size + block_size);
+		ext4_inode_set_size(inode_ref->inode,
+				    inode_size + (uint64_t)count * block_size);
 		inode_ref->dirty = true;
 
 
@@ -1680,13 +1820,16 @@ int ext4_fs_append_inode_dblk(struct ext4_inode_ref *inode_ref,
 	/* Logical blocks are numbered from 0 */
 	uint32_t new_block_idx = (uint32_t)(inode_size / block_size);
 
-	/* Allocate new physical block */
+	/* Allocate new physical block, block maps are extended one block at
+	 * a time, the following ones stay preallocated */
 	ext4_fsblk_t goal, phys_block;
+	uint32_t count;
 	int rc = ext4_fs_indirect_find_goal(inode_ref, &goal);
 	if (rc != EOK)
 		return rc;
 
-	rc = ext4_balloc_alloc_block(inode_ref, goal, &phys_block);
+	rc = ext4_balloc_alloc_blocks(inode_ref, new_block_idx, goal, 1,
+				      UINT32_MAX, &phys_block, &count);
 	if (rc != EOK)
 		return rc;
 
@@ -1704,10 +1847,19 @@ int ext4_fs_append_inode_dblk(struct ext4_inode_ref *inode_ref,
 
 	*fblock = phys_block;
 	*iblock = new_block_idx;
+	*blocks_count = 1;
 
 	return EOK;
 }
 
+int ext4_fs_append_inode_dblk(struct ext4_inode_ref *inode_ref,
+			      ext4_fsblk_t *fblock, ext4_lblk_t *iblock)
+{
+	uint32_t count;
+
+	return ext4_fs_append_inode_dblks(inode_ref, 1, fblock, iblock, &count);
+}
+
 void ext4_fs_inode_links_count_inc(struct ext4_inode_ref *inode_ref)
 {
 	uint16_t link;
@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2026 mprogramming
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup lwext4
+ * @{
+ */
+/**
+ * @file  ext4_icache.c
+ * @brief Inode cache, in-memory inodes shared by the open files.
+ */
+
+#include <ext4_config.h>
+#include <ext4_types.h>
+#include <ext4_icache.h>
+#include <ext4_debug.h>
+#include <ext4_errno.h>
+
+#include <string.h>
+#include <stdlib.h>
+
+static int ext4_cinode_compare(struct ext4_cinode *a, struct ext4_cinode *b)
+{
+	if (a->index == b->index)
+		return 0;
+	return a->index > b->index ? 1 : -1;
+}
+
+RB_GENERATE_INTERNAL(ext4_cinode_tree, ext4_cinode, node,
+		     ext4_cinode_compare, static inline)
+
+static void ext4_icache_release(struct ext4_icache *ic,
+				struct ext4_cinode *ci)
+{
+	if (!ci->detached) {
+		RB_REMOVE(ext4_cinode_tree, &ic->root, ci);
+		ic->cnt--;
+	}
+	ext4_free(ci);
+}
+
+void ext4_icache_init(struct ext4_icache *ic, uint32_t inode_size)
+{
+	ext4_assert(ic);
+
+	memset(ic, 0, sizeof(struct ext4_icache));
+	RB_INIT(&ic->root);
+	TAILQ_INIT(&ic->dirty_list);
+	ic->inode_size = inode_size < sizeof(struct ext4_inode)
+			     ? inode_size : sizeof(struct ext4_inode);
+}
+
+void ext4_icache_fini(struct ext4_icache *ic)
+{
+	struct ext4_cinode *ci, *tmp;
+
+	ext4_assert(ic);
+
+	/*Entries are released along with the files still referencing them*/
+	RB_FOREACH_SAFE(ci, ext4_cinode_tree, &ic->root, tmp)
+		ext4_icache_detach(ic, ci->index);
+
+	memset(ic, 0, sizeof(struct ext4_icache));
+}
+
+struct ext4_cinode *ext4_icache_find(struct ext4_icache *ic, uint32_t index)
+{
+	struct ext4_cinode key = {.index = index};
+
+	if (!ic || !ic->cnt)
+		return NULL;
+
+	return RB_FIND(ext4_cinode_tree, &ic->root, &key);
+}
+
+struct ext4_cinode *ext4_icache_next(struct ext4_icache *ic,
+				     struct ext4_cinode *ci)
+{
+	if (!ic || !ic->cnt)
+		return NULL;
+
+	if (!ci)
+		return RB_MIN(ext4_cinode_tree, &ic->root);
+
+	return RB_NEXT(ext4_cinode_tree, &ic->root, ci);
+}
+
+struct ext4_cinode *ext4_icache_get(struct ext4_icache *ic, uint32_t index,
+				    const struct ext4_inode *inode)
+{
+	struct ext4_cinode *ci = ext4_icache_find(ic, index);
+
+	if (ci) {
+		if (!ci->refctr++)
+			ic->unref_cnt--;
+		return ci;
+	}
+
+	ci = ext4_calloc(1, sizeof(struct ext4_cinode));
+	if (!ci)
+		return NULL;
+
+	ci->index = index;
+	ci->refctr = 1;
+	memcpy(&ci->inode, inode, ic->inode_size);
+	RB_INSERT(ext4_cinode_tree, &ic->root, ci);
+	ic->cnt++;
+	return ci;
+}
+
+void ext4_icache_put(struct ext4_icache *ic, struct ext4_cinode *ci)
+{
+	ext4_assert(ci->refctr);
+
+	if (--ci->refctr)
+		return;
+
+	/*Lazily written inode is kept until it's written back*/
+	if (ci->dirty) {
+		ext4_assert(ci->lazy);
+		ic->unref_cnt++;
+		return;
+	}
+	ext4_icache_release(ic, ci);
+}
+
+void ext4_icache_set_dirty(struct ext4_icache *ic, struct ext4_cinode *ci,
+			   bool lazy)
+{
+	if (ci->detached)
+		return;
+
+	if (ci->dirty) {
+		ci->lazy = ci->lazy && lazy;
+		return;
+	}
+
+	ci->dirty = true;
+	ci->lazy = lazy;
+	TAILQ_INSERT_TAIL(&ic->dirty_list, ci, dirty_node);
+}
+
+void ext4_icache_clear_dirty(struct ext4_icache *ic, struct ext4_cinode *ci)
+{
+	if (!ci->dirty)
+		return;
+
+	ci->dirty = false;
+	ci->lazy = false;
+	TAILQ_REMOVE(&ic->dirty_list, ci, dirty_node);
+
+	if (!ci->refctr) {
+		ic->unref_cnt--;
+		ext4_icache_release(ic, ci);
+	}
+}
+
+void ext4_icache_detach(struct ext4_icache *ic, uint32_t index)
+{
+	struct ext4_cinode *ci = ext4_icache_find(ic, index);
+
+	if (!ci)
+		return;
+
+	/*Inode no file references is dirty, cleaning releases it*/
+	if (!ci->refctr) {
+		ext4_icache_clear_dirty(ic, ci);
+		return;
+	}
+
+	ext4_icache_clear_dirty(ic, ci);
+	RB_REMOVE(ext4_cinode_tree, &ic->root, ci);
+	ic->cnt--;
+	ci->detached = true;
+}
+
+/**
+ * @}
+ */
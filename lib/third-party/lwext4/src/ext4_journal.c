@@ -1640,6 +1640,7 @@ int jbd_trans_set_block_dirty(struct jbd_trans *trans,
 	jbd_buf->trans = trans;
 	jbd_buf->block = *block;
 	ext4_bcache_inc_ref(block->buf);
+	ext4_bcache_set_flag(block->buf, BC_TRANS);
 
 	/* If the content reach the disk, notify us
 	 * so that we may do a checkpoint. */
@@ -1733,6 +1734,7 @@ void jbd_journal_free_trans(struct jbd_journal *journal,
 			  tmp) {
 		block_rec = jbd_buf->block_rec;
 		if (abort) {
+			ext4_bcache_clear_flag(jbd_buf->block.buf, BC_TRANS);
 			jbd_buf->block.buf->end_write = NULL;
 			jbd_buf->block.buf->end_write_arg = NULL;
 			ext4_bcache_clear_dirty(jbd_buf->block.buf);
@@ -1818,6 +1820,11 @@ static int jbd_journal_prepare(struct jbd_journal *journal,
 	struct jbd_bhdr *bhdr = NULL;
 	void *data;
 
+	/* The transaction is being committed, its buffers may be
+	 * written back from now on. */
+	TAILQ_FOREACH(jbd_buf, &trans->buf_queue, buf_node)
+		ext4_bcache_clear_flag(jbd_buf->block.buf, BC_TRANS);
+
 	/* Try to remove any non-dirty buffers from the tail of
 	 * buf_queue. */
 	TAILQ_FOREACH_REVERSE_SAFE(jbd_buf, &trans->buf_queue,
@@ -753,6 +753,14 @@ int ext4_mkfs(struct ext4_fs *fs, struct ext4_blockdev *bd,
 		break;
 	}
 
+#if CONFIG_DIR_INDEX_ENABLE
+	/*Hashed directory index is a compatible feature, any type gets it*/
+	if (info->no_dir_index)
+		info->feat_compat &= ~EXT4_FCOM_DIR_INDEX;
+	else
+		info->feat_compat |= EXT4_FCOM_DIR_INDEX;
+#endif
+
 	/*TODO: handle this features some day...*/
 	info->feat_incompat &= ~EXT4_FINCOM_META_BG;
 	info->feat_incompat &= ~EXT4_FINCOM_FLEX_BG;
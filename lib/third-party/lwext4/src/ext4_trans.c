@@ -47,6 +47,7 @@
 int ext4_trans_set_block_dirty(struct ext4_buf *buf)
 {
 	int r = EOK;
+	ext4_bcache_tag_dirty(buf->bc, buf);
 #if CONFIG_JOURNALING_ENABLE
 	struct ext4_fs *fs = buf->bc->bdev->fs;
 	struct ext4_block block = {
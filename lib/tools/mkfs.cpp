@@ -23,7 +23,8 @@ namespace vfs::tools::mkfs {
         info.journal_blocks   = params.journal_blocks;
         info.dsc_size         = params.descriptor_size;
         std::copy(params.uuid.begin(), params.uuid.end(), info.uuid);
-        info.journal = params.journal;
+        info.journal      = params.journal;
+        info.no_dir_index = not params.dir_index;
         snprintf(info.label, sizeof info.label, "%s", params.label.data());
 
         int fs_type {F_SET_EXT4};
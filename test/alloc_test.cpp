@@ -0,0 +1,76 @@
+#include "common/FilesystemUnderTest.hpp"
+#include "common/partition_layout.hpp"
+
+#include <vfs/vfs.hpp>
+
+#include <sys/stat.h>
+#include <catch2/catch_all.hpp>
+
+#include <fcntl.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+using namespace vfs::tests;
+
+/// Global allocation functions are replaced for the whole binary, so the benchmark lives in its own executable
+
+namespace {
+    /// Heap allocations made by the test binary
+    std::atomic<std::size_t> allocations {};
+} // namespace
+
+void* operator new(const std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size != 0 ? size : 1)) { return ptr; }
+    throw std::bad_alloc {};
+}
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+TEST_CASE("Heap allocations per path based call", "[.][benchmark]")
+{
+    constexpr int rounds = 1000;
+
+    auto        fsut    = ext4UnderTest::Builder {}.set_automount().create();
+    auto&       vfs     = fsut->get();
+    const auto  file    = (test_volume0_name / "dir/file").string();
+    const auto  missing = file + "x";
+    const auto  subdir  = (test_volume0_name / "dir/sub").string();
+    struct stat st {};
+    REQUIRE(not vfs.mkdir(test_volume0_name / "dir", 0777));
+    auto fd = vfs.open(file.c_str(), O_CREAT | O_WRONLY, 0);
+    REQUIRE(fd);
+    REQUIRE(not vfs.close(*fd));
+
+    const auto measure = [&](const char* name, const auto& call) {
+        call();
+        const auto before = allocations.load();
+        const auto start  = std::chrono::steady_clock::now();
+        for (int i = 0; i < rounds; ++i) { call(); }
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        const auto count   = allocations.load() - before;
+        std::cout << name << ": " << static_cast<double>(count) / rounds << " allocations/call, " << std::chrono::duration<double, std::micro>(elapsed).count() / rounds
+                  << " us/call" << std::endl;
+        return count;
+    };
+
+    /// Paths come as C strings, the way the syscall adapter passes them
+    const auto stat_allocs = measure("stat", [&] { REQUIRE(not vfs.stat(file.c_str(), st)); });
+    measure("stat of a missing file", [&] { REQUIRE(vfs.stat(missing.c_str(), st)); });
+    measure("open and close", [&] {
+        const auto fd = vfs.open(file.c_str(), O_RDONLY, 0);
+        REQUIRE(fd);
+        REQUIRE(not vfs.close(*fd));
+    });
+    measure("mkdir and rmdir", [&] {
+        REQUIRE(not vfs.mkdir(subdir.c_str(), 0777));
+        REQUIRE(not vfs.rmdir(subdir.c_str()));
+    });
+    REQUIRE(stat_allocs == 0);
+}
+
@@ -0,0 +1,361 @@
+#include "common/FilesystemUnderTest.hpp"
+#include "common/partition_layout.hpp"
+
+#include <vfs/async_fs.hpp>
+#include <vfs/async_io.hpp>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <catch2/catch_all.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace vfs::tests;
+using namespace vfs;
+
+namespace {
+    /// Reap exactly 'count' completions and index them by user data
+    std::map<std::uint64_t, result<std::size_t>> reap_all(AsyncIO& aio, const std::size_t count)
+    {
+        std::map<std::uint64_t, result<std::size_t>> completions;
+        std::vector<CompletionEntry>                 cqes(count);
+        std::size_t                                  reaped {};
+        while (reaped < count) {
+            const auto ret = aio.reap(std::span {cqes}.subspan(0, count - reaped), 1);
+            for (std::size_t i = 0; i < ret; ++i) { completions.emplace(cqes[i].user_data, cqes[i].res); }
+            reaped += ret;
+        }
+        return completions;
+    }
+
+    /// Fire-and-forget coroutine, it runs eagerly until the first suspension point and destroys itself once finished
+    struct detached {
+        struct promise_type {
+            detached           get_return_object() { return {}; }
+            std::suspend_never initial_suspend() noexcept { return {}; }
+            std::suspend_never final_suspend() noexcept { return {}; }
+            void               return_void() {}
+            void               unhandled_exception() { std::terminate(); }
+        };
+    };
+
+    /// Executor running tasks right away on the posting thread
+    struct InlineExecutor final : Executor {
+        void post(std::function<void()> task) override { task(); }
+    };
+
+    constexpr std::size_t bench_file_size  = 64 * 1024;
+    constexpr std::size_t bench_chunk_size = 4096;
+
+    /// Read the whole file in chunks and count failed calls
+    detached read_file(VirtualFS& vfs, AsyncFS& afs, Executor& completion, const std::filesystem::path path, std::atomic_size_t& errors, std::atomic_size_t& done)
+    {
+        std::vector<char> buffer(bench_chunk_size);
+        const auto        fd = co_await afs.async_open(path, O_RDONLY, 0, completion);
+        if (fd) {
+            for (std::size_t offset = 0; offset < bench_file_size; offset += bench_chunk_size) {
+                const auto ret = co_await afs.async_read(*fd, buffer, completion);
+                if (not ret or *ret != bench_chunk_size) { ++errors; }
+            }
+            if (vfs.close(*fd)) { ++errors; }
+        } else {
+            ++errors;
+        }
+        ++done;
+    }
+} // namespace
+
+TEST_CASE("Asynchronous I/O")
+{
+    auto  fsut = ext4UnderTest::Builder {}.with_multipartition().set_automount().create();
+    auto& vfs  = fsut->get();
+    auto  aio  = AsyncIO {vfs, 4};
+
+    const std::array paths {test_volume0_name / "file0", test_volume1_name / "file1"};
+
+    SECTION("batch spanning several mount points")
+    {
+        std::vector<SubmissionEntry> sqes;
+        for (std::size_t i = 0; i < paths.size(); ++i) { sqes.push_back(SubmissionEntry::open(paths[i], O_RDWR | O_CREAT, 0644, i)); }
+        REQUIRE(aio.submit(sqes) == paths.size());
+
+        auto opened = reap_all(aio, paths.size());
+        REQUIRE(aio.in_flight() == 0);
+        std::array<int, 2> fds {};
+        for (std::size_t i = 0; i < paths.size(); ++i) {
+            REQUIRE(opened.at(i).has_value());
+            fds[i] = static_cast<int>(*opened.at(i));
+        }
+
+        const std::array<std::string, 2> contents {"first volume", "second volume"};
+        sqes.clear();
+        for (std::size_t i = 0; i < fds.size(); ++i) {
+            sqes.push_back(SubmissionEntry::write(fds[i], contents[i].data(), contents[i].size(), i));
+            sqes.push_back(SubmissionEntry::fsync(fds[i], 10 + i));
+        }
+        REQUIRE(aio.submit(sqes) == sqes.size());
+        const auto written = reap_all(aio, sqes.size());
+        for (std::size_t i = 0; i < fds.size(); ++i) {
+            REQUIRE(written.at(i).value() == contents[i].size());
+            REQUIRE(written.at(10 + i).has_value());
+        }
+
+        std::array<struct stat, 2> st {};
+        sqes.clear();
+        for (std::size_t i = 0; i < fds.size(); ++i) {
+            sqes.push_back(SubmissionEntry::stat(paths[i], st[i], i));
+            sqes.push_back(SubmissionEntry::close(fds[i], 10 + i));
+        }
+        REQUIRE(aio.submit(sqes) == sqes.size());
+        const auto closed = reap_all(aio, sqes.size());
+        for (std::size_t i = 0; i < fds.size(); ++i) {
+            REQUIRE(closed.at(i).has_value());
+            REQUIRE(static_cast<std::size_t>(st[i].st_size) == contents[i].size());
+            REQUIRE(closed.at(10 + i).has_value());
+        }
+    }
+
+    SECTION("requests targeting the same descriptor are executed in order of submission")
+    {
+        const auto fd = vfs.open(paths[0], O_RDWR | O_CREAT, 0644);
+        REQUIRE(fd);
+
+        constexpr std::size_t        chunks = 64;
+        std::vector<std::string>     data(chunks);
+        std::vector<SubmissionEntry> sqes;
+        for (std::size_t i = 0; i < chunks; ++i) {
+            data[i] = std::to_string(i) + ";";
+            sqes.push_back(SubmissionEntry::write(*fd, data[i].data(), data[i].size(), i));
+        }
+        REQUIRE(aio.submit(sqes) == chunks);
+        const auto written = reap_all(aio, chunks);
+        REQUIRE(std::ranges::all_of(written, [](const auto& cqe) { return cqe.second.has_value(); }));
+
+        std::string expected;
+        for (const auto& d : data) { expected += d; }
+        std::string actual(expected.size(), '\0');
+        REQUIRE(vfs.lseek(*fd, 0, SEEK_SET).value() == 0);
+        REQUIRE(vfs.read(*fd, actual.data(), actual.size()).value() == expected.size());
+        REQUIRE(actual == expected);
+        REQUIRE(not vfs.close(*fd));
+    }
+
+    SECTION("errors are reported through completions")
+    {
+        char                                 buf[16] {};
+        struct stat                          st {};
+        const std::array<SubmissionEntry, 3> sqes {SubmissionEntry::read(1000, buf, sizeof buf, 0), SubmissionEntry::stat(test_volume0_name / "missing", st, 1),
+                                                   SubmissionEntry::open(test_volume0_name / "missing", O_RDONLY, 0, 2)};
+        REQUIRE(aio.submit(sqes) == sqes.size());
+        const auto completions = reap_all(aio, sqes.size());
+        REQUIRE(completions.at(0).error().value() == EBADF);
+        REQUIRE(completions.at(1).error().value() == ENOENT);
+        REQUIRE(completions.at(2).error().value() == ENOENT);
+    }
+
+    SECTION("non-blocking reap")
+    {
+        std::array<CompletionEntry, 1> cqes {};
+        REQUIRE(aio.reap(cqes) == 0);
+    }
+
+    SECTION("blocking reap on an idle ring returns at once")
+    {
+        std::array<CompletionEntry, 1> cqes {};
+        REQUIRE(aio.reap(cqes, 1) == 0);
+
+        /// Only the requests actually in flight are waited for
+        char                                 buf[16] {};
+        const std::array<SubmissionEntry, 1> sqes {SubmissionEntry::read(1000, buf, sizeof buf, 0)};
+        REQUIRE(aio.submit(sqes) == 1);
+        std::array<CompletionEntry, 4> many {};
+        REQUIRE(aio.reap(many, many.size()) == 1);
+        REQUIRE(many[0].res.error().value() == EBADF);
+        REQUIRE(aio.in_flight() == 0);
+    }
+}
+
+TEST_CASE("Coroutine front-end")
+{
+    auto              fsut   = ext4UnderTest::Builder {}.set_automount().create();
+    auto&             vfs    = fsut->get();
+    const auto        path   = test_volume0_name / "file";
+    const std::string data   = "coroutine content";
+    const auto        caller = std::this_thread::get_id();
+    ManualExecutor    completion;
+
+    SECTION("operations complete on the executor chosen by the caller")
+    {
+        ThreadPoolExecutor  io {2};
+        AsyncFS             afs {vfs, io};
+        std::string         read_back(data.size(), '\0');
+        result<int>         opened {error(EBADF)};
+        result<std::size_t> written {error(EBADF)};
+        result<std::size_t> read {error(EBADF)};
+        bool                finished {false};
+        bool                same_thread {true};
+
+        auto task = [&]() -> detached {
+            opened      = co_await afs.async_open(path, O_RDWR | O_CREAT, 0644, completion);
+            same_thread = same_thread and std::this_thread::get_id() == caller;
+            if (opened) {
+                written     = co_await afs.async_write(*opened, data, completion);
+                same_thread = same_thread and std::this_thread::get_id() == caller;
+                std::ignore = vfs.lseek(*opened, 0, SEEK_SET);
+                read        = co_await afs.async_read(*opened, read_back, completion);
+                same_thread = same_thread and std::this_thread::get_id() == caller;
+            }
+            finished = true;
+        };
+        task();
+        while (not finished) { completion.run_one_batch(); }
+
+        REQUIRE(same_thread);
+        REQUIRE(opened);
+        REQUIRE(written.value() == data.size());
+        REQUIRE(read.value() == data.size());
+        REQUIRE(read_back == data);
+        REQUIRE(not vfs.close(*opened));
+    }
+
+    SECTION("cancellation of a queued operation")
+    {
+        ManualExecutor io;
+        AsyncFS        afs {vfs, io};
+        const auto     fd = vfs.open(path, O_RDWR | O_CREAT, 0644);
+        REQUIRE(fd);
+
+        std::stop_source                   stop;
+        std::optional<result<std::size_t>> written;
+        auto                               task = [&]() -> detached { written = co_await afs.async_write(*fd, data, completion, stop.get_token()); };
+        task();
+        REQUIRE(not written);
+
+        stop.request_stop();
+        REQUIRE(completion.run_pending() == 1);
+        REQUIRE(written);
+        REQUIRE(written->error().value() == ECANCELED);
+
+        /// Operation was withdrawn, running the I/O executor must not touch the file anymore
+        REQUIRE(io.run_pending() == 1);
+        struct stat st {};
+        REQUIRE(not vfs.fstat(*fd, st));
+        REQUIRE(st.st_size == 0);
+        REQUIRE(not vfs.close(*fd));
+    }
+
+    SECTION("cancellation racing with suspension")
+    {
+        ManualExecutor io;
+        InlineExecutor resumer;
+        AsyncFS        afs {vfs, io};
+        const auto     fd = vfs.open(path, O_RDWR | O_CREAT, 0644);
+        REQUIRE(fd);
+
+        /// Stop requested while the caller is inside await_suspend resumes the coroutine, and destroys its awaitable, before await_suspend returns
+        std::atomic_int finished {0};
+        for (int i = 0; i < 2000; ++i) {
+            std::stop_source stop;
+            std::atomic_bool go {false};
+            std::atomic_bool cancelled {false};
+            /// Delay is swept over the iterations so that stop lands anywhere from before to after the suspension
+            std::jthread stopper {[&, delay = i % 200] {
+                while (not go) { std::this_thread::yield(); }
+                for (std::atomic_int spin {0}; spin < delay * 10; ++spin) {}
+                stop.request_stop();
+            }};
+            /// Counter is passed as a parameter, the closure is gone as soon as the loop observes the increment
+            auto task = [&](std::atomic_int& done) -> detached {
+                const auto written = co_await afs.async_write(*fd, data, resumer, stop.get_token());
+                cancelled          = not written and written.error().value() == ECANCELED;
+                ++done;
+                done.notify_one();
+            };
+            go = true;
+            task(finished);
+            for (auto done = finished.load(); done != i + 1; done = finished.load()) { finished.wait(done); }
+            REQUIRE(cancelled);
+        }
+        /// Withdrawn operations leave the file untouched
+        io.run_pending();
+        struct stat st {};
+        REQUIRE(not vfs.fstat(*fd, st));
+        REQUIRE(st.st_size == 0);
+        REQUIRE(not vfs.close(*fd));
+    }
+
+    SECTION("already cancelled operation doesn't suspend")
+    {
+        ManualExecutor   io;
+        AsyncFS          afs {vfs, io};
+        std::stop_source stop;
+        stop.request_stop();
+
+        std::optional<result<int>> opened;
+        auto                       task = [&]() -> detached { opened = co_await afs.async_open(path, O_RDWR | O_CREAT, 0644, stop.get_token()); };
+        task();
+        REQUIRE(opened);
+        REQUIRE(opened->error().value() == ECANCELED);
+        REQUIRE(io.run_pending() == 0);
+    }
+}
+
+TEST_CASE("Coroutines vs blocking calls", "[.][benchmark]")
+{
+    auto  fsut = ext4UnderTest::Builder {}.set_automount().set_blockdev_latency(std::chrono::microseconds {50}).create();
+    auto& vfs  = fsut->get();
+
+    const auto                         threads = std::max(2U, std::thread::hardware_concurrency());
+    std::vector<std::filesystem::path> paths;
+    const std::vector<char>            content(bench_file_size, 'x');
+    for (std::size_t i = 0; i < threads; ++i) {
+        paths.push_back(test_volume0_name / ("file" + std::to_string(i)));
+        const auto fd = vfs.open(paths.back(), O_WRONLY | O_CREAT, 0644);
+        REQUIRE(fd);
+        REQUIRE(vfs.write(*fd, content.data(), content.size()).value() == content.size());
+        REQUIRE(not vfs.close(*fd));
+    }
+
+    BENCHMARK("blocking calls, threads: " + std::to_string(threads))
+    {
+        std::atomic_size_t errors {};
+        {
+            std::vector<std::jthread> workers;
+            for (const auto& path : paths) {
+                workers.emplace_back([&] {
+                    std::vector<char> buffer(bench_chunk_size);
+                    const auto        fd = vfs.open(path, O_RDONLY, 0);
+                    if (not fd) {
+                        ++errors;
+                        return;
+                    }
+                    for (std::size_t offset = 0; offset < bench_file_size; offset += bench_chunk_size) {
+                        if (vfs.read(*fd, buffer.data(), buffer.size()) != bench_chunk_size) { ++errors; }
+                    }
+                    std::ignore = vfs.close(*fd);
+                });
+            }
+        }
+        return errors.load();
+    };
+
+    ThreadPoolExecutor io {threads};
+    AsyncFS            afs {vfs, io};
+    BENCHMARK("coroutines on a single thread, I/O executor threads: " + std::to_string(threads))
+    {
+        ManualExecutor     completion;
+        std::atomic_size_t errors {};
+        std::atomic_size_t done {};
+        for (const auto& path : paths) { read_file(vfs, afs, completion, path, errors, done); }
+        while (done != paths.size()) { completion.run_one_batch(); }
+        return errors.load();
+    };
+}
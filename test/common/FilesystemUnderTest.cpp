@@ -31,40 +31,66 @@ namespace vfs::tests {
         return ret;
     }
 
-    VirtualFS& FilesystemUnderTest::get() const { return *vfs; }
-    VirtualFS& FilesystemUnderTest::operator->() { return *vfs; }
-    Disk&      FilesystemUnderTest::get_disk() const { return *disk; }
+    VirtualFS&      FilesystemUnderTest::get() const { return *vfs; }
+    VirtualFS&      FilesystemUnderTest::operator->() { return *vfs; }
+    Disk&           FilesystemUnderTest::get_disk() const { return *disk; }
+    RAMBlockDevice& FilesystemUnderTest::get_blockdev() const { return *block_device; }
 
     ext4UnderTest::Builder& ext4UnderTest::Builder::with_multipartition()
     {
         multipartition = true;
         return *this;
     }
+    ext4UnderTest::Builder& ext4UnderTest::Builder::set_partition_size(const std::size_t sectors)
+    {
+        partition_sectors = sectors;
+        return *this;
+    }
+    ext4UnderTest::Builder& ext4UnderTest::Builder::set_ext_type(const tools::mkfs::ext_type type)
+    {
+        ext_type = type;
+        return *this;
+    }
+    ext4UnderTest::Builder& ext4UnderTest::Builder::set_dir_index(const bool enable)
+    {
+        dir_index = enable;
+        return *this;
+    }
+    ext4UnderTest::Builder& ext4UnderTest::Builder::set_max_open_files(const std::size_t count)
+    {
+        max_files = count;
+        return *this;
+    }
     std::unique_ptr<FilesystemUnderTest> ext4UnderTest::Builder::create()
     {
         auto instance = std::unique_ptr<ext4UnderTest>(new ext4UnderTest());
 
         instance->disk_mngr    = std::make_unique<DiskManager>();
-        instance->block_device = std::make_unique<RAMBlockDevice>(blockdev_size);
+        instance->block_device = std::make_unique<RAMBlockDevice>(blockdev_size, blockdev_latency);
         tools::fdisk::erase_mbr(*instance->block_device);
         tools::fdisk::create_mbr(*instance->block_device);
 
-        write_partition_entry(*instance->block_device, layout::partition_0_conf);
+        auto partition_0_conf = layout::partition_0_conf;
+        if (partition_sectors != 0) { partition_0_conf.num_sectors = partition_sectors; }
+        write_partition_entry(*instance->block_device, partition_0_conf);
         if (multipartition) { write_partition_entry(*instance->block_device, layout::partition_1_conf); }
 
         auto ret = instance->disk_mngr->register_device(*instance->block_device);
         if (not ret) { throw std::runtime_error {"Failed to register block device within disk manager"}; }
         instance->disk = *ret;
 
-        auto part = instance->disk->borrow_partition(0);
-        mkext(*part, layout::partition_0_ext, tools::mkfs::ext_type::ext4);
+        auto part       = instance->disk->borrow_partition(0);
+        auto ext_params = layout::partition_0_ext;
+        ext_params.dir_index = dir_index;
+        mkext(*part, ext_params, ext_type);
 
         if (multipartition) {
             auto spart = instance->disk->borrow_partition(1);
             mkext(*spart, layout::partition_1_ext, tools::mkfs::ext_type::ext4);
         }
 
-        instance->vfs = std::make_unique<VirtualFS>(*instance->disk_mngr, std::make_unique<Stream>());
+        instance->max_files = max_files;
+        instance->vfs       = std::make_unique<VirtualFS>(*instance->disk_mngr, std::make_unique<Stream>(), max_files);
         std::ignore   = instance->vfs->register_filesystem(fstype::ext4);
         if (automount) {
 
@@ -75,7 +101,7 @@ namespace vfs::tests {
     }
     void ext4UnderTest::reload()
     {
-        vfs         = std::make_unique<VirtualFS>(*disk_mngr, std::make_unique<Stream>());
+        vfs         = std::make_unique<VirtualFS>(*disk_mngr, std::make_unique<Stream>(), max_files);
         std::ignore = vfs->register_filesystem(fstype::ext4);
         std::ignore = vfs->mount_all();
     }
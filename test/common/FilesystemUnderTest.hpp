@@ -26,9 +26,10 @@ namespace vfs::tests {
     public:
         virtual ~FilesystemUnderTest() = default;
 
-        VirtualFS& get() const;
-        VirtualFS& operator->();
-        Disk&      get_disk() const;
+        VirtualFS&      get() const;
+        VirtualFS&      operator->();
+        Disk&           get_disk() const;
+        RAMBlockDevice& get_blockdev() const;
 
         virtual void reload() = 0;
 
@@ -46,10 +47,12 @@ namespace vfs::tests {
 
             Derived& set_automount();
             Derived& set_blockdev_size(std::size_t size);
+            Derived& set_blockdev_latency(std::chrono::microseconds latency);
 
         protected:
-            bool        automount {};
-            std::size_t blockdev_size {128 * 1024 * 1024};
+            bool                      automount {};
+            std::size_t               blockdev_size {128 * 1024 * 1024};
+            std::chrono::microseconds blockdev_latency {};
         };
     };
     template <typename Derived> Derived& FilesystemUnderTest::builder_base<Derived>::set_automount()
@@ -63,6 +66,12 @@ namespace vfs::tests {
         return static_cast<Derived&>(*this);
     }
 
+    template <typename Derived> Derived& FilesystemUnderTest::builder_base<Derived>::set_blockdev_latency(const std::chrono::microseconds latency)
+    {
+        blockdev_latency = latency;
+        return static_cast<Derived&>(*this);
+    }
+
     class ext4UnderTest : public FilesystemUnderTest {
     public:
         class Builder : public builder_base<Builder> {
@@ -74,16 +83,26 @@ namespace vfs::tests {
             };
 
             Builder& with_multipartition();
+            Builder& set_partition_size(std::size_t sectors);
+            Builder& set_ext_type(tools::mkfs::ext_type type);
+            Builder& set_dir_index(bool enable);
+            Builder& set_max_open_files(std::size_t count);
 
             std::unique_ptr<FilesystemUnderTest> create() override;
 
         private:
-            bool multipartition {};
+            bool                  multipartition {};
+            std::size_t           partition_sectors {}; ///< Size of the first partition, the layout's one if not set
+            tools::mkfs::ext_type ext_type {tools::mkfs::ext_type::ext4};
+            bool                  dir_index {true}; ///< Format the first partition with hashed directory index
+            std::size_t           max_files {max_open_files};
         };
 
         void reload() override;
 
     private:
         ext4UnderTest() = default;
+
+        std::size_t max_files {max_open_files};
     };
 } // namespace vfs::tests
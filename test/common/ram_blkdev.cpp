@@ -2,10 +2,12 @@
 
 #include <cassert>
 #include <cstring>
+#include <thread>
 
 namespace vfs::tests {
-    RAMBlockDevice::RAMBlockDevice(const std::size_t total_size)
+    RAMBlockDevice::RAMBlockDevice(const std::size_t total_size, const std::chrono::microseconds latency)
         : total_size(total_size)
+        , latency(latency)
         , memory(std::make_unique<std::byte[]>(total_size))
     {
     }
@@ -23,7 +25,10 @@ namespace vfs::tests {
 
         assert((dst_addr + to_write) <= &memory[total_size]);
 
+        if (latency.count() != 0) { std::this_thread::sleep_for(latency); }
+
         memcpy(dst_addr, src_addr, to_write);
+        ++write_count;
         return {};
     }
     std::error_code RAMBlockDevice::read(std::byte& buf, const sector_t lba, const std::size_t count)
@@ -34,6 +39,8 @@ namespace vfs::tests {
 
         assert((src_addr + to_read) <= &memory[total_size]);
 
+        if (latency.count() != 0) { std::this_thread::sleep_for(latency); }
+
         memcpy(dst_addr, src_addr, to_read);
         return {};
     }
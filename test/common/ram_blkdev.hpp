@@ -2,13 +2,19 @@
 
 #include <vfs/blockdev.hpp>
 
+#include <atomic>
+#include <chrono>
 #include <memory>
 
 namespace vfs::tests {
 
     class RAMBlockDevice : public BlockDevice {
     public:
-        explicit RAMBlockDevice(std::size_t total_size);
+        /**
+         * @param total_size size of the device in bytes
+         * @param latency delay injected into every read/write request to emulate a real storage device
+         */
+        explicit RAMBlockDevice(std::size_t total_size, std::chrono::microseconds latency = {});
 
         [[nodiscard]] std::error_code     probe() override;
         [[nodiscard]] std::error_code     flush() override;
@@ -18,11 +24,16 @@ namespace vfs::tests {
         [[nodiscard]] result<sector_t>    get_sector_count() const override;
         [[nodiscard]] std::string         get_name() const override;
 
+        /// Number of write requests served so far
+        [[nodiscard]] std::size_t get_write_count() const { return write_count; }
+
     private:
-        static constexpr std::size_t sector_size = 512;
-        const std::size_t            total_size {};
+        static constexpr std::size_t    sector_size = 512;
+        const std::size_t               total_size {};
+        const std::chrono::microseconds latency {};
 
-        bool                         initialized {false};
-        std::unique_ptr<std::byte[]> memory;
+        bool                            initialized {false};
+        std::unique_ptr<std::byte[]>    memory;
+        std::atomic_size_t              write_count {};
     };
 } // namespace vfs::tests
@@ -5,6 +5,11 @@
 #include <sys/stat.h>
 #include <catch2/catch_all.hpp>
 
+#include <array>
+#include <set>
+#include <string>
+#include <vector>
+
 using namespace vfs::tests;
 
 TEMPLATE_PRODUCT_TEST_CASE("Directory related API", "", (initializer), (ext4_initializer))
@@ -141,6 +146,195 @@ TEST_CASE("Directory related API: ext4 specific")
         }
     }
 }
+
+TEST_CASE("Directory related API: hashed directory index")
+{
+    using namespace vfs::tests;
+    constexpr std::size_t entries = 1500;
+    const auto            name    = [](const std::size_t i) { return "entry_" + std::to_string(i); };
+
+    /// Without dir_index at mkfs time the root directory starts linear, mount enables the feature and the root is converted once it outgrows a block
+    const auto dir_index = GENERATE(true, false);
+    INFO("dir_index at mkfs: " << dir_index);
+    auto  fsut = ext4UnderTest::Builder {}.set_dir_index(dir_index).set_automount().create();
+    auto* vfs  = &fsut->get();
+
+    for (std::size_t i = 0; i < entries; ++i) {
+        if (i % 10 == 0) {
+            REQUIRE(not vfs->mkdir(test_volume0_name / name(i), 0777));
+        } else {
+            auto fd = vfs->open(test_volume0_name / name(i), O_CREAT | O_WRONLY, 0);
+            REQUIRE(fd);
+            REQUIRE(not vfs->close(*fd));
+        }
+    }
+
+    const auto verify = [&](const std::size_t step) {
+        for (std::size_t i = 0; i < entries; ++i) {
+            struct stat st {};
+            const auto  err = vfs->stat(test_volume0_name / name(i), st);
+            if (i % step != 0) {
+                REQUIRE(err == vfs::from_errno(ENOENT));
+                continue;
+            }
+            REQUIRE(not err);
+            REQUIRE((st.st_mode & S_IFMT) == (i % 10 == 0 ? S_IFDIR : S_IFREG));
+        }
+
+        /// Every entry is listed exactly once
+        auto dirh = vfs->diropen(test_volume0_name);
+        REQUIRE(dirh);
+        std::set<std::string> listed;
+        std::filesystem::path entry;
+        struct stat           st {};
+        while (not vfs->dirnext(*dirh.value(), entry, st)) { REQUIRE(listed.insert(entry.string()).second); }
+        REQUIRE(not vfs->dirclose(*dirh.value()));
+        REQUIRE(listed.size() == (entries + step - 1) / step + 3);
+        REQUIRE(listed.count("."));
+        REQUIRE(listed.count(".."));
+        REQUIRE(listed.count("lost+found"));
+    };
+    verify(1);
+
+    for (std::size_t i = 1; i < entries; i += 2) { REQUIRE(not vfs->unlink(test_volume0_name / name(i))); }
+    verify(2);
+
+    fsut->reload();
+    vfs = &fsut->get();
+    verify(2);
+
+    /// Subdirectories keep their parent
+    struct stat parent {};
+    struct stat st {};
+    REQUIRE(not vfs->stat(test_volume0_name, parent));
+    REQUIRE(not vfs->stat(test_volume0_name / name(10) / "..", st));
+    REQUIRE(st.st_ino == parent.st_ino);
+}
+TEST_CASE("Directory related API: batched dirnext")
+{
+    using namespace vfs::tests;
+    constexpr std::size_t files = 20;
+    const auto            dir   = test_volume0_name / "batch";
+
+    auto  fsut = ext4UnderTest::Builder {}.set_automount().create();
+    auto& vfs  = fsut->get();
+
+    REQUIRE(not vfs.mkdir(dir, 0777));
+    REQUIRE(not vfs.mkdir(dir / "sub", 0777));
+    for (std::size_t i = 0; i < files; ++i) {
+        auto fd = vfs.open(dir / ("file_" + std::to_string(i)), O_CREAT | O_WRONLY, 0);
+        REQUIRE(fd);
+        const std::string data(i * 100, 'x');
+        REQUIRE(vfs.write(*fd, data.data(), data.size()) == data.size());
+        REQUIRE(not vfs.close(*fd));
+    }
+    REQUIRE(not vfs.symlink(dir / "file_0", dir / "link"));
+
+    const auto full_stat = GENERATE(true, false);
+    INFO("full stat: " << full_stat);
+
+    auto dirh = vfs.diropen(dir);
+    REQUIRE(dirh);
+
+    /// Batch size not dividing the number of entries, the last batch is partial
+    std::array<vfs::DirEntry, 7> batch {};
+    std::set<std::string>        listed;
+    while (true) {
+        const auto count = vfs.dirnext_batch(*dirh.value(), batch, full_stat);
+        REQUIRE(count);
+        if (*count == 0) { break; }
+        REQUIRE(*count <= batch.size());
+
+        for (std::size_t i = 0; i < *count; ++i) {
+            const auto& entry = batch[i];
+            const auto  name  = std::string {entry.get_name()};
+            REQUIRE(listed.insert(name).second);
+            if (name == "." or name == "..") { continue; }
+
+            struct stat st {};
+            REQUIRE(not vfs.stat(dir / name, st));
+            REQUIRE(entry.st.st_ino == st.st_ino);
+            REQUIRE((entry.st.st_mode & S_IFMT) == (st.st_mode & S_IFMT));
+            if (full_stat) {
+                REQUIRE(entry.st.st_mode == st.st_mode);
+                REQUIRE(entry.st.st_size == st.st_size);
+                REQUIRE(entry.st.st_nlink == st.st_nlink);
+                REQUIRE(entry.st.st_mtime == st.st_mtime);
+            }
+        }
+    }
+    REQUIRE(listed.size() == files + 4);
+    REQUIRE(listed.count("link"));
+
+    /// End of directory is sticky until the handle is rewound
+    REQUIRE(vfs.dirnext_batch(*dirh.value(), batch, full_stat) == 0U);
+    REQUIRE(not vfs.dirreset(*dirh.value()));
+    REQUIRE(vfs.dirnext_batch(*dirh.value(), batch, full_stat) == batch.size());
+    REQUIRE(batch[0].get_name() == ".");
+    REQUIRE(not vfs.dirclose(*dirh.value()));
+}
+
+TEST_CASE("Directory related API: dirtell and dirseek")
+{
+    using namespace vfs::tests;
+    constexpr std::size_t files = 300;
+
+    auto  fsut = ext4UnderTest::Builder {}.set_automount().create();
+    auto& vfs  = fsut->get();
+
+    /// Large enough for a hashed directory of several leaf blocks
+    for (std::size_t i = 0; i < files; ++i) {
+        auto fd = vfs.open(test_volume0_name / ("a_somewhat_longer_file_name_" + std::to_string(i)), O_CREAT | O_WRONLY, 0);
+        REQUIRE(fd);
+        REQUIRE(not vfs.close(*fd));
+    }
+
+    auto dirh = vfs.diropen(test_volume0_name);
+    REQUIRE(dirh);
+    REQUIRE(vfs.dirtell(*dirh.value()) == 0);
+
+    /// Cookie of an entry is the position following the previous one
+    std::vector<std::string>      names;
+    std::vector<off_t>            cookies {0};
+    std::array<vfs::DirEntry, 16> batch {};
+    while (true) {
+        const auto count = vfs.dirnext_batch(*dirh.value(), batch);
+        REQUIRE(count);
+        if (*count == 0) { break; }
+        for (std::size_t i = 0; i < *count; ++i) {
+            names.emplace_back(batch[i].get_name());
+            REQUIRE(batch[i].cookie > cookies.back());
+            cookies.push_back(batch[i].cookie);
+        }
+        REQUIRE(vfs.dirtell(*dirh.value()) == cookies.back());
+    }
+    REQUIRE(names.size() == files + 3);
+
+    const auto next_name = [&] {
+        std::filesystem::path name;
+        struct stat           st {};
+        REQUIRE(not vfs.dirnext(*dirh.value(), name, st));
+        return name.string();
+    };
+    for (const std::size_t idx : {250U, 3U, 0U, 150U, 302U}) {
+        REQUIRE(not vfs.dirseek(*dirh.value(), cookies[idx]));
+        REQUIRE(vfs.dirtell(*dirh.value()) == cookies[idx]);
+        REQUIRE(next_name() == names[idx]);
+        REQUIRE(vfs.dirtell(*dirh.value()) == cookies[idx + 1]);
+    }
+
+    /// Seeking to the end, or to an entry removed since, continues with what follows
+    REQUIRE(not vfs.dirseek(*dirh.value(), cookies.back()));
+    REQUIRE(vfs.dirnext_batch(*dirh.value(), batch) == 0U);
+    REQUIRE(not vfs.unlink(test_volume0_name / names[100]));
+    REQUIRE(not vfs.dirseek(*dirh.value(), cookies[100]));
+    REQUIRE(next_name() == names[101]);
+
+    REQUIRE(vfs.dirseek(*dirh.value(), 2).value() == EINVAL);
+    REQUIRE(vfs.dirseek(*dirh.value(), -1).value() == EINVAL);
+    REQUIRE(not vfs.dirclose(*dirh.value()));
+}
+
 #if 0
 TEMPLATE_PRODUCT_TEST_CASE("Directory related API: vfat specific", "", (initializer), (fat_initializer))
 {
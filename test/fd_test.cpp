@@ -4,8 +4,13 @@
 
 #include <fcntl.h>
 #include <sys/stat.h>
+#include <sys/statvfs.h>
 #include <catch2/catch_all.hpp>
 
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
 using namespace vfs::tests;
 using namespace vfs;
 
@@ -105,6 +110,100 @@ TEMPLATE_PRODUCT_TEST_CASE("File descriptor related API", "", initializer, ext4_
         REQUIRE(fs->get().read(*fd, read_string.data(), 0).value() == 0);
     }
 
+    SECTION("zero-copy pinned reads")
+    {
+        constexpr std::size_t block_size = 4096;
+        auto                  data       = std::vector<char>(4 * block_size);
+        for (std::size_t i = 0; i < data.size(); ++i) { data[i] = static_cast<char>(i * 7 + i / block_size); }
+        const auto pinned_blocks = [&] { return fs->get().stat_parts_of(test_volume0_name)->cache.pinned; };
+        const auto equals        = [](const PinnedData& pinned, const char* expected) { return std::memcmp(pinned.data().data(), expected, pinned.size()) == 0; };
+
+        auto fd = fs->get().open(test_volume0_name / "pinned", O_RDWR | O_CREAT, 0);
+        REQUIRE(fd);
+        REQUIRE(fs->get().write(*fd, data.data(), data.size()).value() == data.size());
+        /// Two blocks of a hole at the end
+        REQUIRE(not fs->get().ftruncate(*fd, 6 * block_size));
+        REQUIRE(fs->get().lseek(*fd, 100, SEEK_SET).value() == 100);
+
+        /// Data is returned up to the end of its block, the file position doesn't move
+        {
+            auto pinned = fs->get().read_pinned(*fd, 10, data.size());
+            REQUIRE(pinned);
+            REQUIRE(pinned->size() == block_size - 10);
+            REQUIRE(equals(*pinned, data.data() + 10));
+            REQUIRE(pinned_blocks() == 1);
+
+            auto part = fs->get().read_pinned(*fd, block_size + 5, 20);
+            REQUIRE(part);
+            REQUIRE(part->size() == 20);
+            REQUIRE(equals(*part, data.data() + block_size + 5));
+            REQUIRE(pinned_blocks() == 2);
+
+            /// Ownership of a pin moves along with the object
+            auto moved = std::move(*part);
+            REQUIRE(part->empty());
+            REQUIRE(moved.size() == 20);
+            moved.reset();
+            REQUIRE(pinned_blocks() == 1);
+        }
+        REQUIRE(pinned_blocks() == 0);
+        REQUIRE(fs->get().lseek(*fd, 0, SEEK_CUR).value() == 100);
+
+        /// Holes read as zeros without pinning anything, the end of file is empty
+        {
+            auto hole = fs->get().read_pinned(*fd, 5 * block_size, block_size);
+            REQUIRE(hole);
+            REQUIRE(hole->size() == block_size);
+            REQUIRE(std::all_of(hole->data().begin(), hole->data().end(), [](const std::byte b) { return b == std::byte {}; }));
+            REQUIRE(pinned_blocks() == 0);
+            REQUIRE(fs->get().read_pinned(*fd, 6 * block_size, 1)->empty());
+            REQUIRE(fs->get().read_pinned(*fd, 0, 0)->empty());
+        }
+
+        /// Pinned blocks can't be evicted, at most a half of the block cache is pinned at once
+        {
+            std::vector<PinnedData> pins;
+            for (std::size_t i = 0; i < 4; ++i) {
+                auto pinned = fs->get().read_pinned(*fd, static_cast<off_t>(i * block_size), block_size);
+                REQUIRE(pinned);
+                pins.push_back(std::move(*pinned));
+            }
+            REQUIRE(pinned_blocks() == 4);
+            REQUIRE(fs->get().read_pinned(*fd, 0, block_size) == error(ENOBUFS));
+
+            /// Pins outlive the descriptor, not the mount point
+            REQUIRE(not fs->get().close(*fd));
+            REQUIRE(fs->get().umount(test_volume0_name.native()) == from_errno(EBUSY));
+            for (std::size_t i = 0; i < pins.size(); ++i) {
+                REQUIRE(pins[i].size() == block_size);
+                REQUIRE(equals(pins[i], data.data() + i * block_size));
+            }
+        }
+        REQUIRE(pinned_blocks() == 0);
+
+        /// Blocks cached by pins follow writes made after they are released
+        fd = fs->get().open(test_volume0_name / "pinned", O_RDWR, 0);
+        REQUIRE(fd);
+        REQUIRE(fs->get().read_pinned(*fd, 0, block_size));
+        REQUIRE(fs->get().read_pinned(*fd, block_size, block_size));
+        std::fill_n(data.begin(), block_size + 10, 'x');
+        REQUIRE(fs->get().write(*fd, data.data(), block_size + 10).value() == block_size + 10);
+        auto pinned = fs->get().read_pinned(*fd, 0, block_size);
+        REQUIRE(pinned);
+        REQUIRE(equals(*pinned, data.data()));
+        pinned = fs->get().read_pinned(*fd, block_size, block_size);
+        REQUIRE(pinned);
+        REQUIRE(equals(*pinned, data.data() + block_size));
+        pinned->reset();
+
+        REQUIRE(fs->get().read_pinned(*fd + 500, 0, block_size) == error(EBADF));
+        REQUIRE(fs->get().read_pinned(*fd, -1, block_size) == error(EINVAL));
+        REQUIRE(not fs->get().close(*fd));
+        fd = fs->get().open(test_volume0_name / "pinned", O_WRONLY, 0);
+        REQUIRE(fs->get().read_pinned(*fd, 0, block_size) == error(EPERM));
+        REQUIRE(not fs->get().close(*fd));
+    }
+
     SECTION("fstat")
     {
         auto test_string = std::string {"test string"};
@@ -119,6 +218,16 @@ TEMPLATE_PRODUCT_TEST_CASE("File descriptor related API", "", initializer, ext4_
         REQUIRE(not fs->get().fstat(*fd, st));
         REQUIRE(st.st_size == static_cast<off_t>(test_string.size()));
 
+        /// fstat follows the opened inode, not its path
+        struct stat path_st {};
+        REQUIRE(not fs->get().stat(test_volume0_name / "test.txt", path_st));
+        REQUIRE(st.st_ino == path_st.st_ino);
+        REQUIRE(st.st_mode == path_st.st_mode);
+        REQUIRE(not fs->get().rename(test_volume0_name / "test.txt", test_volume0_name / "renamed.txt"));
+        REQUIRE(not fs->get().fstat(*fd, st));
+        REQUIRE(st.st_ino == path_st.st_ino);
+        REQUIRE(st.st_size == static_cast<off_t>(test_string.size()));
+
         /// wrong file descriptor
         REQUIRE(fs->get().fstat(*fd + 500, st) == from_errno(EBADF));
     }
@@ -251,6 +360,73 @@ TEMPLATE_PRODUCT_TEST_CASE("File descriptor related API", "", initializer, ext4_
             REQUIRE(not fs->get().close(*fd1));
             REQUIRE(not fs->get().close(*fd2));
         }
+
+        SECTION("descriptors of the same file share its inode")
+        {
+            const auto cache = [&fs] { return fs->get().stat_parts_of(test_volume0_name).value().cache; };
+
+            auto writer = fs->get().open(test_volume0_name / "test.txt", O_WRONLY | O_CREAT, 0);
+            auto reader = fs->get().open(test_volume0_name / "test.txt", O_RDONLY, 0);
+            auto other  = fs->get().open(test_volume0_name / "other.txt", O_WRONLY | O_CREAT, 0);
+            REQUIRE(writer);
+            REQUIRE(reader);
+            REQUIRE(other);
+            REQUIRE(cache().inodes == 2);
+
+            /// Size grown through one descriptor is seen by the other one at once
+            REQUIRE(fs->get().write(*writer, "test", 4).value() == 4);
+            REQUIRE(fs->get().lseek(*reader, 0, SEEK_END).value() == 4);
+            REQUIRE(fs->get().lseek(*reader, 0, SEEK_SET).value() == 0);
+
+            /// fstat is served from memory, the inode table isn't accessed
+            const auto before = cache();
+            struct stat st {};
+            for (int i = 0; i < 10; ++i) {
+                REQUIRE(not fs->get().fstat(*reader, st));
+                REQUIRE(st.st_size == 4);
+            }
+            const auto after = cache();
+            REQUIRE(after.hits + after.misses == before.hits + before.misses);
+
+            REQUIRE(not fs->get().close(*writer));
+            REQUIRE(not fs->get().close(*other));
+            REQUIRE(cache().inodes == 1);
+
+            char rd_buff[16] {};
+            REQUIRE(fs->get().read(*reader, rd_buff, sizeof(rd_buff)).value() == 4);
+            REQUIRE(std::string {"test"} == rd_buff);
+            REQUIRE(not fs->get().close(*reader));
+            REQUIRE(cache().inodes == 0);
+
+            /// Inode written back by the last descriptor is found by path
+            REQUIRE(not fs->get().stat(test_volume0_name / "test.txt", st));
+            REQUIRE(st.st_size == 4);
+        }
+    }
+    SECTION("descriptor table exhaustion")
+    {
+        std::vector<int> fds;
+        for (std::size_t i = 0; i < max_open_files; ++i) {
+            const auto fd = fs->get().open(test_volume0_name / ("test" + std::to_string(i) + ".txt"), O_WRONLY | O_CREAT, 0);
+            REQUIRE(fd);
+            fds.push_back(*fd);
+        }
+        REQUIRE(fs->get().open(test_volume0_name / "one_too_many.txt", O_WRONLY | O_CREAT, 0) == error(EMFILE));
+
+        /// Released descriptor is available again
+        REQUIRE(not fs->get().close(fds.back()));
+        REQUIRE(fs->get().close(fds.back()) == from_errno(EBADF));
+        REQUIRE(fs->get().open(test_volume0_name / "one_too_many.txt", O_WRONLY | O_CREAT, 0).value() == fds.back());
+
+        /// The lowest free descriptor is allocated, regardless of the order descriptors were released in
+        REQUIRE(not fs->get().close(fds[10]));
+        REQUIRE(not fs->get().close(fds[3]));
+        REQUIRE(not fs->get().close(fds[70]));
+        REQUIRE(fs->get().open(test_volume0_name / "test3.txt", O_WRONLY, 0).value() == fds[3]);
+        REQUIRE(fs->get().open(test_volume0_name / "test10.txt", O_WRONLY, 0).value() == fds[10]);
+        REQUIRE(fs->get().open(test_volume0_name / "test70.txt", O_WRONLY, 0).value() == fds[70]);
+
+        for (const auto fd : fds) { REQUIRE(not fs->get().close(fd)); }
     }
     SECTION("unlink/refcount")
     {
@@ -265,6 +441,202 @@ TEMPLATE_PRODUCT_TEST_CASE("File descriptor related API", "", initializer, ext4_
         REQUIRE(not fs->get().close(*fd));
         REQUIRE(fs->get().stat(test_volume0_name / "test.txt", st) == from_errno(ENOENT));
     }
+    SECTION("extent mapped files")
+    {
+        constexpr std::size_t block_size = 4096;
+        const auto            block      = [](const std::size_t i, const char tag) {
+            auto data = std::vector<char>(block_size, tag);
+            std::memcpy(data.data(), &i, sizeof i);
+            return data;
+        };
+
+        SECTION("contiguous file takes no mapping blocks")
+        {
+            auto fd = fs->get().open(test_volume0_name / "contiguous", O_WRONLY | O_CREAT, 0);
+            REQUIRE(fd);
+            for (std::size_t i = 0; i < 100; ++i) { REQUIRE(fs->get().write(*fd, block(i, 'c').data(), block_size).value() == block_size); }
+            REQUIRE(not fs->get().close(*fd));
+
+            struct stat st {};
+            REQUIRE(not fs->get().stat(test_volume0_name / "contiguous", st));
+            REQUIRE(st.st_blocks == 100 * block_size / 512);
+        }
+
+        SECTION("block runs cached by a descriptor follow truncation by another one")
+        {
+            const auto fill = [&](const std::filesystem::path& name, const char tag, const int flags) {
+                auto fd = fs->get().open(test_volume0_name / name, flags, 0);
+                REQUIRE(fd);
+                for (std::size_t i = 0; i < 64; ++i) { REQUIRE(fs->get().write(*fd, block(i, tag).data(), block_size).value() == block_size); }
+                REQUIRE(not fs->get().close(*fd));
+            };
+            fill("file", 'x', O_WRONLY | O_CREAT);
+
+            auto reader = fs->get().open(test_volume0_name / "file", O_RDONLY, 0);
+            REQUIRE(reader);
+            auto buf = std::vector<char>(block_size);
+            REQUIRE(fs->get().read(*reader, buf.data(), block_size).value() == block_size);
+
+            /// Blocks released by truncation are taken by another file, the file's data goes elsewhere
+            auto writer = fs->get().open(test_volume0_name / "file", O_RDWR, 0);
+            REQUIRE(writer);
+            REQUIRE(not fs->get().ftruncate(*writer, 0));
+            REQUIRE(not fs->get().close(*writer));
+            fill("other", 'o', O_WRONLY | O_CREAT);
+            fill("file", 'y', O_WRONLY);
+
+            REQUIRE(fs->get().lseek(*reader, 0, SEEK_SET).value() == 0);
+            for (std::size_t i = 0; i < 64; ++i) {
+                REQUIRE(fs->get().read(*reader, buf.data(), block_size).value() == block_size);
+                REQUIRE(buf == block(i, 'y'));
+            }
+            REQUIRE(not fs->get().close(*reader));
+        }
+
+        SECTION("interleaved appends to open files are preallocated in runs")
+        {
+            struct statvfs before {};
+            REQUIRE(not fs->get().stat_vfs(test_volume0_name, before));
+
+            auto a = fs->get().open(test_volume0_name / "a", O_WRONLY | O_CREAT, 0);
+            auto b = fs->get().open(test_volume0_name / "b", O_WRONLY | O_CREAT, 0);
+            REQUIRE(a);
+            REQUIRE(b);
+            for (std::size_t i = 0; i < 100; ++i) {
+                REQUIRE(fs->get().write(*a, block(i, 'a').data(), block_size).value() == block_size);
+                REQUIRE(fs->get().write(*b, block(i, 'b').data(), block_size).value() == block_size);
+            }
+            REQUIRE(not fs->get().close(*a));
+            REQUIRE(not fs->get().close(*b));
+
+            /// Both files fit the extents of the inode, the blocks preallocated beyond their ends are released on close
+            for (const auto* name : {"a", "b"}) {
+                struct stat st {};
+                REQUIRE(not fs->get().stat(test_volume0_name / name, st));
+                REQUIRE(st.st_blocks == 100 * block_size / 512);
+            }
+            struct statvfs after {};
+            REQUIRE(not fs->get().stat_vfs(test_volume0_name, after));
+            REQUIRE(before.f_bfree - after.f_bfree == 200);
+        }
+
+        SECTION("fragmented files grow and shrink the tree")
+        {
+            /// Interleaved appends of files closed right after, without preallocation, leave every block of both files in its own extent,
+            /// a root of 4 extents is split twice
+            constexpr std::size_t blocks = 1500;
+            struct statvfs        before {};
+            REQUIRE(not fs->get().stat_vfs(test_volume0_name, before));
+
+            for (std::size_t i = 0; i < blocks; ++i) {
+                for (const auto tag : {'a', 'b'}) {
+                    auto fd = fs->get().open(test_volume0_name / std::string(1, tag), O_WRONLY | O_CREAT | O_APPEND, 0);
+                    REQUIRE(fd);
+                    REQUIRE(fs->get().write(*fd, block(i, tag).data(), block_size).value() == block_size);
+                    REQUIRE(not fs->get().close(*fd));
+                }
+            }
+            auto a = fs->get().open(test_volume0_name / "a", O_RDWR, 0);
+            auto b = fs->get().open(test_volume0_name / "b", O_RDWR, 0);
+            REQUIRE(a);
+            REQUIRE(b);
+
+            const auto verify = [&](const int fd, const char tag, const std::size_t count) {
+                auto buf = std::vector<char>(block_size);
+                REQUIRE(fs->get().lseek(fd, 0, SEEK_SET).value() == 0);
+                for (std::size_t i = 0; i < count; ++i) {
+                    REQUIRE(fs->get().read(fd, buf.data(), block_size).value() == block_size);
+                    REQUIRE(buf == block(i, tag));
+                }
+                REQUIRE(fs->get().read(fd, buf.data(), block_size).value() == 0);
+            };
+            verify(*a, 'a', blocks);
+            verify(*b, 'b', blocks);
+
+            REQUIRE(not fs->get().ftruncate(*a, blocks / 3 * block_size));
+            verify(*a, 'a', blocks / 3);
+            verify(*b, 'b', blocks);
+
+            REQUIRE(not fs->get().close(*a));
+            REQUIRE(not fs->get().close(*b));
+            REQUIRE(not fs->get().unlink(test_volume0_name / "a"));
+            REQUIRE(not fs->get().unlink(test_volume0_name / "b"));
+
+            /// Data and tree blocks are all released
+            struct statvfs after {};
+            REQUIRE(not fs->get().stat_vfs(test_volume0_name, after));
+            REQUIRE(after.f_bfree == before.f_bfree);
+        }
+
+        SECTION("fallocated range reads as zeros until it's written")
+        {
+            struct statvfs before {};
+            REQUIRE(not fs->get().stat_vfs(test_volume0_name, before));
+
+            auto fd = fs->get().open(test_volume0_name / "prealloc", O_RDWR | O_CREAT, 0);
+            REQUIRE(fd);
+            REQUIRE(fs->get().fallocate(*fd, {}, 0, 0) == from_errno(EINVAL));
+            REQUIRE(not fs->get().fallocate(*fd, {}, 0, 64 * block_size));
+
+            struct stat st {};
+            REQUIRE(not fs->get().fstat(*fd, st));
+            REQUIRE(st.st_size == 64 * block_size);
+            REQUIRE(st.st_blocks == 64 * block_size / 512);
+
+            /// A write into the middle of a block converts it, the rest of it and its neighbours still read as zeros
+            const auto zeros = std::vector<char>(block_size, 0);
+            auto       buf   = std::vector<char>(block_size);
+            REQUIRE(fs->get().lseek(*fd, 10 * block_size + 100, SEEK_SET).value() == 10 * block_size + 100);
+            REQUIRE(fs->get().write(*fd, "data", 4).value() == 4);
+            REQUIRE(fs->get().lseek(*fd, 0, SEEK_SET).value() == 0);
+            for (std::size_t i = 0; i < 64; ++i) {
+                REQUIRE(fs->get().read(*fd, buf.data(), block_size).value() == block_size);
+                if (i == 10) {
+                    REQUIRE(std::memcmp(buf.data() + 100, "data", 4) == 0);
+                    std::memset(buf.data() + 100, 0, 4);
+                }
+                REQUIRE(buf == zeros);
+            }
+
+            /// Blocks reserved past the end of file are released by truncation
+            REQUIRE(not fs->get().fallocate(*fd, Flags {}.set(FallocFlags::keep_size), 64 * block_size, 16 * block_size));
+            REQUIRE(not fs->get().fstat(*fd, st));
+            REQUIRE(st.st_size == 64 * block_size);
+            REQUIRE(st.st_blocks == 80 * block_size / 512);
+            REQUIRE(not fs->get().ftruncate(*fd, 64 * block_size));
+            REQUIRE(not fs->get().fstat(*fd, st));
+            REQUIRE(st.st_blocks == 64 * block_size / 512);
+
+            REQUIRE(not fs->get().close(*fd));
+            REQUIRE(not fs->get().unlink(test_volume0_name / "prealloc"));
+            struct statvfs after {};
+            REQUIRE(not fs->get().stat_vfs(test_volume0_name, after));
+            REQUIRE(after.f_bfree == before.f_bfree);
+        }
+
+        SECTION("ftruncate growth is sparse")
+        {
+            auto fd = fs->get().open(test_volume0_name / "sparse", O_RDWR | O_CREAT, 0);
+            REQUIRE(fd);
+            REQUIRE(fs->get().write(*fd, block(0, 'x').data(), 100).value() == 100);
+            REQUIRE(not fs->get().ftruncate(*fd, 50));
+            REQUIRE(not fs->get().ftruncate(*fd, 100 * block_size));
+
+            struct stat st {};
+            REQUIRE(not fs->get().fstat(*fd, st));
+            REQUIRE(st.st_size == 100 * block_size);
+            REQUIRE(st.st_blocks == block_size / 512);
+
+            /// Bytes cut off before the file grew again read as zeros
+            auto expected = std::vector<char>(100 * block_size, 0);
+            std::memcpy(expected.data(), block(0, 'x').data(), 50);
+            auto buf = std::vector<char>(expected.size(), 1);
+            REQUIRE(fs->get().lseek(*fd, 0, SEEK_SET).value() == 0);
+            REQUIRE(fs->get().read(*fd, buf.data(), buf.size()).value() == buf.size());
+            REQUIRE(buf == expected);
+            REQUIRE(not fs->get().close(*fd));
+        }
+    }
     SECTION("timestamps")
     {
         struct stat st {};
@@ -277,3 +649,16 @@ TEMPLATE_PRODUCT_TEST_CASE("File descriptor related API", "", initializer, ext4_
         REQUIRE_THAT(st.st_atime, Catch::Matchers::WithinAbs(current_time, 1.0));
     }
 }
+
+TEST_CASE("Configurable descriptor limit")
+{
+    auto limited = ext4UnderTest::Builder {}.set_automount().set_max_open_files(2).create();
+    auto first   = limited->get().open(test_volume0_name / "a.txt", O_WRONLY | O_CREAT, 0);
+    auto second  = limited->get().open(test_volume0_name / "b.txt", O_WRONLY | O_CREAT, 0);
+    REQUIRE(first);
+    REQUIRE(second);
+    REQUIRE(*second == *first + 1);
+    REQUIRE(limited->get().open(test_volume0_name / "c.txt", O_WRONLY | O_CREAT, 0) == error(EMFILE));
+    REQUIRE(not limited->get().close(*first));
+    REQUIRE(not limited->get().close(*second));
+}
@@ -0,0 +1,261 @@
+#include "common/FilesystemUnderTest.hpp"
+#include "common/partition_layout.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <catch2/catch_all.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <set>
+#include <thread>
+#include <vector>
+
+using namespace vfs::tests;
+using namespace vfs;
+
+namespace {
+    constexpr std::size_t file_size  = 256 * 1024;
+    constexpr std::size_t chunk_size = 4096;
+
+    std::vector<char> make_content(const std::size_t seed)
+    {
+        std::vector<char> content(file_size);
+        for (std::size_t i = 0; i < content.size(); ++i) { content[i] = static_cast<char>((i * 31 + seed * 7) & 0xFF); }
+        return content;
+    }
+
+    std::filesystem::path file_name(const std::size_t index) { return test_volume0_name / ("file" + std::to_string(index) + ".bin"); }
+
+    void spawn_file(VirtualFS& vfs, const std::filesystem::path& path, const std::vector<char>& content)
+    {
+        const auto fd = vfs.open(path, O_WRONLY | O_CREAT, 0);
+        REQUIRE(fd);
+        REQUIRE(vfs.write(*fd, content.data(), content.size()).value() == content.size());
+        REQUIRE(not vfs.close(*fd));
+    }
+
+    /// Reader thread count scaled from 1 up to the number of available hardware threads
+    std::vector<std::size_t> thread_counts()
+    {
+        const auto               max = std::max(2U, std::thread::hardware_concurrency());
+        std::vector<std::size_t> counts;
+        for (std::size_t n = 1; n <= max; n *= 2) { counts.push_back(n); }
+        return counts;
+    }
+
+    /**
+     * Spawn given number of threads, each of them reading a whole separate file in chunks using its own descriptor
+     * @return number of errors(failed calls or content mismatches)
+     */
+    std::size_t read_concurrently(VirtualFS& vfs, const std::size_t threads, const std::vector<std::vector<char>>& contents)
+    {
+        std::atomic_size_t errors {};
+        {
+            std::vector<std::jthread> readers;
+            for (std::size_t t = 0; t < threads; ++t) {
+                readers.emplace_back([&, t] {
+                    const auto& expected = contents[t % contents.size()];
+                    const auto  fd       = vfs.open(file_name(t % contents.size()), O_RDONLY, 0);
+                    if (not fd) {
+                        ++errors;
+                        return;
+                    }
+                    std::vector<char> buffer(chunk_size);
+                    for (std::size_t offset = 0; offset < expected.size(); offset += chunk_size) {
+                        const auto ret = vfs.read(*fd, buffer.data(), buffer.size());
+                        if (not ret or *ret != chunk_size or not std::equal(buffer.begin(), buffer.end(), expected.begin() + static_cast<std::ptrdiff_t>(offset))) {
+                            ++errors;
+                        }
+                    }
+                    if (vfs.close(*fd)) { ++errors; }
+                });
+            }
+        }
+        return errors;
+    }
+
+    constexpr std::size_t stress_file_size  = 16 * 1024;
+    constexpr std::size_t stress_iterations = 32;
+
+    std::filesystem::path worker_dir(const std::size_t worker) { return test_volume0_name / ("worker" + std::to_string(worker)); }
+
+    struct stress_report {
+        std::size_t errors {};
+        std::size_t operations {};
+    };
+
+    /**
+     * Mix of namespace and data operations performed by a single worker within its own directory. Every iteration creates a file, writes it, reads it back,
+     * checks its size by both fstat and stat, renames it and removes every other file. Between iterations the worker also reads a file shared by all workers.
+     * Results of every call are verified, so any lost update or torn read is reported as an error.
+     */
+    stress_report stress_worker(VirtualFS& vfs, const std::size_t worker, const std::vector<char>& shared)
+    {
+        stress_report report;
+        const auto    check = [&report](const bool ok) {
+            ++report.operations;
+            if (not ok) { ++report.errors; }
+            return ok;
+        };
+
+        const auto dir = worker_dir(worker);
+        if (not check(not vfs.mkdir(dir, 0755))) { return report; }
+
+        std::vector<char> buffer(stress_file_size);
+        for (std::size_t i = 0; i < stress_iterations; ++i) {
+            const auto content  = make_content(worker * stress_iterations + i);
+            const auto tmp_name = dir / ("tmp" + std::to_string(i));
+            const auto name     = dir / ("file" + std::to_string(i));
+
+            const auto fd = vfs.open(tmp_name, O_RDWR | O_CREAT, 0644);
+            if (not check(fd.has_value())) { continue; }
+            const auto written = vfs.write(*fd, content.data(), stress_file_size);
+            check(written and *written == stress_file_size);
+            const auto pos = vfs.lseek(*fd, 0, SEEK_SET);
+            check(pos and *pos == 0);
+            const auto read = vfs.read(*fd, buffer.data(), buffer.size());
+            check(read and *read == stress_file_size and std::equal(buffer.begin(), buffer.end(), content.begin()));
+            struct stat st {};
+            check(not vfs.fstat(*fd, st) and static_cast<std::size_t>(st.st_size) == stress_file_size);
+            check(not vfs.close(*fd));
+
+            check(not vfs.stat(tmp_name, st) and static_cast<std::size_t>(st.st_size) == stress_file_size);
+            check(not vfs.rename(tmp_name, name));
+            check(vfs.stat(tmp_name, st) == std::make_error_code(std::errc::no_such_file_or_directory));
+            if (i % 2 == 1) { check(not vfs.unlink(name)); }
+
+            const auto shared_fd = vfs.open(file_name(0), O_RDONLY, 0);
+            if (not check(shared_fd.has_value())) { continue; }
+            const auto shared_read = vfs.read(*shared_fd, buffer.data(), buffer.size());
+            check(shared_read and *shared_read == buffer.size() and std::equal(buffer.begin(), buffer.end(), shared.begin()));
+            check(not vfs.close(*shared_fd));
+        }
+        return report;
+    }
+
+    /// Verify that the directory of given worker contains exactly the files it was supposed to leave, with the expected contents
+    std::size_t verify_worker(VirtualFS& vfs, const std::size_t worker)
+    {
+        std::size_t           errors {};
+        std::set<std::string> expected;
+        for (std::size_t i = 0; i < stress_iterations; i += 2) { expected.insert("file" + std::to_string(i)); }
+
+        std::set<std::string> found;
+        auto                  dir = vfs.diropen(worker_dir(worker));
+        if (not dir) { return 1; }
+        std::filesystem::path name;
+        struct stat           st {};
+        while (not vfs.dirnext(**dir, name, st)) {
+            if (name != "." and name != "..") { found.insert(name); }
+        }
+        std::ignore = vfs.dirclose(**dir);
+        if (found != expected) { ++errors; }
+
+        std::vector<char> buffer(stress_file_size);
+        for (std::size_t i = 0; i < stress_iterations; i += 2) {
+            const auto content = make_content(worker * stress_iterations + i);
+            const auto fd      = vfs.open(worker_dir(worker) / ("file" + std::to_string(i)), O_RDONLY, 0);
+            if (not fd) {
+                ++errors;
+                continue;
+            }
+            const auto ret = vfs.read(*fd, buffer.data(), buffer.size());
+            if (not ret or *ret != stress_file_size or not std::equal(buffer.begin(), buffer.end(), content.begin())) { ++errors; }
+            std::ignore = vfs.close(*fd);
+        }
+        return errors;
+    }
+
+    /// Run the stress mix with given number of workers. Workers' directories are numbered starting from 'first_worker' to keep subsequent runs apart.
+    stress_report stress_concurrently(VirtualFS& vfs, const std::size_t first_worker, const std::size_t workers, const std::vector<char>& shared)
+    {
+        std::atomic_size_t errors {};
+        std::atomic_size_t operations {};
+        {
+            std::vector<std::jthread> threads;
+            for (std::size_t w = first_worker; w < first_worker + workers; ++w) {
+                threads.emplace_back([&, w] {
+                    const auto report = stress_worker(vfs, w, shared);
+                    errors += report.errors;
+                    operations += report.operations;
+                });
+            }
+        }
+        return {errors, operations};
+    }
+} // namespace
+
+TEST_CASE("Multithreading: concurrent readers of the same mount point")
+{
+    auto fsut = ext4UnderTest::Builder {}.set_automount().create();
+
+    const auto                     counts = thread_counts();
+    std::vector<std::vector<char>> contents;
+    for (std::size_t i = 0; i < counts.back(); ++i) {
+        contents.push_back(make_content(i));
+        spawn_file(fsut->get(), file_name(i), contents.back());
+    }
+
+    for (const auto threads : counts) {
+        CAPTURE(threads);
+        REQUIRE(read_concurrently(fsut->get(), threads, contents) == 0);
+    }
+}
+
+TEST_CASE("Multithreading: reader scaling", "[.][benchmark]")
+{
+    auto fsut = ext4UnderTest::Builder {}.set_automount().create();
+
+    const auto                     counts = thread_counts();
+    std::vector<std::vector<char>> contents;
+    for (std::size_t i = 0; i < counts.back(); ++i) {
+        contents.push_back(make_content(i));
+        spawn_file(fsut->get(), file_name(i), contents.back());
+    }
+
+    /// Every reader consumes the same amount of data, so perfect scaling keeps the time per run constant across thread counts
+    for (const auto threads : counts) {
+        BENCHMARK("256KiB per reader, readers: " + std::to_string(threads)) { return read_concurrently(fsut->get(), threads, contents); };
+    }
+}
+
+TEST_CASE("Multithreading: stress mix of namespace and data operations")
+{
+    auto fsut = ext4UnderTest::Builder {}.set_automount().create();
+
+    const auto shared = make_content(0);
+    spawn_file(fsut->get(), file_name(0), shared);
+
+    /// Oversubscribe the CPU on purpose, preemption in the middle of an operation is what exposes races
+    const auto workers = std::max<std::size_t>(4, std::thread::hardware_concurrency());
+    const auto report  = stress_concurrently(fsut->get(), 0, workers, shared);
+    REQUIRE(report.errors == 0);
+
+    for (std::size_t w = 0; w < workers; ++w) {
+        CAPTURE(w);
+        REQUIRE(verify_worker(fsut->get(), w) == 0);
+    }
+}
+
+TEST_CASE("Multithreading: stress mix scaling", "[.][benchmark]")
+{
+    auto fsut = ext4UnderTest::Builder {}.set_automount().create();
+
+    const auto shared = make_content(0);
+    spawn_file(fsut->get(), file_name(0), shared);
+
+    std::size_t first_worker {};
+    for (const auto threads : thread_counts()) {
+        const auto start   = std::chrono::steady_clock::now();
+        const auto report  = stress_concurrently(fsut->get(), first_worker, threads, shared);
+        const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        first_worker += threads;
+
+        CAPTURE(threads);
+        REQUIRE(report.errors == 0);
+        std::cout << "stress mix, threads: " << threads << ", operations: " << report.operations << ", ops/sec: " << static_cast<std::size_t>(report.operations / elapsed) << '\n';
+    }
+}
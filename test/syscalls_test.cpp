@@ -7,6 +7,9 @@
 #include <catch2/catch_all.hpp>
 
 #include <fcntl.h>
+#include <cstring>
+#include <string>
+#include <vector>
 
 using namespace vfs::tests;
 
@@ -43,8 +46,16 @@ TEST_CASE("syscalls")
         REQUIRE(errno == 0);
 
         REQUIRE(syscalls::fsync(errno, fd) == 0);
+        REQUIRE(syscalls::fdatasync(errno, fd) == 0);
         REQUIRE(errno == 0);
 
+        /// FALLOC_FL_KEEP_SIZE, the size stays 4
+        REQUIRE(syscalls::fallocate(errno, fd, 0x01, 0, 8192) == 0);
+        REQUIRE(errno == 0);
+        REQUIRE(syscalls::fallocate(errno, fd, 0x10, 0, 8192) == -1);
+        REQUIRE(errno == ENOTSUP);
+        errno = 0;
+
         REQUIRE(syscalls::lseek(errno, fd, 0, SEEK_SET) == 0);
         REQUIRE(errno == 0);
 
@@ -162,6 +173,62 @@ TEST_CASE("syscalls")
                 REQUIRE(syscalls::closedir(errno, dirh) == 0);
                 REQUIRE(errno == 0);
             }
+
+            SECTION("entries read ahead in batches")
+            {
+                /// More entries than fit into a single batch of the directory stream
+                constexpr int files = 30;
+                for (int i = 0; i < files; ++i) { spawn_test_file(test_volume0_name / "test" / ("file_" + std::to_string(i)), "test"); }
+                REQUIRE(syscalls::symlink(errno, (test_volume0_name / "test/file_0").c_str(), (test_volume0_name / "test/link").c_str()) == 0);
+
+                auto dirh = syscalls::opendir(errno, (test_volume0_name / "test").c_str());
+                REQUIRE(dirh != nullptr);
+
+                /// telldir before every readdir, a position is an opaque cookie
+                std::vector<std::string> names;
+                std::vector<long>        positions;
+                while (true) {
+                    const auto pos   = syscalls::telldir(errno, dirh);
+                    const auto entry = syscalls::readdir(errno, dirh);
+                    if (entry == nullptr) { break; }
+                    REQUIRE(entry->d_reclen == std::strlen(entry->d_name));
+                    if (std::string {entry->d_name} == "link") { REQUIRE(entry->d_type == DT_LNK); }
+                    if (std::string {entry->d_name}.starts_with("file_")) { REQUIRE(entry->d_type == DT_REG); }
+                    positions.push_back(pos);
+                    names.emplace_back(entry->d_name);
+                }
+                REQUIRE(errno == 0);
+                REQUIRE(names.size() == files + 3);
+
+                /// Seek back and forth across batch boundaries
+                for (const std::size_t idx : {20U, 3U, 9U, 0U, 32U}) {
+                    syscalls::seekdir(errno, dirh, positions[idx]);
+                    REQUIRE(errno == 0);
+                    REQUIRE(syscalls::telldir(errno, dirh) == positions[idx]);
+                    const auto entry = syscalls::readdir(errno, dirh);
+                    REQUIRE(entry != nullptr);
+                    REQUIRE(std::string {entry->d_name} == names[idx]);
+                    if (idx + 1 < positions.size()) { REQUIRE(syscalls::telldir(errno, dirh) == positions[idx + 1]); }
+                }
+
+                /// Entry at a position is removed, the listing continues with the following one
+                REQUIRE(syscalls::unlink(errno, (test_volume0_name / "test" / names[10]).c_str()) == 0);
+                syscalls::seekdir(errno, dirh, positions[10]);
+                REQUIRE(errno == 0);
+                const auto entry = syscalls::readdir(errno, dirh);
+                REQUIRE(entry != nullptr);
+                REQUIRE(std::string {entry->d_name} == names[11]);
+
+                syscalls::rewinddir(errno, dirh);
+                REQUIRE(syscalls::telldir(errno, dirh) == 0);
+                struct dirent  dent {};
+                struct dirent* result = &dent;
+                REQUIRE(syscalls::readdir_r(errno, dirh, &dent, &result) == 0);
+                REQUIRE(result == &dent);
+                REQUIRE(std::string {dent.d_name} == names[0]);
+
+                REQUIRE(syscalls::closedir(errno, dirh) == 0);
+            }
         }
     }
 }
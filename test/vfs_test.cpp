@@ -9,11 +9,68 @@
 #include <sys/stat.h>
 #include <sys/statvfs.h>
 #include <catch2/catch_all.hpp>
+#include <ext4.h>
 
 #include <fcntl.h>
 
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <numeric>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
 using namespace vfs::tests;
 
+namespace {
+    /// Directory on a fresh volume filled with entries for the directory benchmarks. Entries are hard links, a file takes at most links_per_file of them,
+    /// hence the inode count doesn't limit the directory size.
+    struct populated_dir {
+        static constexpr std::size_t links_per_file = 50000;
+
+        explicit populated_dir(const std::size_t count)
+            : fsut {ext4UnderTest::Builder {}.create()}
+            , vfs {fsut->get()}
+            , count {count}
+        {
+            REQUIRE(vfs.mount(fsut->get_disk().borrow_partition(0)->get_name(), test_volume0_name, {}).value() == 0);
+            REQUIRE(not vfs.mkdir(path, 0777));
+            const auto start = std::chrono::steady_clock::now();
+            for (std::size_t i = 0; i < count; ++i) {
+                if (i % links_per_file == 0) {
+                    const auto fd = vfs.open(entry(i), O_WRONLY | O_CREAT, 0644);
+                    REQUIRE(fd);
+                    REQUIRE(not vfs.close(*fd));
+                } else {
+                    REQUIRE(not vfs.link(entry(i - i % links_per_file), entry(i)));
+                }
+            }
+            populate_time = std::chrono::steady_clock::now() - start;
+        }
+        ~populated_dir() { std::ignore = vfs.umount(test_volume0_name.string()); }
+        populated_dir(const populated_dir&)                    = delete;
+        auto operator=(const populated_dir&) -> populated_dir& = delete;
+
+        [[nodiscard]] std::filesystem::path entry(const std::size_t i) const { return path / ("entry_" + std::to_string(i)); }
+
+        /// Time spent per directory entry in microseconds
+        [[nodiscard]] double us_per_entry(const std::chrono::steady_clock::duration elapsed) const
+        {
+            return std::chrono::duration<double, std::micro>(elapsed).count() / static_cast<double>(count);
+        }
+
+        std::unique_ptr<FilesystemUnderTest> fsut;
+        vfs::VirtualFS&                      vfs;
+        const std::filesystem::path          path {test_volume0_name / "dir"};
+        const std::size_t                    count;
+        std::chrono::steady_clock::duration  populate_time {}; ///< Time it took to create the entries
+    };
+} // namespace
+
 TEST_CASE("register/unregister filesystem")
 {
     auto dmgr = vfs::DiskManager {};
@@ -83,6 +140,15 @@ TEST_CASE("mount/umount")
 
         /// TODO: add support for explicit fs types
         SECTION("incorrect partition type") { REQUIRE(fsut->get().mount(part_name, "/", "vfat", {}).value() == 0); }
+        SECTION("relative root")
+        {
+            REQUIRE(fsut->get().mount(part_name, "volume0", {}).value() == EINVAL);
+            REQUIRE(fsut->get().stat_parts().empty());
+
+            /// Nothing is left mounted, the partition can be mounted again
+            REQUIRE(fsut->get().mount(part_name, test_volume0_name, {}).value() == 0);
+            REQUIRE(fsut->get().umount(test_volume0_name.string()).value() == 0);
+        }
         SECTION("empty root")
         {
             /// Partition label will be used to construct mount point. If not available, mount point will be generated
@@ -111,6 +177,489 @@ TEST_CASE("mount/umount")
             REQUIRE(parts[0].disk_name == part_name);
             REQUIRE(parts[0].mount_point == "/root");
         }
+        SECTION("block cache capacity and statistics")
+        {
+            const auto cache_ops = [&fsut] {
+                for (int i = 0; i < 32; ++i) {
+                    const auto path = test_volume0_name / ("file" + std::to_string(i));
+                    const auto fd   = fsut->get().open(path, O_RDWR | O_CREAT, 0644);
+                    REQUIRE(fd);
+                    REQUIRE(fsut->get().write(*fd, path.c_str(), path.native().size()).value() == path.native().size());
+                    REQUIRE(not fsut->get().close(*fd));
+                    struct stat st {};
+                    REQUIRE(not fsut->get().stat(path, st));
+                }
+                return fsut->get().stat_parts_of(test_volume0_name).value().cache;
+            };
+
+            SECTION("default capacity")
+            {
+                REQUIRE(fsut->get().mount(part_name, test_volume0_name, {}).value() == 0);
+                const auto stats = cache_ops();
+                REQUIRE(stats.capacity == 8);
+                REQUIRE(stats.misses > 0);
+                REQUIRE(stats.evictions > 0);
+            }
+
+            SECTION("custom capacity")
+            {
+                REQUIRE(fsut->get().mount(part_name, test_volume0_name, {}, {}, vfs::MountOptions {.cache_blocks = 1024}).value() == 0);
+                const auto stats = cache_ops();
+                REQUIRE(stats.capacity == 1024);
+                REQUIRE(stats.hits > 0);
+                REQUIRE(stats.misses > 0);
+                REQUIRE(stats.evictions == 0);
+                REQUIRE(stats.blocks <= stats.capacity);
+            }
+
+            SECTION("2Q replacement policy")
+            {
+                const auto options = vfs::MountOptions {.cache_blocks = 8, .cache_policy = vfs::CachePolicy::two_queue};
+                REQUIRE(fsut->get().mount(part_name, test_volume0_name, {}, {}, options).value() == 0);
+                const auto stats = cache_ops();
+                REQUIRE(stats.capacity == 8);
+                REQUIRE(stats.hits > 0);
+                REQUIRE(stats.evictions > 0);
+                REQUIRE(stats.blocks <= stats.capacity);
+
+                /// Content must survive evictions from both queues
+                for (int i = 0; i < 32; ++i) {
+                    const auto        path = test_volume0_name / ("file" + std::to_string(i));
+                    std::vector<char> content(path.native().size());
+                    const auto        fd = fsut->get().open(path, O_RDONLY, 0);
+                    REQUIRE(fd);
+                    REQUIRE(fsut->get().read(*fd, content.data(), content.size()).value() == content.size());
+                    REQUIRE(std::string(content.begin(), content.end()) == path.native());
+                    REQUIRE(not fsut->get().close(*fd));
+                }
+            }
+
+            SECTION("write-back")
+            {
+                const auto options = vfs::MountOptions {.cache_blocks = 1024, .write_back = true, .dirty_ratio = 100, .dirty_expire = std::chrono::hours {1}};
+                REQUIRE(fsut->get().mount(part_name, test_volume0_name, {}, {}, options).value() == 0);
+                REQUIRE(cache_ops().dirty > 0);
+
+                /// fsync is a write-back barrier, file data is left dirty in the cache as well, hence every file has to be synced
+                for (int i = 0; i < 32; ++i) {
+                    const auto fd = fsut->get().open(test_volume0_name / ("file" + std::to_string(i)), O_RDONLY, 0);
+                    REQUIRE(fd);
+                    REQUIRE(not fsut->get().fsync(*fd));
+                    REQUIRE(not fsut->get().close(*fd));
+                }
+                REQUIRE(fsut->get().stat_parts_of(test_volume0_name).value().cache.dirty == 0);
+
+                /// So is umount
+                REQUIRE(cache_ops().dirty > 0);
+                REQUIRE(fsut->get().umount(test_volume0_name.string()).value() == 0);
+                REQUIRE(fsut->get().mount(part_name, test_volume0_name, {}).value() == 0);
+                for (int i = 0; i < 32; ++i) {
+                    struct stat st {};
+                    const auto  path = test_volume0_name / ("file" + std::to_string(i));
+                    REQUIRE(not fsut->get().stat(path, st));
+                    REQUIRE(static_cast<std::size_t>(st.st_size) == path.native().size());
+                }
+            }
+
+            SECTION("fsync writes back the file's own changes only")
+            {
+                const auto options = vfs::MountOptions {.cache_blocks = 1024, .write_back = true, .dirty_ratio = 100, .dirty_expire = std::chrono::hours {1}};
+                REQUIRE(fsut->get().mount(part_name, test_volume0_name, {}, {}, options).value() == 0);
+                cache_ops();
+
+                /// Pick two files whose inodes can't share an inode table block, neither with each other nor with the journal inode, whose block is
+                /// permanently referenced by lwext4 and therefore never written back by fsync
+                auto       create_from_ino = [&fsut, i = 0](const ino_t min_ino) mutable {
+                    struct stat st {};
+                    auto        path = test_volume0_name;
+                    while (st.st_ino < min_ino) {
+                        path          = test_volume0_name / ("far" + std::to_string(i++));
+                        const auto fd = fsut->get().open(path, O_WRONLY | O_CREAT, 0644);
+                        REQUIRE(fd);
+                        REQUIRE(fsut->get().write(*fd, "far", 3).value() == 3);
+                        REQUIRE(not fsut->get().close(*fd));
+                        REQUIRE(not fsut->get().stat(path, st));
+                    }
+                    return std::pair {path, st};
+                };
+                struct stat root {};
+                REQUIRE(not fsut->get().stat(test_volume0_name, root));
+                const auto max_inodes_per_block = static_cast<ino_t>(root.st_blksize / 128);
+                const auto [first_path, first]  = create_from_ino(max_inodes_per_block + 1);
+                const auto second_path          = create_from_ino(first.st_ino + max_inodes_per_block).first;
+
+                const auto dirty = [&fsut] { return fsut->get().stat_parts_of(test_volume0_name).value().cache.dirty; };
+                const auto fd1   = fsut->get().open(first_path, O_RDWR, 0);
+                const auto fd2   = fsut->get().open(second_path, O_RDWR, 0);
+                REQUIRE(fd1);
+                REQUIRE(fd2);
+                REQUIRE(not fsut->get().fsync(*fd1));
+                REQUIRE(not fsut->get().fsync(*fd2));
+                /// Data of the files skipped on the way is still dirty
+                const auto others = dirty();
+
+                /// Appending updates file size in the inode and the data block
+                REQUIRE(fsut->get().lseek(*fd1, 0, SEEK_END));
+                REQUIRE(fsut->get().lseek(*fd2, 0, SEEK_END));
+                REQUIRE(fsut->get().write(*fd1, "x", 1).value() == 1);
+                REQUIRE(fsut->get().write(*fd2, "x", 1).value() == 1);
+                REQUIRE(dirty() > others);
+                REQUIRE(not fsut->get().fsync(*fd1));
+                REQUIRE(dirty() > others);
+                REQUIRE(not fsut->get().fsync(*fd2));
+                REQUIRE(dirty() == others);
+
+                /// Timestamp updates are left behind by fdatasync
+                REQUIRE(not fsut->get().close(*fd1));
+                REQUIRE(not fsut->get().close(*fd2));
+                const auto fd = fsut->get().open(first_path, O_RDONLY, 0);
+                REQUIRE(fd);
+                const auto timestamps = dirty();
+                REQUIRE(timestamps > others);
+                REQUIRE(not fsut->get().fdatasync(*fd));
+                REQUIRE(dirty() == timestamps);
+                REQUIRE(not fsut->get().fsync(*fd));
+                REQUIRE(dirty() < timestamps);
+                REQUIRE(not fsut->get().close(*fd));
+            }
+
+            SECTION("write-back of file data")
+            {
+                const auto options = vfs::MountOptions {.cache_blocks = 1024, .write_back = true, .dirty_ratio = 100, .dirty_expire = std::chrono::hours {1}};
+                REQUIRE(fsut->get().mount(part_name, test_volume0_name, {}, {}, options).value() == 0);
+                const auto path = test_volume0_name / "data";
+                struct stat st {};
+                REQUIRE(not fsut->get().stat(test_volume0_name, st));
+                const auto        block_size = static_cast<std::size_t>(st.st_blksize);
+                std::vector<char> expected(2 * block_size, 'a');
+                auto              fd = fsut->get().open(path, O_RDWR | O_CREAT, 0644);
+                REQUIRE(fd);
+                REQUIRE(fsut->get().write(*fd, expected.data(), expected.size()).value() == expected.size());
+                REQUIRE(not fsut->get().fsync(*fd));
+
+                /// Partial block writes stay in the cache
+                const auto writes = fsut->get_blockdev().get_write_count();
+                for (std::size_t offset = 5; offset < expected.size(); offset += block_size) {
+                    REQUIRE(fsut->get().lseek(*fd, static_cast<off_t>(offset), SEEK_SET));
+                    REQUIRE(fsut->get().write(*fd, "dirty", 5).value() == 5);
+                    std::copy_n("dirty", 5, expected.begin() + static_cast<std::ptrdiff_t>(offset));
+                }
+                REQUIRE(fsut->get_blockdev().get_write_count() == writes);
+
+                /// Both partial and whole block reads see them
+                std::vector<char> actual(expected.size());
+                REQUIRE(fsut->get().lseek(*fd, 3, SEEK_SET));
+                REQUIRE(fsut->get().read(*fd, actual.data(), 10).value() == 10);
+                REQUIRE(std::equal(actual.begin(), actual.begin() + 10, expected.begin() + 3));
+                REQUIRE(fsut->get().lseek(*fd, 0, SEEK_SET));
+                REQUIRE(fsut->get().read(*fd, actual.data(), actual.size()).value() == actual.size());
+                REQUIRE(actual == expected);
+                REQUIRE(not fsut->get().close(*fd));
+
+                REQUIRE(fsut->get().umount(test_volume0_name.string()).value() == 0);
+                REQUIRE(fsut->get_blockdev().get_write_count() > writes);
+                REQUIRE(fsut->get().mount(part_name, test_volume0_name, {}).value() == 0);
+                fd = fsut->get().open(path, O_RDONLY, 0);
+                REQUIRE(fd);
+                REQUIRE(fsut->get().read(*fd, actual.data(), actual.size()).value() == actual.size());
+                REQUIRE(actual == expected);
+                REQUIRE(not fsut->get().close(*fd));
+            }
+
+            SECTION("write-back of expired dirty blocks")
+            {
+                const auto options = vfs::MountOptions {.cache_blocks = 1024, .write_back = true, .dirty_ratio = 100, .dirty_expire = std::chrono::milliseconds {10}};
+                REQUIRE(fsut->get().mount(part_name, test_volume0_name, {}, {}, options).value() == 0);
+                cache_ops();
+
+                const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds {5};
+                while (fsut->get().stat_parts_of(test_volume0_name).value().cache.dirty != 0 and std::chrono::steady_clock::now() < deadline) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds {1});
+                }
+                REQUIRE(fsut->get().stat_parts_of(test_volume0_name).value().cache.dirty == 0);
+            }
+        }
+        SECTION("journal group commit")
+        {
+            const auto writes = [&fsut] { return fsut->get_blockdev().get_write_count(); };
+            const auto create = [&fsut](const std::string& prefix) {
+                for (int i = 0; i < 64; ++i) {
+                    const auto fd = fsut->get().open(test_volume0_name / (prefix + std::to_string(i)), O_WRONLY | O_CREAT, 0644);
+                    REQUIRE(fd);
+                    REQUIRE(not fsut->get().close(*fd));
+                }
+            };
+            const auto verify = [&fsut](const std::string& prefix) {
+                for (int i = 0; i < 64; ++i) {
+                    struct stat st {};
+                    REQUIRE(not fsut->get().stat(test_volume0_name / (prefix + std::to_string(i)), st));
+                }
+            };
+
+            SECTION("operations wait for fsync")
+            {
+                /// Blocks of a transaction waiting for a commit stay cached, the cache must be large enough to hold a group
+                REQUIRE(fsut->get().mount(part_name, test_volume0_name, {}, {}, vfs::MountOptions {.cache_blocks = 1024}).value() == 0);
+                auto start = writes();
+                create("single");
+                const auto per_operation = writes() - start;
+                REQUIRE(fsut->get().umount(test_volume0_name.string()).value() == 0);
+
+                const auto options = vfs::MountOptions {.cache_blocks = 1024, .journal_commit = vfs::JournalCommit::on_sync};
+                REQUIRE(fsut->get().mount(part_name, test_volume0_name, {}, {}, options).value() == 0);
+                start = writes();
+                create("grouped");
+                REQUIRE(writes() == start);
+
+                const auto fd = fsut->get().open(test_volume0_name / "grouped0", O_RDONLY, 0);
+                REQUIRE(fd);
+                REQUIRE(not fsut->get().fsync(*fd));
+                REQUIRE(not fsut->get().close(*fd));
+                REQUIRE(writes() > start);
+                REQUIRE((writes() - start) * 4 < per_operation);
+
+                /// Failed operations don't discard the ones waiting for a commit
+                REQUIRE(fsut->get().mkdir(test_volume0_name / "dir", 0755).value() == 0);
+                REQUIRE(fsut->get().open(test_volume0_name / "grouped0" / "file", O_WRONLY | O_CREAT, 0644).error().value() == ENOENT);
+                create("pending");
+
+                /// Umount commits operations still waiting
+                REQUIRE(fsut->get().umount(test_volume0_name.string()).value() == 0);
+                REQUIRE(fsut->get().mount(part_name, test_volume0_name, {}).value() == 0);
+                verify("single");
+                verify("grouped");
+                verify("pending");
+                struct stat st {};
+                REQUIRE(not fsut->get().stat(test_volume0_name / "dir", st));
+            }
+
+            SECTION("inodes of open files are written on commit")
+            {
+                const auto options = vfs::MountOptions {.journal_commit = vfs::JournalCommit::on_sync};
+                REQUIRE(fsut->get().mount(part_name, test_volume0_name, {}, {}, options).value() == 0);
+                const auto data   = std::vector<char>(10000, 'x');
+                const auto open   = fsut->get().open(test_volume0_name / "open", O_WRONLY | O_CREAT, 0644);
+                const auto closed = fsut->get().open(test_volume0_name / "closed", O_WRONLY | O_CREAT, 0644);
+                REQUIRE(open);
+                REQUIRE(closed);
+                REQUIRE(fsut->get().write(*open, data.data(), data.size()).value() == data.size());
+                REQUIRE(fsut->get().write(*closed, data.data(), data.size()).value() == data.size());
+                REQUIRE(not fsut->get().close(*closed));
+
+                /// Umount commits the inode still held by the open file as well
+                REQUIRE(fsut->get().umount(test_volume0_name.string()).value() == 0);
+                REQUIRE(fsut->get().mount(part_name, test_volume0_name, {}).value() == 0);
+                for (const auto name : {"open", "closed"}) {
+                    struct stat st {};
+                    REQUIRE(not fsut->get().stat(test_volume0_name / name, st));
+                    REQUIRE(st.st_size == static_cast<off_t>(data.size()));
+                }
+            }
+
+            SECTION("block budget")
+            {
+                const auto options = vfs::MountOptions {.journal_commit = vfs::JournalCommit::on_sync, .commit_blocks = 4};
+                REQUIRE(fsut->get().mount(part_name, test_volume0_name, {}, {}, options).value() == 0);
+                const auto start = writes();
+                create("budget");
+                REQUIRE(writes() > start);
+            }
+
+            SECTION("commit interval")
+            {
+                const auto options = vfs::MountOptions {.journal_commit = vfs::JournalCommit::grouped, .commit_interval = std::chrono::milliseconds {10}};
+                REQUIRE(fsut->get().mount(part_name, test_volume0_name, {}, {}, options).value() == 0);
+                create("timed");
+
+                const auto written  = writes();
+                const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds {5};
+                while (writes() == written and std::chrono::steady_clock::now() < deadline) { std::this_thread::sleep_for(std::chrono::milliseconds {1}); }
+                REQUIRE(writes() > written);
+            }
+
+            SECTION("transactions fit the block cache")
+            {
+                /// Blocks of an open transaction are referenced until it's committed, the default budget would exceed the default cache
+                const auto options = vfs::MountOptions {.journal_commit = vfs::JournalCommit::on_sync};
+                REQUIRE(fsut->get().mount(part_name, test_volume0_name, {}, {}, options).value() == 0);
+                for (int i = 0; i < 1024; ++i) {
+                    const auto fd = fsut->get().open(test_volume0_name / ("fit" + std::to_string(i)), O_WRONLY | O_CREAT, 0644);
+                    REQUIRE(fd);
+                    REQUIRE(not fsut->get().close(*fd));
+                }
+                const auto stats = fsut->get().stat_parts_of(test_volume0_name).value().cache;
+                REQUIRE(stats.blocks <= stats.capacity);
+                REQUIRE(stats.overflows == 0);
+            }
+        }
+        SECTION("directory entry cache")
+        {
+            const auto dentry_stats = [&fsut] {
+                const auto stats = fsut->get().stat_parts_of(test_volume0_name).value().cache;
+                return std::pair {stats.dentry_hits, stats.dentry_misses};
+            };
+            const auto exists = [&fsut](const std::filesystem::path& path) {
+                struct stat st {};
+                return not fsut->get().stat(test_volume0_name / path, st);
+            };
+
+            SECTION("deep path lookups")
+            {
+                REQUIRE(fsut->get().mount(part_name, test_volume0_name, {}).value() == 0);
+                REQUIRE(fsut->get().mkdir(test_volume0_name / "a/b/c/d", 0755).value() == 0);
+                REQUIRE(exists("a/b/c/d"));
+
+                const auto [hits, misses] = dentry_stats();
+                for (int i = 0; i < 100; ++i) { REQUIRE(exists("a/b/c/d")); }
+                const auto [hits_after, misses_after] = dentry_stats();
+                REQUIRE(hits_after - hits == 400);
+                REQUIRE(misses_after == misses);
+            }
+
+            SECTION("disabled")
+            {
+                REQUIRE(fsut->get().mount(part_name, test_volume0_name, {}, {}, vfs::MountOptions {.dentry_cache = 0}).value() == 0);
+                REQUIRE(fsut->get().mkdir(test_volume0_name / "a/b", 0755).value() == 0);
+                for (int i = 0; i < 10; ++i) { REQUIRE(exists("a/b")); }
+                REQUIRE(dentry_stats() == std::pair<std::uint64_t, std::uint64_t> {0, 0});
+            }
+
+            SECTION("entries follow namespace changes")
+            {
+                REQUIRE(fsut->get().mount(part_name, test_volume0_name, {}, {}, vfs::MountOptions {.dentry_cache = 8}).value() == 0);
+
+                /// Negative entry is replaced once the name is created
+                REQUIRE(not exists("file"));
+                REQUIRE(not exists("file"));
+                auto fd = fsut->get().open(test_volume0_name / "file", O_WRONLY | O_CREAT, 0644);
+                REQUIRE(fd);
+                REQUIRE(not fsut->get().close(*fd));
+                REQUIRE(exists("file"));
+
+                REQUIRE(fsut->get().rename(test_volume0_name / "file", test_volume0_name / "renamed").value() == 0);
+                REQUIRE(not exists("file"));
+                REQUIRE(exists("renamed"));
+
+                REQUIRE(fsut->get().unlink(test_volume0_name / "renamed").value() == 0);
+                REQUIRE(not exists("renamed"));
+
+                /// Entries of a removed directory mustn't resolve in the one recreated under the same name
+                REQUIRE(fsut->get().mkdir(test_volume0_name / "dir/sub", 0755).value() == 0);
+                REQUIRE(exists("dir/sub"));
+                REQUIRE(fsut->get().rmdir(test_volume0_name / "dir/sub").value() == 0);
+                REQUIRE(fsut->get().rmdir(test_volume0_name / "dir").value() == 0);
+                REQUIRE(not exists("dir"));
+                REQUIRE(fsut->get().mkdir(test_volume0_name / "dir", 0755).value() == 0);
+                REQUIRE(exists("dir"));
+                REQUIRE(not exists("dir/sub"));
+
+                /// Renamed directory keeps its children
+                REQUIRE(fsut->get().mkdir(test_volume0_name / "dir/child", 0755).value() == 0);
+                REQUIRE(exists("dir/child"));
+                REQUIRE(fsut->get().rename(test_volume0_name / "dir", test_volume0_name / "moved").value() == 0);
+                REQUIRE(not exists("dir/child"));
+                REQUIRE(exists("moved/child"));
+
+                /// Capacity is exceeded by far, the least recently used entries are replaced
+                for (int i = 0; i < 32; ++i) {
+                    fd = fsut->get().open(test_volume0_name / ("f" + std::to_string(i)), O_WRONLY | O_CREAT, 0644);
+                    REQUIRE(fd);
+                    REQUIRE(not fsut->get().close(*fd));
+                }
+                for (int i = 0; i < 32; ++i) { REQUIRE(exists("f" + std::to_string(i))); }
+                REQUIRE(exists("moved/child"));
+            }
+        }
+
+        SECTION("access and modification times")
+        {
+            const auto writes  = [&fsut] { return fsut->get_blockdev().get_write_count(); };
+            const auto file    = test_volume0_name / "file";
+            const auto file_st = [&fsut, &file] {
+                struct stat st {};
+                REQUIRE(not fsut->get().stat(file, st));
+                return st;
+            };
+            const auto read_file = [&fsut, &file] {
+                char       buf[16];
+                const auto fd = fsut->get().open(file, O_RDONLY, 0);
+                REQUIRE(fd);
+                REQUIRE(fsut->get().read(*fd, buf, sizeof buf).value() == sizeof buf);
+                REQUIRE(not fsut->get().close(*fd));
+            };
+            const auto remount = [&fsut, &part_name](const vfs::Flags flags) {
+                REQUIRE(fsut->get().umount(test_volume0_name.string()).value() == 0);
+                REQUIRE(fsut->get().mount(part_name, test_volume0_name, {}, flags).value() == 0);
+            };
+
+            REQUIRE(fsut->get().mount(part_name, test_volume0_name, {}).value() == 0);
+            const auto data = std::vector<char>(100, 'x');
+            const auto fd   = fsut->get().open(file, O_WRONLY | O_CREAT, 0644);
+            REQUIRE(fd);
+            REQUIRE(fsut->get().write(*fd, data.data(), data.size()).value() == data.size());
+            REQUIRE(not fsut->get().close(*fd));
+            const auto created = file_st();
+            /// Timestamps have a resolution of a second
+            while (std::time(nullptr) <= created.st_mtime) { std::this_thread::sleep_for(std::chrono::milliseconds {10}); }
+
+            SECTION("noatime")
+            {
+                remount(vfs::Flags {}.set(vfs::MountFlags::noatime));
+                const auto start = writes();
+                read_file();
+                REQUIRE(writes() == start);
+                REQUIRE(file_st().st_atime == created.st_atime);
+
+                /// Inodes written by older versions have no change time, opening them mustn't be taken for a creation
+                REQUIRE(ext4_ctime_set(file.c_str(), 0) == EOK);
+                const auto before = writes();
+                read_file();
+                REQUIRE(writes() == before);
+                REQUIRE(file_st().st_atime == created.st_atime);
+                REQUIRE(file_st().st_mtime == created.st_mtime);
+            }
+
+            SECTION("relatime")
+            {
+                remount(vfs::Flags {}.set(vfs::MountFlags::relatime));
+                /// Access time isn't newer than the modification time
+                read_file();
+                const auto accessed = file_st();
+                REQUIRE(accessed.st_atime > created.st_atime);
+
+                const auto start = writes();
+                read_file();
+                REQUIRE(writes() == start);
+                REQUIRE(file_st().st_atime == accessed.st_atime);
+            }
+
+            SECTION("modification time follows writes")
+            {
+                auto fd = fsut->get().open(file, O_RDWR, 0);
+                REQUIRE(fd);
+                REQUIRE(not fsut->get().close(*fd));
+                REQUIRE(file_st().st_mtime == created.st_mtime);
+
+                fd = fsut->get().open(file, O_RDWR, 0);
+                REQUIRE(fd);
+                REQUIRE(fsut->get().write(*fd, data.data(), data.size()).value() == data.size());
+                REQUIRE(not fsut->get().close(*fd));
+                REQUIRE(file_st().st_mtime > created.st_mtime);
+            }
+
+            SECTION("lazytime")
+            {
+                remount(vfs::Flags {}.set(vfs::MountFlags::lazytime));
+                const auto start = writes();
+                read_file();
+                REQUIRE(writes() == start);
+                REQUIRE(file_st().st_atime > created.st_atime);
+
+                /// Umount writes the timestamps kept in memory
+                remount({});
+                REQUIRE(file_st().st_atime > created.st_atime);
+            }
+        }
     }
     SECTION("umount")
     {
@@ -122,6 +671,32 @@ TEST_CASE("mount/umount")
         }
     }
 
+    SECTION("mount point resolution - roots are matched by whole path components")
+    {
+        auto       fsut = ext4UnderTest::Builder {}.with_multipartition().create();
+        const auto p0   = fsut->get_disk().borrow_partition(0)->get_name();
+        const auto p1   = fsut->get_disk().borrow_partition(1)->get_name();
+
+        REQUIRE(fsut->get().mount(p0, test_volume0_name.string(), {}).value() == 0);
+        REQUIRE(fsut->get().mount(p1, test_volume0_name.string() + "x", {}).value() == 0);
+
+        const auto fd = fsut->get().open(test_volume0_name.string() + "x/test.txt", O_WRONLY | O_CREAT, 0);
+        REQUIRE(fd);
+        REQUIRE(not fsut->get().close(*fd));
+
+        struct stat st {};
+        REQUIRE(not fsut->get().stat(test_volume0_name.string() + "x/test.txt", st));
+        REQUIRE(fsut->get().stat(test_volume0_name / "test.txt", st).value() == ENOENT);
+        REQUIRE(fsut->get().stat_parts_of(test_volume0_name.string() + "x/test.txt")->disk_name == p1);
+        REQUIRE(fsut->get().stat_parts_of(test_volume0_name / "test.txt")->disk_name == p0);
+        REQUIRE(fsut->get().stat_parts_of("/volume").error().value() == ENOENT);
+        REQUIRE(fsut->get().rename(test_volume0_name.string() + "x/test.txt", test_volume0_name / "test.txt").value() == EXDEV);
+
+        REQUIRE(fsut->get().umount(test_volume0_name.string()).value() == 0);
+        REQUIRE(fsut->get().stat(test_volume0_name.string() + "x/test.txt", st).value() == 0);
+        REQUIRE(fsut->get().get_roots() == std::vector<std::string> {test_volume0_name.string() + "x"});
+    }
+
     SECTION("mount/unmount with unlink - any files marked to unlink should be removed upon closing filesystem")
     {
         auto fsut = ext4UnderTest::Builder {}.set_automount().create();
@@ -146,4 +721,399 @@ TEST_CASE("various")
         struct stat st {};
         REQUIRE(not fsut->get().stat(test_volume0_name, st));
     }
-}
\ No newline at end of file
+
+    SECTION("path normalization")
+    {
+        auto& vfs = fsut->get();
+        REQUIRE(not vfs.mkdir(test_volume0_name / "dir", 0777));
+        auto fd = vfs.open(test_volume0_name / "dir/file", O_CREAT | O_WRONLY, 0);
+        REQUIRE(fd);
+        REQUIRE(not vfs.close(*fd));
+
+        struct stat expected {};
+        struct stat st {};
+        REQUIRE(not vfs.stat(test_volume0_name / "dir/file", expected));
+        const auto root = test_volume0_name.string();
+        for (const auto& path : {root + "//dir///file", root + "/./dir/./file", root + "/dir/../dir/file", root + "/../../" + root + "/dir/file"}) {
+            INFO(path);
+            REQUIRE(not vfs.stat(path, st));
+            REQUIRE(st.st_ino == expected.st_ino);
+        }
+        REQUIRE(not vfs.stat(root + "/dir/..", st));
+        REQUIRE(not vfs.stat(root + "/.", st));
+
+        REQUIRE(vfs.stat("relative/path", st).value() == EINVAL);
+        REQUIRE(vfs.stat(root + "/" + std::string(PATH_MAX, 'x'), st).value() == ENAMETOOLONG);
+        REQUIRE(vfs.stat("", st).value() == ENOENT);
+    }
+}
+TEST_CASE("scatter-gather block I/O")
+{
+    auto        fsut      = ext4UnderTest::Builder {}.create();
+    auto&       partition = *fsut->get_disk().borrow_partition(0);
+    const auto  sect_size = partition.get_sector_size().value();
+    std::vector buffer_a(sect_size * 2, std::byte {0xA5});
+    std::vector buffer_b(sect_size, std::byte {0x5A});
+
+    const std::array<vfs::write_segment, 2> writes {{{10, 2, buffer_a.data()}, {20, 1, buffer_b.data()}}};
+    REQUIRE(not partition.writev(writes));
+
+    SECTION("segments land on partition relative sectors")
+    {
+        std::vector<std::byte> single(sect_size);
+        REQUIRE(not partition.read(single.front(), 11, 1));
+        REQUIRE(single == std::vector(sect_size, std::byte {0xA5}));
+        REQUIRE(not partition.read(single.front(), 20, 1));
+        REQUIRE(single == buffer_b);
+    }
+
+    SECTION("read back by a vectored request")
+    {
+        std::vector<std::byte>                 read_a(sect_size * 2);
+        std::vector<std::byte>                 read_b(sect_size);
+        const std::array<vfs::read_segment, 2> reads {{{20, 1, read_b.data()}, {10, 2, read_a.data()}}};
+        REQUIRE(not partition.readv(reads));
+        REQUIRE(read_a == buffer_a);
+        REQUIRE(read_b == buffer_b);
+    }
+
+    SECTION("requests longer than a translation batch")
+    {
+        constexpr std::size_t           segments = 20;
+        std::vector<std::byte>          pattern(sect_size * segments);
+        std::vector<std::byte>          content(pattern.size());
+        std::vector<vfs::write_segment> to_write;
+        std::vector<vfs::read_segment>  to_read;
+        for (std::size_t i = 0; i < segments; ++i) {
+            std::fill_n(pattern.begin() + i * sect_size, sect_size, static_cast<std::byte>(i));
+            to_write.push_back({100 + i * 2, 1, pattern.data() + i * sect_size});
+            to_read.push_back({100 + i * 2, 1, content.data() + i * sect_size});
+        }
+        REQUIRE(not partition.writev(to_write));
+        REQUIRE(not partition.readv(to_read));
+        REQUIRE(content == pattern);
+    }
+}
+
+TEST_CASE("Block cache hit rate per replacement policy", "[.][benchmark]")
+{
+    constexpr std::size_t cache_blocks = 32;
+    constexpr std::size_t hot_files    = 16;
+    constexpr std::size_t cold_files   = 1024;
+    constexpr std::size_t sweep_files  = 128;
+    constexpr std::size_t rounds       = 64;
+    constexpr std::size_t stream_chunk = 64 * 1024;
+
+    const auto run = [&](const vfs::CachePolicy policy) {
+        auto       fsut      = ext4UnderTest::Builder {}.create();
+        auto&      vfs       = fsut->get();
+        const auto part_name = fsut->get_disk().borrow_partition(0)->get_name();
+        REQUIRE(vfs.mount(part_name, test_volume0_name, {}, {}, vfs::MountOptions {.cache_blocks = cache_blocks, .cache_policy = policy}).value() == 0);
+
+        const auto create = [&vfs](const std::filesystem::path& path, const std::size_t size) {
+            const auto fd = vfs.open(path, O_WRONLY | O_CREAT, 0644);
+            REQUIRE(fd);
+            const std::vector<char> content(size, 'x');
+            REQUIRE(vfs.write(*fd, content.data(), content.size()).value() == content.size());
+            REQUIRE(not vfs.close(*fd));
+        };
+        REQUIRE(not vfs.mkdir(test_volume0_name / "hot", 0755));
+        REQUIRE(not vfs.mkdir(test_volume0_name / "cold", 0755));
+        /// Interleave creation so that hot inodes are spread over the inode table
+        for (std::size_t i = 0; i < cold_files; ++i) {
+            if (i % (cold_files / hot_files) == 0) { create(test_volume0_name / "hot" / std::to_string(i), 16); }
+            create(test_volume0_name / "cold" / std::to_string(i), 16);
+        }
+        create(test_volume0_name / "stream", rounds * stream_chunk);
+
+        /// Every round stats the hot set, streams a chunk of a large file and sweeps through a slice of cold files, which are revisited only after the
+        /// sweep went through all of them
+        const auto before = vfs.stat_parts_of(test_volume0_name).value().cache;
+        const auto stream = vfs.open(test_volume0_name / "stream", O_RDONLY, 0);
+        REQUIRE(stream);
+        std::vector<char> buffer(stream_chunk);
+        struct stat       st {};
+        for (std::size_t round = 0; round < rounds; ++round) {
+            for (std::size_t i = 0; i < cold_files; i += cold_files / hot_files) { REQUIRE(not vfs.stat(test_volume0_name / "hot" / std::to_string(i), st)); }
+            REQUIRE(vfs.read(*stream, buffer.data(), buffer.size()).value() == buffer.size());
+            for (std::size_t i = 0; i < sweep_files; ++i) {
+                REQUIRE(not vfs.stat(test_volume0_name / "cold" / std::to_string((round * sweep_files + i) % cold_files), st));
+            }
+        }
+        REQUIRE(not vfs.close(*stream));
+        const auto after = vfs.stat_parts_of(test_volume0_name).value().cache;
+        return std::pair {after.hits - before.hits, after.misses - before.misses};
+    };
+
+    for (const auto& [name, policy] : {std::pair {"LRU", vfs::CachePolicy::lru}, std::pair {"2Q", vfs::CachePolicy::two_queue}}) {
+        const auto [hits, misses] = run(policy);
+        std::cout << "block cache policy: " << name << ", hit rate: " << 100.0 * static_cast<double>(hits) / static_cast<double>(hits + misses)
+                  << "%, misses: " << misses << std::endl;
+    }
+}
+
+TEST_CASE("File creation cost per journal commit mode", "[.][benchmark]")
+{
+    constexpr std::size_t files = 1024;
+
+    for (const auto& [name, mode] : {std::pair {"per operation", vfs::JournalCommit::per_operation}, std::pair {"grouped", vfs::JournalCommit::grouped},
+                                     std::pair {"on sync", vfs::JournalCommit::on_sync}}) {
+        auto       fsut      = ext4UnderTest::Builder {}.create();
+        auto&      vfs       = fsut->get();
+        const auto part_name = fsut->get_disk().borrow_partition(0)->get_name();
+        /// Group budget is limited to a quarter of the cache
+        REQUIRE(vfs.mount(part_name, test_volume0_name, {}, {}, vfs::MountOptions {.cache_blocks = 4096, .journal_commit = mode}).value() == 0);
+
+        const auto writes = fsut->get_blockdev().get_write_count();
+        const auto start  = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < files; ++i) {
+            const auto fd = vfs.open(test_volume0_name / std::to_string(i), O_WRONLY | O_CREAT, 0644);
+            REQUIRE(fd);
+            REQUIRE(not vfs.close(*fd));
+        }
+        REQUIRE(vfs.umount(test_volume0_name.string()).value() == 0);
+        const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+
+        std::cout << "journal commit: " << name << ", " << files << " files created in " << elapsed.count()
+                  << " ms, device writes: " << fsut->get_blockdev().get_write_count() - writes << std::endl;
+    }
+}
+
+TEST_CASE("Sequential throughput per block mapping", "[.][benchmark]")
+{
+    constexpr std::size_t file_size = 100 * 1024 * 1024;
+    constexpr std::size_t chunk     = 1024 * 1024;
+    constexpr std::size_t disk_size = 256 * 1024 * 1024;
+
+    const auto mb_per_s = [](const std::chrono::steady_clock::duration elapsed) {
+        return static_cast<double>(file_size) / (1024 * 1024) / std::chrono::duration<double>(elapsed).count();
+    };
+
+    /// ext3 is the ext4 feature set this library supports, without extents
+    for (const auto& [name, type] : {std::pair {"block maps", vfs::tools::mkfs::ext_type::ext3}, std::pair {"extents", vfs::tools::mkfs::ext_type::ext4}}) {
+        auto       fsut      = ext4UnderTest::Builder {}.set_blockdev_size(disk_size).set_partition_size(disk_size / 512 - 64).set_ext_type(type).create();
+        auto&      vfs       = fsut->get();
+        const auto part_name = fsut->get_disk().borrow_partition(0)->get_name();
+        REQUIRE(vfs.mount(part_name, test_volume0_name, {}).value() == 0);
+
+        std::vector<char> buffer(chunk, 'x');
+        auto              fd    = vfs.open(test_volume0_name / "stream", O_WRONLY | O_CREAT, 0644);
+        auto              start = std::chrono::steady_clock::now();
+        REQUIRE(fd);
+        for (std::size_t i = 0; i < file_size / chunk; ++i) { REQUIRE(vfs.write(*fd, buffer.data(), buffer.size()).value() == buffer.size()); }
+        REQUIRE(not vfs.close(*fd));
+        const auto write = std::chrono::steady_clock::now() - start;
+
+        fd    = vfs.open(test_volume0_name / "stream", O_RDONLY, 0);
+        start = std::chrono::steady_clock::now();
+        REQUIRE(fd);
+        for (std::size_t i = 0; i < file_size / chunk; ++i) { REQUIRE(vfs.read(*fd, buffer.data(), buffer.size()).value() == buffer.size()); }
+        REQUIRE(not vfs.close(*fd));
+        const auto read = std::chrono::steady_clock::now() - start;
+
+        std::cout << "block mapping: " << name << ", sequential write: " << mb_per_s(write) << " MB/s, sequential read: " << mb_per_s(read) << " MB/s"
+                  << std::endl;
+    }
+}
+
+TEST_CASE("Preallocation and holes per block mapping")
+{
+    constexpr std::size_t block_size = 4096;
+    constexpr blkcnt_t    sectors    = block_size / 512;
+    constexpr std::size_t disk_size  = 64 * 1024 * 1024;
+
+    for (const auto& [name, type] : {std::pair {"block maps", vfs::tools::mkfs::ext_type::ext3}, std::pair {"extents", vfs::tools::mkfs::ext_type::ext4}}) {
+        INFO(name);
+        auto       fsut      = ext4UnderTest::Builder {}.set_blockdev_size(disk_size).set_partition_size(disk_size / 512 - 64).set_ext_type(type).create();
+        auto&      vfs       = fsut->get();
+        const auto part_name = fsut->get_disk().borrow_partition(0)->get_name();
+        REQUIRE(vfs.mount(part_name, test_volume0_name, {}).value() == 0);
+
+        auto fd = vfs.open(test_volume0_name / "file", O_RDWR | O_CREAT, 0644);
+        REQUIRE(fd);
+        REQUIRE(vfs.write(*fd, "head", 4).value() == 4);
+
+        /// Block mapped files can't keep unwritten blocks past the end of file, without keep_size their holes are zero filled instead
+        const auto keep_size = vfs.fallocate(*fd, vfs::Flags {}.set(vfs::FallocFlags::keep_size), 0, 16 * block_size);
+        if (type == vfs::tools::mkfs::ext_type::ext3) {
+            REQUIRE(keep_size == vfs::from_errno(ENOTSUP));
+        } else {
+            REQUIRE(not keep_size);
+        }
+        REQUIRE(not vfs.fallocate(*fd, {}, 0, 16 * block_size));
+        REQUIRE(vfs.lseek(*fd, 0, SEEK_CUR).value() == 4);
+
+        /// A hole past the preallocated range is filled by a write into its middle
+        REQUIRE(not vfs.ftruncate(*fd, 64 * block_size));
+        REQUIRE(vfs.lseek(*fd, 40 * block_size + 10, SEEK_SET).value() == 40 * block_size + 10);
+        REQUIRE(vfs.write(*fd, "hole", 4).value() == 4);
+
+        auto expected = std::vector<char>(64 * block_size, 0);
+        std::memcpy(expected.data(), "head", 4);
+        std::memcpy(expected.data() + 40 * block_size + 10, "hole", 4);
+        auto buf = std::vector<char>(expected.size(), 1);
+        REQUIRE(vfs.lseek(*fd, 0, SEEK_SET).value() == 0);
+        REQUIRE(vfs.read(*fd, buf.data(), buf.size()).value() == buf.size());
+        REQUIRE(buf == expected);
+
+        struct stat st {};
+        REQUIRE(not vfs.fstat(*fd, st));
+        REQUIRE(st.st_size == 64 * block_size);
+        REQUIRE(st.st_blocks >= 17 * sectors);
+        REQUIRE(st.st_blocks < 64 * sectors);
+
+        /// Holes inside the file are allocated too, the data around them is kept
+        REQUIRE(not vfs.fallocate(*fd, {}, 0, 64 * block_size));
+        REQUIRE(not vfs.fstat(*fd, st));
+        REQUIRE(st.st_size == 64 * block_size);
+        REQUIRE(st.st_blocks >= 64 * sectors);
+        REQUIRE(vfs.lseek(*fd, 0, SEEK_SET).value() == 0);
+        REQUIRE(vfs.read(*fd, buf.data(), buf.size()).value() == buf.size());
+        REQUIRE(buf == expected);
+        REQUIRE(not vfs.close(*fd));
+        REQUIRE(vfs.umount(test_volume0_name.string()).value() == 0);
+    }
+}
+
+TEST_CASE("Directory create and lookup latency per entry count", "[.][benchmark]")
+{
+    for (const std::size_t count : {1000, 10000, 100000}) {
+        const populated_dir dir {count};
+
+        /// Strided order, consecutive lookups don't hit the same directory blocks
+        struct stat st {};
+        const auto  start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < count; ++i) { REQUIRE(not dir.vfs.stat(dir.entry(i * 7919 % count), st)); }
+        const auto lookup = std::chrono::steady_clock::now() - start;
+
+        std::cout << "directory entries: " << count << ", create: " << dir.us_per_entry(dir.populate_time) << " us/entry, lookup: " << dir.us_per_entry(lookup)
+                  << " us/entry" << std::endl;
+    }
+}
+
+TEST_CASE("Directory listing with stat per entry and batched", "[.][benchmark]")
+{
+    constexpr std::size_t count = 10000;
+    const populated_dir   dir {count};
+    auto&                 vfs = dir.vfs;
+
+    /// What a directory_iterator user does, a dirnext and a stat of the entry path per entry
+    auto dirh = vfs.diropen(dir.path);
+    REQUIRE(dirh);
+    std::size_t           listed {};
+    std::filesystem::path entry;
+    struct stat           st {};
+    auto                  start = std::chrono::steady_clock::now();
+    while (not vfs.dirnext(*dirh.value(), entry, st)) {
+        REQUIRE(not vfs.stat(dir.path / entry, st));
+        ++listed;
+    }
+    const auto per_entry = std::chrono::steady_clock::now() - start;
+    REQUIRE(listed == count + 2);
+
+    REQUIRE(not vfs.dirreset(*dirh.value()));
+    std::array<vfs::DirEntry, 32> batch {};
+    listed = 0;
+    start  = std::chrono::steady_clock::now();
+    while (true) {
+        const auto ret = vfs.dirnext_batch(*dirh.value(), batch, true);
+        REQUIRE(ret);
+        if (*ret == 0) { break; }
+        listed += *ret;
+    }
+    const auto batched = std::chrono::steady_clock::now() - start;
+    REQUIRE(listed == count + 2);
+    REQUIRE(not vfs.dirclose(*dirh.value()));
+
+    std::cout << "directory entries: " << count << ", dirnext + stat: " << dir.us_per_entry(per_entry) << " us/entry, dirnext_batch with stat: "
+              << dir.us_per_entry(batched) << " us/entry" << std::endl;
+}
+
+TEST_CASE("Directory seek latency per entry count", "[.][benchmark]")
+{
+    for (const std::size_t count : {1000, 10000, 100000}) {
+        const populated_dir dir {count};
+        auto&               vfs = dir.vfs;
+
+        /// Positions of the last entries, resumed the way seekdir did before cookies and with a cookie
+        auto dirh = vfs.diropen(dir.path);
+        REQUIRE(dirh);
+        const auto            target = count - 10;
+        std::filesystem::path entry;
+        struct stat           st {};
+        for (std::size_t i = 0; i < target; ++i) { REQUIRE(not vfs.dirnext(*dirh.value(), entry, st)); }
+        const auto cookie = vfs.dirtell(*dirh.value());
+        REQUIRE(cookie);
+
+        constexpr int rounds = 10;
+        auto          start  = std::chrono::steady_clock::now();
+        for (int r = 0; r < rounds; ++r) {
+            REQUIRE(not vfs.dirreset(*dirh.value()));
+            for (std::size_t i = 0; i < target; ++i) { REQUIRE(not vfs.dirnext(*dirh.value(), entry, st)); }
+        }
+        const auto rescan = std::chrono::steady_clock::now() - start;
+
+        start = std::chrono::steady_clock::now();
+        for (int r = 0; r < rounds; ++r) { REQUIRE(not vfs.dirseek(*dirh.value(), *cookie)); }
+        const auto seek = std::chrono::steady_clock::now() - start;
+        REQUIRE(not vfs.dirclose(*dirh.value()));
+
+        std::cout << "directory entries: " << count << ", rewind and skip: " << std::chrono::duration<double, std::micro>(rescan).count() / rounds
+                  << " us/seek, dirseek: " << std::chrono::duration<double, std::micro>(seek).count() / rounds << " us/seek" << std::endl;
+    }
+}
+
+TEST_CASE("Asset parsing with copying and pinned reads", "[.][benchmark]")
+{
+    constexpr std::size_t file_size    = 256 * 1024;
+    constexpr std::size_t chunk        = 4096;
+    constexpr std::size_t cache_blocks = 256;
+    constexpr int         rounds       = 1000;
+
+    auto       fsut      = ext4UnderTest::Builder {}.create();
+    auto&      vfs       = fsut->get();
+    const auto part_name = fsut->get_disk().borrow_partition(0)->get_name();
+    REQUIRE(vfs.mount(part_name, test_volume0_name, {}, {}, vfs::MountOptions {.cache_blocks = cache_blocks}).value() == 0);
+
+    std::vector<char> content(file_size);
+    for (std::size_t i = 0; i < content.size(); ++i) { content[i] = static_cast<char>(i % 251); }
+    auto fd = vfs.open(test_volume0_name / "asset", O_RDWR | O_CREAT, 0644);
+    REQUIRE(fd);
+    REQUIRE(vfs.write(*fd, content.data(), content.size()).value() == content.size());
+
+    /// The parser only sums the bytes, so the cost of getting them to it dominates
+    const auto expected = std::accumulate(content.begin(), content.end(), std::uint64_t {}, [](const auto sum, const char c) { return sum + static_cast<unsigned char>(c); });
+    const auto parse    = [](const auto begin, const auto end) {
+        return std::accumulate(begin, end, std::uint64_t {}, [](const auto sum, const auto c) { return sum + static_cast<unsigned char>(c); });
+    };
+    const auto measure = [&](const char* name, const auto& pass) {
+        REQUIRE(pass() == expected);
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < rounds; ++i) { REQUIRE(pass() == expected); }
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << name << ": " << std::chrono::duration<double, std::micro>(elapsed).count() / rounds << " us per " << file_size / 1024 << " KiB file"
+                  << std::endl;
+    };
+
+    std::vector<char> buffer(chunk);
+    measure("read into a buffer", [&] {
+        std::uint64_t sum {};
+        REQUIRE(vfs.lseek(*fd, 0, SEEK_SET).value() == 0);
+        for (std::size_t off = 0; off < file_size; off += chunk) {
+            REQUIRE(vfs.read(*fd, buffer.data(), buffer.size()).value() == buffer.size());
+            sum += parse(buffer.begin(), buffer.end());
+        }
+        return sum;
+    });
+    measure("pinned in the block cache", [&] {
+        std::uint64_t sum {};
+        for (std::size_t off = 0; off < file_size;) {
+            const auto pinned = vfs.read_pinned(*fd, static_cast<off_t>(off), file_size - off);
+            REQUIRE(pinned);
+            sum += parse(pinned->data().begin(), pinned->data().end());
+            off += pinned->size();
+        }
+        return sum;
+    });
+    REQUIRE(not vfs.close(*fd));
+}